@@ -0,0 +1,37 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stdint.h>
+
+// ============================================
+// BOOT TIMELINE
+// ============================================
+// Time-to-drive after power-up, stage by stage. Each stage keeps the
+// micros() of its first occurrence (the clock starts with the app, a few
+// tens of ms after power-on, after the ROM and bootloader). setup() only
+// does what driving needs - display and splash, NVS, radio and channel
+// lock - and returns; the splash stays up for WELCOME_SCREEN_DURATION while
+// loop() already runs. BOOT prints the timeline.
+
+enum BootStage : uint8_t {
+  BOOT_SETUP,          // setup() entered
+  BOOT_SPLASH,         // splash on screen
+  BOOT_NVS,            // calibration and parameters loaded
+  BOOT_RADIO_READY,    // esp_now_init done, peers registered
+  BOOT_FIRST_ACK,      // first MAC ACK or echo from any device
+  BOOT_LINK,           // channel of the selected device locked
+  BOOT_LOOP,           // first loop() pass
+  BOOT_FIRST_DRIVE,    // first drive command sent
+  BOOT_STAGES
+};
+
+// ============================================
+// FUNCTION PROTOTYPES
+// ============================================
+
+void bootMark(BootStage stage);      // first call per stage wins; any task
+uint32_t bootStageUs(BootStage stage);   // 0 = not reached
+bool bootSplashShowing();           // main display held back until false
+void printBootTimeline();
+
+#endif // BOOT_H
@@ -0,0 +1,53 @@
+#ifndef BUTTONS_H
+#define BUTTONS_H
+
+#include <Arduino.h>
+#include "gesture_engine.h"
+
+// ============================================
+// BUTTONS AND GESTURES
+// ============================================
+// GPIO interrupts timestamp every edge of the two stick buttons and the AUX
+// switch; updateButtons() feeds them to a GestureEngine once per loop pass.
+// Features react to the named gestures below instead of timing levels
+// themselves. Bit order matches ControlCommand::buttons.
+
+enum ButtonId : uint8_t {
+  BTN_LEFT,
+  BTN_RIGHT,
+  BTN_AUX,
+  BTN_COUNT
+};
+
+// Index into the gesture table in buttons.cpp (bit in the fired mask).
+enum GestureId : uint8_t {
+  GST_MENU_HOLD,        // right alone held HOLD_TO_MENU_MS: open device menu
+  GST_MENU_PICK,        // right released: confirm the highlighted device
+  GST_CALIBRATE,        // left + right held CALIBRATION_TRIGGER_TIME
+  GST_LEFT_PRESS,       // calibration step captures
+  GST_RIGHT_PRESS,
+  GST_AUX_PRESS,
+};
+
+// ============================================
+// GLOBAL VARIABLES
+// ============================================
+
+extern uint32_t buttonEdgeOverflows;   // ISR queue full, levels resynced
+
+// ============================================
+// FUNCTION PROTOTYPES
+// ============================================
+
+void initButtons();                    // pins, interrupts, initial levels
+void updateButtons();                  // drain edges; sets leftButton etc.
+bool gestureFired(GestureId g);        // during the last updateButtons()
+
+// ControlCommand::buttons: debounced levels plus any press since the last
+// command, so a tap between two sends is not lost.
+uint8_t buttonsForCommand();
+// A press or release the last command did not carry yet (send now).
+bool buttonsChanged();
+uint32_t buttonBounces();
+
+#endif // BUTTONS_H
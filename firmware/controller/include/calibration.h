@@ -3,25 +3,36 @@
 
 #include <Preferences.h>
 #include "config.h"
+#include "joystick.h"   // AXES, AXIS_COUNT
+#include "axis_curve.h"
 
 // ============================================
 // CALIBRATION DATA STRUCTURE
 // ============================================
 
+// Min / centre / max per calibration slot (AxisDesc::slot), defaulting to
+// the full ADC range. Slots with their curveMask bit set map through the
+// multi-point curve instead; their min/centre/max are its end and centre
+// knots.
 struct CalibrationData {
-  int leftXMin = 0;
-  int leftXMax = ADC_MAX;
-  int leftXCenter = ADC_CENTER;
-  int leftYMin = 0;
-  int leftYMax = ADC_MAX;
-  int leftYCenter = ADC_CENTER;
-  
-  int rightXMin = 0;
-  int rightXMax = ADC_MAX;
-  int rightXCenter = ADC_CENTER;
-  int rightYMin = 0;
-  int rightYMax = ADC_MAX;
-  int rightYCenter = ADC_CENTER;
+  AxisCal axis[AXIS_COUNT];
+  AxisCurve curve[AXIS_COUNT];
+  uint8_t curveMask;
+
+  CalibrationData() : curve(), curveMask(0) {
+    for (AxisCal &c : axis) c = {0, ADC_CENTER, ADC_MAX};
+  }
+};
+
+// NVS blob "curve" (76 bytes), written only while a slot has a curve.
+#define CURVE_BLOB_VERSION 1
+
+struct CurveBlob {
+  uint8_t version;
+  uint8_t knots;       // AXIS_CURVE_KNOTS
+  uint8_t slots;       // AXIS_COUNT
+  uint8_t mask;        // curveMask
+  AxisCurve curve[AXIS_COUNT];
 };
 
 // ============================================
@@ -34,8 +45,8 @@ extern bool inCalibrationMode;
 extern bool waitingForButtonRelease;
 extern int calibrationStep;
 extern unsigned long calibrationStepStart;
-extern unsigned long bothButtonsPressedStart;
-extern bool bothButtonsWerePressed;
+extern bool calibratingCurve;                  // multi-point steps instead of min/max
+extern int8_t curveLut[AXIS_COUNT][AXIS_LUT_LEN];
 
 // ============================================
 // FUNCTION PROTOTYPES
@@ -46,4 +57,13 @@ void loadCalibration();
 void handleCalibration();
 void validateCalibration();
 
+// Start the multi-point calibration (CURVE CAL), or drop every curve and
+// go back to three-point mapping (CURVE OFF, saved at once).
+void startCurveCalibration();
+void clearCurves();
+
+// Rebuild curveLut from calibration.curve; called whenever the curves change.
+void buildCurveLuts();
+void printCurves();
+
 #endif // CALIBRATION_H
@@ -32,26 +32,31 @@
 // TIMING CONFIGURATION
 // ============================================
 
-#define WELCOME_SCREEN_DURATION 2000  // ms
+#define WELCOME_SCREEN_DURATION 2000  // ms, splash shown while driving starts
 #define CALIBRATION_TRIGGER_TIME 5000 // ms (both buttons held)
-#define SEND_INTERVAL 20               // ms (50Hz)
-#define DEADZONE_THRESHOLD 50          // ADC units around center
+#define BUTTON_DEBOUNCE_US 5000       // ignore contact bounce this long after an edge
 
 // ============================================
 // ESP-NOW CONTROL
 // ============================================
 
-#define CONTROL_PROTOCOL_VERSION 1     // must match receiver firmware
-#define CONTROL_DEFAULT_SPEED 200      // master speed sent to robot (0-255)
 #define HOLD_TO_MENU_MS 600            // hold right button this long to open device menu
 #define MENU_TILT_REPEAT_MS 250        // min time between highlight steps in menu
-#define LINK_OK_MS    600              // link shown OK if an ACK was seen within this
-#define LINK_DEAD_MS  800              // re-acquire channel after this much ACK silence
-
-// Joystick -> command axis polarity (flip to +1/-1 if a direction is reversed)
-#define SIGN_X   (+1)                  // left stick X  -> strafe
-#define SIGN_Y   (-1)                  // left stick Y  -> forward (inverted to match stick)
-#define SIGN_ROT (+1)                  // right stick X -> rotation
+#define MENU_ROWS 4                    // device rows on screen; the list scrolls
+#define MENU_FIRST_ROW_Y 14
+#define MENU_ROW_HEIGHT 10
+#define PROBE_PERIOD_MS   1000         // background probe of each non-selected device
+#define PROBE_MAX_HOP_US  6000         // longest a background probe may leave the drive channel
+#define PROBE_LINK_OK_MS  3000         // non-selected device shown OK if probed within this
+#define TX_MAX_IN_FLIGHT  1            // drive frames awaiting their send callback
+#define TX_CALLBACK_TIMEOUT_US 100000  // stop counting a frame whose callback is this late
+#define SNIFF_RING_LEN    32           // sniffed frames awaiting the loop (power of two)
+#define RSSI_FRESH_MS     2000         // RSSI shown only if a frame was heard within this
+#define RSSI_WEAK_DBM     -80          // mean RSSI below this over a quiet floor = range
+#define RSSI_NOISY_FLOOR_DBM -85       // mean noise floor above this = interference
+
+// Send interval, deadzone, speed, link timeouts and axis polarity are
+// runtime parameters (GET/SET/SAVE): see CONTROLLER_PARAMS in params.h.
 
 // ============================================
 // ADC CONFIGURATION
@@ -63,6 +68,8 @@
 #define ADC_MAP_MIN 0
 #define ADC_MAP_MAX 58
 #define ADC_MAP_CENTER 29
+#define CURVE_SAMPLES 64               // ADC reads averaged per multi-point calibration point
+#define CURVE_SAMPLE_GAP_US 250        // between those reads (64 reads = 16 ms)
 
 // ============================================
 // SERIAL COMMUNICATION
@@ -70,4 +77,14 @@
 
 #define SERIAL_BAUDRATE 115200
 
+// ============================================
+// DIAGNOSTICS
+// ============================================
+
+#define FLIGHT_RECORDER_EVENTS 2048    // RAM event history for DUMP (power of two)
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1                // 0 compiles every TRACE_* macro to nothing
+#endif
+#define TRACE_EVENTS 1024              // RAM trace history for TRACE DUMP (power of two)
+
 #endif // CONFIG_H
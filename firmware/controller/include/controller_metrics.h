@@ -0,0 +1,56 @@
+#ifndef CONTROLLER_METRICS_H
+#define CONTROLLER_METRICS_H
+
+#include "metrics.h"
+
+// ============================================
+// CONTROLLER METRICS
+// ============================================
+// Every metric the controller exports through METRICS. Add an entry here
+// and update it where the event happens; nothing else needs registering.
+
+#define CONTROLLER_METRICS(COUNTER, GAUGE, HISTOGRAM) \
+  COUNTER(loopPasses,     "passes", "loop() passes") \
+  COUNTER(commands,       "cmds",   "drive commands built (sticks or macro)") \
+  COUNTER(framesSent,     "frames", "frames accepted by esp_now_send") \
+  COUNTER(framesHeld,     "frames", "frames held back (slot busy or NO_MEM)") \
+  COUNTER(sendDelivered,  "frames", "send callbacks with MAC ACK") \
+  COUNTER(sendFailed,     "frames", "send callbacks with retries exhausted") \
+  COUNTER(echoes,         "frames", "LinkEcho replies from the selected device") \
+  COUNTER(channelSwitches,"",       "radio channel changes (select / re-acquire)") \
+  COUNTER(probes,         "",       "background probes sent") \
+  COUNTER(buttonEdges,    "edges",  "button edges taken from the ISR queue") \
+  GAUGE(txSeq,            "",       "seq of the newest drive command") \
+  GAUGE(selectedDevice,   "",       "index of the selected device") \
+  GAUGE(linkOk,           "bool",   "selected device answered within params.linkOkMs") \
+  GAUGE(linkQuality,      "%",      "selected device ACK rate (EWMA)") \
+  GAUGE(lastSendStatus,   "",       "0 none, 1 delivered, 2 failed, 3 echoed") \
+  GAUGE(menuOpen,         "bool",   "device-select menu shown") \
+  HISTOGRAM(loopUs,       "us",     "loop() period", loopEdgesUs) \
+  HISTOGRAM(cmdIntervalUs,"us",     "gap between drive commands", intervalEdgesUs) \
+  HISTOGRAM(sendCallUs,   "us",     "time inside esp_now_send", sendCallEdgesUs) \
+  HISTOGRAM(ackUs,        "us",     "send -> send callback", ackEdgesUs) \
+  HISTOGRAM(flushUs,      "us",     "OLED frame over I2C", flushEdgesUs)
+
+extern const uint32_t loopEdgesUs[METRIC_HIST_BUCKETS - 1];
+extern const uint32_t intervalEdgesUs[METRIC_HIST_BUCKETS - 1];
+extern const uint32_t sendCallEdgesUs[METRIC_HIST_BUCKETS - 1];
+extern const uint32_t ackEdgesUs[METRIC_HIST_BUCKETS - 1];
+extern const uint32_t flushEdgesUs[METRIC_HIST_BUCKETS - 1];
+
+METRICS_REGISTRY(ControllerMetrics, CONTROLLER_METRICS)
+
+// ============================================
+// GLOBAL VARIABLES
+// ============================================
+
+extern ControllerMetrics metrics;
+
+// ============================================
+// FUNCTION PROTOTYPES
+// ============================================
+
+// METRICS command output: a snapshot in the given format on Serial.
+void printMetrics(MetricsFormat format);
+
+#endif // CONTROLLER_METRICS_H
@@ -2,12 +2,14 @@
 #define DISPLAY_H
 
 #include <Adafruit_SSD1306.h>
+#include "list_view.h"
 
 // ============================================
 // GLOBAL VARIABLES
 // ============================================
 
 extern Adafruit_SSD1306 display;
+extern unsigned long displayRenderUs;
 
 // ============================================
 // FUNCTION PROTOTYPES
@@ -20,6 +22,6 @@ void drawJoystickBars();
 void drawButtonStatus();
 void drawESPNowStatus();
 void displayCalibrationScreen();
-void displayDeviceMenu(int highlight);
+void displayDeviceMenu(ListView &menu);   // redraws only what changed
 
 #endif // DISPLAY_H
@@ -4,29 +4,75 @@
 #include <esp_now.h>
 #include <WiFi.h>
 #include <Arduino.h>
+#include <atomic>
 #include "config.h"
+#include "espnow_data.h"     // ControlCommand, shared with the receiver
+#include "probe_scheduler.h"
+#include "link_stats.h"
+#include "tx_tracker.h"
+#include "peer_table.h"
 
-// ============================================
-// ESP-NOW CONTROL PROTOCOL
-// ============================================
-// ControlCommand must stay byte-identical to the receiver firmware
-// (Mini Mecanum ESP32). Sent controller -> device at ~50 Hz.
-typedef struct __attribute__((packed)) {
-  uint8_t version;   // protocol version
-  uint8_t seq;       // rolling counter, for debug / loss detection
-  int8_t  x;         // strafe    -100..100 (left .. right)
-  int8_t  y;         // forward   -100..100 (back .. forward)
-  int8_t  rot;       // rotation  -100..100 (CCW .. CW)
-  uint8_t speed;     // master speed 0..255
-  uint8_t buttons;   // bit0=leftBtn, bit1=rightBtn, bit2=aux
-} ControlCommand;     // 7 bytes packed
-
-// A controllable device in the static list.
+// A controllable device in the static list. Every entry is registered as an
+// ESP-NOW peer at init; the fields below the line are per-peer link state.
 struct ControlDevice {
   const char* name;     // shown on OLED
   uint8_t     mac[6];   // peer MAC
   uint8_t     channel;  // last-known WiFi channel; 0 = unknown -> sweep
   bool        linkOk;   // last send delivered
+  // --
+  volatile unsigned long lastAckMs;  // millis() of the last delivered frame, 0 = never
+  volatile uint8_t quality;          // delivery rate, 0..100 (moving average)
+};
+
+// How each control command is put on the air.
+enum RedundancyMode : uint8_t {
+  REDUNDANCY_OFF,      // one ControlCommand per tick
+  REDUNDANCY_PREV,     // RedundantCommand: current + previous command
+  REDUNDANCY_DOUBLE,   // ControlCommand sent twice, half an interval apart
+};
+
+// How control frames are addressed. Probes are always unicast.
+enum TxMode : uint8_t {
+  TX_UNICAST,          // to the device MAC: MAC-layer ACK and retries
+  TX_BROADCAST,        // to FF:FF:FF:FF:FF:FF with the target MAC in the frame,
+                       // no ACK/retries; link health comes from LinkEcho
+};
+
+// Delivery seen through the receiver's LinkEcho, kept per TxMode so the
+// two can be compared side by side.
+struct LinkModeStats {
+  uint32_t sent;               // commands sent in this mode
+  uint32_t echoed;             // of those, echoed back by the selected device
+  uint16_t rxLossPermille;     // receiver's own effective-loss figure, last echo
+  LatencyHistogram rtt;        // send -> echo received
+  LatencyHistogram txDone;     // send -> send callback (includes retries in unicast)
+};
+
+// One RADIO profile measured by BENCH: back-to-back zero-motion frames to
+// the selected device, one in flight at a time.
+struct LinkBenchResult {
+  uint32_t sent;
+  uint32_t acked;
+  uint32_t failed;        // send callback reported failure (retries exhausted)
+  uint32_t timeouts;      // no callback within 50 ms
+  uint32_t sendErrors;    // esp_now_send refused the frame
+  uint32_t echoed;        // LinkEcho back: the receiver decoded the frame
+  uint32_t elapsedMs;
+  LatencyHistogram ack;   // send -> ACKed callback
+};
+
+// Outcome of the last frame to the selected device (metrics.lastSendStatus).
+enum SendStatus : uint8_t {
+  SEND_NONE,         // nothing sent yet
+  SEND_DELIVERED,    // MAC ACK (unicast)
+  SEND_FAILED,       // retries exhausted (unicast)
+  SEND_ECHOED,       // LinkEcho received (broadcast)
+};
+
+struct TxStats {
+  uint32_t commands;   // control commands generated
+  uint32_t frames;     // frames handed to esp_now_send
+  uint32_t bytes;      // payload bytes in those frames
 };
 
 // ============================================
@@ -37,7 +83,17 @@ extern ControlDevice devices[];
 extern int numDevices;
 extern int selectedDevice;
 extern bool espNowReady;
-extern String lastSendStatus;
+extern std::atomic<uint32_t> lastSwitchUs;    // last device switch: select -> first delivered command
+extern RedundancyMode redundancyMode;
+extern TxStats txStats;
+extern TxTracker txTracker;           // drive frames in flight, TXQ stats
+extern TxMode txMode;
+extern LinkModeStats linkModeStats[2];   // indexed by TxMode
+extern ProbeScheduler backgroundProber;
+extern bool backgroundProbing;
+extern uint32_t probeLateMaxUs;       // worst overrun of a probe hop past the next drive command
+extern PeerTable peerTable;           // which devices hold plain / encrypted peer slots
+extern bool pmkProvisioned;           // own PMK set (else the ESP-NOW default)
 
 // ============================================
 // FUNCTION PROTOTYPES
@@ -46,7 +102,23 @@ extern String lastSendStatus;
 void initESPNow();
 void sendControlCommand();            // build from joysticks + send to selected device
 bool selectDevice(int index);         // switch peer + lock channel (sweeps if unknown)
+int findDevice(const uint8_t *mac);   // index in devices[], -1 if unknown
+const char *sendStatusName(uint8_t status);
+void setRedundancyMode(RedundancyMode mode);  // also resets txStats
+bool setTxMode(TxMode mode);          // broadcast refused while the selected device is keyed
+void resetLinkModeStats();
+void probeBackground(bool driving);   // spare-slot probe of a non-selected device
+bool runLinkBench(int profile, uint32_t durationMs, LinkBenchResult &r);  // blocking
+
+// Encryption keys (KEY command), kept in NVS ("keys" namespace). nullptr
+// clears. Peers are re-registered at once.
+bool setEspNowPmk(const uint8_t *pmk);
+bool setDeviceKey(int index, const uint8_t *lmk);
+
+// The selected (keyed) device as a plain and as an encrypted peer, in
+// alternating rounds; blocking.
+bool runCryptoBench(uint32_t durationMs, LinkBenchResult &plain, LinkBenchResult &encrypted);
 void OnDataSent(const uint8_t *mac_addr, esp_now_send_status_t status);
-void handleSerialCommands();
+void OnDataRecv(const uint8_t *mac_addr, const uint8_t *data, int len);
 
 #endif // ESPNOW_H
@@ -0,0 +1,26 @@
+#ifndef FLIGHTLOG_H
+#define FLIGHTLOG_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "flight_recorder.h"
+
+// ============================================
+// GLOBAL VARIABLES
+// ============================================
+
+extern FlightRecorder<FLIGHT_RECORDER_EVENTS> flightRecorder;
+
+// ============================================
+// FUNCTION PROTOTYPES
+// ============================================
+
+// Record an event with the current micros(). Safe from the loop and from
+// the WiFi task callbacks.
+static inline void flightLog(uint8_t type, uint8_t a = 0, uint16_t b = 0) {
+  flightRecorder.record(micros(), type, a, b);
+}
+
+void flightDump();   // stream the ring as TLM_EVENTS frames (DUMP command)
+
+#endif // FLIGHTLOG_H
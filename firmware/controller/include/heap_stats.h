@@ -0,0 +1,33 @@
+#ifndef HEAP_STATS_H
+#define HEAP_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================
+// HEAP STATISTICS
+// ============================================
+// Free / min-ever / largest block from the heap itself, plus malloc and free
+// call counts from linker wraps (-Wl,--wrap=malloc etc., enabled together
+// with -DHEAP_COUNT_ALLOCS in the controller-diag environment of
+// platformio.ini). Without the wraps the counts
+// stay 0 and counting is reported as off. Used by the HEAP command to check
+// that the drive loop allocates nothing in steady state.
+
+struct HeapReport {
+  size_t freeBytes;
+  size_t minFreeBytes;       // low-water mark since boot
+  size_t largestBlock;
+  size_t allocatedBlocks;    // live blocks
+  uint32_t allocs;           // malloc/calloc/realloc(NULL) calls since boot
+  uint32_t frees;
+};
+
+// ============================================
+// FUNCTION PROTOTYPES
+// ============================================
+
+void heapReport(HeapReport &r);
+bool heapCountingEnabled();
+
+#endif // HEAP_STATS_H
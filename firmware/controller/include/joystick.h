@@ -3,15 +3,29 @@
 
 #include <Arduino.h>
 #include "config.h"
+#include "axis_model.h"
+
+// ============================================
+// AXES
+// ============================================
+// One row per analog axis (see axis_model.h). The row order is the order of
+// axisRaw[], of the calibration slots and of the calibration steps.
+
+enum AxisId { AXIS_LX, AXIS_LY, AXIS_RX, AXIS_RY, AXIS_COUNT };
+
+constexpr AxisDesc AXES[AXIS_COUNT] = {
+  // pin      role            slot     stick        key       label neg     pos
+  {LEFT_VRX,  AXIS_ROLE_X,    AXIS_LX, STICK_LEFT,  "leftX",  "LX", "LEFT", "RIGHT"},
+  {LEFT_VRY,  AXIS_ROLE_Y,    AXIS_LY, STICK_LEFT,  "leftY",  "LY", "DOWN", "UP"},
+  {RIGHT_VRX, AXIS_ROLE_ROT,  AXIS_RX, STICK_RIGHT, "rightX", "RX", "LEFT", "RIGHT"},
+  {RIGHT_VRY, AXIS_ROLE_NONE, AXIS_RY, STICK_RIGHT, "rightY", "RY", "DOWN", "UP"},
+};
 
 // ============================================
 // GLOBAL VARIABLES
 // ============================================
 
-extern int leftX;
-extern int leftY;
-extern int rightX;
-extern int rightY;
+extern int axisRaw[AXIS_COUNT];       // last ADC reading per axis
 extern bool leftButton;
 extern bool rightButton;
 extern bool auxSwitch;
@@ -23,11 +37,14 @@ extern bool auxSwitch;
 void initJoystick();
 void readJoystickInputs();
 void checkCalibrationTrigger();
-void mapJoystickValues(int& leftXBar, int& leftYBar, int& rightXBar, int& rightYBar);
-void printJoystickDebug(int leftXBar, int leftYBar, int rightXBar, int rightYBar);
+void mapJoystickValues(int bars[AXIS_COUNT]);          // ADC_MAP_MIN..ADC_MAP_MAX per axis
+void printJoystickDebug(const int bars[AXIS_COUNT]);
+
+// One axis as a signed -100..100 value using calibration, with a deadzone
+// around centre.
+int8_t mapAxisSigned(int axis);
 
-// Map a raw ADC reading to a signed -100..100 value using calibration,
-// with a deadzone around centre. Used to build the ESP-NOW command.
-int8_t mapAxisSigned(int raw, int mn, int ctr, int mx);
+// ControlCommand fields (indexed by AxisRole) from the axes that drive them.
+void mapAxisRoles(int8_t out[AXIS_ROLE_COUNT]);
 
 #endif // JOYSTICK_H
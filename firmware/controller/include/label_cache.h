@@ -0,0 +1,52 @@
+#ifndef LABEL_CACHE_H
+#define LABEL_CACHE_H
+
+#include <Arduino.h>
+
+// ============================================
+// PRE-RENDERED LABEL CACHE
+// ============================================
+// Static labels and device names are rasterised once (size-1 font, 8 px
+// tall) into column bytes already laid out for the SSD1306 page buffer in
+// the current rotation. Drawing one is a byte OR per column (two when the
+// label straddles a page) instead of a drawPixel per lit pixel via print().
+
+#define LABEL_POOL_BYTES 1024   // column bytes for all labels + device names
+#define LABEL_MAX_DEVICES 20    // ESP-NOW peer limit
+
+enum LabelId {
+  LBL_MOVE,
+  LBL_TURN,
+  LBL_BTN_L,
+  LBL_BTN_R,
+  LBL_BTN_A,
+  LBL_REC,
+  LBL_PLAY,
+  LBL_MENU_TITLE,
+  LBL_MENU_HINT,
+  LBL_CURSOR,
+  LBL_STAR,
+  LBL_OK,
+  LBL_SORT_TABLE,    // device menu sort order, in ListSort order
+  LBL_SORT_QUALITY,
+  LBL_SORT_SEEN,
+  NUM_LABELS
+};
+
+// ============================================
+// GLOBAL VARIABLES
+// ============================================
+
+extern bool labelCacheEnabled;   // false = fall back to print() (for A/B timing)
+
+// ============================================
+// FUNCTION PROTOTYPES
+// ============================================
+
+void labelCacheInit();            // after display.begin() and setRotation()
+void drawLabel(LabelId id, int x, int y);
+void drawDeviceName(int index, int x, int y);
+int labelWidth(LabelId id);       // pixels
+int deviceNameWidth(int index);
+
+#endif // LABEL_CACHE_H
@@ -0,0 +1,39 @@
+#ifndef MACRO_H
+#define MACRO_H
+
+#include <Arduino.h>
+#include "espnow.h"
+
+// ============================================
+// MACRO RECORD / REPLAY
+// ============================================
+// Records the commands sent at the control rate into a compressed log on
+// LittleFS and replays them through sendControlCommand() with the original
+// timing. Flash I/O runs in a background task behind a RAM double buffer, so
+// the TX tick only ever copies a few bytes.
+
+#define MACRO_PATH      "/macro.bin"
+#define MACRO_BUF_SIZE  512
+
+enum MacroState { MACRO_IDLE, MACRO_RECORDING, MACRO_PLAYING };
+
+// ============================================
+// GLOBAL VARIABLES
+// ============================================
+
+extern MacroState macroState;
+
+// ============================================
+// FUNCTION PROTOTYPES
+// ============================================
+
+bool macroStartRecording();
+void macroStopRecording();           // flushes and prints size / bytes-per-second
+bool macroStartReplay();
+void macroStopReplay();
+
+// TX tick hooks (called from sendControlCommand)
+void macroRecord(unsigned long nowMs, const ControlCommand &cmd);
+bool macroReplayNext(unsigned long nowMs, ControlCommand &cmd);  // true when a command is due
+
+#endif // MACRO_H
@@ -0,0 +1,42 @@
+#ifndef PARAMS_H
+#define PARAMS_H
+
+#include "param_store.h"
+
+// ============================================
+// CONTROL PARAMETERS
+// ============================================
+// Tunables that used to be #defines in config.h. Read them as
+// params.<name>; change them with SET, persist with SAVE (NVS namespace
+// "params"). Bump PARAMS_SCHEMA when a parameter changes meaning or units,
+// so values saved by older firmware fall back to these defaults.
+
+#define PARAMS_SCHEMA 1
+
+#define CONTROLLER_PARAMS(P, T) \
+  P(T, sendIntervalMs, "send_ms",    PARAM_INT,  20,  5,   200,   "ms",  "drive command period") \
+  P(T, deadzone,       "deadzone",   PARAM_INT,  50,  0,   1000,  "adc", "stick deadzone around centre") \
+  P(T, defaultSpeed,   "speed",      PARAM_INT,  200, 0,   255,   "pwm", "master speed (AUX doubles it)") \
+  P(T, linkOkMs,       "link_ok",    PARAM_INT,  600, 50,  10000, "ms",  "link shown OK if acked within") \
+  P(T, linkDeadMs,     "link_dead",  PARAM_INT,  800, 100, 30000, "ms",  "re-acquire after this ACK silence") \
+  P(T, signX,          "sign_x",     PARAM_SIGN, +1,  -1,  1,     "",    "strafe (x) polarity") \
+  P(T, signY,          "sign_y",     PARAM_SIGN, -1,  -1,  1,     "",    "forward (y) polarity") \
+  P(T, signRot,        "sign_rot",   PARAM_SIGN, +1,  -1,  1,     "",    "rotation (rot) polarity")
+
+PARAMS_STRUCT(ControllerParams, CONTROLLER_PARAMS);
+
+// ============================================
+// GLOBAL VARIABLES
+// ============================================
+
+extern ControllerParams params;
+extern ParamStore paramStore;
+
+// ============================================
+// FUNCTION PROTOTYPES
+// ============================================
+
+void loadParams();   // NVS -> params (defaults where missing or invalid)
+void saveParams();
+
+#endif // PARAMS_H
@@ -0,0 +1,45 @@
+#ifndef RADIO_H
+#define RADIO_H
+
+#include <Arduino.h>
+#include <esp_wifi.h>
+
+// ============================================
+// RADIO PROFILES
+// ============================================
+// PHY rate used for ESP-NOW frames, optionally over Espressif's long-range
+// (LR) protocol, plus an optional TX power cap. Chosen with the RADIO
+// command and kept in NVS ("radio" namespace). LR profiles only reach
+// receivers that have LR in their protocol bitmap.
+
+struct RadioProfile {
+  const char *name;
+  wifi_phy_rate_t rate;
+  bool longRange;       // enable WIFI_PROTOCOL_LR
+  uint16_t rateKbps;    // nominal, for airtime estimates
+};
+
+#define RADIO_TX_POWER_DEFAULT 0   // 0 = leave the driver's limit alone
+#define RADIO_TX_POWER_MIN 8       // esp_wifi_set_max_tx_power() range, 0.25 dBm units
+#define RADIO_TX_POWER_MAX 84      // (2..21 dBm)
+
+// ============================================
+// GLOBAL VARIABLES
+// ============================================
+
+extern const RadioProfile radioProfiles[];
+extern const int numRadioProfiles;
+extern int radioProfile;              // index into radioProfiles[]
+extern int8_t radioTxPowerQdbm;       // 0.25 dBm units, 0 = driver default
+
+// ============================================
+// FUNCTION PROTOTYPES
+// ============================================
+
+int findRadioProfile(const char *name);   // case-sensitive, -1 if unknown
+bool applyRadioProfile(int index);        // radio only, does not persist
+bool applyRadioTxPower(int8_t qdbm);
+void loadRadioSettings();                 // NVS -> globals (initESPNow applies them)
+void saveRadioSettings();
+
+#endif // RADIO_H
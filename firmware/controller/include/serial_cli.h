@@ -0,0 +1,29 @@
+#ifndef SERIAL_CLI_H
+#define SERIAL_CLI_H
+
+#include <Arduino.h>
+
+// ============================================
+// SERIAL COMMAND LINE
+// ============================================
+// Bytes are collected from Serial into a fixed buffer as they arrive; a
+// command runs only once its '\n' (or '\r') has been seen, so the loop never
+// waits on a partial line. No heap allocation anywhere on this path.
+
+#define CLI_LINE_MAX 64
+
+// One command: name is matched case-insensitively against the first word of
+// the line, args points at the rest of the (upper-cased) line or "".
+struct CliCommand {
+  const char *name;
+  void (*handler)(const char *args);
+  const char *help;
+};
+
+// ============================================
+// FUNCTION PROTOTYPES
+// ============================================
+
+void handleSerialCommands();
+
+#endif // SERIAL_CLI_H
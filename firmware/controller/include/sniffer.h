@@ -0,0 +1,47 @@
+#ifndef SNIFFER_H
+#define SNIFFER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "rssi_monitor.h"
+#include "probe_scheduler.h"   // PROBE_MAX_DEVICES
+
+// ============================================
+// RSSI SNIFFER
+// ============================================
+// Optional promiscuous receive that measures every frame heard from a known
+// device: RSSI, noise floor and PHY rate. Link quality on its own only comes
+// from ACKs, which cannot tell a device out of range from a jammed channel.
+// The WiFi task only queues a copy of each frame's header (SniffRing);
+// snifferPoll() parses and aggregates them from the loop. Only frames on the
+// radio's current channel are heard: the selected device, its echoes, and
+// devices being probed. Off by default (RSSI ON).
+
+// ============================================
+// GLOBAL VARIABLES
+// ============================================
+
+extern bool snifferEnabled;
+extern RssiStats rssiStats[PROBE_MAX_DEVICES];   // indexed like devices[]
+
+struct SnifferStats {
+  uint32_t frames;       // records taken from the ring
+  uint32_t matched;      // from a known device
+  uint32_t espnow;       // of those, ESP-NOW frames
+  uint32_t retries;      // of those, MAC retransmissions
+};
+extern SnifferStats snifferStats;
+
+// ============================================
+// FUNCTION PROTOTYPES
+// ============================================
+
+bool snifferEnable(bool on);          // switch promiscuous receive on or off
+void snifferPoll();                   // drain the ring into rssiStats (loop)
+void snifferReset();                  // clear rssiStats and snifferStats
+uint32_t snifferDropped();            // records lost to a full ring
+bool rssiFresh(int idx);              // a sample within RSSI_FRESH_MS
+LinkDiag rssiDiagnose(int idx);
+const char *linkDiagName(LinkDiag d);
+
+#endif // SNIFFER_H
@@ -0,0 +1,28 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include "espnow.h"
+
+// ============================================
+// GLOBAL VARIABLES
+// ============================================
+
+extern bool telemetryStreaming;   // binary frames on Serial (STREAM ON/OFF)
+
+// ============================================
+// FUNCTION PROTOTYPES
+// ============================================
+
+// Emitters are no-ops while streaming is off, so call sites need no guard.
+void telemetryEmitSample(uint32_t tUs);
+void telemetryEmitCommand(uint32_t tUs, uint8_t device, const ControlCommand &cmd);
+void telemetryEmitTiming(uint32_t tUs, uint16_t sendUs);
+
+// Safe to call from the WiFi task (OnDataSent): queued, sent by telemetryPoll().
+void telemetryQueueAck(uint8_t device, uint8_t seq, bool ok);
+
+void telemetryPoll();                 // drain queued callback events, once per loop
+void telemetryLoopDone(uint32_t loopUs); // record loop period for TLM_TIMING
+
+#endif // TELEMETRY_H
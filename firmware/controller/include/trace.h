@@ -0,0 +1,67 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "flight_recorder.h"
+
+// ============================================
+// EVENT TRACE
+// ============================================
+// Begin/end/instant trace points (TracePoint in telemetry_frame.h) recorded
+// into a RAM ring, so the interleaving of input sampling, sends, callbacks,
+// I2C flushes and channel switches can be seen after a stutter. TRACE DUMP
+// streams the ring as TLM_TRACE frames; tools/trace_export converts a capture
+// to Chrome trace JSON. Same lock-free ring as the flight recorder, so the
+// WiFi task callbacks can record too. With TRACE_ENABLED 0 every macro
+// expands to nothing.
+
+#if TRACE_ENABLED
+
+extern FlightRecorder<TRACE_EVENTS> traceRecorder;
+
+static inline void traceRecord(uint8_t point, uint8_t phase, uint16_t arg) {
+  traceRecorder.record(micros(), point, phase, arg);
+}
+
+// Begin on construction, end on scope exit (covers early returns).
+class TraceScope {
+public:
+  TraceScope(uint8_t point, uint16_t arg) : _point(point) { traceRecord(point, TRACE_PH_BEGIN, arg); }
+  ~TraceScope() { traceRecord(_point, TRACE_PH_END, 0); }
+
+private:
+  uint8_t _point;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b)  TRACE_CONCAT_(a, b)
+
+#define TRACE_BEGIN(point, arg)   traceRecord((point), TRACE_PH_BEGIN, (arg))
+#define TRACE_END(point)          traceRecord((point), TRACE_PH_END, 0)
+#define TRACE_INSTANT(point, arg) traceRecord((point), TRACE_PH_INSTANT, (arg))
+#define TRACE_INSTANT_AT(point, tUs, arg) traceRecorder.record((tUs), (point), TRACE_PH_INSTANT, (arg))
+#define TRACE_SCOPE(point, arg)   TraceScope TRACE_CONCAT(traceScope_, __LINE__)((point), (arg))
+
+#else
+
+#define TRACE_BEGIN(point, arg)   do {} while (0)
+#define TRACE_END(point)          do {} while (0)
+#define TRACE_INSTANT(point, arg) do {} while (0)
+#define TRACE_INSTANT_AT(point, tUs, arg) do {} while (0)
+#define TRACE_SCOPE(point, arg)   do {} while (0)
+
+#endif // TRACE_ENABLED
+
+// ============================================
+// FUNCTION PROTOTYPES
+// ============================================
+
+#if TRACE_ENABLED
+void traceDump();                       // stream the ring as TLM_TRACE frames
+void traceClear();                      // later dumps start after this point
+uint32_t traceEventsSinceClear();
+uint32_t traceBenchNs(uint32_t events); // cost of one trace point, in ns
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,57 @@
+#include "boot.h"
+#include "config.h"
+#include <Arduino.h>
+#include <atomic>
+
+// ============================================
+// GLOBAL VARIABLES
+// ============================================
+
+static const char *const stageNames[BOOT_STAGES] = {
+  "setup", "splash", "nvs loaded", "radio ready", "first ack",
+  "link locked", "first loop", "first drive",
+};
+
+// BOOT_FIRST_ACK is marked from the WiFi task.
+static std::atomic<uint32_t> stageUs[BOOT_STAGES];
+
+// ============================================
+// FUNCTION IMPLEMENTATIONS
+// ============================================
+
+void bootMark(BootStage stage) {
+  uint32_t expected = 0;
+  uint32_t now = micros();
+  if (now == 0) now = 1;   // 0 means "not reached"
+  if (!stageUs[stage].compare_exchange_strong(expected, now, std::memory_order_relaxed)) return;
+  if (stage == BOOT_FIRST_DRIVE) {
+    Serial.printf("[BOOT] First drive command %lu ms after start (BOOT for the timeline)\n",
+      (unsigned long)(now / 1000));
+  }
+}
+
+uint32_t bootStageUs(BootStage stage) {
+  return stageUs[stage].load(std::memory_order_relaxed);
+}
+
+bool bootSplashShowing() {
+  static bool showing = true;
+  uint32_t splash = bootStageUs(BOOT_SPLASH);
+  if (showing && splash && micros() - splash >= WELCOME_SCREEN_DURATION * 1000UL) showing = false;
+  return showing;
+}
+
+void printBootTimeline() {
+  Serial.println("\n=== Boot timeline (ms since start) ===");
+  uint32_t prev = 0;
+  for (int i = 0; i < BOOT_STAGES; i++) {
+    uint32_t t = bootStageUs((BootStage)i);
+    if (!t) {
+      Serial.printf("  %-12s      --\n", stageNames[i]);
+      continue;
+    }
+    Serial.printf("  %-12s %8.1f  (%+.1f)\n", stageNames[i], t / 1000.0f, (int32_t)(t - prev) / 1000.0f);
+    prev = t;
+  }
+  Serial.println("======================================\n");
+}
@@ -0,0 +1,116 @@
+#include "buttons.h"
+#include "config.h"
+#include "trace.h"
+#include "controller_metrics.h"
+#include <atomic>
+
+// ============================================
+// GLOBAL VARIABLES
+// ============================================
+
+uint32_t buttonEdgeOverflows = 0;
+
+// Same order as GestureId.
+static const GestureSpec gestureTable[] = {
+  {GESTURE_HOLD,       1u << BTN_RIGHT, 1u << BTN_LEFT, HOLD_TO_MENU_MS},           // GST_MENU_HOLD
+  {GESTURE_RELEASE,    1u << BTN_RIGHT, 0, 0},                                      // GST_MENU_PICK
+  {GESTURE_CHORD_HOLD, (1u << BTN_LEFT) | (1u << BTN_RIGHT), 0, CALIBRATION_TRIGGER_TIME}, // GST_CALIBRATE
+  {GESTURE_PRESS,      1u << BTN_LEFT, 0, 0},                                       // GST_LEFT_PRESS
+  {GESTURE_PRESS,      1u << BTN_RIGHT, 0, 0},                                      // GST_RIGHT_PRESS
+  {GESTURE_PRESS,      1u << BTN_AUX, 0, 0},                                        // GST_AUX_PRESS
+};
+
+static const uint8_t buttonPins[BTN_COUNT] = {LEFT_SW, RIGHT_SW, AUX_SWITCH};
+
+static GestureEngine engine;
+static uint32_t fired = 0;
+static uint8_t sentLevels = 0;
+
+// Edges from the GPIO ISRs to updateButtons(). The three ISRs run at the same
+// level on one core and never nest, so together they are a single producer.
+#define EDGE_QUEUE_LEN 32
+static ButtonEdge edgeQueue[EDGE_QUEUE_LEN];
+static std::atomic<uint8_t> edgeHead(0);   // written by the ISRs
+static std::atomic<uint8_t> edgeTail(0);   // written by loop
+static std::atomic<bool> edgeOverflow(false);
+
+// ============================================
+// FUNCTION IMPLEMENTATIONS
+// ============================================
+
+static void IRAM_ATTR queueEdge(uint8_t button) {
+  uint32_t t = micros();
+  uint8_t h = edgeHead.load(std::memory_order_relaxed);
+  uint8_t next = (h + 1) % EDGE_QUEUE_LEN;
+  if (next == edgeTail.load(std::memory_order_acquire)) {
+    edgeOverflow.store(true, std::memory_order_relaxed);
+    return;
+  }
+  // Active LOW with pullup.
+  edgeQueue[h] = {t, button, (uint8_t)!digitalRead(buttonPins[button])};
+  edgeHead.store(next, std::memory_order_release);
+}
+
+static void IRAM_ATTR onLeftEdge()  { queueEdge(BTN_LEFT); }
+static void IRAM_ATTR onRightEdge() { queueEdge(BTN_RIGHT); }
+static void IRAM_ATTR onAuxEdge()   { queueEdge(BTN_AUX); }
+
+// Feed the current pin levels as edges (boot, or after lost edges).
+static void syncLevels() {
+  uint32_t t = micros();
+  for (uint8_t b = 0; b < BTN_COUNT; b++) {
+    engine.edge({t, b, (uint8_t)!digitalRead(buttonPins[b])});
+  }
+}
+
+void initButtons() {
+  for (uint8_t b = 0; b < BTN_COUNT; b++) pinMode(buttonPins[b], INPUT_PULLUP);
+  engine.begin(gestureTable, sizeof(gestureTable) / sizeof(gestureTable[0]), BUTTON_DEBOUNCE_US);
+  syncLevels();
+  engine.poll(micros());      // drop gestures from buttons held at boot
+  engine.takePresses();
+  attachInterrupt(digitalPinToInterrupt(LEFT_SW), onLeftEdge, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(RIGHT_SW), onRightEdge, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(AUX_SWITCH), onAuxEdge, CHANGE);
+}
+
+void updateButtons() {
+  extern bool leftButton, rightButton, auxSwitch;
+
+  uint8_t t = edgeTail.load(std::memory_order_relaxed);
+  while (t != edgeHead.load(std::memory_order_acquire)) {
+    const ButtonEdge &e = edgeQueue[t];
+    TRACE_INSTANT_AT(TP_BUTTON, e.tUs, e.button | e.down << 8);
+    metrics.buttonEdges.inc();
+    engine.edge(e);
+    t = (t + 1) % EDGE_QUEUE_LEN;
+    edgeTail.store(t, std::memory_order_release);
+  }
+  if (edgeOverflow.exchange(false, std::memory_order_relaxed)) {
+    buttonEdgeOverflows++;
+    syncLevels();
+  }
+  fired = engine.poll(micros());
+
+  uint8_t levels = engine.levels();
+  leftButton = levels & (1u << BTN_LEFT);
+  rightButton = levels & (1u << BTN_RIGHT);
+  auxSwitch = levels & (1u << BTN_AUX);
+}
+
+bool gestureFired(GestureId g) {
+  return fired & (1u << g);
+}
+
+uint8_t buttonsForCommand() {
+  sentLevels = engine.levels();
+  return sentLevels | engine.takePresses();
+}
+
+bool buttonsChanged() {
+  return engine.presses() || engine.levels() != sentLevels;
+}
+
+uint32_t buttonBounces() {
+  return engine.bounces();
+}
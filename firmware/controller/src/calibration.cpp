@@ -1,6 +1,7 @@
 #include "calibration.h"
 #include "config.h"
 #include "display.h"
+#include "buttons.h"
 #include <Arduino.h>
 
 // ============================================
@@ -13,30 +14,52 @@ bool inCalibrationMode = false;
 bool waitingForButtonRelease = false;
 int calibrationStep = 0;
 unsigned long calibrationStepStart = 0;
-unsigned long bothButtonsPressedStart = 0;
-bool bothButtonsWerePressed = false;
+bool calibratingCurve = false;
+int8_t curveLut[AXIS_COUNT][AXIS_LUT_LEN];
+
+static int curvePoints[AXIS_COUNT][AXIS_CURVE_KNOTS];   // captures in progress
+static int curveStepShown = -1;
 
 // ============================================
 // FUNCTION IMPLEMENTATIONS
 // ============================================
 
+// NVS keys are the axis key plus Min/Center/Max ("leftXMin"), as written
+// by every earlier firmware.
+static void calKey(char *key, size_t len, const AxisDesc &a, const char *field) {
+  snprintf(key, len, "%s%s", a.key, field);
+}
+
+static void printCalibration() {
+  for (const AxisDesc &a : AXES) {
+    const AxisCal &c = calibration.axis[a.slot];
+    Serial.printf("  %s: Min=%d Center=%d Max=%d\n", a.label, c.min, c.center, c.max);
+  }
+}
+
 void saveCalibration() {
+  char key[16];
   preferences.begin("joystick", false);
-  
-  preferences.putInt("leftXMin", calibration.leftXMin);
-  preferences.putInt("leftXMax", calibration.leftXMax);
-  preferences.putInt("leftXCenter", calibration.leftXCenter);
-  preferences.putInt("leftYMin", calibration.leftYMin);
-  preferences.putInt("leftYMax", calibration.leftYMax);
-  preferences.putInt("leftYCenter", calibration.leftYCenter);
-  
-  preferences.putInt("rightXMin", calibration.rightXMin);
-  preferences.putInt("rightXMax", calibration.rightXMax);
-  preferences.putInt("rightXCenter", calibration.rightXCenter);
-  preferences.putInt("rightYMin", calibration.rightYMin);
-  preferences.putInt("rightYMax", calibration.rightYMax);
-  preferences.putInt("rightYCenter", calibration.rightYCenter);
-  
+  for (const AxisDesc &a : AXES) {
+    const AxisCal &c = calibration.axis[a.slot];
+    calKey(key, sizeof(key), a, "Min");
+    preferences.putInt(key, c.min);
+    calKey(key, sizeof(key), a, "Max");
+    preferences.putInt(key, c.max);
+    calKey(key, sizeof(key), a, "Center");
+    preferences.putInt(key, c.center);
+  }
+  if (calibration.curveMask) {
+    CurveBlob b;
+    b.version = CURVE_BLOB_VERSION;
+    b.knots = AXIS_CURVE_KNOTS;
+    b.slots = AXIS_COUNT;
+    b.mask = calibration.curveMask;
+    memcpy(b.curve, calibration.curve, sizeof(b.curve));
+    preferences.putBytes("curve", &b, sizeof(b));
+  } else if (preferences.isKey("curve")) {
+    preferences.remove("curve");
+  }
   preferences.putBool("calibrated", true);
   preferences.end();
   
@@ -49,35 +72,33 @@ void loadCalibration() {
   bool isCalibrated = preferences.getBool("calibrated", false);
   
   if (isCalibrated) {
-    calibration.leftXMin = preferences.getInt("leftXMin", 0);
-    calibration.leftXMax = preferences.getInt("leftXMax", ADC_MAX);
-    calibration.leftXCenter = preferences.getInt("leftXCenter", ADC_CENTER);
-    calibration.leftYMin = preferences.getInt("leftYMin", 0);
-    calibration.leftYMax = preferences.getInt("leftYMax", ADC_MAX);
-    calibration.leftYCenter = preferences.getInt("leftYCenter", ADC_CENTER);
-    
-    calibration.rightXMin = preferences.getInt("rightXMin", 0);
-    calibration.rightXMax = preferences.getInt("rightXMax", ADC_MAX);
-    calibration.rightXCenter = preferences.getInt("rightXCenter", ADC_CENTER);
-    calibration.rightYMin = preferences.getInt("rightYMin", 0);
-    calibration.rightYMax = preferences.getInt("rightYMax", ADC_MAX);
-    calibration.rightYCenter = preferences.getInt("rightYCenter", ADC_CENTER);
-    
+    char key[16];
+    for (const AxisDesc &a : AXES) {
+      AxisCal &c = calibration.axis[a.slot];
+      calKey(key, sizeof(key), a, "Min");
+      c.min = preferences.getInt(key, 0);
+      calKey(key, sizeof(key), a, "Max");
+      c.max = preferences.getInt(key, ADC_MAX);
+      calKey(key, sizeof(key), a, "Center");
+      c.center = preferences.getInt(key, ADC_CENTER);
+    }
+
+    // A curve that does not match this build, or is not strictly
+    // increasing, is ignored and its axis stays three-point.
+    CurveBlob b;
+    if (preferences.isKey("curve") && preferences.getBytesLength("curve") == sizeof(b) &&
+        preferences.getBytes("curve", &b, sizeof(b)) == sizeof(b) &&
+        b.version == CURVE_BLOB_VERSION && b.knots == AXIS_CURVE_KNOTS && b.slots == AXIS_COUNT) {
+      for (int s = 0; s < AXIS_COUNT; s++) {
+        if (!(b.mask & (1 << s)) || !axisCurveValid(b.curve[s])) continue;
+        calibration.curve[s] = b.curve[s];
+        calibration.curveMask |= 1 << s;
+      }
+    }
+    buildCurveLuts();
     Serial.println("\n>>> Calibration loaded from NVS <<<");
-    Serial.println("Left Joystick:");
-    Serial.print("  X: Min="); Serial.print(calibration.leftXMin); 
-    Serial.print(" Center="); Serial.print(calibration.leftXCenter);
-    Serial.print(" Max="); Serial.println(calibration.leftXMax);
-    Serial.print("  Y: Min="); Serial.print(calibration.leftYMin);
-    Serial.print(" Center="); Serial.print(calibration.leftYCenter);
-    Serial.print(" Max="); Serial.println(calibration.leftYMax);
-    Serial.println("Right Joystick:");
-    Serial.print("  X: Min="); Serial.print(calibration.rightXMin);
-    Serial.print(" Center="); Serial.print(calibration.rightXCenter);
-    Serial.print(" Max="); Serial.println(calibration.rightXMax);
-    Serial.print("  Y: Min="); Serial.print(calibration.rightYMin);
-    Serial.print(" Center="); Serial.print(calibration.rightYCenter);
-    Serial.print(" Max="); Serial.println(calibration.rightYMax);
+    printCalibration();
+    if (calibration.curveMask) printCurves();
   } else {
     Serial.println("\nNo calibration found in NVS. Using defaults.");
     Serial.println("Hold both joystick buttons for 5 seconds to calibrate.");
@@ -86,224 +107,230 @@ void loadCalibration() {
   preferences.end();
 }
 
+void buildCurveLuts() {
+  for (int s = 0; s < AXIS_COUNT; s++) {
+    if (calibration.curveMask & (1 << s)) axisCurveLut(calibration.curve[s], curveLut[s]);
+  }
+}
+
+void printCurves() {
+  for (const AxisDesc &a : AXES) {
+    Serial.printf("  %s:", a.label);
+    if (!(calibration.curveMask & (1 << a.slot))) {
+      Serial.println(" three-point");
+      continue;
+    }
+    for (uint16_t k : calibration.curve[a.slot].knot) Serial.printf(" %u", k);
+    Serial.println();
+  }
+}
+
+void startCurveCalibration() {
+  if (inCalibrationMode) return;
+  inCalibrationMode = true;
+  calibratingCurve = true;
+  waitingForButtonRelease = true;
+  calibrationStep = 0;
+  calibrationStepStart = millis();
+  curveStepShown = -1;
+  Serial.println("\n>>> ENTERING CURVE CALIBRATION <<<");
+  Serial.println("Release both buttons to begin...");
+}
+
+void clearCurves() {
+  if (!calibration.curveMask) return;
+  calibration.curveMask = 0;
+  saveCalibration();
+}
+
 void validateCalibration() {
-  // Ensure min is actually less than max
-  if (calibration.leftXMin > calibration.leftXMax) { 
-    int temp = calibration.leftXMin; 
-    calibration.leftXMin = calibration.leftXMax; 
-    calibration.leftXMax = temp; 
+  // Min below max, centre between them
+  for (AxisCal &c : calibration.axis) axisValidate(c);
+  Serial.println("Validated calibration values.");
+}
+
+// ============================================
+// MULTI-POINT CALIBRATION
+// ============================================
+
+// Axes that drive a command field get a curve; the rest stay three-point.
+static int curveAxisCount() {
+  int n = 0;
+  for (const AxisDesc &a : AXES) n += a.role != AXIS_ROLE_NONE;
+  return n;
+}
+
+static int curveAxis(int n) {
+  for (int i = 0; i < AXIS_COUNT; i++) {
+    if (AXES[i].role != AXIS_ROLE_NONE && n-- == 0) return i;
   }
-  if (calibration.leftYMin > calibration.leftYMax) { 
-    int temp = calibration.leftYMin; 
-    calibration.leftYMin = calibration.leftYMax; 
-    calibration.leftYMax = temp; 
+  return -1;
+}
+
+// One point: CURVE_SAMPLES reads spread over a few ms, trimmed mean.
+static int sampleAxis(uint8_t pin) {
+  uint16_t s[CURVE_SAMPLES];
+  for (int i = 0; i < CURVE_SAMPLES; i++) {
+    s[i] = analogRead(pin);
+    delayMicroseconds(CURVE_SAMPLE_GAP_US);
   }
-  if (calibration.rightXMin > calibration.rightXMax) { 
-    int temp = calibration.rightXMin; 
-    calibration.rightXMin = calibration.rightXMax; 
-    calibration.rightXMax = temp; 
+  return axisPointAverage(s, CURVE_SAMPLES);
+}
+
+static void finishCurveCalibration() {
+  Serial.println("\n>>> CURVE CALIBRATION COMPLETE <<<");
+  for (int n = 0; n < curveAxisCount(); n++) {
+    const AxisDesc &a = AXES[curveAxis(n)];
+    AxisCurve &curve = calibration.curve[a.slot];
+    int moved = axisCurveFit(curvePoints[curveAxis(n)], curve);
+    if (moved < 0) {
+      calibration.curveMask &= ~(1 << a.slot);
+      Serial.printf("  %s: too little travel, keeping three-point\n", a.label);
+      continue;
+    }
+    calibration.curveMask |= 1 << a.slot;
+    calibration.axis[a.slot] = {curve.knot[0], curve.knot[AXIS_CURVE_HALF], curve.knot[AXIS_CURVE_KNOTS - 1]};
+    if (moved) Serial.printf("  %s: %d point(s) out of order, adjusted\n", a.label, moved);
   }
-  if (calibration.rightYMin > calibration.rightYMax) { 
-    int temp = calibration.rightYMin; 
-    calibration.rightYMin = calibration.rightYMax; 
-    calibration.rightYMax = temp; 
+  printCurves();
+  buildCurveLuts();
+  Serial.println("========================================\n");
+  saveCalibration();
+}
+
+// For each curve axis in AXES order, AXIS_CURVE_HALF points towards the low
+// end (25% .. 100% of travel) and then towards the high end, confirmed with
+// the other stick's button. Then both sticks are centred (AUX) and the
+// curves are fitted and saved.
+static void handleCurveCalibration() {
+  displayCalibrationScreen();
+
+  const int perAxis = 2 * AXIS_CURVE_HALF;
+  const int centerStep = curveAxisCount() * perAxis;
+  bool announce = calibrationStep != curveStepShown;
+  curveStepShown = calibrationStep;
+  if (calibrationStep < centerStep) {
+    int i = curveAxis(calibrationStep / perAxis);
+    const AxisDesc &a = AXES[i];
+    int s = calibrationStep % perAxis;
+    bool high = s >= AXIS_CURVE_HALF;
+    int point = s % AXIS_CURVE_HALF + 1;
+    int pct = 100 * point / AXIS_CURVE_HALF;
+    bool left = a.stick == STICK_LEFT;
+    const char *dir = high ? a.pos : a.neg;
+    char button = left ? 'R' : 'L';
+    display.printf("%s %s %d%%\n", a.label, dir, pct);
+    display.printf("Hold, press %c\n", button);
+    if (announce) {
+      Serial.printf("Step %d: Hold %s joystick %s at %d%% of travel, press %c button\n",
+        calibrationStep, left ? "LEFT" : "RIGHT", dir, pct, button);
+    }
+
+    if (gestureFired(left ? GST_RIGHT_PRESS : GST_LEFT_PRESS)) {
+      int k = high ? AXIS_CURVE_HALF + point : AXIS_CURVE_HALF - point;
+      curvePoints[i][k] = sampleAxis(a.pin);
+      Serial.printf("Captured %s %s %d%%: %d\n", a.label, dir, pct, curvePoints[i][k]);
+      calibrationStep++;
+    }
+  } else if (calibrationStep == centerStep) {
+    display.println(F("Center BOTH, AUX"));
+    if (announce) Serial.printf("Step %d: Center both joysticks, press AUX switch\n", calibrationStep);
+
+    if (gestureFired(GST_AUX_PRESS)) {
+      for (int n = 0; n < curveAxisCount(); n++) {
+        int i = curveAxis(n);
+        curvePoints[i][AXIS_CURVE_HALF] = sampleAxis(AXES[i].pin);
+      }
+      calibrationStep++;
+      Serial.println("Captured center positions");
+    }
+  } else {
+    display.println(F("Curves saved"));
+    display.display();
+    finishCurveCalibration();
+    delay(2000);
+
+    inCalibrationMode = false;
+    calibratingCurve = false;
+    waitingForButtonRelease = false;
+    calibrationStep = 0;
+    return;
   }
-  
-  // Ensure center is within min/max range
-  calibration.leftXCenter = constrain(calibration.leftXCenter, calibration.leftXMin, calibration.leftXMax);
-  calibration.leftYCenter = constrain(calibration.leftYCenter, calibration.leftYMin, calibration.leftYMax);
-  calibration.rightXCenter = constrain(calibration.rightXCenter, calibration.rightXMin, calibration.rightXMax);
-  calibration.rightYCenter = constrain(calibration.rightYCenter, calibration.rightYMin, calibration.rightYMax);
-  
-  Serial.println("Validated calibration values.");
+
+  display.display();
 }
 
+// Steps 0 .. 2 * AXIS_COUNT - 1 take each axis in AXES order to its low end,
+// then its high end, confirmed with the other stick's button. Then both
+// sticks are centred (AUX) and the result is saved.
 void handleCalibration() {
-  extern int leftX, leftY, rightX, rightY;
-  extern bool leftButton, rightButton;
-  
-  // Read current joystick values
-  int lx = analogRead(LEFT_VRX);
-  int ly = analogRead(LEFT_VRY);
-  int rx = analogRead(RIGHT_VRX);
-  int ry = analogRead(RIGHT_VRY);
+  if (calibratingCurve) {
+    handleCurveCalibration();
+    return;
+  }
+
+  int raw[AXIS_COUNT];
+  for (int i = 0; i < AXIS_COUNT; i++) raw[i] = analogRead(AXES[i].pin);
   
   displayCalibrationScreen();
   
-  switch(calibrationStep) {
-    case 0:
-      display.println(F("Move LEFT joystick"));
-      display.println(F("fully UP"));
-      display.println();
-      display.println(F("Press R button"));
-      display.println(F("when ready"));
-      Serial.println("Step 0: Move LEFT joystick UP, press R button");
-      
-      if (!digitalRead(RIGHT_SW) == true) {
-        calibration.leftYMax = ly;
-        calibrationStep++;
-        Serial.print("Captured Left Y Max: "); Serial.println(calibration.leftYMax);
-        delay(500);
-      }
-      break;
-      
-    case 1:
-      display.println(F("Move LEFT joystick"));
-      display.println(F("fully DOWN"));
-      display.println();
-      display.println(F("Press R button"));
-      Serial.println("Step 1: Move LEFT joystick DOWN, press R button");
-      
-      if (!digitalRead(RIGHT_SW) == true) {
-        calibration.leftYMin = ly;
-        calibrationStep++;
-        Serial.print("Captured Left Y Min: "); Serial.println(calibration.leftYMin);
-        delay(500);
-      }
-      break;
-      
-    case 2:
-      display.println(F("Move LEFT joystick"));
-      display.println(F("fully LEFT"));
-      display.println();
-      display.println(F("Press R button"));
-      Serial.println("Step 2: Move LEFT joystick LEFT, press R button");
-      
-      if (!digitalRead(RIGHT_SW) == true) {
-        calibration.leftXMin = lx;
-        calibrationStep++;
-        Serial.print("Captured Left X Min: "); Serial.println(calibration.leftXMin);
-        delay(500);
-      }
-      break;
-      
-    case 3:
-      display.println(F("Move LEFT joystick"));
-      display.println(F("fully RIGHT"));
-      display.println();
-      display.println(F("Press R button"));
-      Serial.println("Step 3: Move LEFT joystick RIGHT, press R button");
-      
-      if (!digitalRead(RIGHT_SW) == true) {
-        calibration.leftXMax = lx;
-        calibrationStep++;
-        Serial.print("Captured Left X Max: "); Serial.println(calibration.leftXMax);
-        delay(500);
-      }
-      break;
-      
-    case 4:
-      display.println(F("Move RIGHT joystick"));
-      display.println(F("fully UP"));
-      display.println();
-      display.println(F("Press L button"));
-      Serial.println("Step 4: Move RIGHT joystick UP, press L button");
-      
-      if (!digitalRead(LEFT_SW) == true) {
-        calibration.rightYMax = ry;
-        calibrationStep++;
-        Serial.print("Captured Right Y Max: "); Serial.println(calibration.rightYMax);
-        delay(500);
-      }
-      break;
-      
-    case 5:
-      display.println(F("Move RIGHT joystick"));
-      display.println(F("fully DOWN"));
-      display.println();
-      display.println(F("Press L button"));
-      Serial.println("Step 5: Move RIGHT joystick DOWN, press L button");
-      
-      if (!digitalRead(LEFT_SW) == true) {
-        calibration.rightYMin = ry;
-        calibrationStep++;
-        Serial.print("Captured Right Y Min: "); Serial.println(calibration.rightYMin);
-        delay(500);
-      }
-      break;
-      
-    case 6:
-      display.println(F("Move RIGHT joystick"));
-      display.println(F("fully LEFT"));
-      display.println();
-      display.println(F("Press L button"));
-      Serial.println("Step 6: Move RIGHT joystick LEFT, press L button");
-      
-      if (!digitalRead(LEFT_SW) == true) {
-        calibration.rightXMin = rx;
-        calibrationStep++;
-        Serial.print("Captured Right X Min: "); Serial.println(calibration.rightXMin);
-        delay(500);
-      }
-      break;
-      
-    case 7:
-      display.println(F("Move RIGHT joystick"));
-      display.println(F("fully RIGHT"));
-      display.println();
-      display.println(F("Press L button"));
-      Serial.println("Step 7: Move RIGHT joystick RIGHT, press L button");
-      
-      if (!digitalRead(LEFT_SW) == true) {
-        calibration.rightXMax = rx;
-        calibrationStep++;
-        Serial.print("Captured Right X Max: "); Serial.println(calibration.rightXMax);
-        delay(500);
-      }
-      break;
-      
-    case 8:
-      display.println(F("Center BOTH"));
-      display.println(F("joysticks"));
-      display.println();
-      display.println(F("Press AUX switch"));
-      Serial.println("Step 8: Center both joysticks, press AUX switch");
-      
-      if (!digitalRead(AUX_SWITCH) == true) {
-        calibration.leftXCenter = lx;
-        calibration.leftYCenter = ly;
-        calibration.rightXCenter = rx;
-        calibration.rightYCenter = ry;
-        calibrationStep++;
-        Serial.println("Captured center positions");
-        delay(500);
-      }
-      break;
-      
-    case 9:
-      display.println(F("Calibration"));
-      display.println(F("Complete!"));
-      display.println();
-      display.println(F("Returning to"));
-      display.println(F("normal mode..."));
-      
-      Serial.println("\n>>> CALIBRATION COMPLETE <<<");
-      Serial.println("Left Joystick:");
-      Serial.print("  X: Min="); Serial.print(calibration.leftXMin); 
-      Serial.print(" Center="); Serial.print(calibration.leftXCenter);
-      Serial.print(" Max="); Serial.println(calibration.leftXMax);
-      Serial.print("  Y: Min="); Serial.print(calibration.leftYMin);
-      Serial.print(" Center="); Serial.print(calibration.leftYCenter);
-      Serial.print(" Max="); Serial.println(calibration.leftYMax);
-      Serial.println("Right Joystick:");
-      Serial.print("  X: Min="); Serial.print(calibration.rightXMin);
-      Serial.print(" Center="); Serial.print(calibration.rightXCenter);
-      Serial.print(" Max="); Serial.println(calibration.rightXMax);
-      Serial.print("  Y: Min="); Serial.print(calibration.rightYMin);
-      Serial.print(" Center="); Serial.print(calibration.rightYCenter);
-      Serial.print(" Max="); Serial.println(calibration.rightYMax);
-      
-      validateCalibration();
-      Serial.println("========================================\n");
-      
-      saveCalibration();
-      display.display();
-      delay(2000);
-      
-      inCalibrationMode = false;
-      waitingForButtonRelease = false;
-      calibrationStep = 0;
-      return;
+  const int centerStep = 2 * AXIS_COUNT;
+  if (calibrationStep < centerStep) {
+    int i = calibrationStep / 2;
+    const AxisDesc &a = AXES[i];
+    bool high = calibrationStep % 2;
+    bool left = a.stick == STICK_LEFT;
+    const char *stick = left ? "LEFT" : "RIGHT";
+    const char *dir = high ? a.pos : a.neg;
+    char button = left ? 'R' : 'L';
+    display.printf("Move %s joystick\n", stick);
+    display.printf("fully %s\n\n", dir);
+    display.printf("Press %c button\n", button);
+    if (calibrationStep == 0) display.println(F("when ready"));
+    Serial.printf("Step %d: Move %s joystick %s, press %c button\n", calibrationStep, stick, dir, button);
+
+    if (gestureFired(left ? GST_RIGHT_PRESS : GST_LEFT_PRESS)) {
+      AxisCal &c = calibration.axis[a.slot];
+      (high ? c.max : c.min) = raw[i];
+      calibrationStep++;
+      Serial.printf("Captured %s %s: %d\n", a.label, high ? "Max" : "Min", raw[i]);
+    }
+  } else if (calibrationStep == centerStep) {
+    display.println(F("Center BOTH"));
+    display.println(F("joysticks"));
+    display.println();
+    display.println(F("Press AUX switch"));
+    Serial.printf("Step %d: Center both joysticks, press AUX switch\n", calibrationStep);
+    
+    if (gestureFired(GST_AUX_PRESS)) {
+      for (int i = 0; i < AXIS_COUNT; i++) calibration.axis[AXES[i].slot].center = raw[i];
+      calibrationStep++;
+      Serial.println("Captured center positions");
+    }
+  } else {
+    display.println(F("Calibration"));
+    display.println(F("Complete!"));
+    display.println();
+    display.println(F("Returning to"));
+    display.println(F("normal mode..."));
+    
+    Serial.println("\n>>> CALIBRATION COMPLETE <<<");
+    printCalibration();
+    
+    validateCalibration();
+    Serial.println("========================================\n");
+
+    // New end stops and centre replace any multi-point curves.
+    calibration.curveMask = 0;
+    
+    saveCalibration();
+    display.display();
+    delay(2000);
+    
+    inCalibrationMode = false;
+    waitingForButtonRelease = false;
+    calibrationStep = 0;
+    return;
   }
   
   display.display();
@@ -0,0 +1,30 @@
+#include "controller_metrics.h"
+#include <Arduino.h>
+
+// ============================================
+// GLOBAL VARIABLES
+// ============================================
+
+const uint32_t loopEdgesUs[METRIC_HIST_BUCKETS - 1]     = {2000, 5000, 6000, 8000, 12000, 25000, 50000};
+const uint32_t intervalEdgesUs[METRIC_HIST_BUCKETS - 1] = {10000, 19000, 21000, 25000, 40000, 100000, 500000};
+const uint32_t sendCallEdgesUs[METRIC_HIST_BUCKETS - 1] = {50, 100, 200, 500, 1000, 5000, 20000};
+const uint32_t ackEdgesUs[METRIC_HIST_BUCKETS - 1]      = {500, 1000, 2000, 5000, 10000, 20000, 50000};
+const uint32_t flushEdgesUs[METRIC_HIST_BUCKETS - 1]    = {5000, 10000, 15000, 20000, 25000, 30000, 50000};
+
+ControllerMetrics metrics;
+
+static MetricsSnapshot snapshot;   // ~2 KB, kept off the loop task stack
+
+// ============================================
+// FUNCTION IMPLEMENTATIONS
+// ============================================
+
+static void writeSerial(const char *text, void *) {
+  Serial.print(text);
+}
+
+void printMetrics(MetricsFormat format) {
+  metricsTake(metrics, millis(), snapshot);
+  MetricsPrinter printer(writeSerial, nullptr);
+  printer.print(snapshot, format);
+}
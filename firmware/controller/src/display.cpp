@@ -3,6 +3,11 @@
 #include "joystick.h"
 #include "calibration.h"
 #include "espnow.h"
+#include "macro.h"
+#include "label_cache.h"
+#include "trace.h"
+#include "controller_metrics.h"
+#include "sniffer.h"
 #include <Arduino.h>
 
 // ============================================
@@ -10,6 +15,7 @@
 // ============================================
 
 Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
+unsigned long displayRenderUs = 0;   // smoothed time to draw a main frame (excl. I2C flush)
 
 // ============================================
 // FUNCTION IMPLEMENTATIONS
@@ -24,6 +30,7 @@ void initDisplay() {
   
   // Rotate display 180 degrees (upside down)
   display.setRotation(2);
+  labelCacheInit();
 }
 
 void showWelcomeScreen() {
@@ -42,29 +49,23 @@ void displayCalibrationScreen() {
   display.setTextSize(1);
   display.setTextColor(SSD1306_WHITE);
   
-  // Read current joystick values for debugging
-  int lx = analogRead(LEFT_VRX);
-  int ly = analogRead(LEFT_VRY);
-  int rx = analogRead(RIGHT_VRX);
-  int ry = analogRead(RIGHT_VRY);
-  
   // Show calibration step on display
   display.setCursor(0, 0);
   display.println(F("CALIBRATION MODE"));
   display.println();
   
-  // Display current raw values for debugging
+  // Display current raw values for debugging, two axes per line
   display.setTextSize(1);
-  display.print(F("LX:")); display.print(lx);
-  display.print(F(" LY:")); display.println(ly);
-  display.print(F("RX:")); display.print(rx);
-  display.print(F(" RY:")); display.println(ry);
+  for (int i = 0; i < AXIS_COUNT; i++) {
+    display.printf(i % 2 ? " %s:%d\n" : "%s:%d", AXES[i].label, analogRead(AXES[i].pin));
+  }
+  if (AXIS_COUNT % 2) display.println();
   display.println();
 }
 
 // Draw one joystick as a crosshair box with a dot at the stick position.
 // xbar/ybar are 0..ADC_MAP_MAX (centre = ADC_MAP_CENTER).
-static void drawStick(int x0, int y0, int sz, int xbar, int ybar, const char* label) {
+static void drawStick(int x0, int y0, int sz, int xbar, int ybar, LabelId label) {
   display.drawRect(x0, y0, sz, sz, SSD1306_WHITE);
   int cx = x0 + sz / 2;
   int cy = y0 + sz / 2;
@@ -76,31 +77,28 @@ static void drawStick(int x0, int y0, int sz, int xbar, int ybar, const char* la
   int py = y0 + 3 + (int)((long)(ADC_MAP_MAX - ybar) * (sz - 6) / ADC_MAP_MAX);
   display.fillCircle(px, py, 3, SSD1306_WHITE);
   // Label centred under the box
-  int len = strlen(label) * 6;
-  display.setCursor(x0 + (sz - len) / 2, y0 + sz + 2);
-  display.print(label);
+  drawLabel(label, x0 + (sz - labelWidth(label)) / 2, y0 + sz + 2);
 }
 
 void drawJoystickBars() {
-  int leftXBar, leftYBar, rightXBar, rightYBar;
-  mapJoystickValues(leftXBar, leftYBar, rightXBar, rightYBar);
+  int bars[AXIS_COUNT];
+  mapJoystickValues(bars);
 
   // Left stick = translation, right stick = rotation
-  drawStick(4, 13, 38, leftXBar, leftYBar, "MOVE");
-  drawStick(86, 13, 38, rightXBar, rightYBar, "TURN");
+  drawStick(4, 13, 38, bars[AXIS_LX], bars[AXIS_LY], LBL_MOVE);
+  drawStick(86, 13, 38, bars[AXIS_RX], bars[AXIS_RY], LBL_TURN);
 }
 
 void drawButtonStatus() {
   extern bool leftButton, rightButton, auxSwitch;
 
   // Button indicators in the middle column, between the two stick boxes.
-  struct Btn { const char* l; bool on; } btns[3] = {
-    {"L", leftButton}, {"R", rightButton}, {"A", auxSwitch}
+  struct Btn { LabelId l; bool on; } btns[3] = {
+    {LBL_BTN_L, leftButton}, {LBL_BTN_R, rightButton}, {LBL_BTN_A, auxSwitch}
   };
   for (int i = 0; i < 3; i++) {
     int y = 16 + i * 13;
-    display.setCursor(50, y + 1);
-    display.print(btns[i].l);
+    drawLabel(btns[i].l, 50, y + 1);
     display.drawRect(60, y, 9, 9, SSD1306_WHITE);
     if (btns[i].on) display.fillRect(62, y + 2, 5, 5, SSD1306_WHITE);
   }
@@ -110,8 +108,12 @@ void drawESPNowStatus() {
   // Top status bar: device name on the left, link indicator on the right.
   ControlDevice &dev = devices[selectedDevice];
 
-  display.setCursor(0, 0);
-  display.print(dev.name);
+  drawDeviceName(selectedDevice, 0, 0);
+
+  // Macro indicator left of the link dot.
+  if (macroState != MACRO_IDLE) {
+    drawLabel(macroState == MACRO_RECORDING ? LBL_REC : LBL_PLAY, 92, 0);
+  }
 
   // Link indicator: filled circle = linked, hollow = no link.
   if (dev.linkOk) {
@@ -123,30 +125,56 @@ void drawESPNowStatus() {
   display.drawLine(0, 10, 127, 10, SSD1306_WHITE);
 }
 
-void displayDeviceMenu(int highlight) {
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setTextColor(SSD1306_WHITE);
-
-  display.setCursor(0, 0);
-  display.println(F("SELECT DEVICE"));
-  display.drawLine(0, 10, 127, 10, SSD1306_WHITE);
+// One menu row: cursor, name, selected star, quality bar (or mean RSSI
+// while the sniffer hears the device), link mark.
+static void drawMenuRow(int row, int i, bool highlighted) {
+  int yPos = MENU_FIRST_ROW_Y + row * MENU_ROW_HEIGHT;
+  display.fillRect(0, yPos - 1, 124, MENU_ROW_HEIGHT, SSD1306_BLACK);
+  if (i < 0) return;
+  if (highlighted) drawLabel(LBL_CURSOR, 0, yPos);
+  drawDeviceName(i, 12, yPos);
+  if (i == selectedDevice) drawLabel(LBL_STAR, 18 + deviceNameWidth(i), yPos);
+  if (rssiFresh(i)) {
+    display.setCursor(84, yPos);
+    display.print(rssiStats[i].mean());
+  } else {
+    display.drawRect(90, yPos + 1, 12, 5, SSD1306_WHITE);
+    display.fillRect(91, yPos + 2, devices[i].quality / 10, 3, SSD1306_WHITE);
+  }
+  if (devices[i].linkOk) drawLabel(LBL_OK, 110, yPos);
+}
 
-  for (int i = 0; i < numDevices && i < 4; i++) {
-    int yPos = 14 + i * 10;
-    display.setCursor(0, yPos);
-    display.print(i == highlight ? F(">") : F(" "));
-    display.print(F(" "));
-    display.print(devices[i].name);
-    if (i == selectedDevice) display.print(F(" *"));
-    if (devices[i].linkOk) {
-      display.setCursor(110, yPos);
-      display.print(F("OK"));
+void displayDeviceMenu(ListView &menu) {
+  if (!menu.dirty()) return;   // nothing on screen would change: skip the I2C flush
+  bool full = menu.frameDirty();
+  if (full) {
+    display.clearDisplay();
+    display.setTextSize(1);
+    display.setTextColor(SSD1306_WHITE);
+    drawLabel(LBL_MENU_TITLE, 0, 0);
+    LabelId sortLabel = (LabelId)(LBL_SORT_TABLE + menu.sort());
+    drawLabel(sortLabel, 128 - labelWidth(sortLabel), 0);
+    display.drawLine(0, 10, 127, 10, SSD1306_WHITE);
+    drawLabel(LBL_MENU_HINT, 0, 56);
+
+    // Scroll bar on the right edge when the list does not fit.
+    if (menu.count() > MENU_ROWS) {
+      int trackH = MENU_ROWS * MENU_ROW_HEIGHT;
+      int barH = trackH * MENU_ROWS / menu.count();
+      if (barH < 3) barH = 3;
+      int barY = MENU_FIRST_ROW_Y - 1 + (trackH - barH) * menu.top() / (menu.count() - MENU_ROWS);
+      display.drawLine(126, MENU_FIRST_ROW_Y - 1, 126, MENU_FIRST_ROW_Y - 2 + trackH, SSD1306_WHITE);
+      display.fillRect(125, barY, 3, barH, SSD1306_WHITE);
     }
   }
 
-  display.setCursor(0, 56);
-  display.print(F("release = pick"));
+  for (int row = 0; row < MENU_ROWS; row++) {
+    if (!full && !menu.rowDirty(row)) continue;
+    drawMenuRow(row, menu.itemAt(row), menu.top() + row == menu.position());
+  }
+  menu.drawn();
+
+  TRACE_SCOPE(TP_I2C_FLUSH, 0);
   display.display();
 }
 
@@ -154,10 +182,18 @@ void updateMainDisplay() {
   display.clearDisplay();
   display.setTextSize(1);
   display.setTextColor(SSD1306_WHITE);
-  
+
+  TRACE_BEGIN(TP_DISPLAY, 0);
+  unsigned long start = micros();
   drawJoystickBars();
   drawButtonStatus();
   drawESPNowStatus();
-  
+  unsigned long us = micros() - start;
+  displayRenderUs = displayRenderUs ? (displayRenderUs * 7 + us) / 8 : us;
+  TRACE_END(TP_DISPLAY);
+
+  TRACE_SCOPE(TP_I2C_FLUSH, 0);
+  start = micros();
   display.display();
+  metrics.flushUs.add(micros() - start);
 }
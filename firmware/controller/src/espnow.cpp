@@ -2,6 +2,15 @@
 #include "config.h"
 #include "joystick.h"
 #include "calibration.h"
+#include "telemetry.h"
+#include "macro.h"
+#include "flightlog.h"
+#include "radio.h"
+#include "buttons.h"
+#include "trace.h"
+#include "controller_metrics.h"
+#include "params.h"
+#include "boot.h"
 #include <Arduino.h>
 #include <esp_now.h>
 #include <WiFi.h>
@@ -22,48 +31,237 @@ int selectedDevice = 0;
 // GLOBAL STATE
 // ============================================
 bool espNowReady = false;
-String lastSendStatus = "Not sent";
+std::atomic<uint32_t> lastSwitchUs(0);
 
 static unsigned long lastSendTime = 0;
 static uint8_t txSeq = 0;
+static volatile uint8_t lastTxSeq = 0;   // seq of the frame most recently handed to the radio
 
-// Time of the most recent successful delivery (ACK). Used to decide when the
-// link is genuinely dead vs. just dropping the odd ACK.
+// Time of the most recent successful delivery (ACK) from the selected device,
+// or of the switch to it. Used to decide when the link is genuinely dead vs.
+// just dropping the odd ACK.
 static volatile unsigned long lastSuccessMs = 0;
 
 // Probe result for channel sweep, written by the send callback.
+static volatile int probeDevice = -1;
 static volatile bool probeDone = false;
 static volatile bool probeOk = false;
 
+static uint8_t radioChannel = 0;         // channel the radio is tuned to, 0 = not set
+
+// Drive frames handed to the radio and not yet reported by the callback.
+// Background probes wait for them so they never share the air.
+TxTracker txTracker;
+
+// A drive frame that found no free slot (or a full WiFi queue), kept until
+// the next pass. Only the freshest is kept; older ones are superseded.
+static uint8_t heldFrame[sizeof(RedundantCommand)];
+static size_t heldLen = 0;               // 0 = nothing held
+static uint8_t heldSeq = 0;
+static uint32_t heldSinceUs = 0;
+static uint32_t nextTxDueUs = 0;         // when the next drive frame is expected
+
+RedundancyMode redundancyMode = REDUNDANCY_OFF;
+TxStats txStats = {};
+static ControlCommand lastCmd;           // PREV: rides along in the next frame
+static bool lastCmdValid = false;
+static bool repeatPending = false;       // DOUBLE: second copy not sent yet
+
+TxMode txMode = TX_UNICAST;
+LinkModeStats linkModeStats[2];
+static const uint8_t broadcastMac[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+PeerTable peerTable;
+bool pmkProvisioned = false;
+static uint8_t deviceLmk[PEER_TABLE_MAX][PEER_KEY_LEN];
+static volatile uint32_t selectedEchoes = 0;   // LinkEchoes from the selected device (bench)
+
+// Send time of each drive seq, so its echo can be turned into a round trip.
+struct SentSeq {
+  uint32_t us;
+  uint8_t mode;          // TxMode the command went out in
+  bool pending;          // no echo yet
+};
+static SentSeq sentSeq[256];
+
+// Switch latency: armed by selectDevice(), the first control command sent
+// afterwards is remembered, and the first delivered command stops the clock.
+enum { SWITCH_IDLE, SWITCH_SELECTED, SWITCH_SENT };
+static volatile uint8_t switchState = SWITCH_IDLE;
+static uint32_t switchStartUs = 0;
+static std::atomic<bool> switchDone(false);   // lastSwitchUs waiting to be printed
+
+// Publish a finished switch measurement (callback side).
+static void finishSwitch() {
+  lastSwitchUs.store(micros() - switchStartUs, std::memory_order_relaxed);
+  switchState = SWITCH_IDLE;
+  switchDone.store(true, std::memory_order_release);
+}
+
 // ============================================
 // SEND CALLBACK
 // ============================================
 void OnDataSent(const uint8_t *mac_addr, esp_now_send_status_t status) {
   bool ok = (status == ESP_NOW_SEND_SUCCESS);
-  probeOk = ok;
-  probeDone = true;
-  lastSendStatus = ok ? "Delivery Success" : "Delivery Failed";
-  if (ok) lastSuccessMs = millis();
+  uint32_t nowUs = micros();
+  uint8_t seq = lastTxSeq;
+  uint32_t txUs;
+
+  // Broadcast frames are never ACKed: the callback only says the frame left.
+  if (memcmp(mac_addr, broadcastMac, 6) == 0) {
+    if (txTracker.completed(true, nowUs, seq, txUs)) linkModeStats[TX_BROADCAST].txDone.add(txUs);
+    return;
+  }
+
+  int idx = findDevice(mac_addr);
+  if (idx < 0) return;
+
+  ControlDevice &dev = devices[idx];
+  dev.quality = (dev.quality * 7 + (ok ? 100 : 0) + 4) / 8;
+  if (ok) {
+    dev.lastAckMs = millis();
+    bootMark(BOOT_FIRST_ACK);
+  }
+
+  bool probe = idx == probeDevice;
+  if (probe) {
+    probeOk = ok;
+    probeDone = true;
+  }
+  // Probes are only sent with no drive frame out, so anything else here is
+  // the oldest tracked drive frame - also when SELECT switched devices while
+  // it was in flight, or the tracker would stay one entry behind.
+  bool tracked = !probe && txTracker.completed(ok, nowUs, seq, txUs);
+  if (idx == selectedDevice) {
+    if (tracked) {
+      linkModeStats[TX_UNICAST].txDone.add(txUs);
+      metrics.ackUs.add(txUs);
+    }
+    TRACE_INSTANT(TP_SEND_CB, seq | (ok ? 0x100 : 0));
+    metrics.lastSendStatus.set(ok ? SEND_DELIVERED : SEND_FAILED);
+    (ok ? metrics.sendDelivered : metrics.sendFailed).inc();
+    metrics.linkQuality.set(dev.quality);
+    if (ok) lastSuccessMs = dev.lastAckMs;
+    if (ok && switchState == SWITCH_SENT) finishSwitch();
+    // Background probes are logged by probeBackground(); keep the stream's
+    // ACKs to the drive link.
+    telemetryQueueAck((uint8_t)idx, seq, ok);
+    flightLog(ok ? FE_ACK : FE_NACK, (uint8_t)idx, seq);
+  }
+}
+
+// metrics.lastSendStatus as set here and by the broadcast echo below.
+const char *sendStatusName(uint8_t status) {
+  switch (status) {
+    case SEND_DELIVERED: return "Delivery Success";
+    case SEND_FAILED:    return "Delivery Failed";
+    case SEND_ECHOED:    return "Echo received";
+    default:             return "Not sent";
+  }
+}
+
+// ============================================
+// RECEIVE CALLBACK
+// ============================================
+// Receivers answer every new command and every probe with a LinkEcho. In
+// broadcast mode that is the only delivery signal; in both modes it gives
+// the round-trip time.
+void OnDataRecv(const uint8_t *mac_addr, const uint8_t *data, int len) {
+  if (len != sizeof(LinkEcho)) return;
+  LinkEcho echo;
+  memcpy(&echo, data, sizeof(echo));
+  if (echo.version != CONTROL_PROTOCOL_VERSION) return;
+  int idx = findDevice(mac_addr);
+  if (idx < 0) return;
+
+  ControlDevice &dev = devices[idx];
+  dev.lastAckMs = millis();
+  if (idx != selectedDevice) return;
+  selectedEchoes++;
+  // A probe's echo (ours from BENCH, or another controller's) says nothing
+  // about the drive stream.
+  if (echo.flags & ECHO_FLAG_PROBE) return;
+
+  TRACE_INSTANT(TP_ECHO, echo.seq);
+  metrics.echoes.inc();
+  bootMark(BOOT_FIRST_ACK);
+  SentSeq &s = sentSeq[echo.seq];
+  if (s.pending) {
+    s.pending = false;
+    LinkModeStats &st = linkModeStats[s.mode];
+    st.echoed++;
+    st.rtt.add(micros() - s.us);
+    st.rxLossPermille = echo.lossPermille;
+  }
+  if (txMode != TX_BROADCAST) return;
+
+  // Broadcast: the echo stands in for the MAC ACK.
+  metrics.lastSendStatus.set(SEND_ECHOED);
+  lastSuccessMs = dev.lastAckMs;
+  if (switchState == SWITCH_SENT) finishSwitch();
+  telemetryQueueAck((uint8_t)idx, echo.seq, true);
+  flightLog(FE_ACK, (uint8_t)idx, echo.seq);
 }
 
 // ============================================
 // PEER MANAGEMENT
 // ============================================
-// Peer is registered with channel 0 (use current radio channel); the radio
-// channel is set explicitly with esp_wifi_set_channel before sending.
-static void setPeer(const uint8_t *mac) {
-  if (esp_now_is_peer_exist(mac)) return;
+// PeerTable decides which devices hold a plain or an encrypted peer slot
+// (see peer_table.h). Every device fits at init unless more have keys than
+// the driver's encrypted limit; then switching to one that is left out
+// takes over the slot of the keyed device selected longest ago. Peers use
+// channel 0 (current radio channel); the radio channel is set explicitly
+// with esp_wifi_set_channel before sending.
+int findDevice(const uint8_t *mac) {
+  for (int i = 0; i < numDevices; i++) {
+    if (memcmp(devices[i].mac, mac, 6) == 0) return i;
+  }
+  return -1;
+}
+
+// lmk = nullptr for a plain peer. Re-adding replaces the old entry, so a
+// changed key or PMK takes effect.
+static bool setPeer(const uint8_t *mac, const uint8_t *lmk) {
+  if (esp_now_is_peer_exist(mac)) esp_now_del_peer(mac);
   esp_now_peer_info_t peer = {};
   memcpy(peer.peer_addr, mac, 6);
   peer.channel = 0;
-  peer.encrypt = false;
-  esp_now_add_peer(&peer);
+  peer.encrypt = lmk != nullptr;
+  if (lmk) memcpy(peer.lmk, lmk, ESP_NOW_KEY_LEN);
+  return esp_now_add_peer(&peer) == ESP_OK;
+}
+
+// Apply what PeerTable wants for the current keys and selected device.
+static void syncPeers() {
+  PeerChange changes[2 * PEER_TABLE_MAX];
+  int m = peerTable.update(selectedDevice, changes);
+  for (int c = 0; c < m; c++) {
+    int i = changes[c].device;
+    if (changes[c].to == PEER_NONE) {
+      esp_now_del_peer(devices[i].mac);
+    } else if (!setPeer(devices[i].mac, changes[c].to == PEER_ENCRYPTED ? deviceLmk[i] : nullptr)) {
+      peerTable.failed(i);
+      Serial.printf("[ESP-NOW] Cannot register peer %s\n", devices[i].name);
+    }
+  }
+}
+
+// One peer slot is kept for the broadcast address (broadcast mode).
+static void registerPeers() {
+  syncPeers();
+  if (!setPeer(broadcastMac, nullptr)) Serial.println("[ESP-NOW] Cannot register broadcast peer");
+  int plain = peerTable.count(PEER_PLAIN), enc = peerTable.count(PEER_ENCRYPTED);
+  Serial.printf("[ESP-NOW] %d/%d peers registered, %d encrypted\n", plain + enc, numDevices, enc);
 }
 
 // Set the radio channel and wait until it actually takes effect. Sending a
 // probe before the channel switch completes makes the sweep lock the wrong
 // channel (off by one), so confirm via read-back.
 static void setRadioChannel(uint8_t ch) {
+  TRACE_SCOPE(TP_CHANNEL, ch);
+  flightLog(FE_CHANNEL, ch, (uint16_t)selectedDevice);
+  metrics.channelSwitches.inc();
+  radioChannel = ch;
   esp_wifi_set_channel(ch, WIFI_SECOND_CHAN_NONE);
   uint8_t cur = 0;
   wifi_second_chan_t sc;
@@ -75,21 +273,93 @@ static void setRadioChannel(uint8_t ch) {
   delay(10);  // small extra settle for the PHY
 }
 
-static bool sendProbe(const uint8_t *mac) {
+static uint8_t probeSeq = 0;   // own counter so probes leave no gaps in the drive seq
+
+// Zero-motion command whose only purpose is to be ACKed; the callback
+// reports the outcome through probeDone/probeOk. Marked CONTROL_BTN_PROBE so
+// the receiver neither hands it the robot nor mixes its seq into the drive
+// stream's.
+static bool sendProbeFrame(int idx, uint8_t seq) {
   ControlCommand cmd = {};
   cmd.version = CONTROL_PROTOCOL_VERSION;
-  cmd.seq = txSeq++;
+  cmd.seq = seq;
   cmd.speed = 0;  // zeroed motion
+  cmd.buttons = CONTROL_BTN_PROBE;
+
+  // Callbacks come back in send order: let drive frames drain first so the
+  // probe's callback cannot be taken for theirs, nor theirs for the probe's.
+  uint32_t t0 = micros();
+  while (!txTracker.idle() && micros() - t0 < TX_CALLBACK_TIMEOUT_US) delayMicroseconds(50);
+  probeDevice = idx;
   probeDone = false;
   probeOk = false;
-  if (esp_now_send(mac, (uint8_t *)&cmd, sizeof(cmd)) != ESP_OK) return false;
+  return esp_now_send(devices[idx].mac, (uint8_t *)&cmd, sizeof(cmd)) == ESP_OK;
+}
+
+static bool probePending = false;   // background probe awaiting its callback
+
+static bool sendProbe(const uint8_t *mac) {
+  probePending = false;   // a blocking probe takes over the callback flags
+  lastTxSeq = probeSeq;
+  if (!sendProbeFrame(findDevice(mac), probeSeq++)) return false;
   unsigned long start = millis();
   while (!probeDone && millis() - start < 50) {
     delay(1);
   }
+  // Answered or not, later callbacks from this device are drive frames again.
+  probeDevice = -1;
   return probeDone && probeOk;
 }
 
+// Channels found by a sweep are kept in NVS, so the first lock after a
+// reboot probes the known channel instead of sweeping from 1 (up to ~1.5 s
+// to reach channel 13). A stale entry costs one failed probe, then a sweep.
+static void channelKey(int idx, char *key, size_t len) {
+  snprintf(key, len, "ch%d", idx);
+}
+
+static void loadDeviceChannels() {
+  char key[8];
+  preferences.begin("radio", true);
+  for (int i = 0; i < numDevices; i++) {
+    channelKey(i, key, sizeof(key));
+    uint8_t ch = preferences.getUChar(key, 0);
+    if (ch >= 1 && ch <= 13) devices[i].channel = ch;
+  }
+  preferences.end();
+}
+
+static void saveDeviceChannel(int idx, uint8_t ch) {
+  if (idx < 0) return;
+  char key[8];
+  channelKey(idx, key, sizeof(key));
+  preferences.begin("radio", false);
+  if (preferences.getUChar(key, 0) != ch) preferences.putUChar(key, ch);   // spare the flash
+  preferences.end();
+}
+
+// PMK and per-device LMKs, by device index like the channels. NVS is only
+// as private as the flash: without flash encryption the keys can be read
+// back from a stolen controller.
+static void lmkKey(int idx, char *key, size_t len) {
+  snprintf(key, len, "lmk%d", idx);
+}
+
+static void loadKeys() {
+  char key[8];
+  uint8_t k[PEER_KEY_LEN];
+  preferences.begin("keys", true);
+  pmkProvisioned = preferences.isKey("pmk") && preferences.getBytes("pmk", k, sizeof(k)) == sizeof(k);
+  if (pmkProvisioned) esp_now_set_pmk(k);
+  peerTable.begin(numDevices, ESP_NOW_MAX_TOTAL_PEER_NUM - 1, ESP_NOW_MAX_ENCRYPT_PEER_NUM);
+  for (int i = 0; i < numDevices && i < PEER_TABLE_MAX; i++) {
+    lmkKey(i, key, sizeof(key));
+    peerTable.setKeyed(i, preferences.isKey(key) &&
+                          preferences.getBytes(key, deviceLmk[i], PEER_KEY_LEN) == PEER_KEY_LEN);
+  }
+  preferences.end();
+}
+
 // Sweep channels 1..13 to find the one the device is reachable on.
 // Returns the channel, or 0 if not found.
 // Note: allow the radio to settle on the new channel before probing, otherwise
@@ -100,6 +370,7 @@ static uint8_t sweepChannel(const uint8_t *mac) {
     // Two attempts per channel for robustness against a single dropped frame.
     if (sendProbe(mac) || sendProbe(mac)) {
       Serial.printf("[ESP-NOW] Found device on channel %d\n", ch);
+      saveDeviceChannel(findDevice(mac), ch);
       return ch;
     }
   }
@@ -113,16 +384,36 @@ static uint8_t sweepChannel(const uint8_t *mac) {
 bool selectDevice(int index) {
   if (index < 0 || index >= numDevices) return false;
 
-  // Remove the previous peer so only the active device is registered.
-  if (selectedDevice >= 0 && selectedDevice < numDevices) {
-    esp_now_del_peer(devices[selectedDevice].mac);
-  }
+  switchStartUs = micros();
+  switchState = SWITCH_IDLE;
+  backgroundProber.reset(selectedDevice);
+  backgroundProber.reset(index);
   selectedDevice = index;
+  metrics.selectedDevice.set(index);
+  heldLen = 0;   // a held frame was meant for the previous device
 
   if (!espNowReady) return false;
 
+  syncPeers();
+  if (txMode == TX_BROADCAST && peerTable.keyed(index)) {
+    txMode = TX_UNICAST;
+    Serial.println("[ESP-NOW] Keyed device: tx mode back to UNICAST");
+  }
+
   ControlDevice &dev = devices[index];
-  setPeer(dev.mac);
+  switchState = SWITCH_SELECTED;
+
+  // Already on the device's channel: nothing to do on the radio. The next
+  // control command doubles as the probe; if it goes unanswered the normal
+  // re-acquire path takes over after params.linkDeadMs.
+  if (dev.channel != 0 && dev.channel == radioChannel) {
+    unsigned long now = millis();
+    lastSuccessMs = now;
+    dev.linkOk = dev.lastAckMs != 0 && now - dev.lastAckMs < (unsigned long)params.linkOkMs;
+    flightLog(FE_SELECT, (uint8_t)index, 2);
+    Serial.printf("[ESP-NOW] Selected %s on channel %d (no probe)\n", dev.name, dev.channel);
+    return true;
+  }
 
   // Use cached channel if known, else sweep.
   if (dev.channel != 0) {
@@ -130,6 +421,7 @@ bool selectDevice(int index) {
     if (sendProbe(dev.mac) || sendProbe(dev.mac)) {
       dev.linkOk = true;
       lastSuccessMs = millis();
+      flightLog(FE_SELECT, (uint8_t)index, 1);
       Serial.printf("[ESP-NOW] Selected %s on cached channel %d\n", dev.name, dev.channel);
       return true;
     }
@@ -140,10 +432,12 @@ bool selectDevice(int index) {
     dev.channel = ch;
     dev.linkOk = true;
     lastSuccessMs = millis();
+    flightLog(FE_SELECT, (uint8_t)index, 1);
     Serial.printf("[ESP-NOW] Selected %s, locked channel %d\n", dev.name, ch);
     return true;
   }
   dev.linkOk = false;
+  flightLog(FE_SELECT, (uint8_t)index, 0);
   Serial.printf("[ESP-NOW] Selected %s but link not found\n", dev.name);
   return false;
 }
@@ -155,6 +449,13 @@ void initESPNow() {
   WiFi.disconnect();
   delay(100);
   esp_wifi_set_ps(WIFI_PS_NONE);
+  loadRadioSettings();
+  loadDeviceChannels();
+  applyRadioProfile(radioProfile);
+  applyRadioTxPower(radioTxPowerQdbm);
+  Serial.printf("[RADIO] Profile %s", radioProfiles[radioProfile].name);
+  if (radioTxPowerQdbm) Serial.printf(", TX power %.2f dBm\n", radioTxPowerQdbm / 4.0f);
+  else Serial.println(", TX power default");
 
   Serial.print("[ESP-NOW] Controller MAC: ");
   Serial.println(WiFi.macAddress());
@@ -165,95 +466,465 @@ void initESPNow() {
     return;
   }
   esp_now_register_send_cb(esp_now_send_cb_t(OnDataSent));
+  esp_now_register_recv_cb(esp_now_recv_cb_t(OnDataRecv));
   espNowReady = true;
   Serial.println("[ESP-NOW] Ready");
+  loadKeys();
+  registerPeers();
+  txTracker.begin(TX_MAX_IN_FLIGHT, TX_CALLBACK_TIMEOUT_US);
+  backgroundProber.begin(PROBE_PERIOD_MS, PROBE_MAX_HOP_US);
+  bootMark(BOOT_RADIO_READY);
+
+  // Lock onto the default device (its saved channel first).
+  if (selectDevice(selectedDevice)) bootMark(BOOT_LINK);
+}
+
+// Fill the motion fields of cmd from the current stick/button state.
+static void buildCommandFromSticks(ControlCommand &cmd) {
+  extern bool auxSwitch;
+
+  // Which axis drives which field is the role column of AXES (joystick.h);
+  // each field's polarity is its sign_* parameter.
+  int8_t v[AXIS_ROLE_COUNT];
+  mapAxisRoles(v);
+  cmd.x   = params.signX   * v[AXIS_ROLE_X];
+  cmd.y   = params.signY   * v[AXIS_ROLE_Y];
+  cmd.rot = params.signRot * v[AXIS_ROLE_ROT];
+  // AUX engaged = speed boost (double, capped at the 255 PWM ceiling).
+  cmd.speed = auxSwitch ? (uint8_t)min(params.defaultSpeed * 2, (int32_t)255)
+                        : (uint8_t)params.defaultSpeed;
+  cmd.buttons = buttonsForCommand();
+}
+
+void setRedundancyMode(RedundancyMode mode) {
+  redundancyMode = mode;
+  lastCmdValid = false;
+  repeatPending = false;
+  txStats = {};
+}
+
+// Broadcast frames cannot be encrypted, so a keyed device is only driven
+// unicast.
+bool setTxMode(TxMode mode) {
+  if (mode == TX_BROADCAST && peerTable.keyed(selectedDevice)) {
+    Serial.println("[ESP-NOW] Broadcast frames are never encrypted; KEY CLEAR the device first");
+    return false;
+  }
+  txMode = mode;
+  return true;
+}
+
+void resetLinkModeStats() {
+  for (LinkModeStats &st : linkModeStats) {
+    st.sent = 0;
+    st.echoed = 0;
+    st.rxLossPermille = 0;
+    st.rtt.reset();
+    st.txDone.reset();
+  }
+  for (SentSeq &s : sentSeq) s.pending = false;
+}
 
-  // Lock onto the default device.
-  selectDevice(selectedDevice);
+static void holdFrame(const void *data, size_t len, uint8_t seq, uint32_t nowUs) {
+  TRACE_INSTANT(TP_HELD, seq);
+  metrics.framesHeld.inc();
+  memcpy(heldFrame, data, len);
+  heldLen = len;
+  heldSeq = seq;
+  heldSinceUs = nowUs;
+}
+
+// Hand one drive frame to the radio. With TX_MAX_IN_FLIGHT frames still
+// awaiting their callback, or the WiFi queue full, the frame is held instead
+// so it never queues behind a frame the MAC layer is retrying. A newer frame
+// replaces whatever is held. In broadcast mode the frame is prefixed with the
+// target MAC and goes to the broadcast address instead.
+static bool transmit(const uint8_t *mac, const void *data, size_t len, uint8_t seq) {
+  uint32_t nowUs = micros();
+  if (heldLen) {
+    if (heldSeq != seq) txTracker.superseded();
+    heldLen = 0;
+  }
+  if (!txTracker.hasRoom(nowUs)) {
+    holdFrame(data, len, seq, nowUs);
+    return false;
+  }
+
+  const uint8_t *dest = mac;
+  const uint8_t *frame = (const uint8_t *)data;
+  size_t frameLen = len;
+  uint8_t addressed[CONTROL_TARGET_LEN + sizeof(RedundantCommand)];
+  if (txMode == TX_BROADCAST && len <= sizeof(RedundantCommand)) {
+    memcpy(addressed, mac, CONTROL_TARGET_LEN);
+    memcpy(addressed + CONTROL_TARGET_LEN, data, len);
+    dest = broadcastMac;
+    frame = addressed;
+    frameLen += CONTROL_TARGET_LEN;
+  }
+
+  TRACE_BEGIN(TP_ESPNOW_SEND, seq);
+  esp_err_t err = esp_now_send(dest, frame, frameLen);
+  TRACE_END(TP_ESPNOW_SEND);
+  metrics.sendCallUs.add(micros() - nowUs);
+  if (err == ESP_OK) {
+    metrics.framesSent.inc();
+    txTracker.sent(seq, nowUs);
+    txStats.frames++;
+    txStats.bytes += frameLen;
+    lastTxSeq = seq;
+    return true;
+  }
+  if (err == ESP_ERR_ESPNOW_NO_MEM) {
+    txTracker.queueFull();
+    holdFrame(data, len, seq, nowUs);
+  } else {
+    txTracker.sendError();
+  }
+  return false;
+}
+
+// Retry a held frame once a slot is free. One held across a whole interval
+// (menu, blocking probe) is stale: the next command replaces it.
+static void flushHeldFrame() {
+  if (!heldLen) return;
+  uint32_t nowUs = micros();
+  if (nowUs - heldSinceUs >= params.sendIntervalMs * 1000UL) {
+    txTracker.superseded();
+    heldLen = 0;
+    return;
+  }
+  if (!txTracker.hasRoom(nowUs)) return;
+  uint8_t frame[sizeof(heldFrame)];
+  size_t len = heldLen;
+  memcpy(frame, heldFrame, len);
+  heldLen = 0;
+  transmit(devices[selectedDevice].mac, frame, len, heldSeq);
 }
 
 void sendControlCommand() {
   if (!espNowReady) return;
+  TRACE_SCOPE(TP_CMD, 0);
 
   unsigned long now = millis();
-  if (now - lastSendTime < SEND_INTERVAL) return;
-  lastSendTime = now;
+  unsigned long interval = params.sendIntervalMs;
+  flushHeldFrame();
 
-  extern int leftX, leftY, rightX, rightY;
-  extern bool leftButton, rightButton, auxSwitch;
-  extern CalibrationData calibration;
+  // DOUBLE: the second copy goes out half an interval after the first, so a
+  // short burst of interference rarely takes both. A copy that missed its
+  // slot (menu, blocking probe) is dropped rather than sent stale.
+  if (repeatPending && now - lastSendTime >= interval / 2) {
+    repeatPending = false;
+    if (now - lastSendTime < interval) {
+      transmit(devices[selectedDevice].mac, &lastCmd, sizeof(lastCmd), lastCmd.seq);
+      nextTxDueUs = micros() + (interval - interval / 2) * 1000UL;
+      return;
+    }
+  }
 
   ControlCommand cmd;
+  if (macroState == MACRO_PLAYING) {
+    // Replay paces itself from the recorded sample times.
+    if (!macroReplayNext(now, cmd)) return;
+  } else {
+    // A button edge goes out on this pass instead of waiting for the slot.
+    if (now - lastSendTime < interval && !buttonsChanged()) return;
+    buildCommandFromSticks(cmd);
+    bootMark(BOOT_FIRST_DRIVE);
+  }
+  lastSendTime = now;
+
   cmd.version = CONTROL_PROTOCOL_VERSION;
   cmd.seq = txSeq++;
-  cmd.x   = SIGN_X   * mapAxisSigned(leftX,  calibration.leftXMin,  calibration.leftXCenter,  calibration.leftXMax);
-  cmd.y   = SIGN_Y   * mapAxisSigned(leftY,  calibration.leftYMin,  calibration.leftYCenter,  calibration.leftYMax);
-  cmd.rot = SIGN_ROT * mapAxisSigned(rightX, calibration.rightXMin, calibration.rightXCenter, calibration.rightXMax);
-  // AUX engaged = speed boost (double, capped at the 255 PWM ceiling).
-  cmd.speed = auxSwitch ? (uint8_t)min(CONTROL_DEFAULT_SPEED * 2, 255)
-                        : CONTROL_DEFAULT_SPEED;
-  cmd.buttons = (leftButton ? 0x01 : 0) | (rightButton ? 0x02 : 0) | (auxSwitch ? 0x04 : 0);
+  macroRecord(now, cmd);
+  static uint32_t lastCmdUs = 0;
+  uint32_t cmdUs = micros();
+  if (lastCmdUs) metrics.cmdIntervalUs.add(cmdUs - lastCmdUs);
+  lastCmdUs = cmdUs;
+  metrics.commands.inc();
+  metrics.txSeq.set(cmd.seq);
 
   uint8_t *mac = devices[selectedDevice].mac;
-  esp_now_send(mac, (uint8_t *)&cmd, sizeof(cmd));
+  uint32_t sendStart = micros();
+  if (switchState == SWITCH_SELECTED) switchState = SWITCH_SENT;
+  txStats.commands++;
+  sentSeq[cmd.seq] = {sendStart, (uint8_t)txMode, true};
+  linkModeStats[txMode].sent++;
+  if (redundancyMode == REDUNDANCY_PREV && lastCmdValid) {
+    RedundantCommand frame = {cmd, lastCmd};
+    transmit(mac, &frame, sizeof(frame), cmd.seq);
+  } else {
+    transmit(mac, &cmd, sizeof(cmd), cmd.seq);
+  }
+  lastCmd = cmd;
+  lastCmdValid = true;
+  repeatPending = redundancyMode == REDUNDANCY_DOUBLE;
+  nextTxDueUs = sendStart + (repeatPending ? interval / 2 : interval) * 1000UL;
+  uint32_t sendUs = micros() - sendStart;
+  flightRecorder.record(sendStart, FE_CMD_SENT, (uint8_t)selectedDevice, cmd.seq);
+
+  telemetryEmitSample(sendStart);
+  telemetryEmitCommand(sendStart, (uint8_t)selectedDevice, cmd);
+  telemetryEmitTiming(sendStart, sendUs > 0xFFFF ? 0xFFFF : (uint16_t)sendUs);
+
+  // Stable link indicator: linked if we have had an ACK (in broadcast mode:
+  // an echo) recently. Individual dropped ACKs do not mean the command was
+  // lost (the robot still receives the data), so do NOT react to them.
+  devices[selectedDevice].linkOk = (now - lastSuccessMs < (unsigned long)params.linkOkMs);
+  metrics.linkOk.set(devices[selectedDevice].linkOk);
 
-  // Stable link indicator: linked if we have had an ACK recently. Individual
-  // dropped ACKs do not mean the command was lost (the robot still receives
-  // the data), so do NOT react to them.
-  devices[selectedDevice].linkOk = (now - lastSuccessMs < LINK_OK_MS);
+  if (switchDone.exchange(false, std::memory_order_acquire)) {
+    Serial.printf("[ESP-NOW] Switch to %s: %lu us to first delivered command\n",
+      devices[selectedDevice].name, (unsigned long)lastSwitchUs.load(std::memory_order_relaxed));
+  }
 
   // Re-acquire the channel ONLY after a sustained silence (the device was
   // powered off, moved channel, or went out of range). Try the current
   // channel first (instant) before falling back to a full sweep, so a brief
   // drop does not cause a multi-second blocking sweep mid-drive.
   static unsigned long lastReacquireMs = 0;
-  if (now - lastSuccessMs > LINK_DEAD_MS && now - lastReacquireMs > LINK_DEAD_MS) {
+  unsigned long deadMs = params.linkDeadMs;
+  if (now - lastSuccessMs > deadMs && now - lastReacquireMs > deadMs) {
     lastReacquireMs = now;
     Serial.println("[ESP-NOW] Link silent, re-acquiring...");
+    flightLog(FE_REACQ_START, (uint8_t)selectedDevice);
+    uint8_t found = 0;
     if (sendProbe(mac) || sendProbe(mac)) {
       lastSuccessMs = millis();  // still here, transient drop
+      found = devices[selectedDevice].channel;
+      bootMark(BOOT_LINK);
     } else {
       uint8_t ch = sweepChannel(mac);
       if (ch != 0) {
         devices[selectedDevice].channel = ch;
         lastSuccessMs = millis();
+        bootMark(BOOT_LINK);
       }
+      found = ch;
+    }
+    flightLog(FE_REACQ_END, (uint8_t)selectedDevice, found);
+  }
+}
+
+// ============================================
+// BACKGROUND PROBING
+// ============================================
+// Keeps the cached channel and link state of non-selected devices fresh so a
+// switch usually lands on the right channel without a sweep. Runs in the gap
+// between drive commands; the scheduler only hands out a probe that fits the
+// gap, and a channel hop is cut off at its budget.
+ProbeScheduler backgroundProber;
+bool backgroundProbing = true;
+uint32_t probeLateMaxUs = 0;
+
+static ProbeDecision pendingProbe;
+static unsigned long pendingSinceMs = 0;
+
+// Wait for a retune to take effect, without the settle delay the sweep uses.
+static bool waitChannel(uint8_t ch, uint32_t deadlineUs) {
+  uint8_t cur = 0;
+  wifi_second_chan_t sc;
+  do {
+    esp_wifi_get_channel(&cur, &sc);
+    if (cur == ch) return true;
+    delayMicroseconds(50);
+  } while ((int32_t)(micros() - deadlineUs) < 0);
+  return false;
+}
+
+static void finishProbe(const ProbeDecision &d, bool ok, uint32_t costUs) {
+  probeDevice = -1;
+  backgroundProber.result(d, ok, costUs);
+  flightLog(FE_PROBE, (uint8_t)d.device, d.channel | (ok ? 0x100 : 0) | (d.hop ? 0x200 : 0));
+
+  ControlDevice &dev = devices[d.device];
+  if (ok && dev.channel != d.channel) {
+    Serial.printf("[PROBE] %s answered on channel %d (was %d)\n", dev.name, d.channel, dev.channel);
+    dev.channel = d.channel;
+  }
+}
+
+// Probe on another channel and come back, within d.budgetUs.
+static void hopProbe(const ProbeDecision &d) {
+  TRACE_SCOPE(TP_PROBE, d.device | 0x100);
+  metrics.probes.inc();
+  uint8_t home = radioChannel;
+  uint32_t start = micros();
+  uint32_t deadline = start + d.budgetUs;
+  bool ok = false;
+
+  esp_wifi_set_channel(d.channel, WIFI_SECOND_CHAN_NONE);
+  if (waitChannel(d.channel, deadline) && sendProbeFrame(d.device, probeSeq++)) {
+    while (!probeDone && (int32_t)(micros() - deadline) < 0) delayMicroseconds(50);
+    ok = probeDone && probeOk;
+  }
+  esp_wifi_set_channel(home, WIFI_SECOND_CHAN_NONE);
+  waitChannel(home, micros() + 2000);
+  finishProbe(d, ok, micros() - start);
+}
+
+void probeBackground(bool driving) {
+  if (!espNowReady || !backgroundProbing || numDevices < 2 || radioChannel == 0) return;
+  if (macroState == MACRO_PLAYING) return;   // replay timing is not on the send-interval grid
+  unsigned long now = millis();
+
+  // Collect an outstanding same-channel probe.
+  if (probePending) {
+    if (!probeDone && now - pendingSinceMs < 50) return;
+    probePending = false;
+    finishProbe(pendingProbe, probeDone && probeOk, 0);
+  }
+
+  for (int i = 0; i < numDevices; i++) {
+    if (i == selectedDevice) continue;
+    unsigned long ack = devices[i].lastAckMs;
+    devices[i].linkOk = ack != 0 && now - ack < PROBE_LINK_OK_MS;
+  }
+
+  // Spare slot: the last drive command has been reported and the next one
+  // is not due yet. Outside DRIVE nothing is streamed, so the full hop
+  // budget is available.
+  uint32_t slackUs = PROBE_MAX_HOP_US + PROBE_HOP_GUARD_US;
+  if (driving) {
+    uint32_t nowUs = micros();
+    if (heldLen || txTracker.depth(nowUs) > 0) return;
+    int32_t left = (int32_t)(nextTxDueUs - nowUs);
+    slackUs = left > 0 ? left : 0;
+  }
+
+  uint8_t channels[PROBE_MAX_DEVICES];
+  int n = min(numDevices, PROBE_MAX_DEVICES);
+  for (int i = 0; i < n; i++) channels[i] = devices[i].channel;
+
+  ProbeDecision d;
+  if (!backgroundProber.next(now, slackUs, selectedDevice, radioChannel, channels, n, d)) return;
+
+  if (d.hop) {
+    hopProbe(d);
+    if (driving) {
+      int32_t late = (int32_t)(micros() - nextTxDueUs);
+      if (late > 0 && (uint32_t)late > probeLateMaxUs) probeLateMaxUs = late;
+    }
+  } else if (sendProbeFrame(d.device, probeSeq++)) {
+    TRACE_INSTANT(TP_PROBE, d.device);
+    metrics.probes.inc();
+    pendingProbe = d;
+    pendingSinceMs = now;
+    probePending = true;
+  } else {
+    finishProbe(d, false, 0);
+  }
+}
+
+// ============================================
+// LINK BENCHMARK
+// ============================================
+// Back-to-back probes to the selected device for durationMs, added to r.
+static void benchRound(uint32_t durationMs, LinkBenchResult &r) {
+  int idx = selectedDevice;
+  probePending = false;   // a pending background probe would steal the callback
+  uint32_t echoes = selectedEchoes;
+  unsigned long start = millis();
+  while (millis() - start < durationMs) {
+    uint32_t t0 = micros();
+    if (!sendProbeFrame(idx, probeSeq++)) {
+      r.sendErrors++;
+      delay(1);
+      continue;
+    }
+    r.sent++;
+    while (!probeDone && micros() - t0 < 50000) delayMicroseconds(20);
+    if (!probeDone) r.timeouts++;
+    else if (probeOk) {
+      r.acked++;
+      r.ack.add(micros() - t0);
+    } else {
+      r.failed++;
+    }
+    yield();
+  }
+  r.elapsedMs += millis() - start;
+  delay(5);   // the last frame's echo
+  probeDevice = -1;
+  r.echoed += selectedEchoes - echoes;
+}
+
+// Switches to a radio profile and fires zero-motion frames at the selected
+// device for durationMs, waiting for each callback before the next send, so
+// acked/s is the profile's delivered rate with retries and ACK latency is the
+// full send -> MAC ACK time. Leaves the radio on that profile; the caller
+// restores the saved one.
+bool runLinkBench(int profile, uint32_t durationMs, LinkBenchResult &r) {
+  r = LinkBenchResult();
+  if (!espNowReady || !applyRadioProfile(profile)) return false;
+  delay(20);   // let the PHY settle on the new rate
+  benchRound(durationMs, r);
+  return true;
+}
+
+#define CRYPTO_BENCH_ROUND_MS 250   // alternate often so drift hits both alike
+
+// The peer is re-added plain or encrypted between rounds; the MAC-layer ACK
+// comes from the receiver's radio before decryption, so ACK latency and
+// rate are measured whatever key the receiver holds. Echoes only come back
+// for frames the receiver could decode.
+bool runCryptoBench(uint32_t durationMs, LinkBenchResult &plain, LinkBenchResult &encrypted) {
+  plain = LinkBenchResult();
+  encrypted = LinkBenchResult();
+  int idx = selectedDevice;
+  if (!espNowReady || peerTable.slot(idx) != PEER_ENCRYPTED) return false;
+
+  const uint8_t *mac = devices[idx].mac;
+  for (uint32_t done = 0; done < durationMs; done += CRYPTO_BENCH_ROUND_MS) {
+    bool ok = setPeer(mac, nullptr);
+    if (ok) benchRound(CRYPTO_BENCH_ROUND_MS / 2, plain);
+    ok = setPeer(mac, deviceLmk[idx]) && ok;
+    if (!ok) {
+      peerTable.failed(idx);
+      syncPeers();
+      return false;
     }
+    benchRound(CRYPTO_BENCH_ROUND_MS / 2, encrypted);
   }
+  return true;
 }
 
-void handleSerialCommands() {
-  if (!Serial.available()) return;
-  String cmd = Serial.readStringUntil('\n');
-  cmd.trim();
-  cmd.toUpperCase();
-
-  if (cmd == "STATUS") {
-    Serial.println("\n=== ESP-NOW Status ===");
-    Serial.printf("Ready: %s\n", espNowReady ? "YES" : "NO");
-    ControlDevice &d = devices[selectedDevice];
-    Serial.printf("Device: %s  ch:%d  link:%s\n",
-      d.name, d.channel, d.linkOk ? "OK" : "--");
-    Serial.printf("Last: %s\n", lastSendStatus.c_str());
-    Serial.println("====================\n");
-  } else if (cmd == "LIST") {
-    Serial.println("\n=== Devices ===");
-    for (int i = 0; i < numDevices; i++) {
-      Serial.printf("%s%d) %s  ch:%d  link:%s\n",
-        i == selectedDevice ? "* " : "  ",
-        i, devices[i].name, devices[i].channel,
-        devices[i].linkOk ? "OK" : "--");
+bool setEspNowPmk(const uint8_t *pmk) {
+  preferences.begin("keys", false);
+  if (pmk) preferences.putBytes("pmk", pmk, PEER_KEY_LEN);
+  else if (preferences.isKey("pmk")) preferences.remove("pmk");
+  preferences.end();
+  pmkProvisioned = pmk != nullptr;
+
+  // The default PMK is only restored by esp_now_init(); takes a reboot.
+  if (!pmk) return true;
+  if (esp_now_set_pmk(pmk) != ESP_OK) return false;
+  // Encrypted peers pick up the PMK when they are added.
+  for (int i = 0; i < numDevices && i < PEER_TABLE_MAX; i++) {
+    if (peerTable.slot(i) == PEER_ENCRYPTED && !setPeer(devices[i].mac, deviceLmk[i])) {
+      peerTable.failed(i);
     }
-    Serial.println("===============\n");
-  } else if (cmd.startsWith("SELECT ")) {
-    int idx = cmd.substring(7).toInt();
-    if (selectDevice(idx)) Serial.printf("Selected device %d\n", idx);
-    else Serial.println("Select failed");
-  } else if (cmd == "HELP") {
-    Serial.println("\n=== Commands ===");
-    Serial.println("STATUS    - link status");
-    Serial.println("LIST      - list devices");
-    Serial.println("SELECT n  - select device n");
-    Serial.println("================\n");
   }
+  syncPeers();
+  return true;
+}
+
+bool setDeviceKey(int index, const uint8_t *lmk) {
+  if (index < 0 || index >= numDevices || index >= PEER_TABLE_MAX) return false;
+  char key[8];
+  lmkKey(index, key, sizeof(key));
+  preferences.begin("keys", false);
+  if (lmk) preferences.putBytes(key, lmk, PEER_KEY_LEN);
+  else if (preferences.isKey(key)) preferences.remove(key);
+  preferences.end();
+
+  if (lmk) memcpy(deviceLmk[index], lmk, PEER_KEY_LEN);
+  else memset(deviceLmk[index], 0, PEER_KEY_LEN);
+  // Same kind of slot with a new key: re-add it with the new one.
+  if (lmk && peerTable.slot(index) == PEER_ENCRYPTED && !setPeer(devices[index].mac, lmk)) {
+    peerTable.failed(index);
+  }
+  peerTable.setKeyed(index, lmk != nullptr);
+  syncPeers();
+  if (lmk && index == selectedDevice && txMode == TX_BROADCAST) txMode = TX_UNICAST;
+  return true;
 }
@@ -0,0 +1,40 @@
+#include "flightlog.h"
+#include "telemetry_frame.h"
+#include <Arduino.h>
+
+// ============================================
+// GLOBAL VARIABLES
+// ============================================
+
+FlightRecorder<FLIGHT_RECORDER_EVENTS> flightRecorder;
+
+// ============================================
+// FUNCTION IMPLEMENTATIONS
+// ============================================
+
+void flightDump() {
+  uint32_t from = flightRecorder.first();
+  uint32_t to = flightRecorder.written();
+  Serial.printf("DUMP %lu events\n", (unsigned long)(to - from));
+  Serial.write((uint8_t)0);   // delimiter, so the header text is not glued to frame 1
+  Serial.flush();
+
+  // Pack TLM_EVENTS_PER_FRAME events per frame; producers keep running, so
+  // anything overwritten while we stream is skipped.
+  FlightEvent batch[TLM_EVENTS_PER_FRAME];
+  uint8_t frame[TLM_MAX_ENCODED];
+  size_t n = 0;
+  uint32_t skipped = 0;
+  for (uint32_t i = from; i != to; i++) {
+    if (!flightRecorder.read(i, batch[n])) {
+      skipped++;
+      continue;
+    }
+    if (++n == TLM_EVENTS_PER_FRAME) {
+      Serial.write(frame, tlmEncodeFrame(TLM_EVENTS, batch, sizeof(batch), frame));
+      n = 0;
+    }
+  }
+  if (n) Serial.write(frame, tlmEncodeFrame(TLM_EVENTS, batch, n * sizeof(FlightEvent), frame));
+  Serial.printf("\nDUMP end (%lu overwritten during dump)\n", (unsigned long)skipped);
+}
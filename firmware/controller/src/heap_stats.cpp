@@ -0,0 +1,66 @@
+#include "heap_stats.h"
+#include <esp_heap_caps.h>
+#include <atomic>
+
+// ============================================
+// ALLOCATION COUNTERS
+// ============================================
+// Linker wraps around the C allocator. Everything that ends in malloc/free
+// (String, new, the Arduino core, newlib) is counted; the WiFi driver's own
+// heap_caps_* calls are not.
+
+static std::atomic<uint32_t> allocCount(0);
+static std::atomic<uint32_t> freeCount(0);
+
+#ifdef HEAP_COUNT_ALLOCS
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+void *__wrap_malloc(size_t size) {
+  allocCount.fetch_add(1, std::memory_order_relaxed);
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+  allocCount.fetch_add(1, std::memory_order_relaxed);
+  return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+  if (!ptr) allocCount.fetch_add(1, std::memory_order_relaxed);
+  else if (size == 0) freeCount.fetch_add(1, std::memory_order_relaxed);
+  return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr) {
+  if (ptr) freeCount.fetch_add(1, std::memory_order_relaxed);
+  __real_free(ptr);
+}
+}
+#endif
+
+// ============================================
+// FUNCTION IMPLEMENTATIONS
+// ============================================
+
+void heapReport(HeapReport &r) {
+  multi_heap_info_t info;
+  heap_caps_get_info(&info, MALLOC_CAP_DEFAULT);
+  r.freeBytes = info.total_free_bytes;
+  r.minFreeBytes = info.minimum_free_bytes;
+  r.largestBlock = info.largest_free_block;
+  r.allocatedBlocks = info.allocated_blocks;
+  r.allocs = allocCount.load(std::memory_order_relaxed);
+  r.frees = freeCount.load(std::memory_order_relaxed);
+}
+
+bool heapCountingEnabled() {
+#ifdef HEAP_COUNT_ALLOCS
+  return true;
+#else
+  return false;
+#endif
+}
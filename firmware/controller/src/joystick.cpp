@@ -1,16 +1,16 @@
 #include "joystick.h"
 #include "calibration.h"
+#include "buttons.h"
+#include "trace.h"
 #include "config.h"
+#include "params.h"
 #include <Arduino.h>
 
 // ============================================
 // GLOBAL VARIABLES
 // ============================================
 
-int leftX = ADC_CENTER;
-int leftY = ADC_CENTER;
-int rightX = ADC_CENTER;
-int rightY = ADC_CENTER;
+int axisRaw[AXIS_COUNT];
 bool leftButton = false;
 bool rightButton = false;
 bool auxSwitch = false;
@@ -20,180 +20,102 @@ bool auxSwitch = false;
 // ============================================
 
 void initJoystick() {
-  pinMode(LEFT_VRX, INPUT);
-  pinMode(LEFT_VRY, INPUT);
-  pinMode(LEFT_SW, INPUT_PULLUP);
-  
-  pinMode(RIGHT_VRX, INPUT);
-  pinMode(RIGHT_VRY, INPUT);
-  pinMode(RIGHT_SW, INPUT_PULLUP);
-  
-  pinMode(AUX_SWITCH, INPUT_PULLUP);
+  for (int i = 0; i < AXIS_COUNT; i++) {
+    pinMode(AXES[i].pin, INPUT);
+    axisRaw[i] = ADC_CENTER;
+  }
+
+  // Stick buttons and AUX switch are interrupt-driven
+  initButtons();
 }
 
 void readJoystickInputs() {
+  TRACE_SCOPE(TP_INPUT, 0);
+
   // Read all analog inputs
-  leftX = analogRead(LEFT_VRX);
-  leftY = analogRead(LEFT_VRY);
-  rightX = analogRead(RIGHT_VRX);
-  rightY = analogRead(RIGHT_VRY);
-  
-  // Read digital inputs (active LOW with pullup)
-  leftButton = !digitalRead(LEFT_SW);
-  rightButton = !digitalRead(RIGHT_SW);
-  auxSwitch = !digitalRead(AUX_SWITCH);
+  auto read = [](int a) { axisRaw[a] = analogRead(AXES[a].pin); };
+  AxisLoop<0, AXIS_COUNT>::run(read);
+
+  // Debounced button levels and this pass's gestures
+  updateButtons();
 }
 
 void checkCalibrationTrigger() {
-  extern unsigned long bothButtonsPressedStart;
-  extern bool bothButtonsWerePressed;
   extern bool inCalibrationMode;
   extern bool waitingForButtonRelease;
   extern int calibrationStep;
   extern unsigned long calibrationStepStart;
   
-  // Check for calibration mode trigger (both buttons held for 5 seconds)
-  if (leftButton && rightButton && !inCalibrationMode) {
-    if (!bothButtonsWerePressed) {
-      bothButtonsPressedStart = millis();
-      bothButtonsWerePressed = true;
-    } else if (millis() - bothButtonsPressedStart >= CALIBRATION_TRIGGER_TIME) {
-      // Enter calibration mode but wait for button release
-      inCalibrationMode = true;
-      waitingForButtonRelease = true;
-      calibrationStep = 0;
-      calibrationStepStart = millis();
-      Serial.println("\n>>> ENTERING CALIBRATION MODE <<<");
-      Serial.println("Release both buttons to begin...");
-    }
-  } else if (!leftButton || !rightButton) {
-    bothButtonsWerePressed = false;
-  }
+  // Both buttons held for CALIBRATION_TRIGGER_TIME
+  if (inCalibrationMode || !gestureFired(GST_CALIBRATE)) return;
+
+  // Enter calibration mode but wait for button release
+  inCalibrationMode = true;
+  waitingForButtonRelease = true;
+  calibrationStep = 0;
+  calibrationStepStart = millis();
+  Serial.println("\n>>> ENTERING CALIBRATION MODE <<<");
+  Serial.println("Release both buttons to begin...");
 }
 
-void mapJoystickValues(int& leftXBar, int& leftYBar, int& rightXBar, int& rightYBar) {
-  extern CalibrationData calibration;
-  
-  // Left X mapping with deadzone around center
-  if (abs(leftX - calibration.leftXCenter) < DEADZONE_THRESHOLD) {
-    leftXBar = ADC_MAP_CENTER;
-  } else if (leftX < calibration.leftXCenter) {
-    leftXBar = map(constrain(leftX, calibration.leftXMin, calibration.leftXCenter), 
-                   calibration.leftXMin, calibration.leftXCenter, ADC_MAP_MIN, ADC_MAP_CENTER);
-  } else {
-    leftXBar = map(constrain(leftX, calibration.leftXCenter, calibration.leftXMax), 
-                   calibration.leftXCenter, calibration.leftXMax, ADC_MAP_CENTER, ADC_MAP_MAX);
+// Multi-point curve lookup if the axis has one, else three-point mapping.
+static inline int8_t axisValue(int a) {
+  uint8_t slot = AXES[a].slot;
+  if (calibration.curveMask & (1 << slot)) {
+    return axisCurveSigned(curveLut[slot], axisRaw[a], calibration.axis[slot].center, params.deadzone);
   }
-  
-  // Left Y mapping with deadzone
-  if (abs(leftY - calibration.leftYCenter) < DEADZONE_THRESHOLD) {
-    leftYBar = ADC_MAP_CENTER;
-  } else if (leftY < calibration.leftYCenter) {
-    leftYBar = map(constrain(leftY, calibration.leftYMin, calibration.leftYCenter), 
-                   calibration.leftYMin, calibration.leftYCenter, ADC_MAP_MIN, ADC_MAP_CENTER);
-  } else {
-    leftYBar = map(constrain(leftY, calibration.leftYCenter, calibration.leftYMax), 
-                   calibration.leftYCenter, calibration.leftYMax, ADC_MAP_CENTER, ADC_MAP_MAX);
-  }
-  
-  // Right X mapping with deadzone
-  if (abs(rightX - calibration.rightXCenter) < DEADZONE_THRESHOLD) {
-    rightXBar = ADC_MAP_CENTER;
-  } else if (rightX < calibration.rightXCenter) {
-    rightXBar = map(constrain(rightX, calibration.rightXMin, calibration.rightXCenter), 
-                    calibration.rightXMin, calibration.rightXCenter, ADC_MAP_MIN, ADC_MAP_CENTER);
-  } else {
-    rightXBar = map(constrain(rightX, calibration.rightXCenter, calibration.rightXMax), 
-                    calibration.rightXCenter, calibration.rightXMax, ADC_MAP_CENTER, ADC_MAP_MAX);
-  }
-  
-  // Right Y mapping with deadzone
-  if (abs(rightY - calibration.rightYCenter) < DEADZONE_THRESHOLD) {
-    rightYBar = ADC_MAP_CENTER;
-  } else if (rightY < calibration.rightYCenter) {
-    rightYBar = map(constrain(rightY, calibration.rightYMin, calibration.rightYCenter), 
-                    calibration.rightYMin, calibration.rightYCenter, ADC_MAP_MIN, ADC_MAP_CENTER);
-  } else {
-    rightYBar = map(constrain(rightY, calibration.rightYCenter, calibration.rightYMax), 
-                    calibration.rightYCenter, calibration.rightYMax, ADC_MAP_CENTER, ADC_MAP_MAX);
+  return axisSigned(axisRaw[a], calibration.axis[slot], params.deadzone);
+}
+
+void mapJoystickValues(int bars[AXIS_COUNT]) {
+  axisScaleAll(AXES, axisRaw, calibration.axis, params.deadzone,
+               ADC_MAP_MIN, ADC_MAP_CENTER, ADC_MAP_MAX, bars);
+  if (!calibration.curveMask) return;
+  for (int a = 0; a < AXIS_COUNT; a++) {
+    if (!(calibration.curveMask & (1 << AXES[a].slot))) continue;
+    bars[a] = ADC_MAP_MIN + (axisValue(a) + 100) * (ADC_MAP_MAX - ADC_MAP_MIN) / 200;
   }
-  
-  // Constrain bars to valid range (safety net)
-  leftXBar = constrain(leftXBar, ADC_MAP_MIN, ADC_MAP_MAX);
-  leftYBar = constrain(leftYBar, ADC_MAP_MIN, ADC_MAP_MAX);
-  rightXBar = constrain(rightXBar, ADC_MAP_MIN, ADC_MAP_MAX);
-  rightYBar = constrain(rightYBar, ADC_MAP_MIN, ADC_MAP_MAX);
 }
 
-int8_t mapAxisSigned(int raw, int mn, int ctr, int mx) {
-  if (abs(raw - ctr) < DEADZONE_THRESHOLD) return 0;
-  long v;
-  if (raw < ctr) {
-    v = map(constrain(raw, mn, ctr), mn, ctr, -100, 0);
-  } else {
-    v = map(constrain(raw, ctr, mx), ctr, mx, 0, 100);
+int8_t mapAxisSigned(int axis) {
+  return axisValue(axis);
+}
+
+void mapAxisRoles(int8_t out[AXIS_ROLE_COUNT]) {
+  if (!calibration.curveMask) {
+    axisRoles(AXES, axisRaw, calibration.axis, params.deadzone, out);
+    return;
   }
-  return (int8_t)constrain(v, -100, 100);
+  for (int r = 0; r < AXIS_ROLE_COUNT; r++) out[r] = 0;
+  auto f = [&](int a) {
+    if (AXES[a].role == AXIS_ROLE_NONE) return;
+    out[AXES[a].role] = axisValue(a);
+  };
+  AxisLoop<0, AXIS_COUNT>::run(f);
 }
 
-void printJoystickDebug(int leftXBar, int leftYBar, int rightXBar, int rightYBar) {
-  extern CalibrationData calibration;
-  extern unsigned long bothButtonsPressedStart;
-  extern bool bothButtonsWerePressed;
-  
+void printJoystickDebug(const int bars[AXIS_COUNT]) {
   Serial.println("----------------------------------------");
   Serial.print("Time: "); Serial.println(millis());
-  
-  Serial.println("\n[Left Joystick]");
-  Serial.print("  VRX (GPIO4): "); Serial.print(leftX);
-  Serial.print(" [Min:"); Serial.print(calibration.leftXMin);
-  Serial.print(" Ctr:"); Serial.print(calibration.leftXCenter);
-  Serial.print(" Max:"); Serial.print(calibration.leftXMax);
-  Serial.print("] Bar:"); Serial.print(leftXBar);
-  if (leftX < calibration.leftXCenter - 500) Serial.println(" -> LEFT");
-  else if (leftX > calibration.leftXCenter + 500) Serial.println(" -> RIGHT");
-  else Serial.println(" -> CENTER");
-  
-  Serial.print("  VRY (GPIO3):  "); Serial.print(leftY);
-  Serial.print(" [Min:"); Serial.print(calibration.leftYMin);
-  Serial.print(" Ctr:"); Serial.print(calibration.leftYCenter);
-  Serial.print(" Max:"); Serial.print(calibration.leftYMax);
-  Serial.print("] Bar:"); Serial.print(leftYBar);
-  if (leftY < calibration.leftYCenter - 500) Serial.println(" -> DOWN");
-  else if (leftY > calibration.leftYCenter + 500) Serial.println(" -> UP");
-  else Serial.println(" -> CENTER");
-  
-  Serial.print("  SW (GPIO5):   "); Serial.println(leftButton ? "PRESSED" : "RELEASED");
-  
-  Serial.println("\n[Right Joystick]");
-  Serial.print("  VRX (GPIO2):  "); Serial.print(rightX);
-  Serial.print(" [Min:"); Serial.print(calibration.rightXMin);
-  Serial.print(" Ctr:"); Serial.print(calibration.rightXCenter);
-  Serial.print(" Max:"); Serial.print(calibration.rightXMax);
-  Serial.print("] Bar:"); Serial.print(rightXBar);
-  if (rightX < calibration.rightXCenter - 500) Serial.println(" -> LEFT");
-  else if (rightX > calibration.rightXCenter + 500) Serial.println(" -> RIGHT");
-  else Serial.println(" -> CENTER");
-  
-  Serial.print("  VRY (GPIO1):  "); Serial.print(rightY);
-  Serial.print(" [Min:"); Serial.print(calibration.rightYMin);
-  Serial.print(" Ctr:"); Serial.print(calibration.rightYCenter);
-  Serial.print(" Max:"); Serial.print(calibration.rightYMax);
-  Serial.print("] Bar:"); Serial.print(rightYBar);
-  if (rightY < calibration.rightYCenter - 500) Serial.println(" -> DOWN");
-  else if (rightY > calibration.rightYCenter + 500) Serial.println(" -> UP");
-  else Serial.println(" -> CENTER");
-  
-  Serial.print("  SW (GPIO0):   "); Serial.println(rightButton ? "PRESSED" : "RELEASED");
-  
+
+  for (int i = 0; i < AXIS_COUNT; i++) {
+    const AxisDesc &a = AXES[i];
+    const AxisCal &c = calibration.axis[a.slot];
+    bool left = a.stick == STICK_LEFT;
+    if (i == 0 || AXES[i - 1].stick != a.stick) {
+      Serial.println(left ? "\n[Left Joystick]" : "\n[Right Joystick]");
+    }
+    Serial.printf("  %s (GPIO%d): %4d [Min:%d Ctr:%d Max:%d%s] Bar:%d -> %s\n",
+      a.label, a.pin, axisRaw[i], c.min, c.center, c.max,
+      calibration.curveMask & (1 << a.slot) ? " curve" : "", bars[i],
+      axisRaw[i] < c.center - 500 ? a.neg : axisRaw[i] > c.center + 500 ? a.pos : "CENTER");
+    if (i == AXIS_COUNT - 1 || AXES[i + 1].stick != a.stick) {
+      Serial.printf("  SW (GPIO%d):   %s\n", left ? LEFT_SW : RIGHT_SW,
+        (left ? leftButton : rightButton) ? "PRESSED" : "RELEASED");
+    }
+  }
+
   Serial.println("\n[Aux Switch]");
   Serial.print("  GPIO7:        "); Serial.println(auxSwitch ? "ON" : "OFF");
-  
-  // Show calibration trigger status
-  if (leftButton && rightButton && bothButtonsWerePressed) {
-    unsigned long holdTime = millis() - bothButtonsPressedStart;
-    Serial.print("\n[Calibration Trigger] Holding both buttons: ");
-    Serial.print(holdTime);
-    Serial.println("ms / 5000ms");
-  }
+  Serial.print("  Bounces:      "); Serial.println(buttonBounces());
 }
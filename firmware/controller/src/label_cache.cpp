@@ -0,0 +1,142 @@
+#include "label_cache.h"
+#include "config.h"
+#include "display.h"
+#include "espnow.h"
+#include "label_blit.h"
+#include <Arduino.h>
+
+// ============================================
+// GLOBAL VARIABLES
+// ============================================
+
+bool labelCacheEnabled = true;
+
+struct LabelEntry {
+  uint16_t offset;   // into pool
+  uint8_t width;     // columns; 0 = not cached, draw with print()
+};
+
+static const char *const labelText[NUM_LABELS] = {
+  "MOVE", "TURN", "L", "R", "A", "REC", "PLAY",
+  "SELECT DEVICE", "release = pick", ">", "*", "OK",
+  "list", "qual", "seen"
+};
+
+static uint8_t pool[LABEL_POOL_BYTES];
+static uint16_t poolUsed = 0;
+static LabelEntry labels[NUM_LABELS];
+static LabelEntry names[LABEL_MAX_DEVICES];
+
+static bool cacheValid = false;
+static uint8_t builtRotation = 0;
+static int builtDevices = 0;
+
+// ============================================
+// BUILD
+// ============================================
+
+// Rasterise text into 8-pixel columns (bit n = row n). Under rotation 2 the
+// panel is mirrored on both axes, so the bits are reversed here and the
+// column order is reversed when blitting (label_blit.h).
+static LabelEntry renderLabel(const char *text) {
+  LabelEntry e = {poolUsed, 0};
+  int w = strlen(text) * 6;
+  if (w == 0 || w > 255 || poolUsed + w > LABEL_POOL_BYTES) return e;
+
+  GFXcanvas1 canvas(w, 8);
+  if (!canvas.getBuffer()) return e;
+  canvas.setTextWrap(false);
+  canvas.setTextSize(1);
+  canvas.setTextColor(1);
+  canvas.setCursor(0, 0);
+  canvas.print(text);
+
+  labelColumns(canvas, w, builtRotation == 2, pool + poolUsed);
+  poolUsed += w;
+  e.width = w;
+  return e;
+}
+
+static void buildCache() {
+  unsigned long start = micros();
+  poolUsed = 0;
+  builtRotation = display.getRotation();
+  builtDevices = numDevices;
+  memset(labels, 0, sizeof(labels));
+  memset(names, 0, sizeof(names));
+
+  // Only the unrotated and 180° layouts keep columns vertical in the
+  // page buffer; anything else is drawn with print().
+  if (builtRotation == 0 || builtRotation == 2) {
+    for (int i = 0; i < NUM_LABELS; i++) labels[i] = renderLabel(labelText[i]);
+    for (int i = 0; i < numDevices && i < LABEL_MAX_DEVICES; i++) {
+      names[i] = renderLabel(devices[i].name);
+    }
+  }
+  cacheValid = true;
+  Serial.printf("[LABEL] Cached %u bytes in %lu us\n", poolUsed, micros() - start);
+}
+
+// Device names come from the compiled-in devices[] table, so a rotation or
+// device count change is all that can make the cache stale.
+static void ensureBuilt() {
+  if (!cacheValid || builtRotation != display.getRotation() || builtDevices != numDevices) {
+    buildCache();
+  }
+}
+
+// ============================================
+// DRAW
+// ============================================
+
+// OR the columns into the SSD1306 page buffer: one byte per column, two when
+// the label straddles a page boundary.
+static void blit(const LabelEntry &e, int x, int y) {
+  labelBlit(display.getBuffer(), SCREEN_WIDTH, SCREEN_HEIGHT, pool + e.offset, e.width, x, y,
+            builtRotation == 2);
+}
+
+static void printAt(const char *text, int x, int y) {
+  display.setCursor(x, y);
+  display.print(text);
+}
+
+// ============================================
+// FUNCTION IMPLEMENTATIONS
+// ============================================
+
+void labelCacheInit() {
+  buildCache();
+}
+
+void drawLabel(LabelId id, int x, int y) {
+  if (labelCacheEnabled) {
+    ensureBuilt();
+    if (labels[id].width) {
+      blit(labels[id], x, y);
+      return;
+    }
+  }
+  printAt(labelText[id], x, y);
+}
+
+void drawDeviceName(int index, int x, int y) {
+  if (index < 0 || index >= numDevices) return;
+  if (labelCacheEnabled && index < LABEL_MAX_DEVICES) {
+    ensureBuilt();
+    if (names[index].width) {
+      blit(names[index], x, y);
+      return;
+    }
+  }
+  printAt(devices[index].name, x, y);
+}
+
+int labelWidth(LabelId id) {
+  return strlen(labelText[id]) * 6;
+}
+
+int deviceNameWidth(int index) {
+  if (index < 0 || index >= numDevices) return 0;
+  return strlen(devices[index].name) * 6;
+}
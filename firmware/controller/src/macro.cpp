@@ -0,0 +1,269 @@
+#include "macro.h"
+#include "macro_codec.h"
+#include "config.h"
+#include "params.h"
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
+
+// ============================================
+// GLOBAL VARIABLES
+// ============================================
+
+MacroState macroState = MACRO_IDLE;
+
+// Double buffer shared with the I/O task. A buffer belongs to either the
+// tick side or the I/O task; ownership is handed over with the atomic flag
+// and the other side never touches it meanwhile.
+enum { OWNER_TICK = 0, OWNER_IO = 1 };
+enum { IO_WRITE, IO_READ };
+
+static uint8_t buf[2][MACRO_BUF_SIZE];
+static uint16_t bufLen[2];
+static uint16_t bufPos[2];                  // replay read cursor
+static std::atomic<uint8_t> bufOwner[2];
+static uint8_t active = 0;
+
+static File file;
+static TaskHandle_t ioTask = nullptr;
+static volatile uint8_t ioMode = IO_WRITE;
+static volatile bool ioEof = false;
+static volatile uint32_t ioBytes = 0;
+
+static MacroEncoder encoder;
+static MacroDecoder decoder;
+
+// Recording stats
+static unsigned long recStartMs = 0;
+static unsigned long lastSampleMs = 0;
+static uint32_t recSamples = 0;
+static bool recBroken = false;              // a sample was dropped; log unusable
+
+// Replay state
+static unsigned long replayDueMs = 0;
+static int pendingRepeats = 0;
+static uint32_t replayUnderruns = 0;
+
+// ============================================
+// I/O TASK
+// ============================================
+
+static void macroIoTask(void *arg) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(50));
+    for (int i = 0; i < 2; i++) {
+      if (bufOwner[i].load(std::memory_order_acquire) != OWNER_IO) continue;
+      if (ioMode == IO_WRITE) {
+        if (bufLen[i]) ioBytes += file.write(buf[i], bufLen[i]);
+        bufLen[i] = 0;
+      } else {
+        size_t n = file.read(buf[i], MACRO_BUF_SIZE);
+        if (n == 0) ioEof = true;
+        bufLen[i] = n;
+        bufPos[i] = 0;
+      }
+      bufOwner[i].store(OWNER_TICK, std::memory_order_release);
+    }
+  }
+}
+
+static void handOff(uint8_t i) {
+  bufOwner[i].store(OWNER_IO, std::memory_order_release);
+  xTaskNotifyGive(ioTask);
+}
+
+// Block (CLI context only) until the I/O task has returned both buffers.
+static void waitForIo() {
+  unsigned long start = millis();
+  while ((bufOwner[0].load() != OWNER_TICK || bufOwner[1].load() != OWNER_TICK) &&
+         millis() - start < 1000) {
+    xTaskNotifyGive(ioTask);
+    delay(1);
+  }
+}
+
+static bool beginIo() {
+  if (!LittleFS.begin(true)) {
+    Serial.println("[MACRO] LittleFS mount failed");
+    return false;
+  }
+  if (!ioTask) {
+    xTaskCreatePinnedToCore(macroIoTask, "macroIO", 4096, nullptr, 1, &ioTask, 0);
+  }
+  for (int i = 0; i < 2; i++) {
+    bufLen[i] = 0;
+    bufPos[i] = 0;
+    bufOwner[i].store(OWNER_TICK);
+  }
+  active = 0;
+  ioBytes = 0;
+  ioEof = false;
+  return ioTask != nullptr;
+}
+
+// ============================================
+// RECORDING
+// ============================================
+
+static void appendBytes(const uint8_t *p, size_t n) {
+  if (n == 0 || recBroken) return;
+  if (bufLen[active] + n > MACRO_BUF_SIZE) {
+    handOff(active);
+    active ^= 1;
+  }
+  if (bufOwner[active].load(std::memory_order_acquire) != OWNER_TICK) {
+    // Flash is more than a full buffer behind; dropping bytes would desync
+    // the delta stream, so stop recording instead.
+    recBroken = true;
+    return;
+  }
+  memcpy(buf[active] + bufLen[active], p, n);
+  bufLen[active] += n;
+}
+
+bool macroStartRecording() {
+  if (macroState != MACRO_IDLE || !beginIo()) return false;
+  file = LittleFS.open(MACRO_PATH, "w");
+  if (!file) {
+    Serial.println("[MACRO] cannot create " MACRO_PATH);
+    return false;
+  }
+  MacroFileHeader hdr = {MACRO_MAGIC, MACRO_VERSION, (uint8_t)params.sendIntervalMs, 0};
+  file.write((const uint8_t *)&hdr, sizeof(hdr));
+
+  ioMode = IO_WRITE;
+  encoder.begin((uint8_t)params.sendIntervalMs);
+  recSamples = 0;
+  recBroken = false;
+  lastSampleMs = 0;
+  recStartMs = millis();
+  macroState = MACRO_RECORDING;
+  Serial.println("[MACRO] Recording...");
+  return true;
+}
+
+void macroStopRecording() {
+  if (macroState != MACRO_RECORDING) return;
+  macroState = MACRO_IDLE;
+
+  uint8_t tail[MACRO_MAX_ENCODED];
+  appendBytes(tail, encoder.flush(tail));
+  if (bufLen[active]) handOff(active);
+  waitForIo();
+  file.close();
+
+  unsigned long durMs = millis() - recStartMs;
+  uint32_t bytes = ioBytes + sizeof(MacroFileHeader);
+  Serial.printf("[MACRO] %s: %lu samples, %lu bytes in %.1f s (%.1f B/s, %.2f B/sample)\n",
+    recBroken ? "Recording BROKEN (flash overrun)" : "Saved",
+    (unsigned long)recSamples, (unsigned long)bytes, durMs / 1000.0f,
+    durMs ? bytes * 1000.0f / durMs : 0.0f,
+    recSamples ? (float)ioBytes / recSamples : 0.0f);
+}
+
+void macroRecord(unsigned long nowMs, const ControlCommand &cmd) {
+  if (macroState != MACRO_RECORDING) return;
+  MacroSample s;
+  s.dtMs = recSamples ? (uint16_t)min(nowMs - lastSampleMs, 0xFFFFUL) : 0;
+  s.x = cmd.x;
+  s.y = cmd.y;
+  s.rot = cmd.rot;
+  s.speed = cmd.speed;
+  s.buttons = cmd.buttons;
+  lastSampleMs = nowMs;
+  recSamples++;
+
+  uint8_t out[MACRO_MAX_ENCODED];
+  appendBytes(out, encoder.encode(s, out));
+}
+
+// ============================================
+// REPLAY
+// ============================================
+
+bool macroStartReplay() {
+  if (macroState != MACRO_IDLE || !beginIo()) return false;
+  file = LittleFS.open(MACRO_PATH, "r");
+  if (!file) {
+    Serial.println("[MACRO] no recording found");
+    return false;
+  }
+  MacroFileHeader hdr;
+  if (file.read((uint8_t *)&hdr, sizeof(hdr)) != sizeof(hdr) ||
+      hdr.magic != MACRO_MAGIC || hdr.version != MACRO_VERSION) {
+    Serial.println("[MACRO] bad recording header");
+    file.close();
+    return false;
+  }
+
+  ioMode = IO_READ;
+  decoder.begin(hdr.tickMs);
+  pendingRepeats = 0;
+  replayUnderruns = 0;
+  replayDueMs = millis();
+  handOff(0);
+  handOff(1);
+  macroState = MACRO_PLAYING;
+  Serial.println("[MACRO] Replaying...");
+  return true;
+}
+
+void macroStopReplay() {
+  if (macroState != MACRO_PLAYING) return;
+  macroState = MACRO_IDLE;
+  waitForIo();
+  file.close();
+  Serial.printf("[MACRO] Replay stopped (%lu flash underruns)\n", (unsigned long)replayUnderruns);
+}
+
+// Pull bytes until the decoder yields a sample. Returns the repeat count,
+// 0 if the I/O task has not refilled the next buffer yet, -1 at end of log.
+static int pullSample() {
+  for (;;) {
+    if (bufOwner[active].load(std::memory_order_acquire) != OWNER_TICK) return 0;
+    if (bufPos[active] >= bufLen[active]) {
+      if (bufLen[active] == 0 && ioEof) return -1;
+      handOff(active);
+      active ^= 1;
+      continue;
+    }
+    int r = decoder.push(buf[active][bufPos[active]++]);
+    if (r != 0) return r;
+  }
+}
+
+bool macroReplayNext(unsigned long nowMs, ControlCommand &cmd) {
+  if (macroState != MACRO_PLAYING) return false;
+
+  if (pendingRepeats == 0) {
+    int r = pullSample();
+    if (r == 0) {
+      // Only a miss if the next sample would already have been due.
+      if ((long)(nowMs - replayDueMs) > params.sendIntervalMs) replayUnderruns++;
+      return false;
+    }
+    if (r < 0) {
+      Serial.println("[MACRO] Replay finished");
+      macroStopReplay();
+      return false;
+    }
+    pendingRepeats = r;
+    replayDueMs += decoder.sample().dtMs;
+  }
+
+  if ((long)(nowMs - replayDueMs) < 0) return false;
+  // Keep the recorded spacing, but do not burst to catch up after a stall.
+  if (nowMs - replayDueMs > 100) replayDueMs = nowMs;
+
+  const MacroSample &s = decoder.sample();
+  cmd.x = s.x;
+  cmd.y = s.y;
+  cmd.rot = s.rot;
+  cmd.speed = s.speed;
+  cmd.buttons = s.buttons;
+
+  if (--pendingRepeats > 0) replayDueMs += s.dtMs;
+  return true;
+}
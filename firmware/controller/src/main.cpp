@@ -7,14 +7,26 @@
 #include "espnow.h"
 #include "display.h"
 #include "joystick.h"
+#include "buttons.h"
+#include "trace.h"
+#include "controller_metrics.h"
+#include "params.h"
+#include "serial_cli.h"
+#include "telemetry.h"
+#include "flightlog.h"
+#include "boot.h"
+#include "sniffer.h"
 
 // ============================================
 // SETUP
 // ============================================
 
+// Only what driving needs happens here, in the order that gets the first
+// command out soonest; the splash stays up while loop() already runs (see
+// boot.h).
 void setup() {
+  bootMark(BOOT_SETUP);
   Serial.begin(SERIAL_BAUDRATE);
-  delay(200);
 
   // Initialize I2C with custom pins
   Wire.begin(SDA_PIN, SCL_PIN);
@@ -22,7 +34,7 @@ void setup() {
   // Initialize display
   initDisplay();
   showWelcomeScreen();
-  unsigned long welcomeStartTime = millis();
+  bootMark(BOOT_SPLASH);
 
   // Configure joystick pins
   initJoystick();
@@ -31,18 +43,15 @@ void setup() {
   Serial.println("ESP-NOW Controller Started");
   Serial.println("========================================");
 
-  // Load saved calibration from NVS
+  // Load saved calibration and runtime parameters from NVS
   loadCalibration();
+  loadParams();
+  bootMark(BOOT_NVS);
 
   // Initialize ESP-NOW (sets WiFi STA, finds the default device's channel)
   initESPNow();
 
   Serial.println("Setup complete. Type 'HELP' for commands.\n");
-
-  // Wait for welcome screen to finish
-  while (millis() - welcomeStartTime < WELCOME_SCREEN_DURATION) {
-    delay(10);
-  }
 }
 
 // ============================================
@@ -54,52 +63,91 @@ enum ControllerMode { MODE_DRIVE, MODE_SELECT };
 static ControllerMode mode = MODE_DRIVE;
 
 // Device-select menu state machine. Hold the right button alone to open the
-// menu, tilt the left stick up/down to move the highlight, release to pick.
+// menu, tilt the left stick up/down to move the highlight (the list scrolls)
+// and left/right to change the sort order, release to pick.
+static ListView deviceMenu;
+
+// Sort keys and what each menu row shows, refreshed every menu pass.
+static void refreshDeviceMenu() {
+  static ListItem items[LIST_MAX_ITEMS];
+  for (int i = 0; i < numDevices; i++) {
+    const ControlDevice &d = devices[i];
+    items[i].quality = d.quality;
+    items[i].lastSeenMs = d.lastAckMs;
+    items[i].status = (d.linkOk ? 1 : 0) | (i == selectedDevice ? 2 : 0) | (d.quality / 10) << 2;
+    if (rssiFresh(i)) items[i].status |= 0x40 | (uint8_t)-rssiStats[i].mean() << 8;
+  }
+  deviceMenu.update(items, numDevices, millis());
+}
+
 static void updateDeviceSelection() {
-  extern int leftY;
-  extern CalibrationData calibration;
-  static unsigned long rightHoldStart = 0;
-  static bool rightWasHeld = false;
   static unsigned long lastTiltMs = 0;
-  static int highlight = 0;
 
   if (mode == MODE_DRIVE) {
-    if (rightButton && !leftButton) {
-      if (!rightWasHeld) {
-        rightWasHeld = true;
-        rightHoldStart = millis();
-      } else if (millis() - rightHoldStart > HOLD_TO_MENU_MS) {
-        mode = MODE_SELECT;
-        highlight = selectedDevice;
-      }
-    } else {
-      rightWasHeld = false;
+    if (gestureFired(GST_MENU_HOLD)) {
+      mode = MODE_SELECT;
+      metrics.menuOpen.set(1);
+      flightLog(FE_MODE, MODE_SELECT);
+      ListSort sort = deviceMenu.sort();   // kept from the last time
+      deviceMenu.begin(MENU_ROWS);         // full redraw over the main screen
+      deviceMenu.setSort(sort);
+      refreshDeviceMenu();
+      deviceMenu.select(selectedDevice);
     }
   } else {  // MODE_SELECT
-    int8_t y = mapAxisSigned(leftY, calibration.leftYMin,
-                             calibration.leftYCenter, calibration.leftYMax);
+    refreshDeviceMenu();
+    int8_t x = mapAxisSigned(AXIS_LX);
+    int8_t y = mapAxisSigned(AXIS_LY);
     if (millis() - lastTiltMs > MENU_TILT_REPEAT_MS) {
       if (y > 50) {  // up = previous
-        highlight = (highlight - 1 + numDevices) % numDevices;
+        deviceMenu.move(-1);
         lastTiltMs = millis();
       } else if (y < -50) {  // down = next
-        highlight = (highlight + 1) % numDevices;
+        deviceMenu.move(+1);
+        lastTiltMs = millis();
+      } else if (x > 50 || x < -50) {  // right/left = next/previous sort order
+        int step = x > 0 ? 1 : LIST_SORT_COUNT - 1;
+        deviceMenu.setSort((ListSort)((deviceMenu.sort() + step) % LIST_SORT_COUNT));
         lastTiltMs = millis();
       }
     }
-    // Release the right button to confirm the highlighted device.
-    if (!rightButton) {
+    // Release the right button to confirm the highlighted device. The level
+    // check covers a release consumed while calibration had the loop.
+    if (gestureFired(GST_MENU_PICK) || !rightButton) {
       mode = MODE_DRIVE;
-      rightWasHeld = false;
-      selectDevice(highlight);
+      metrics.menuOpen.set(0);
+      flightLog(FE_MODE, MODE_DRIVE);
+      selectDevice(deviceMenu.highlighted());
+      return;
     }
-    displayDeviceMenu(highlight);
+    displayDeviceMenu(deviceMenu);
+  }
+}
+
+// Loop period for the binary telemetry TIMING frame, measured from the top of
+// one loop() to the top of the next (so it includes the trailing delay).
+static void markLoopStart() {
+  static uint32_t loopStartUs = 0;
+  uint32_t now = micros();
+  if (loopStartUs != 0) {
+    telemetryLoopDone(now - loopStartUs);
+    metrics.loopUs.add(now - loopStartUs);
   }
+  metrics.loopPasses.inc();
+  loopStartUs = now;
 }
 
 void loop() {
-  // Handle serial commands (for setting MAC address, etc.)
+  markLoopStart();
+  bootMark(BOOT_LOOP);
+  TRACE_SCOPE(TP_LOOP, 0);
+
+  // Handle serial commands (non-blocking; runs complete lines only)
+  TRACE_BEGIN(TP_CLI, 0);
   handleSerialCommands();
+  TRACE_END(TP_CLI);
+  telemetryPoll();
+  snifferPoll();
 
   // Read all joystick inputs
   readJoystickInputs();
@@ -126,7 +174,6 @@ void loop() {
       if (!leftButton && !rightButton) {
         waitingForButtonRelease = false;
         Serial.println("Buttons released. Starting calibration...");
-        delay(500);
       }
       return;
     }
@@ -136,8 +183,11 @@ void loop() {
   }
   
   // Device-select state machine (handles its own display when in the menu)
+  TRACE_BEGIN(TP_MENU, 0);
   updateDeviceSelection();
+  TRACE_END(TP_MENU);
   if (mode == MODE_SELECT) {
+    probeBackground(false);  // refresh the menu's link marks
     delay(20);
     return;  // do not drive while selecting; robot failsafe stops it
   }
@@ -146,9 +196,10 @@ void loop() {
   // internally). The OLED refresh is slow over I2C, so throttle it to ~10 Hz
   // to avoid capping the command rate.
   sendControlCommand();
+  probeBackground(true);
 
   static unsigned long lastDisplayMs = 0;
-  if (millis() - lastDisplayMs > 100) {
+  if (millis() - lastDisplayMs > 100 && !bootSplashShowing()) {
     updateMainDisplay();
     lastDisplayMs = millis();
   }
@@ -0,0 +1,45 @@
+#include "params.h"
+#include "calibration.h"   // shared Preferences instance
+#include <Arduino.h>
+
+// ============================================
+// GLOBAL VARIABLES
+// ============================================
+
+ControllerParams params;
+
+static const ParamInfo paramDefs[] = PARAMS_TABLE(ControllerParams, CONTROLLER_PARAMS);
+
+ParamStore paramStore(paramDefs, sizeof(paramDefs) / sizeof(paramDefs[0]), &params, PARAMS_SCHEMA);
+
+// ============================================
+// FUNCTION IMPLEMENTATIONS
+// ============================================
+
+void loadParams() {
+  preferences.begin("params", true);
+  ParamLoadResult r = paramStore.load(preferences);
+  preferences.end();
+
+  switch (r) {
+    case PARAM_NOTHING_STORED:
+      Serial.println("[PARAMS] None saved, using defaults");
+      break;
+    case PARAM_SCHEMA_MISMATCH:
+      Serial.printf("[PARAMS] Saved for another schema, using defaults (schema %u)\n", PARAMS_SCHEMA);
+      break;
+    case PARAM_LOADED:
+      Serial.println("[PARAMS] Loaded from NVS");
+      if (paramStore.rejected()) {
+        Serial.printf("[PARAMS] %d saved value(s) out of range, defaults used\n", paramStore.rejected());
+      }
+      break;
+  }
+}
+
+void saveParams() {
+  preferences.begin("params", false);
+  paramStore.save(preferences);
+  preferences.end();
+  Serial.println("[PARAMS] Saved to NVS");
+}
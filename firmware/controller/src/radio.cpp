@@ -0,0 +1,80 @@
+#include "radio.h"
+#include "calibration.h"   // shared Preferences instance
+#include <string.h>
+
+// ============================================
+// GLOBAL VARIABLES
+// ============================================
+
+// 1M is the ESP-NOW default and stays the boot default. The CCK/OFDM rates
+// cut airtime (and with it latency and collision odds) at the cost of range;
+// LR trades the other way.
+const RadioProfile radioProfiles[] = {
+  {"1M",     WIFI_PHY_RATE_1M_L,      false, 1000},
+  {"2M",     WIFI_PHY_RATE_2M_S,      false, 2000},
+  {"11M",    WIFI_PHY_RATE_11M_L,     false, 11000},
+  {"6M",     WIFI_PHY_RATE_6M,        false, 6000},
+  {"24M",    WIFI_PHY_RATE_24M,       false, 24000},
+  {"54M",    WIFI_PHY_RATE_54M,       false, 54000},
+  {"LR500K", WIFI_PHY_RATE_LORA_500K, true,  500},
+  {"LR250K", WIFI_PHY_RATE_LORA_250K, true,  250},
+};
+const int numRadioProfiles = sizeof(radioProfiles) / sizeof(radioProfiles[0]);
+
+int radioProfile = 0;
+int8_t radioTxPowerQdbm = RADIO_TX_POWER_DEFAULT;
+
+// ============================================
+// FUNCTION IMPLEMENTATIONS
+// ============================================
+
+int findRadioProfile(const char *name) {
+  for (int i = 0; i < numRadioProfiles; i++) {
+    if (strcmp(radioProfiles[i].name, name) == 0) return i;
+  }
+  return -1;
+}
+
+bool applyRadioProfile(int index) {
+  if (index < 0 || index >= numRadioProfiles) return false;
+  const RadioProfile &p = radioProfiles[index];
+  uint8_t protocols = WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N;
+  if (p.longRange) protocols |= WIFI_PROTOCOL_LR;
+
+  esp_err_t err = esp_wifi_set_protocol(WIFI_IF_STA, protocols);
+  if (err == ESP_OK) err = esp_wifi_config_espnow_rate(WIFI_IF_STA, p.rate);
+  if (err != ESP_OK) {
+    Serial.printf("[RADIO] Profile %s failed: %s\n", p.name, esp_err_to_name(err));
+    return false;
+  }
+  radioProfile = index;
+  return true;
+}
+
+// The driver takes RADIO_TX_POWER_MIN..MAX and clamps to what the chip can do.
+bool applyRadioTxPower(int8_t qdbm) {
+  if (qdbm != 0) {
+    esp_err_t err = esp_wifi_set_max_tx_power(qdbm);
+    if (err != ESP_OK) {
+      Serial.printf("[RADIO] TX power %d failed: %s\n", qdbm, esp_err_to_name(err));
+      return false;
+    }
+  }
+  radioTxPowerQdbm = qdbm;
+  return true;
+}
+
+void loadRadioSettings() {
+  preferences.begin("radio", true);
+  int index = preferences.getUChar("profile", 0);
+  radioTxPowerQdbm = preferences.getChar("txpower", RADIO_TX_POWER_DEFAULT);
+  preferences.end();
+  radioProfile = index < numRadioProfiles ? index : 0;
+}
+
+void saveRadioSettings() {
+  preferences.begin("radio", false);
+  preferences.putUChar("profile", (uint8_t)radioProfile);
+  preferences.putChar("txpower", radioTxPowerQdbm);
+  preferences.end();
+}
@@ -0,0 +1,610 @@
+#include "serial_cli.h"
+#include "espnow.h"
+#include "telemetry.h"
+#include "macro.h"
+#include "flightlog.h"
+#include "display.h"
+#include "label_cache.h"
+#include "link_stats.h"
+#include "radio.h"
+#include "heap_stats.h"
+#include "trace.h"
+#include "controller_metrics.h"
+#include "params.h"
+#include "boot.h"
+#include "sniffer.h"
+#include "calibration.h"
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================
+// LINE BUFFER
+// ============================================
+
+static char lineBuf[CLI_LINE_MAX];
+static uint8_t lineLen = 0;
+static bool lineOverflow = false;   // discard until the next terminator
+
+// ============================================
+// COMMAND HANDLERS
+// ============================================
+
+static void cmdStatus(const char *args) {
+  Serial.println("\n=== ESP-NOW Status ===");
+  Serial.printf("Ready: %s\n", espNowReady ? "YES" : "NO");
+  ControlDevice &d = devices[selectedDevice];
+  Serial.printf("Device: %s  ch:%d  link:%s\n",
+    d.name, d.channel, d.linkOk ? "OK" : "--");
+  Serial.printf("Last: %s  (delivered %lu, failed %lu, echoes %lu)\n",
+    sendStatusName(metrics.lastSendStatus.load()),
+    (unsigned long)metrics.sendDelivered.load(),
+    (unsigned long)metrics.sendFailed.load(),
+    (unsigned long)metrics.echoes.load());
+  Serial.printf("Last switch: %lu us to first delivered command\n",
+    (unsigned long)lastSwitchUs.load(std::memory_order_relaxed));
+  Serial.printf("Radio: %s\n", radioProfiles[radioProfile].name);
+  Serial.printf("Stream: %s\n", telemetryStreaming ? "ON" : "OFF");
+  Serial.printf("Render: %lu us/frame (label cache %s)\n",
+    displayRenderUs, labelCacheEnabled ? "ON" : "OFF");
+  Serial.println("====================\n");
+}
+
+static void cmdList(const char *args) {
+  Serial.println("\n=== Devices ===");
+  unsigned long now = millis();
+  for (int i = 0; i < numDevices; i++) {
+    ControlDevice &d = devices[i];
+    unsigned long ack = d.lastAckMs;
+    Serial.printf("%s%d) %s  ch:%d  link:%s  q:%u%%  ack:",
+      i == selectedDevice ? "* " : "  ",
+      i, d.name, d.channel, d.linkOk ? "OK" : "--", d.quality);
+    if (ack) Serial.printf("%lu ms ago\n", now - ack);
+    else Serial.println("never");
+  }
+  Serial.println("===============\n");
+}
+
+static void cmdSelect(const char *args) {
+  if (!*args) {
+    Serial.println("Usage: SELECT n");
+    return;
+  }
+  int idx = atoi(args);
+  if (selectDevice(idx)) Serial.printf("Selected device %d\n", idx);
+  else Serial.println("Select failed");
+}
+
+static void cmdStream(const char *args) {
+  if (strcmp(args, "ON") == 0) {
+    Serial.println("Binary telemetry stream ON (send STREAM OFF to stop)");
+    Serial.flush();
+    telemetryStreaming = true;
+  } else if (strcmp(args, "OFF") == 0) {
+    telemetryStreaming = false;
+    Serial.println("\nBinary telemetry stream OFF");
+  } else {
+    Serial.println("Usage: STREAM ON|OFF");
+  }
+}
+
+static void cmdRec(const char *args) {
+  if (strcmp(args, "START") == 0) {
+    if (!macroStartRecording()) Serial.println("Cannot start recording");
+  } else if (strcmp(args, "STOP") == 0) {
+    macroStopRecording();
+  } else {
+    Serial.println("Usage: REC START|STOP");
+  }
+}
+
+static void cmdPlay(const char *args) {
+  if (strcmp(args, "STOP") == 0) {
+    macroStopReplay();
+  } else if (!*args) {
+    if (!macroStartReplay()) Serial.println("Cannot start replay");
+  } else {
+    Serial.println("Usage: PLAY [STOP]");
+  }
+}
+
+static void cmdDump(const char *args) {
+  flightDump();
+}
+
+static void cmdLabels(const char *args) {
+  if (strcmp(args, "ON") == 0) {
+    labelCacheEnabled = true;
+  } else if (strcmp(args, "OFF") == 0) {
+    labelCacheEnabled = false;
+  } else {
+    Serial.println("Usage: LABELS ON|OFF");
+    return;
+  }
+  Serial.printf("Label cache %s (see STATUS for render time)\n", args);
+}
+
+static void cmdProbe(const char *args) {
+  if (strcmp(args, "ON") == 0) {
+    backgroundProbing = true;
+  } else if (strcmp(args, "OFF") == 0) {
+    backgroundProbing = false;
+  } else if (*args) {
+    Serial.println("Usage: PROBE [ON|OFF]");
+    return;
+  }
+  const ProbeScheduler &p = backgroundProber;
+  Serial.printf("Background probing %s\n", backgroundProbing ? "ON" : "OFF");
+  Serial.printf("  probes:%lu  hops:%lu  deferred:%lu  found:%lu\n",
+    (unsigned long)p.probes, (unsigned long)p.hops,
+    (unsigned long)p.deferred, (unsigned long)p.found);
+  Serial.printf("  hop max:%lu us  drive stream delayed max:%lu us\n",
+    (unsigned long)p.hopCostMaxUs, (unsigned long)probeLateMaxUs);
+}
+
+static void cmdRssi(const char *args) {
+  if (strcmp(args, "ON") == 0 || strcmp(args, "OFF") == 0) {
+    if (!snifferEnable(args[1] == 'N')) return;
+  } else if (strcmp(args, "RESET") == 0) {
+    snifferReset();
+  } else if (*args) {
+    Serial.println("Usage: RSSI [ON|OFF|RESET]");
+    return;
+  }
+  Serial.printf("RSSI sniffer %s  frames:%lu  matched:%lu  esp-now:%lu  retries:%lu  dropped:%lu\n",
+    snifferEnabled ? "ON" : "OFF", (unsigned long)snifferStats.frames,
+    (unsigned long)snifferStats.matched, (unsigned long)snifferStats.espnow,
+    (unsigned long)snifferStats.retries, (unsigned long)snifferDropped());
+  uint32_t now = micros();
+  for (int i = 0; i < numDevices && i < PROBE_MAX_DEVICES; i++) {
+    const RssiStats &s = rssiStats[i];
+    if (!s.total) {
+      Serial.printf("  %d) %-10s no frames heard\n", i, devices[i].name);
+      continue;
+    }
+    Serial.printf("  %d) %-10s n:%2d  last:%4d  mean:%4d  min:%4d  max:%4d  noise:%4d  snr:%3d dB  %lu kbps  %lu ms ago  %s\n",
+      i, devices[i].name, s.samples(), s.last, s.mean(), s.min(), s.max(),
+      s.noiseMean(), s.snr(), (unsigned long)s.lastRateKbps,
+      (unsigned long)(now - s.lastUs) / 1000, linkDiagName(rssiDiagnose(i)));
+  }
+}
+
+static void cmdRedundancy(const char *args) {
+  static const char *const names[] = {"OFF", "PREV", "DOUBLE"};
+  for (int m = 0; m < 3; m++) {
+    if (strcmp(args, names[m]) == 0) setRedundancyMode((RedundancyMode)m);
+  }
+  if (*args && strcmp(args, names[redundancyMode]) != 0) {
+    Serial.println("Usage: REDUNDANCY [OFF|PREV|DOUBLE]");
+    return;
+  }
+
+  // Airtime per command at the 1 Mbps ESP-NOW default, against one plain
+  // ControlCommand per command. Broadcast frames are not ACKed.
+  const TxStats &t = txStats;
+  bool acked = txMode == TX_UNICAST;
+  uint32_t base = espnowAirtimeUs(sizeof(ControlCommand), 1000, acked);
+  float perCmd = t.commands ? (float)t.frames / t.commands : 0.0f;
+  float airUs = 0;
+  if (t.frames) {
+    float bytesPerFrame = (float)t.bytes / t.frames;
+    airUs = perCmd * espnowAirtimeUs((size_t)(bytesPerFrame + 0.5f), 1000, acked);
+  }
+  Serial.printf("Redundancy %s: %lu commands, %lu frames (%.2f/cmd), %lu bytes\n",
+    names[redundancyMode], (unsigned long)t.commands, (unsigned long)t.frames,
+    perCmd, (unsigned long)t.bytes);
+  Serial.printf("  airtime ~%.0f us/cmd (plain %lu us, overhead %+.0f%%)\n",
+    airUs, (unsigned long)base, t.commands ? (airUs / base - 1) * 100 : 0.0f);
+  Serial.println("  effective loss is reported by the receiver");
+}
+
+static void cmdCurve(const char *args) {
+  if (strcmp(args, "CAL") == 0) {
+    startCurveCalibration();
+    return;
+  } else if (strcmp(args, "OFF") == 0) {
+    clearCurves();
+  } else if (*args) {
+    Serial.println("Usage: CURVE [CAL|OFF]");
+    return;
+  }
+  Serial.printf("Stick curves (%d knots, raw ADC at %d..%d):\n",
+    AXIS_CURVE_KNOTS, axisCurveOut(0), axisCurveOut(AXIS_CURVE_KNOTS - 1));
+  printCurves();
+}
+
+static void printKeys() {
+  Serial.printf("PMK: %s\n", pmkProvisioned ? "set" : "ESP-NOW default");
+  Serial.printf("Peers: %d plain, %d/%d encrypted, %d slots\n",
+    peerTable.count(PEER_PLAIN), peerTable.count(PEER_ENCRYPTED),
+    peerTable.encryptedSlots(), peerTable.slots());
+  static const char *const slotNames[] = {"not registered", "plain", "encrypted"};
+  for (int i = 0; i < numDevices; i++) {
+    Serial.printf("%s%d) %-10s key:%-3s  peer:%s\n", i == selectedDevice ? "* " : "  ",
+      i, devices[i].name, peerTable.keyed(i) ? "yes" : "no", slotNames[peerTable.slot(i)]);
+  }
+}
+
+static void printBenchRow(const char *name, const LinkBenchResult &r) {
+  float loss = r.sent ? 100.0f * (r.sent - r.acked) / r.sent : 0.0f;
+  Serial.printf("  %-9s %6lu %6lu %5.1f%% %6.0f %6lu   %5lu/%5lu/%5lu/%6lu\n",
+    name, (unsigned long)r.sent, (unsigned long)r.acked, loss,
+    r.elapsedMs ? r.acked * 1000.0f / r.elapsedMs : 0.0f, (unsigned long)r.echoed,
+    (unsigned long)r.ack.avgUs(), (unsigned long)r.ack.percentileUs(0.5f),
+    (unsigned long)r.ack.percentileUs(0.95f), (unsigned long)r.ack.maxUs);
+}
+
+// Keys are 32 hex digits. They are never printed back.
+static void cmdKey(const char *args) {
+  uint8_t key[PEER_KEY_LEN];
+  int idx = -1, n = 0;
+  if (strncmp(args, "PMK ", 4) == 0) {
+    if (!parseKeyHex(args + 4, key)) {
+      Serial.println("Usage: KEY PMK <32 hex digits>");
+      return;
+    }
+    if (!setEspNowPmk(key)) Serial.println("PMK not accepted");
+  } else if (sscanf(args, "SET %d %n", &idx, &n) == 1 && n) {
+    if (!parseKeyHex(args + n, key) || !setDeviceKey(idx, key)) {
+      Serial.println("Usage: KEY SET n <32 hex digits>");
+      return;
+    }
+  } else if (sscanf(args, "CLEAR %d", &idx) == 1) {
+    if (!setDeviceKey(idx, nullptr)) {
+      Serial.println("Usage: KEY CLEAR n");
+      return;
+    }
+  } else if (strncmp(args, "BENCH", 5) == 0) {
+    unsigned seconds = 4;
+    sscanf(args + 5, "%u", &seconds);
+    if (seconds < 1 || seconds > 30) seconds = 4;
+    LinkBenchResult plain, encrypted;
+    Serial.printf("Encryption bench against %s, %us (alternating plain / encrypted)\n",
+      devices[selectedDevice].name, seconds);
+    if (!runCryptoBench(seconds * 1000, plain, encrypted)) {
+      Serial.println("Needs an encrypted selected device (KEY SET n ...)");
+      return;
+    }
+    Serial.println("  peer        sent  acked   loss  pkt/s   echo   ack avg/p50/p95/max us");
+    printBenchRow("plain", plain);
+    printBenchRow("encrypted", encrypted);
+    Serial.println("  echo = decoded by the receiver; 0 for encrypted means its key or PMK differs");
+    return;
+  } else if (*args) {
+    Serial.println("Usage: KEY [PMK hex | SET n hex | CLEAR n | BENCH [s]]");
+    return;
+  }
+  printKeys();
+}
+
+static void cmdTxMode(const char *args) {
+  static const char *const names[] = {"UNICAST", "BROADCAST"};
+  if (strcmp(args, "RESET") == 0) {
+    resetLinkModeStats();
+  } else if (*args) {
+    int m = strcmp(args, names[TX_UNICAST]) == 0 ? TX_UNICAST
+          : strcmp(args, names[TX_BROADCAST]) == 0 ? TX_BROADCAST : -1;
+    if (m < 0) {
+      Serial.println("Usage: TXMODE [UNICAST|BROADCAST|RESET]");
+      return;
+    }
+    if (!setTxMode((TxMode)m)) return;
+  }
+
+  // Round trip = command out + LinkEcho back; the echo is always broadcast,
+  // so both modes pay the same for the return leg.
+  Serial.printf("Tx mode %s (stats per mode since boot or TXMODE RESET)\n", names[txMode]);
+  Serial.println("  mode         sent   echo  rt-loss  rtt avg/p50/p95/max us    tx-done avg/p95 us  rx-loss");
+  for (int m = 0; m < 2; m++) {
+    const LinkModeStats &s = linkModeStats[m];
+    float rtLoss = s.sent ? 100.0f * (s.sent - s.echoed) / s.sent : 0.0f;
+    Serial.printf("  %-10s %6lu %6lu  %6.2f%%  %5lu/%5lu/%5lu/%6lu   %6lu/%6lu    %5.1f%%\n",
+      names[m], (unsigned long)s.sent, (unsigned long)s.echoed, rtLoss,
+      (unsigned long)s.rtt.avgUs(), (unsigned long)s.rtt.percentileUs(0.5f),
+      (unsigned long)s.rtt.percentileUs(0.95f), (unsigned long)s.rtt.maxUs,
+      (unsigned long)s.txDone.avgUs(), (unsigned long)s.txDone.percentileUs(0.95f),
+      s.rxLossPermille / 10.0f);
+  }
+  Serial.println("  rx-loss is the receiver's effective loss since it booted (last echo)");
+}
+
+static void cmdTxQueue(const char *args) {
+  if (strcmp(args, "RESET") == 0) txTracker.resetStats();
+  else if (*args) {
+    Serial.println("Usage: TXQ [RESET]");
+    return;
+  }
+  const TxTrackerStats &s = txTracker.stats();
+  Serial.printf("Tx queue: max in flight %u, now %u, peak %u\n",
+    txTracker.maxInFlight(), txTracker.depth(micros()), s.maxDepth);
+  Serial.printf("  sent %lu  acked %lu  failed %lu\n",
+    (unsigned long)s.sent, (unsigned long)s.acked, (unsigned long)s.failed);
+  Serial.printf("  superseded %lu  queue-full %lu  send-errors %lu  timeouts %lu\n",
+    (unsigned long)s.superseded, (unsigned long)s.queueFull,
+    (unsigned long)s.sendErrors, (unsigned long)s.timeouts);
+  Serial.print("  depth at send:");
+  for (int d = 0; d < TX_MAX_IN_FLIGHT_CAP; d++) Serial.printf(" %d:%lu", d, (unsigned long)s.depthAtSend[d]);
+  Serial.println();
+}
+
+// Deltas are against the previous HEAP call, so two calls a few seconds
+// apart while driving show whether the loop allocates in steady state.
+static void cmdHeap(const char *args) {
+  static HeapReport last;
+  static unsigned long lastMs = 0;
+  HeapReport r;
+  heapReport(r);
+  unsigned long now = millis();
+
+  Serial.printf("Heap: free %u  min-ever %u  largest block %u  live blocks %u\n",
+    (unsigned)r.freeBytes, (unsigned)r.minFreeBytes, (unsigned)r.largestBlock,
+    (unsigned)r.allocatedBlocks);
+  if (heapCountingEnabled()) {
+    Serial.printf("  allocs %lu  frees %lu since boot\n", (unsigned long)r.allocs, (unsigned long)r.frees);
+  } else {
+    Serial.println("  alloc counting off (build the controller-diag env to count)");
+  }
+  if (lastMs) {
+    Serial.printf("  since last HEAP (%lu ms): %ld allocs, %ld frees, %+ld bytes free\n",
+      now - lastMs, (long)(r.allocs - last.allocs), (long)(r.frees - last.frees),
+      (long)r.freeBytes - (long)last.freeBytes);
+  }
+  lastMs = now;
+  heapReport(last);   // after printing, so our own output is not in the next delta
+}
+
+static void cmdTrace(const char *args) {
+#if TRACE_ENABLED
+  if (strcmp(args, "DUMP") == 0) {
+    traceDump();
+    return;
+  }
+  if (strcmp(args, "CLEAR") == 0) {
+    traceClear();
+  } else if (strcmp(args, "BENCH") == 0) {
+    Serial.printf("Trace point cost: %lu ns (1000 instants vs empty loop)\n",
+      (unsigned long)traceBenchNs(1000));
+  } else if (*args) {
+    Serial.println("Usage: TRACE [DUMP|CLEAR|BENCH]");
+    return;
+  }
+  uint32_t n = traceEventsSinceClear();
+  Serial.printf("Trace: %lu events since clear, ring holds %u (%u bytes RAM)\n",
+    (unsigned long)n, (unsigned)(n < TRACE_EVENTS ? n : TRACE_EVENTS),
+    (unsigned)sizeof(traceRecorder));
+#else
+  Serial.println("Tracing compiled out (TRACE_ENABLED 0)");
+#endif
+}
+
+static void cmdMetrics(const char *args) {
+  if (strcmp(args, "RESET") == 0) {
+    metrics.reset();
+    Serial.println("Metrics counters and histograms reset");
+  } else if (strcmp(args, "CSV") == 0) {
+    printMetrics(METRICS_CSV);
+  } else if (strcmp(args, "JSON") == 0) {
+    printMetrics(METRICS_JSON);
+  } else if (*args) {
+    Serial.println("Usage: METRICS [CSV|JSON|RESET]");
+  } else {
+    printMetrics(METRICS_HUMAN);
+  }
+}
+
+static void printParam(int i) {
+  const ParamInfo &p = paramStore.info(i);
+  int32_t v = paramStore.get(i);
+  Serial.printf("%c %-10s %6ld %-4s", v != p.def ? '*' : ' ', p.key, (long)v, p.unit);
+  char range[24];
+  if (p.type == PARAM_SIGN) snprintf(range, sizeof(range), "-1|1");
+  else snprintf(range, sizeof(range), "%ld..%ld", (long)p.min, (long)p.max);
+  Serial.printf("  %-10s  %s\n", range, p.help);
+}
+
+static void cmdGet(const char *args) {
+  if (*args) {
+    int i = paramStore.find(args);
+    if (i < 0) Serial.printf("Unknown parameter %s (GET lists them)\n", args);
+    else printParam(i);
+    return;
+  }
+  Serial.println("\n=== Parameters (* = not default) ===");
+  for (int i = 0; i < paramStore.count(); i++) printParam(i);
+  if (paramStore.dirty()) Serial.println("Unsaved changes: SAVE to keep them across reboots");
+}
+
+static void cmdSet(const char *args) {
+  if (strcmp(args, "DEFAULTS") == 0) {
+    paramStore.resetDefaults();
+    Serial.println("Parameters back to defaults (SAVE to keep)");
+    return;
+  }
+  char name[16];
+  const char *sp = strchr(args, ' ');
+  size_t len = sp ? (size_t)(sp - args) : 0;
+  if (!sp || len >= sizeof(name)) {
+    Serial.println("Usage: SET name value | SET DEFAULTS");
+    return;
+  }
+  memcpy(name, args, len);
+  name[len] = '\0';
+  char *end;
+  long v = strtol(sp + 1, &end, 10);
+  int i = paramStore.find(name);
+  if (i < 0) {
+    Serial.printf("Unknown parameter %s (GET lists them)\n", name);
+  } else if (end == sp + 1 || *end) {
+    Serial.println("Usage: SET name value | SET DEFAULTS");
+  } else if (paramStore.set(i, (int32_t)v) == PARAM_OUT_OF_RANGE) {
+    const ParamInfo &p = paramStore.info(i);
+    if (p.type == PARAM_SIGN) Serial.printf("%s must be -1 or 1\n", p.key);
+    else Serial.printf("%s must be %ld..%ld\n", p.key, (long)p.min, (long)p.max);
+  } else {
+    printParam(i);
+  }
+}
+
+static void cmdSave(const char *args) {
+  saveParams();
+}
+
+static void cmdBoot(const char *args) {
+  printBootTimeline();
+}
+
+static void printRadio() {
+  Serial.print("Radio profiles:");
+  for (int i = 0; i < numRadioProfiles; i++) {
+    Serial.printf(" %s%s", i == radioProfile ? "*" : "", radioProfiles[i].name);
+  }
+  if (radioTxPowerQdbm) Serial.printf("  TX power %.2f dBm\n", radioTxPowerQdbm / 4.0f);
+  else Serial.println("  TX power default");
+}
+
+static void cmdRadio(const char *args) {
+  if (strncmp(args, "POWER", 5) == 0) {
+    const char *v = args + 5;
+    while (*v == ' ') v++;
+    // dBm, 0 = back to the driver default (applies after a reboot)
+    int qdbm = (int)(atof(v) * 4 + 0.5f);
+    if (!*v || (qdbm != 0 && (qdbm < RADIO_TX_POWER_MIN || qdbm > RADIO_TX_POWER_MAX))) {
+      Serial.printf("Usage: RADIO POWER dBm (%d..%d, 0 = default)\n",
+        RADIO_TX_POWER_MIN / 4, RADIO_TX_POWER_MAX / 4);
+      return;
+    }
+    if (!applyRadioTxPower((int8_t)qdbm)) return;
+    saveRadioSettings();
+  } else if (*args) {
+    int p = findRadioProfile(args);
+    if (p < 0) {
+      Serial.println("Usage: RADIO [profile | POWER dBm]");
+      printRadio();
+      return;
+    }
+    if (!applyRadioProfile(p)) return;
+    saveRadioSettings();
+  }
+  printRadio();
+}
+
+// BENCH [profile|ALL] [seconds]: blocking, drive commands pause meanwhile
+// (the receiver's failsafe ramps to zero). Restores the saved profile.
+static void cmdBench(const char *args) {
+  char name[16] = "ALL";
+  unsigned seconds = 2;
+  sscanf(args, "%15s %u", name, &seconds);
+  if (seconds < 1 || seconds > 30) seconds = 2;
+  int only = strcmp(name, "ALL") == 0 ? -1 : findRadioProfile(name);
+  if (only < 0 && strcmp(name, "ALL") != 0) {
+    Serial.println("Usage: BENCH [profile|ALL] [seconds]");
+    return;
+  }
+
+  int saved = radioProfile;
+  Serial.printf("Link bench against %s, %us per profile\n", devices[selectedDevice].name, seconds);
+  Serial.println("  profile     sent  acked   loss  pkt/s   echo   ack avg/p50/p95/max us");
+  for (int p = 0; p < numRadioProfiles; p++) {
+    if (only >= 0 && p != only) continue;
+    LinkBenchResult r;
+    if (!runLinkBench(p, seconds * 1000, r)) {
+      Serial.printf("  %-9s   (not run)\n", radioProfiles[p].name);
+      continue;
+    }
+    printBenchRow(radioProfiles[p].name, r);
+  }
+  applyRadioProfile(saved);
+  Serial.printf("Back on %s\n", radioProfiles[radioProfile].name);
+}
+
+static void cmdHelp(const char *args);
+
+static const CliCommand commands[] = {
+  {"STATUS", cmdStatus, "link status"},
+  {"LIST",   cmdList,   "list devices"},
+  {"SELECT", cmdSelect, "select device n"},
+  {"STREAM", cmdStream, "ON|OFF binary telemetry"},
+  {"REC",    cmdRec,    "START|STOP record driving macro"},
+  {"PLAY",   cmdPlay,   "[STOP] replay recorded macro"},
+  {"DUMP",   cmdDump,   "stream flight recorder (binary)"},
+  {"LABELS", cmdLabels, "ON|OFF pre-rendered OLED labels"},
+  {"PROBE",  cmdProbe,  "[ON|OFF] background probing + stats"},
+  {"RSSI",   cmdRssi,   "[ON|OFF|RESET] promiscuous RSSI / noise per device"},
+  {"CURVE",  cmdCurve,  "[CAL|OFF] multi-point stick calibration"},
+  {"KEY",    cmdKey,    "[PMK|SET n|CLEAR n|BENCH] ESP-NOW encryption keys"},
+  {"REDUNDANCY", cmdRedundancy, "[OFF|PREV|DOUBLE] redundant sends + airtime"},
+  {"TXMODE", cmdTxMode, "[UNICAST|BROADCAST|RESET] addressing + echo stats"},
+  {"TXQ",    cmdTxQueue, "[RESET] in-flight frames, drops, queue-full"},
+  {"BOOT",   cmdBoot,   "boot timeline: start -> radio -> first ACK -> first drive"},
+  {"HEAP",   cmdHeap,   "free / min-ever heap, alloc counts since last HEAP"},
+  {"METRICS", cmdMetrics, "[CSV|JSON|RESET] counters, gauges, histograms"},
+  {"TRACE",  cmdTrace,  "[DUMP|CLEAR|BENCH] event trace (binary dump)"},
+  {"GET",    cmdGet,    "[name] runtime parameters"},
+  {"SET",    cmdSet,    "name value | DEFAULTS (until SAVE)"},
+  {"SAVE",   cmdSave,   "write parameters to NVS"},
+  {"RADIO",  cmdRadio,  "[profile | POWER dBm] PHY rate / LR / TX power"},
+  {"BENCH",  cmdBench,  "[profile|ALL] [s] link benchmark per profile"},
+  {"HELP",   cmdHelp,   "this list"},
+};
+static const int numCommands = sizeof(commands) / sizeof(commands[0]);
+
+static void cmdHelp(const char *args) {
+  Serial.println("\n=== Commands ===");
+  for (int i = 0; i < numCommands; i++) {
+    Serial.printf("%-11s - %s\n", commands[i].name, commands[i].help);
+  }
+  Serial.println("================\n");
+}
+
+// ============================================
+// DISPATCH
+// ============================================
+
+static void runLine(char *line) {
+  // Trim and upper-case in place.
+  while (*line == ' ' || *line == '\t') line++;
+  char *end = line + strlen(line);
+  while (end > line && (end[-1] == ' ' || end[-1] == '\t')) *--end = '\0';
+  if (!*line) return;
+  for (char *p = line; *p; p++) {
+    if (*p >= 'a' && *p <= 'z') *p -= 'a' - 'A';
+  }
+
+  // Split the command word from its arguments.
+  char *args = line;
+  while (*args && *args != ' ') args++;
+  if (*args) {
+    *args++ = '\0';
+    while (*args == ' ') args++;
+  }
+
+  for (int i = 0; i < numCommands; i++) {
+    if (strcmp(line, commands[i].name) == 0) {
+      commands[i].handler(args);
+      return;
+    }
+  }
+  Serial.printf("Unknown command '%s' (HELP for list)\n", line);
+}
+
+void handleSerialCommands() {
+  // Bounded per call so a flood of input cannot starve the control loop.
+  for (int budget = CLI_LINE_MAX; budget > 0 && Serial.available(); budget--) {
+    int c = Serial.read();
+    if (c < 0) break;
+    if (c == '\n' || c == '\r') {
+      if (lineOverflow) {
+        Serial.println("Line too long, ignored");
+      } else {
+        lineBuf[lineLen] = '\0';
+        runLine(lineBuf);
+      }
+      lineLen = 0;
+      lineOverflow = false;
+    } else if (lineLen < CLI_LINE_MAX - 1) {
+      lineBuf[lineLen++] = (char)c;
+    } else {
+      lineOverflow = true;
+    }
+  }
+}
@@ -0,0 +1,102 @@
+#include "sniffer.h"
+#include "espnow.h"
+#include <esp_wifi.h>
+
+// ============================================
+// GLOBAL VARIABLES
+// ============================================
+
+bool snifferEnabled = false;
+RssiStats rssiStats[PROBE_MAX_DEVICES];
+SnifferStats snifferStats = {};
+
+static SniffRing<SNIFF_RING_LEN> sniffRing;
+
+// ============================================
+// PROMISCUOUS CALLBACK (WiFi task)
+// ============================================
+// Copies the radio metadata and the first SNIFF_HDR_BYTES of the frame and
+// returns; matching and statistics happen in snifferPoll().
+static void IRAM_ATTR onPromiscuous(void *buf, wifi_promiscuous_pkt_type_t type) {
+  if (type != WIFI_PKT_MGMT && type != WIFI_PKT_DATA) return;
+  const wifi_promiscuous_pkt_t *pkt = (const wifi_promiscuous_pkt_t *)buf;
+  const wifi_pkt_rx_ctrl_t &rx = pkt->rx_ctrl;
+  uint16_t len = rx.sig_len < SNIFF_HDR_BYTES ? rx.sig_len : SNIFF_HDR_BYTES;
+  if (!sniffWanted(pkt->payload, len)) return;
+
+  SniffRecord r;
+  r.tUs = micros();
+  r.rssi = rx.rssi;
+  r.noiseFloor = rx.noise_floor;
+  r.rate = rx.rate;
+  r.sigMode = rx.sig_mode;
+  r.mcs = rx.mcs;
+  r.channel = rx.channel;
+  r.len = len;
+  memcpy(r.hdr, pkt->payload, len);
+  sniffRing.push(r);
+}
+
+// ============================================
+// FUNCTION IMPLEMENTATIONS
+// ============================================
+
+bool snifferEnable(bool on) {
+  if (on) {
+    wifi_promiscuous_filter_t filter = {WIFI_PROMIS_FILTER_MASK_MGMT | WIFI_PROMIS_FILTER_MASK_DATA};
+    esp_wifi_set_promiscuous_filter(&filter);
+    esp_wifi_set_promiscuous_rx_cb(onPromiscuous);
+  }
+  esp_err_t err = esp_wifi_set_promiscuous(on);
+  if (err != ESP_OK) {
+    Serial.printf("[RSSI] Promiscuous %s failed: %s\n", on ? "on" : "off", esp_err_to_name(err));
+    return false;
+  }
+  snifferEnabled = on;
+  return true;
+}
+
+void snifferPoll() {
+  SniffRecord r;
+  SniffedFrame f;
+  int n = min(numDevices, PROBE_MAX_DEVICES);
+  while (sniffRing.pop(r)) {
+    snifferStats.frames++;
+    if (!parseSniffHeader(r.hdr, r.len, f)) continue;
+    int idx = findDevice(f.src);
+    if (idx < 0 || idx >= n) continue;
+    snifferStats.matched++;
+    if (f.kind == SNIFF_ESPNOW) snifferStats.espnow++;
+    if (f.retry) snifferStats.retries++;
+    rssiStats[idx].add(r.rssi, r.noiseFloor, sniffRateKbps(r.sigMode, r.rate, r.mcs), r.tUs);
+  }
+}
+
+void snifferReset() {
+  for (RssiStats &s : rssiStats) s.reset();
+  snifferStats = {};
+}
+
+uint32_t snifferDropped() {
+  return sniffRing.dropped();
+}
+
+bool rssiFresh(int idx) {
+  if (idx < 0 || idx >= PROBE_MAX_DEVICES) return false;
+  const RssiStats &s = rssiStats[idx];
+  return s.total && micros() - s.lastUs < RSSI_FRESH_MS * 1000UL;
+}
+
+LinkDiag rssiDiagnose(int idx) {
+  if (!rssiFresh(idx)) return DIAG_NO_DATA;
+  return rssiStats[idx].diagnose(RSSI_WEAK_DBM, RSSI_NOISY_FLOOR_DBM);
+}
+
+const char *linkDiagName(LinkDiag d) {
+  switch (d) {
+    case DIAG_OK:    return "ok";
+    case DIAG_WEAK:  return "weak (range)";
+    case DIAG_NOISY: return "noisy (interference)";
+    default:         return "no data";
+  }
+}
@@ -0,0 +1,91 @@
+#include "telemetry.h"
+#include "joystick.h"
+#include "telemetry_frame.h"
+#include <Arduino.h>
+#include <atomic>
+
+// ============================================
+// GLOBAL VARIABLES
+// ============================================
+
+bool telemetryStreaming = false;
+
+static uint16_t lastLoopUs = 0;
+
+// ACK events from the WiFi task. Single producer (OnDataSent) and single
+// consumer (telemetryPoll in loop), so two atomic indices are enough.
+#define ACK_QUEUE_LEN 16
+static TlmAck ackQueue[ACK_QUEUE_LEN];
+static std::atomic<uint8_t> ackHead(0);   // written by producer
+static std::atomic<uint8_t> ackTail(0);   // written by consumer
+
+// ============================================
+// FUNCTION IMPLEMENTATIONS
+// ============================================
+
+static void writeFrame(uint8_t type, const void *payload, size_t len) {
+  uint8_t buf[TLM_MAX_ENCODED];
+  size_t n = tlmEncodeFrame(type, payload, len, buf);
+  if (n) Serial.write(buf, n);
+}
+
+void telemetryEmitSample(uint32_t tUs) {
+  if (!telemetryStreaming) return;
+  TlmSample s;
+  s.tUs = tUs;
+  s.lx = axisRaw[AXIS_LX];
+  s.ly = axisRaw[AXIS_LY];
+  s.rx = axisRaw[AXIS_RX];
+  s.ry = axisRaw[AXIS_RY];
+  s.buttons = (leftButton ? 0x01 : 0) | (rightButton ? 0x02 : 0) | (auxSwitch ? 0x04 : 0);
+  writeFrame(TLM_SAMPLE, &s, sizeof(s));
+}
+
+void telemetryEmitCommand(uint32_t tUs, uint8_t device, const ControlCommand &cmd) {
+  if (!telemetryStreaming) return;
+  TlmCommand c;
+  c.tUs = tUs;
+  c.device = device;
+  c.seq = cmd.seq;
+  c.x = cmd.x;
+  c.y = cmd.y;
+  c.rot = cmd.rot;
+  c.speed = cmd.speed;
+  c.buttons = cmd.buttons;
+  writeFrame(TLM_COMMAND, &c, sizeof(c));
+}
+
+void telemetryEmitTiming(uint32_t tUs, uint16_t sendUs) {
+  if (!telemetryStreaming) return;
+  TlmTiming t;
+  t.tUs = tUs;
+  t.loopUs = lastLoopUs;
+  t.sendUs = sendUs;
+  writeFrame(TLM_TIMING, &t, sizeof(t));
+}
+
+void telemetryQueueAck(uint8_t device, uint8_t seq, bool ok) {
+  if (!telemetryStreaming) return;
+  uint8_t head = ackHead.load(std::memory_order_relaxed);
+  uint8_t next = (head + 1) % ACK_QUEUE_LEN;
+  if (next == ackTail.load(std::memory_order_acquire)) return;  // full: drop
+  TlmAck &a = ackQueue[head];
+  a.tUs = micros();
+  a.device = device;
+  a.seq = seq;
+  a.ok = ok ? 1 : 0;
+  ackHead.store(next, std::memory_order_release);
+}
+
+void telemetryPoll() {
+  uint8_t tail = ackTail.load(std::memory_order_relaxed);
+  while (tail != ackHead.load(std::memory_order_acquire)) {
+    writeFrame(TLM_ACK, &ackQueue[tail], sizeof(TlmAck));
+    tail = (tail + 1) % ACK_QUEUE_LEN;
+    ackTail.store(tail, std::memory_order_release);
+  }
+}
+
+void telemetryLoopDone(uint32_t loopUs) {
+  lastLoopUs = loopUs > 0xFFFF ? 0xFFFF : (uint16_t)loopUs;
+}
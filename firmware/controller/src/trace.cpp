@@ -0,0 +1,72 @@
+#include "trace.h"
+#include "telemetry_frame.h"
+
+#if TRACE_ENABLED
+
+// ============================================
+// GLOBAL VARIABLES
+// ============================================
+
+FlightRecorder<TRACE_EVENTS> traceRecorder;
+
+static uint32_t traceFrom = 0;   // first index TRACE DUMP streams (TRACE CLEAR)
+
+// ============================================
+// FUNCTION IMPLEMENTATIONS
+// ============================================
+
+void traceClear() {
+  traceFrom = traceRecorder.written();
+}
+
+uint32_t traceEventsSinceClear() {
+  return traceRecorder.written() - traceFrom;
+}
+
+// Same framing as flightDump(), but of the trace ring and from traceFrom.
+void traceDump() {
+  uint32_t to = traceRecorder.written();
+  uint32_t from = traceRecorder.first();
+  if ((int32_t)(traceFrom - from) > 0) from = traceFrom;
+  Serial.printf("TRACE %lu events\n", (unsigned long)(to - from));
+  Serial.write((uint8_t)0);   // delimiter, so the header text is not glued to frame 1
+  Serial.flush();
+
+  FlightEvent batch[TLM_EVENTS_PER_FRAME];
+  uint8_t frame[TLM_MAX_ENCODED];
+  size_t n = 0;
+  uint32_t skipped = 0;
+  for (uint32_t i = from; i != to; i++) {
+    if (!traceRecorder.read(i, batch[n])) {
+      skipped++;
+      continue;
+    }
+    if (++n == TLM_EVENTS_PER_FRAME) {
+      Serial.write(frame, tlmEncodeFrame(TLM_TRACE, batch, sizeof(batch), frame));
+      n = 0;
+    }
+  }
+  if (n) Serial.write(frame, tlmEncodeFrame(TLM_TRACE, batch, n * sizeof(FlightEvent), frame));
+  Serial.printf("\nTRACE end (%lu overwritten during dump)\n", (unsigned long)skipped);
+}
+
+// Time `events` instant trace points against an empty loop of the same
+// length. The bench events are left out of later dumps.
+uint32_t traceBenchNs(uint32_t events) {
+  volatile uint32_t sink = 0;
+  uint32_t t0 = micros();
+  for (uint32_t i = 0; i < events; i++) sink = sink + i;
+  uint32_t emptyUs = micros() - t0;
+
+  t0 = micros();
+  for (uint32_t i = 0; i < events; i++) {
+    sink = sink + i;
+    TRACE_INSTANT(TP_LOOP, (uint16_t)i);
+  }
+  uint32_t tracedUs = micros() - t0;
+
+  traceClear();
+  return tracedUs > emptyUs ? (uint32_t)((uint64_t)(tracedUs - emptyUs) * 1000 / events) : 0;
+}
+
+#endif // TRACE_ENABLED
@@ -1,54 +1,126 @@
 #include <Arduino.h>
 #include <esp_now.h>
 #include <WiFi.h>
+#include <esp_wifi.h>
+#include <atomic>
+#include "espnow_data.h"
+#include "command_smoother.h"
+#include "link_stats.h"
+#include "command_arbiter.h"
+#include "mecanum_mixer.h"
+#include "peer_table.h"     // parseKeyHex
 
-typedef struct {
-  int leftX, leftY, rightX, rightY;
-  bool leftButton, rightButton, auxSwitch;
-} JoystickData;
+// ============================================
+// CONFIGURATION
+// ============================================
 
-JoystickData receivedData = {0};
-bool dataReceived = false;
+#define CONTROL_PERIOD_US   10000   // local control rate (100 Hz)
+#define SENDER_PERIOD_US    20000   // controller SEND_INTERVAL
+#define SMOOTH_DELAY_US     20000   // playout delay (see tools/smoother_sim)
+#define SMOOTH_POLICY       SMOOTH_LINEAR
+#define FAILSAFE_US         250000  // silence before ramping to zero
+#define FAILSAFE_RAMP_US    250000
+#define PRINT_INTERVAL_MS   200
+#define SERIAL_WAIT_MS      2000    // wait at most this long for a serial monitor (0 = never)
+#define ARB_POLICY          ARB_PRIORITY
+#define ARB_LOCK_US         500000  // owner silent this long -> another controller may drive
+#define ARB_DEFAULT_PRIO    1       // controllers not in arbRules (0 = spectators only)
+
+// Encryption: the values given to the controller's KEY PMK and KEY SET for
+// this receiver, 32 hex digits each. Empty = ESP-NOW default PMK / plain peer.
+#define ESPNOW_PMK          ""
+#define CONTROLLER_LMK      ""
+
+// ============================================
+// GLOBAL VARIABLES
+// ============================================
+
+// Received commands, WiFi task -> loop. Single producer (OnDataRecv) and
+// single consumer (loop), so two atomic indices are enough.
+#define RX_QUEUE_LEN 16
+struct RxEntry {
+  uint32_t tUs;
+  uint8_t mac[6];                          // sending controller
+  ControlCommand cmd;
+  bool viaPrev;                            // copy carried in a RedundantCommand
+};
+static RxEntry rxQueue[RX_QUEUE_LEN];
+static std::atomic<uint8_t> rxHead(0);
+static std::atomic<uint8_t> rxTail(0);
+static volatile uint32_t rxDropped = 0;    // queue full
+static volatile uint32_t rxBad = 0;        // wrong size / version
+static volatile uint32_t rxOther = 0;      // broadcast frames for another receiver
+static uint8_t ownMac[6];
+static const uint8_t broadcastMac[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+static uint32_t echoesSent = 0;
+static uint32_t echoErrors = 0;
+
+static CommandSmoother smoother;
+static CommandArbiter arbiter;             // per-controller seq state + owner
+static uint32_t recovered = 0;             // commands only received as "prev"
 int packetCount = 0;
 
 // Controller MAC address (to send data back)
 uint8_t controllerMAC[6] = {0xEC, 0xDA, 0x3B, 0xBD, 0xCD, 0x74};
 
+// Per-controller priorities; others get ARB_DEFAULT_PRIO. With ARB_PRIORITY
+// a higher priority takes the robot over at once, 0 = spectator.
+static const ArbRule arbRules[] = {
+  {{0xEC, 0xDA, 0x3B, 0xBD, 0xCD, 0x74}, 2},   // controllerMAC
+};
+
+static void queueCommand(const uint8_t *mac, const uint8_t *data, uint32_t tUs, bool viaPrev) {
+  uint8_t head = rxHead.load(std::memory_order_relaxed);
+  uint8_t next = (head + 1) % RX_QUEUE_LEN;
+  if (next == rxTail.load(std::memory_order_acquire)) {
+    rxDropped++;
+    return;
+  }
+  rxQueue[head].tUs = tUs;
+  memcpy(rxQueue[head].mac, mac, 6);
+  memcpy(&rxQueue[head].cmd, data, sizeof(ControlCommand));
+  rxQueue[head].viaPrev = viaPrev;
+  rxHead.store(next, std::memory_order_release);
+}
+
+// Runs in the WiFi task: timestamp and queue only, no printing. A plain
+// ControlCommand and a RedundantCommand are told apart by length; either may
+// come prefixed with a target MAC (controller in broadcast mode).
 void OnDataRecv(const uint8_t * mac, const uint8_t *incomingData, int len) {
-  Serial.printf("\n🔔 [CALLBACK] Received %d bytes from controller\n", len);
-  Serial.flush();
-  
-  if (len == sizeof(JoystickData)) {
-    memcpy(&receivedData, incomingData, sizeof(JoystickData));
-    dataReceived = true;
-    packetCount++;
-    
-    Serial.printf("✅ [PACKET #%d] L(%d,%d) R(%d,%d) Btn(%d,%d,%d)\n", 
-      packetCount,
-      receivedData.leftX, receivedData.leftY, 
-      receivedData.rightX, receivedData.rightY,
-      receivedData.leftButton, receivedData.rightButton, receivedData.auxSwitch);
-    Serial.flush();
+  uint32_t now = micros();
+  if (len == CONTROL_TARGET_LEN + (int)sizeof(ControlCommand) ||
+      len == CONTROL_TARGET_LEN + (int)sizeof(RedundantCommand)) {
+    if (memcmp(incomingData, ownMac, CONTROL_TARGET_LEN) != 0) {
+      rxOther++;
+      return;
+    }
+    incomingData += CONTROL_TARGET_LEN;
+    len -= CONTROL_TARGET_LEN;
+  }
+  if (len < 1 || incomingData[0] != CONTROL_PROTOCOL_VERSION) {
+    rxBad++;
+  } else if (len == sizeof(ControlCommand)) {
+    queueCommand(mac, incomingData, now, false);
+  } else if (len == sizeof(RedundantCommand)) {
+    // Older first, so an in-order stream stays in order.
+    queueCommand(mac, incomingData + offsetof(RedundantCommand, prev), now, true);
+    queueCommand(mac, incomingData + offsetof(RedundantCommand, cur), now, false);
   } else {
-    Serial.printf("❌ [ERROR] Wrong packet size: got %d, expected %zu\n", len, sizeof(JoystickData));
-    Serial.flush();
+    rxBad++;
   }
 }
 
+// Echoes go out for every command; count failures instead of printing.
 void OnDataSent(const uint8_t *mac_addr, esp_now_send_status_t status) {
-  if (status == ESP_NOW_SEND_SUCCESS) {
-    Serial.printf("[SENT] ✅ Sent successfully to controller\n");
-  } else {
-    Serial.printf("[SENT] ❌ Failed to send to controller\n");
-  }
+  if (status != ESP_NOW_SEND_SUCCESS) echoErrors++;
 }
 
 void setup() {
-  // 10-second delay to allow serial monitor to connect
-  delay(10000);
-  
+  // Give an open serial monitor a moment to attach so the boot log is not
+  // lost, but do not hold up a receiver running without one.
   Serial.begin(115200);
-  delay(500);
+  unsigned long serialWaitStart = millis();
+  while (!Serial && millis() - serialWaitStart < SERIAL_WAIT_MS) delay(10);
   
   while (Serial.available()) Serial.read();
   
@@ -58,9 +130,14 @@ void setup() {
   
   WiFi.mode(WIFI_STA);
   WiFi.disconnect();
+  // Accept the controller's LR radio profiles too; 11b/g/n frames are
+  // received as before.
+  esp_wifi_set_protocol(WIFI_IF_STA, WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G |
+                                     WIFI_PROTOCOL_11N | WIFI_PROTOCOL_LR);
   
   Serial.print("[INIT] Receiver MAC: ");
   Serial.println(WiFi.macAddress());
+  WiFi.macAddress(ownMac);
   
   Serial.println("[INIT] Initializing ESP-NOW...");
   esp_err_t initErr = esp_now_init();
@@ -86,12 +163,16 @@ void setup() {
   esp_err_t sendErr = esp_now_register_send_cb(esp_now_send_cb_t(OnDataSent));
   Serial.printf("[INIT] Register send callback result: %d (0 = success)\n", sendErr);
   
+  uint8_t pmk[PEER_KEY_LEN];
+  if (parseKeyHex(ESPNOW_PMK, pmk)) esp_now_set_pmk(pmk);
+
   esp_now_peer_info_t peerInfo = {};
   memcpy(peerInfo.peer_addr, controllerMAC, 6);
   peerInfo.channel = 0;
-  peerInfo.encrypt = false;
+  peerInfo.encrypt = parseKeyHex(CONTROLLER_LMK, peerInfo.lmk);
   
-  Serial.printf("[INIT] Adding controller peer: %02X:%02X:%02X:%02X:%02X:%02X\n",
+  Serial.printf("[INIT] Adding %s controller peer: %02X:%02X:%02X:%02X:%02X:%02X\n",
+    peerInfo.encrypt ? "encrypted" : "plain",
     controllerMAC[0], controllerMAC[1], controllerMAC[2],
     controllerMAC[3], controllerMAC[4], controllerMAC[5]);
   
@@ -101,23 +182,122 @@ void setup() {
     Serial.println("[INIT] ✅ Controller peer added");
   }
   
+  // Echoes are broadcast: no retries, so they time the link rather than the
+  // MAC layer, and whichever controller is driving hears them.
+  memcpy(peerInfo.peer_addr, broadcastMac, 6);
+  peerInfo.encrypt = false;
+  if (esp_now_add_peer(&peerInfo) != ESP_OK) {
+    Serial.println("[INIT] ⚠️  Could not add broadcast peer, no link echoes");
+  }
+
+  smoother.begin({SENDER_PERIOD_US, SMOOTH_DELAY_US, FAILSAFE_US, FAILSAFE_RAMP_US, SMOOTH_POLICY});
+  arbiter.begin({ARB_POLICY, ARB_LOCK_US, ARB_DEFAULT_PRIO, arbRules,
+                 sizeof(arbRules) / sizeof(arbRules[0])});
+
   Serial.println("\n========================================");
-  Serial.println("✅ RECEIVER READY");
-  Serial.println("Waiting for joystick data from controller...");
+  Serial.printf("✅ RECEIVER READY (%lu ms after start)\n", millis());
+  Serial.println("Waiting for control commands from controller...");
   Serial.println("========================================\n");
 }
 
+// Tell the sending controller a new command or a probe arrived (see LinkEcho).
+static void sendEcho(uint8_t seq, const SeqTracker &seqTracker, uint8_t flags = 0) {
+  LinkEcho echo;
+  echo.version = CONTROL_PROTOCOL_VERSION;
+  echo.seq = seq;
+  echo.lossPermille = (uint16_t)(seqTracker.lossRate() * 1000 + 0.5f);
+  echo.received = seqTracker.unique;
+  echo.flags = flags;
+  if (esp_now_send(broadcastMac, (const uint8_t *)&echo, sizeof(echo)) == ESP_OK) echoesSent++;
+  else echoErrors++;
+}
+
+static void printMac(const uint8_t *mac) {
+  Serial.printf("%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
+// Log owner changes; a new owner's seqs are unrelated to the old one's, so
+// the smoother starts a fresh timeline.
+static void reportOwnerChanges() {
+  static const char *const reasons[] = {"claim", "takeover", "expired"};
+  ArbChange c;
+  while (arbiter.takeChange(c)) {
+    Serial.printf("[ARB] %lu ms owner ", (unsigned long)(c.tUs / 1000));
+    if (c.from >= 0) printMac(arbiter.source(c.from).mac);
+    else Serial.print("none");
+    Serial.print(" -> ");
+    if (c.to >= 0) printMac(arbiter.source(c.to).mac);
+    else Serial.print("none");
+    Serial.printf(" (%s)\n", reasons[c.reason]);
+    if (c.to >= 0) smoother.restart();
+  }
+}
+
+static void drainRxQueue() {
+  uint8_t tail = rxTail.load(std::memory_order_relaxed);
+  while (tail != rxHead.load(std::memory_order_acquire)) {
+    const RxEntry &e = rxQueue[tail];
+    // Redundant copies and commands from controllers that do not own the
+    // robot stop here; only the owner's first sightings reach the smoother.
+    // Probes are echoed whoever sends them and go no further.
+    ArbVerdict v = arbiter.offer(e.mac, e.cmd.seq, e.tUs, e.cmd.buttons & CONTROL_BTN_PROBE);
+    reportOwnerChanges();
+    if (v == ARB_PROBE) {
+      static const SeqTracker none;
+      int src = arbiter.find(e.mac);
+      sendEcho(e.cmd.seq, src >= 0 ? arbiter.source(src).seq : none, ECHO_FLAG_PROBE);
+    } else if (v == ARB_DRIVE) {
+      if (e.viaPrev) recovered++;
+      else sendEcho(e.cmd.seq, arbiter.source(arbiter.owner()).seq);
+      smoother.push(e.cmd, e.tUs);
+    }
+    if (!e.viaPrev) packetCount++;
+    tail = (tail + 1) % RX_QUEUE_LEN;
+    rxTail.store(tail, std::memory_order_release);
+  }
+}
+
+static void printStatus(const ControlCommand &out, const WheelDuty &w) {
+  const SmootherStats &s = smoother.stats();
+  // Loss and duplicates of the owning controller; blk = commands refused
+  // from the others.
+  static const SeqTracker none;
+  int owner = arbiter.owner();
+  const SeqTracker &seq = owner >= 0 ? arbiter.source(owner).seq : none;
+  uint32_t blocked = 0;
+  for (int i = 0; i < ARB_MAX_SOURCES; i++) blocked += arbiter.source(i).blocked;
+  Serial.printf("%s x=%4d y=%4d rot=%4d spd=%3u btn=%u | FL %4d FR %4d BL %4d BR %4d | own %02X%02X rx %d loss %.1f%% rec %lu dup %lu blk %lu late %lu underrun %lu bad %lu other %lu echo %lu/%lu\n",
+    smoother.failsafe() ? "⚠️ [FAILSAFE]" : "✅ [CMD]",
+    out.x, out.y, out.rot, out.speed, out.buttons, w.fl, w.fr, w.bl, w.br,
+    owner >= 0 ? arbiter.source(owner).mac[4] : 0, owner >= 0 ? arbiter.source(owner).mac[5] : 0,
+    packetCount, seq.lossRate() * 100, (unsigned long)recovered,
+    (unsigned long)seq.duplicates, (unsigned long)blocked, (unsigned long)s.late,
+    (unsigned long)s.underruns, (unsigned long)rxBad, (unsigned long)rxOther,
+    (unsigned long)echoesSent, (unsigned long)echoErrors);
+}
+
 void loop() {
+  static uint32_t nextTickUs = micros();
   static unsigned long lastPrint = 0;
-  
-  if (!dataReceived) {
-    if (millis() - lastPrint > 5000) {
-      Serial.println("⏳ [STATUS] No packets received yet - waiting...");
-      lastPrint = millis();
-    }
-  } else {
-    dataReceived = false;
+
+  // Drain on every pass, not just on the tick, so echoes go out as soon as a
+  // command lands and the controller's round trip does not include our tick.
+  drainRxQueue();
+
+  // Fixed-rate control tick; skip ahead rather than burst after a stall.
+  if ((int32_t)(micros() - nextTickUs) < 0) return;
+  nextTickUs += CONTROL_PERIOD_US;
+  if ((int32_t)(micros() - nextTickUs) > 0) nextTickUs = micros() + CONTROL_PERIOD_US;
+
+  arbiter.expire(micros());
+  reportOwnerChanges();
+  ControlCommand out = smoother.tick(micros());
+  // What the robot's wheels would get (signed 8-bit PWM duty).
+  WheelDuty wheels = mecanumMix(out);
+
+  if (millis() - lastPrint > (packetCount ? PRINT_INTERVAL_MS : 5000)) {
+    lastPrint = millis();
+    if (packetCount) printStatus(out, wheels);
+    else Serial.println("⏳ [STATUS] No packets received yet - waiting...");
   }
-  
-  delay(100);
 }
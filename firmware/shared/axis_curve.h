@@ -0,0 +1,151 @@
+#ifndef AXIS_CURVE_H
+#define AXIS_CURVE_H
+
+#include <stdint.h>
+
+// ============================================
+// MULTI-POINT AXIS CURVE
+// ============================================
+// Three-point calibration maps each half-axis with one straight line, which
+// loses fine control on sticks that are non-linear near the ends or around
+// centre. A curve holds the raw reading at AXIS_CURVE_KNOTS evenly spaced
+// outputs (-100, -75, ... 0 ... 75, 100 with four points per half) and is
+// piecewise linear between them. Each knot is the trimmed mean of many ADC
+// reads, and the knots are forced strictly increasing before use.
+//
+// The curve is evaluated once per raw value into a lookup table at
+// calibration/boot, so the hot path is one deadzone check and one load.
+//
+// Plain C++11 so tools/axis_curve_check can test fitting and accuracy.
+
+#define AXIS_CURVE_HALF 4          // points per half-axis, the last at the end stop
+#define AXIS_CURVE_KNOTS (2 * AXIS_CURVE_HALF + 1)
+#define AXIS_CURVE_MIN_GAP 8       // raw counts between neighbouring knots
+#define AXIS_CURVE_RAW_MAX 4095    // 12-bit ADC
+#define AXIS_LUT_SHIFT 2           // one table entry per 4 raw counts
+#define AXIS_LUT_LEN ((AXIS_CURVE_RAW_MAX >> AXIS_LUT_SHIFT) + 1)
+
+// Raw reading at each knot, ascending; knot AXIS_CURVE_HALF is the centre.
+struct AxisCurve {
+  uint16_t knot[AXIS_CURVE_KNOTS];
+};
+
+// Output (-100..100) at knot k.
+static inline int axisCurveOut(int k) {
+  return (k - AXIS_CURVE_HALF) * 100 / AXIS_CURVE_HALF;
+}
+
+// ============================================
+// FITTING
+// ============================================
+
+// One calibration point from n raw reads: sorts them in place and averages
+// the middle half, so a few spikes do not move the point.
+static inline int axisPointAverage(uint16_t *s, int n) {
+  for (int i = 1; i < n; i++) {
+    uint16_t v = s[i];
+    int j = i;
+    for (; j > 0 && s[j - 1] > v; j--) s[j] = s[j - 1];
+    s[j] = v;
+  }
+  int lo = n / 4, hi = n - n / 4;
+  long sum = 0;
+  for (int i = lo; i < hi; i++) sum += s[i];
+  return (int)((sum + (hi - lo) / 2) / (hi - lo));
+}
+
+// Knots from captured points (index = knot, so points[0] is the low end
+// stop). Out-of-order points are pooled with their neighbours to the
+// nearest non-decreasing sequence (pool adjacent violators), then spread to
+// at least AXIS_CURVE_MIN_GAP apart. A pot mounted the other way round is
+// reversed, as axisValidate() swaps min and max. Returns how many knots
+// moved from their captures, or -1 if the axis has too little travel.
+static inline int axisCurveFit(const int *points, AxisCurve &out) {
+  const int K = AXIS_CURVE_KNOTS;
+  bool reverse = points[K - 1] < points[0];
+  long p[K];
+  for (int k = 0; k < K; k++) p[k] = points[reverse ? K - 1 - k : k];
+
+  // Pool adjacent violators: blocks of equal value, merged while a block
+  // sits below the one before it.
+  long sum[K];
+  int len[K];
+  int blocks = 0;
+  for (int k = 0; k < K; k++) {
+    sum[blocks] = p[k];
+    len[blocks] = 1;
+    blocks++;
+    while (blocks > 1 && sum[blocks - 2] * len[blocks - 1] > sum[blocks - 1] * len[blocks - 2]) {
+      sum[blocks - 2] += sum[blocks - 1];
+      len[blocks - 2] += len[blocks - 1];
+      blocks--;
+    }
+  }
+  long v[K];
+  for (int b = 0, k = 0; b < blocks; b++) {
+    long mean = (sum[b] + len[b] / 2) / len[b];
+    for (int i = 0; i < len[b]; i++) v[k++] = mean;
+  }
+
+  if (v[K - 1] - v[0] < (long)AXIS_CURVE_MIN_GAP * (K - 1)) return -1;
+
+  // Spread ties: push up from the bottom, then down from the top end stop.
+  if (v[0] < 0) v[0] = 0;
+  for (int k = 1; k < K; k++) {
+    if (v[k] < v[k - 1] + AXIS_CURVE_MIN_GAP) v[k] = v[k - 1] + AXIS_CURVE_MIN_GAP;
+  }
+  if (v[K - 1] > AXIS_CURVE_RAW_MAX) v[K - 1] = AXIS_CURVE_RAW_MAX;
+  for (int k = K - 2; k >= 0; k--) {
+    if (v[k] > v[k + 1] - AXIS_CURVE_MIN_GAP) v[k] = v[k + 1] - AXIS_CURVE_MIN_GAP;
+  }
+
+  int moved = 0;
+  for (int k = 0; k < K; k++) {
+    out.knot[k] = (uint16_t)v[k];
+    if (v[k] != p[k]) moved++;
+  }
+  return moved;
+}
+
+// Strictly increasing within the ADC range: what axisCurveFit() produces.
+// Checked on curves loaded from NVS.
+static inline bool axisCurveValid(const AxisCurve &c) {
+  if (c.knot[AXIS_CURVE_KNOTS - 1] > AXIS_CURVE_RAW_MAX) return false;
+  for (int k = 1; k < AXIS_CURVE_KNOTS; k++) {
+    if (c.knot[k] <= c.knot[k - 1]) return false;
+  }
+  return true;
+}
+
+// ============================================
+// EVALUATION
+// ============================================
+
+// Exact piecewise-linear value, rounded; clamps beyond the end stops.
+static inline int axisCurveEval(const AxisCurve &c, int raw) {
+  const int K = AXIS_CURVE_KNOTS;
+  if (raw <= c.knot[0]) return axisCurveOut(0);
+  if (raw >= c.knot[K - 1]) return axisCurveOut(K - 1);
+  int k = 0;
+  while (raw >= c.knot[k + 1]) k++;
+  int span = c.knot[k + 1] - c.knot[k];
+  int step = axisCurveOut(k + 1) - axisCurveOut(k);
+  return axisCurveOut(k) + (2 * (raw - c.knot[k]) * step + span) / (2 * span);
+}
+
+// The curve sampled at the middle of each table bucket.
+static inline void axisCurveLut(const AxisCurve &c, int8_t lut[AXIS_LUT_LEN]) {
+  for (int i = 0; i < AXIS_LUT_LEN; i++) {
+    lut[i] = (int8_t)axisCurveEval(c, (i << AXIS_LUT_SHIFT) + (1 << AXIS_LUT_SHIFT) / 2);
+  }
+}
+
+// Hot path: signed -100..100 with the deadzone around the centre knot.
+// raw must be a 12-bit reading.
+static inline int8_t axisCurveSigned(const int8_t *lut, int raw, int center, int deadzone) {
+  int d = raw - center;
+  if (d < deadzone && -d < deadzone) return 0;
+  return lut[raw >> AXIS_LUT_SHIFT];
+}
+
+#endif // AXIS_CURVE_H
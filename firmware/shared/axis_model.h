@@ -0,0 +1,137 @@
+#ifndef AXIS_MODEL_H
+#define AXIS_MODEL_H
+
+#include <stdint.h>
+
+// ============================================
+// ANALOG AXIS MODEL
+// ============================================
+// Each stick axis is one row in a constexpr table of AxisDesc: its ADC pin,
+// the ControlCommand field it drives and the calibration slot it uses.
+// Polarity belongs to the field, not the axis (the controller's sign_*
+// parameters), so moving an axis to another field takes its polarity along. Per-axis code loops over the table. AxisLoop unrolls the
+// hot-path loops at compile time, so with a constexpr table they compile to
+// the same straight-line code as one hand-written block per axis. Adding an
+// axis, or giving right Y a command field, is a change to the table only.
+//
+// Plain C++11 so the same mapping runs in tools/axis_bench, which checks it
+// against the old per-axis code and times both.
+
+enum AxisRole : uint8_t {
+  AXIS_ROLE_NONE,       // read and shown, not sent
+  AXIS_ROLE_X,          // ControlCommand.x (strafe)
+  AXIS_ROLE_Y,          // ControlCommand.y (forward)
+  AXIS_ROLE_ROT,        // ControlCommand.rot
+  AXIS_ROLE_COUNT
+};
+
+enum AxisStick : uint8_t { STICK_LEFT, STICK_RIGHT };
+
+struct AxisDesc {
+  uint8_t pin;          // ADC GPIO
+  AxisRole role;
+  uint8_t slot;         // index into the calibration array
+  AxisStick stick;
+  const char *key;      // NVS key prefix ("leftX" -> leftXMin/leftXCenter/leftXMax)
+  const char *label;    // short name for the screen ("LX")
+  const char *neg;      // direction of the low end ("LEFT", "DOWN")
+  const char *pos;      // direction of the high end
+};
+
+// Raw ADC readings at the two ends and at rest.
+struct AxisCal {
+  int min;
+  int center;
+  int max;
+};
+
+// ============================================
+// COMPILE-TIME LOOP
+// ============================================
+// AxisLoop<0, N>::run(f) calls f(0) ... f(N - 1) with no loop left behind
+// once inlined; f sees each index as a constant.
+
+template <int I, int N>
+struct AxisLoop {
+  template <class F>
+  static inline void run(F &f) {
+    f(I);
+    AxisLoop<I + 1, N>::run(f);
+  }
+};
+
+template <int N>
+struct AxisLoop<N, N> {
+  template <class F>
+  static inline void run(F &) {}
+};
+
+// ============================================
+// MAPPING
+// ============================================
+
+// Arduino map() in integer arithmetic; the caller rules out inMin == inMax.
+static inline long axisMapRange(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+static inline long axisClamp(long v, long lo, long hi) {
+  return v < lo ? lo : v > hi ? hi : v;
+}
+
+// Raw reading -> outMin..outMax, piecewise linear through the calibrated
+// centre, with outCenter within deadzone of the centre. A half with no
+// calibrated travel (end == centre) stays at outCenter.
+static inline int axisScale(int raw, const AxisCal &c, int deadzone,
+                            int outMin, int outCenter, int outMax) {
+  int d = raw - c.center;
+  if (d < deadzone && -d < deadzone) return outCenter;
+  long v;
+  if (raw < c.center) {
+    if (c.min == c.center) return outCenter;
+    v = axisMapRange(axisClamp(raw, c.min, c.center), c.min, c.center, outMin, outCenter);
+  } else {
+    if (c.max == c.center) return outCenter;
+    v = axisMapRange(axisClamp(raw, c.center, c.max), c.center, c.max, outCenter, outMax);
+  }
+  return (int)axisClamp(v, outMin, outMax);
+}
+
+// Signed -100..100, the range of a ControlCommand axis.
+static inline int8_t axisSigned(int raw, const AxisCal &c, int deadzone) {
+  return (int8_t)axisScale(raw, c, deadzone, -100, 0, 100);
+}
+
+// min <= center <= max, whatever order the captures came in.
+static inline void axisValidate(AxisCal &c) {
+  if (c.min > c.max) {
+    int t = c.min;
+    c.min = c.max;
+    c.max = t;
+  }
+  c.center = (int)axisClamp(c.center, c.min, c.max);
+}
+
+// Every axis scaled to outMin..outMax (display bars).
+template <int N>
+static inline void axisScaleAll(const AxisDesc (&axes)[N], const int *raw, const AxisCal *cal,
+                                int deadzone, int outMin, int outCenter, int outMax, int *out) {
+  auto f = [&](int a) {
+    out[a] = axisScale(raw[a], cal[axes[a].slot], deadzone, outMin, outCenter, outMax);
+  };
+  AxisLoop<0, N>::run(f);
+}
+
+// Command fields from the axes that drive one; fields no axis drives stay 0.
+template <int N>
+static inline void axisRoles(const AxisDesc (&axes)[N], const int *raw, const AxisCal *cal,
+                             int deadzone, int8_t out[AXIS_ROLE_COUNT]) {
+  for (int r = 0; r < AXIS_ROLE_COUNT; r++) out[r] = 0;
+  auto f = [&](int a) {
+    if (axes[a].role == AXIS_ROLE_NONE) return;
+    out[axes[a].role] = axisSigned(raw[a], cal[axes[a].slot], deadzone);
+  };
+  AxisLoop<0, N>::run(f);
+}
+
+#endif // AXIS_MODEL_H
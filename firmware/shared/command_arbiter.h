@@ -0,0 +1,208 @@
+#ifndef COMMAND_ARBITER_H
+#define COMMAND_ARBITER_H
+
+#include <stdint.h>
+#include <string.h>
+#include "link_stats.h"
+
+// ============================================
+// MULTI-CONTROLLER ARBITRATION
+// ============================================
+// ControlCommand carries no controller identity, so the receiver tells
+// controllers apart by the frame's source MAC. Each source gets its own
+// SeqTracker (seqs from two controllers are unrelated), and at most one
+// source - the owner - drives the outputs:
+//
+//   ARB_FIRST_OWNER  the first controller heard owns the robot until it has
+//                    been silent for lockTimeoutUs; then the next one to send
+//                    takes over.
+//   ARB_PRIORITY     as above, but a source with a higher priority takes
+//                    over at once.
+//
+// Priorities come from a rule table keyed by MAC; other sources get
+// defaultPriority. Priority 0 makes a source a spectator: it is tracked and
+// counted but never owns the robot (defaultPriority 0 allow-lists the
+// table). Owner changes queue up as ArbChanges for the caller to report; a
+// handover after a timeout shows as an expiry followed by a claim.
+//
+// Background probes (CONTROL_BTN_PROBE) are zero-motion frames a controller
+// sends to robots it is not driving, numbered from a counter of their own.
+// They are answered but never arbitrated: a probe neither claims a robot nor
+// keeps a lock alive, and its seq stays out of the source's SeqTracker.
+//
+// Single-threaded: call offer() from the context that drains received
+// frames. Plain C++ so the same arbiter runs in the receiver firmware and
+// in tools/arbiter_check; times are caller-supplied microseconds and may
+// wrap.
+
+#define ARB_MAX_SOURCES 4   // tracked controllers; the quietest is recycled
+#define ARB_CHANGE_LOG  4   // unreported owner changes; the oldest is dropped
+
+enum ArbPolicy : uint8_t {
+  ARB_FIRST_OWNER = 0,
+  ARB_PRIORITY    = 1,
+};
+
+enum ArbVerdict : uint8_t {
+  ARB_DRIVE,        // new command from the owner: apply it
+  ARB_DUPLICATE,    // seq already seen from this source (redundant copy)
+  ARB_SPECTATOR,    // priority 0 source
+  ARB_LOCKED_OUT,   // another source owns the robot
+  ARB_PROBE,        // background probe: answer it, do not apply it
+};
+
+enum ArbReason : uint8_t {
+  ARB_CLAIM,        // no owner: the first driver heard takes it
+  ARB_TAKEOVER,     // higher priority (ARB_PRIORITY)
+  ARB_EXPIRED,      // owner silent for lockTimeoutUs (to is -1)
+};
+
+struct ArbRule {
+  uint8_t mac[6];
+  uint8_t priority;   // 0 = spectator
+};
+
+struct ArbiterConfig {
+  ArbPolicy policy;
+  uint32_t lockTimeoutUs;
+  uint8_t defaultPriority;   // for MACs not in rules
+  const ArbRule *rules;
+  uint8_t numRules;
+};
+
+struct ArbSource {
+  uint8_t mac[6] = {};
+  uint8_t priority = 0;
+  bool used = false;
+  uint32_t lastUs = 0;       // newest frame, duplicates included
+  SeqTracker seq;
+  uint32_t driven = 0;       // commands applied
+  uint32_t blocked = 0;      // new commands refused (locked out / spectator)
+};
+
+// Source indices stay valid until that slot is recycled, so report changes
+// as they are taken.
+struct ArbChange {
+  uint32_t tUs;
+  int8_t from;               // source index, -1 = none
+  int8_t to;
+  ArbReason reason;
+};
+
+class CommandArbiter {
+public:
+  void begin(const ArbiterConfig &cfg) {
+    _cfg = cfg;
+    for (int i = 0; i < ARB_MAX_SOURCES; i++) _sources[i] = ArbSource();
+    _owner = -1;
+    _logHead = 0;
+    _logCount = 0;
+    changes = 0;
+    evictions = 0;
+    probes = 0;
+  }
+
+  // One received command from mac. Ownership is settled before the seq
+  // check, so even a duplicate keeps its source's lock alive.
+  ArbVerdict offer(const uint8_t *mac, uint8_t seq, uint32_t nowUs, bool probe = false) {
+    if (probe) {
+      probes++;
+      return ARB_PROBE;
+    }
+    int i = lookup(mac, nowUs);
+    ArbSource &s = _sources[i];
+    s.lastUs = nowUs;
+    expire(nowUs);
+    if (s.priority > 0 && i != _owner) {
+      if (_owner < 0) {
+        setOwner(i, ARB_CLAIM, nowUs);
+      } else if (_cfg.policy == ARB_PRIORITY && s.priority > _sources[_owner].priority) {
+        setOwner(i, ARB_TAKEOVER, nowUs);
+      }
+    }
+    if (!s.seq.mark(seq)) return ARB_DUPLICATE;
+    if (s.priority == 0) { s.blocked++; return ARB_SPECTATOR; }
+    if (i != _owner) { s.blocked++; return ARB_LOCKED_OUT; }
+    s.driven++;
+    return ARB_DRIVE;
+  }
+
+  // Release an owner that has gone quiet. offer() does this too; call it
+  // from the control tick so the release shows while nothing arrives.
+  void expire(uint32_t nowUs) {
+    if (_owner >= 0 && nowUs - _sources[_owner].lastUs >= _cfg.lockTimeoutUs) {
+      setOwner(-1, ARB_EXPIRED, nowUs);
+    }
+  }
+
+  int owner() const { return _owner; }
+
+  // Source index of mac, -1 if it is not tracked.
+  int find(const uint8_t *mac) const {
+    for (int i = 0; i < ARB_MAX_SOURCES; i++) {
+      if (_sources[i].used && memcmp(_sources[i].mac, mac, 6) == 0) return i;
+    }
+    return -1;
+  }
+
+  const ArbSource &source(int i) const { return _sources[i]; }
+
+  // Oldest unreported owner change, if any.
+  bool takeChange(ArbChange &out) {
+    if (!_logCount) return false;
+    out = _log[(_logHead + ARB_CHANGE_LOG - _logCount) % ARB_CHANGE_LOG];
+    _logCount--;
+    return true;
+  }
+
+  uint32_t changes = 0;
+  uint32_t evictions = 0;   // sources dropped to make room
+  uint32_t probes = 0;      // background probes answered
+
+private:
+  uint8_t priorityOf(const uint8_t *mac) const {
+    for (int r = 0; r < _cfg.numRules; r++) {
+      if (memcmp(_cfg.rules[r].mac, mac, 6) == 0) return _cfg.rules[r].priority;
+    }
+    return _cfg.defaultPriority;
+  }
+
+  int lookup(const uint8_t *mac, uint32_t nowUs) {
+    int slot = find(mac);
+    if (slot >= 0) return slot;
+    uint32_t quietest = 0;
+    for (int i = 0; i < ARB_MAX_SOURCES; i++) {
+      const ArbSource &s = _sources[i];
+      if (i == _owner) continue;
+      uint32_t quiet = s.used ? nowUs - s.lastUs : UINT32_MAX;
+      if (slot < 0 || quiet > quietest) {
+        slot = i;
+        quietest = quiet;
+      }
+    }
+    ArbSource &s = _sources[slot];
+    if (s.used) evictions++;
+    s = ArbSource();
+    memcpy(s.mac, mac, 6);
+    s.priority = priorityOf(mac);
+    s.used = true;
+    return slot;
+  }
+
+  void setOwner(int to, ArbReason reason, uint32_t nowUs) {
+    _log[_logHead] = {nowUs, (int8_t)_owner, (int8_t)to, reason};
+    _logHead = (_logHead + 1) % ARB_CHANGE_LOG;
+    if (_logCount < ARB_CHANGE_LOG) _logCount++;
+    _owner = to;
+    changes++;
+  }
+
+  ArbiterConfig _cfg;
+  ArbSource _sources[ARB_MAX_SOURCES];
+  int _owner = -1;
+  ArbChange _log[ARB_CHANGE_LOG];
+  uint8_t _logHead = 0;
+  uint8_t _logCount = 0;
+};
+
+#endif // COMMAND_ARBITER_H
@@ -0,0 +1,256 @@
+#ifndef COMMAND_SMOOTHER_H
+#define COMMAND_SMOOTHER_H
+
+#include <stdint.h>
+#include <string.h>
+#include "espnow_data.h"
+
+// ============================================
+// RECEIVER JITTER BUFFER / COMMAND SMOOTHER
+// ============================================
+// Commands arrive irregularly (air retries, the controller's own loop
+// jitter) and now and then not at all. Instead of applying each one as it
+// lands, the receiver pushes them in here and pulls a command at its own
+// fixed control rate.
+//
+// Each command gets a playout time from its sequence number:
+//   base + (ext - baseExt) * period + delay
+// where base tracks the earliest arrival seen (so the fastest packets define
+// the timeline) and period is re-estimated from the arrivals, since the
+// controller's real send period is not exactly SEND_INTERVAL. Out-of-order
+// packets are slotted back in by seq; duplicates and packets whose playout
+// time has passed are dropped. At the playout point the output either holds
+// the newest due command (SMOOTH_HOLD) or interpolates x/y/rot towards the
+// next one (SMOOTH_LINEAR), which also bridges single losses. If nothing
+// arrives for failsafeUs the output ramps to zero over rampUs.
+//
+// Plain C++ (no Arduino) so it can be fed synthetic traces on a host;
+// all times are caller-supplied microseconds and may wrap.
+
+#define SMOOTH_SLOTS      8       // buffered commands (8 x 20 ms = 160 ms)
+#define SMOOTH_MAX_JUMP   32      // seq jump that counts as a new stream
+
+enum SmoothPolicy : uint8_t {
+  SMOOTH_HOLD   = 0,   // newest due command, unchanged
+  SMOOTH_LINEAR = 1,   // interpolate towards the next buffered command
+};
+
+struct SmootherConfig {
+  uint32_t periodUs;     // nominal sender period (controller SEND_INTERVAL)
+  uint32_t delayUs;      // playout delay behind the earliest arrival
+  uint32_t failsafeUs;   // silence before the output starts ramping down
+  uint32_t rampUs;       // ramp duration from failsafe to stopped
+  SmoothPolicy policy;
+};
+
+struct SmootherStats {
+  uint32_t received;
+  uint32_t duplicates;
+  uint32_t late;         // arrived after their playout time, dropped
+  uint32_t reordered;    // arrived after a newer one but still in time
+  uint32_t lost;         // seqs never seen, bridged by hold/interpolation
+  uint32_t underruns;    // times the playout point ran past the newest command
+  uint32_t resyncs;      // timeline restarted (first packet, silence, seq jump)
+  uint32_t failsafes;    // times the failsafe ramp started
+};
+
+class CommandSmoother {
+public:
+  void begin(const SmootherConfig &cfg) {
+    _cfg = cfg;
+    _periodUs = cfg.periodUs;
+    _count = 0;
+    _synced = false;
+    _inFailsafe = false;
+    memset(&_out, 0, sizeof(_out));
+    _out.version = CONTROL_PROTOCOL_VERSION;
+    memset(&_stats, 0, sizeof(_stats));
+  }
+
+  // Feed one received command (any context that owns the smoother).
+  void push(const ControlCommand &cmd, uint32_t nowUs) {
+    _stats.received++;
+    int32_t ext = _synced ? _newestExt + (int8_t)(cmd.seq - (uint8_t)_newestExt) : 0;
+    bool silent = _synced && nowUs - _lastArrivalUs > _cfg.failsafeUs;
+    if (!_synced || silent || ext - _newestExt > SMOOTH_MAX_JUMP ||
+        _newestExt - ext > SMOOTH_MAX_JUMP) {
+      resync(cmd, nowUs);
+      return;
+    }
+    _lastArrivalUs = nowUs;
+
+    if (_played && ext <= _playedExt) {
+      if (ext == _playedExt) _stats.duplicates++;
+      else _stats.late++;
+      return;
+    }
+    int pos = 0;
+    while (pos < _count && _slots[pos].ext < ext) pos++;
+    if (pos < _count && _slots[pos].ext == ext) {
+      _stats.duplicates++;
+      return;
+    }
+    if (ext < _newestExt) _stats.reordered++;
+
+    // Full: drop the oldest unplayed entry (only when far behind).
+    if (_count == SMOOTH_SLOTS) {
+      if (pos == 0) { _stats.late++; return; }
+      memmove(_slots, _slots + 1, (SMOOTH_SLOTS - 1) * sizeof(Slot));
+      _count--;
+      pos--;
+    }
+    memmove(_slots + pos + 1, _slots + pos, (_count - pos) * sizeof(Slot));
+    _slots[pos].ext = ext;
+    _slots[pos].cmd = cmd;
+    _count++;
+
+    if (ext > _newestExt) {
+      _newestExt = ext;
+      trackClock(ext, nowUs);
+    }
+  }
+
+  // Smoothed command for this control tick.
+  ControlCommand tick(uint32_t nowUs) {
+    if (!_synced) return _out;
+
+    uint32_t silence = nowUs - _lastArrivalUs;
+    if ((int32_t)silence > 0 && silence > _cfg.failsafeUs) return rampDown(silence - _cfg.failsafeUs);
+    _inFailsafe = false;
+
+    // Playout point in 1/256 seq units.
+    int64_t rel = (int32_t)(nowUs - _cfg.delayUs - _baseUs);
+    int64_t pos = (int64_t)_baseExt * 256 + rel * 256 / (int64_t)_periodUs;
+
+    // Retire everything up to the newest due command.
+    int due = -1;
+    while (due + 1 < _count && (int64_t)_slots[due + 1].ext * 256 <= pos) due++;
+    if (due >= 0) {
+      // Older entries passed over together with it count as late.
+      int32_t ext = _slots[due].ext;
+      _stats.late += due;
+      if (_played && ext > _playedExt + 1 + due) _stats.lost += ext - _playedExt - 1 - due;
+      _current = _slots[due].cmd;
+      _playedExt = ext;
+      _played = true;
+      _count -= due + 1;
+      memmove(_slots, _slots + due + 1, _count * sizeof(Slot));
+    }
+    if (!_played) return _out;   // first command not due yet
+
+    _out = _current;
+    bool starved = _count == 0 && pos >= (int64_t)(_playedExt + 1) * 256;
+    if (starved && !_starved) _stats.underruns++;
+    _starved = starved;
+    if (_count > 0 && _cfg.policy == SMOOTH_LINEAR) {
+      const Slot &next = _slots[0];
+      int64_t span = (int64_t)(next.ext - _playedExt) * 256;
+      int32_t frac = (int32_t)((pos - (int64_t)_playedExt * 256) * 256 / span);
+      if (frac < 0) frac = 0;
+      if (frac > 256) frac = 256;
+      _out.x = lerp(_current.x, next.cmd.x, frac);
+      _out.y = lerp(_current.y, next.cmd.y, frac);
+      _out.rot = lerp(_current.rot, next.cmd.rot, frac);
+    }
+    return _out;
+  }
+
+  // The stream changed hands (another controller, unrelated seqs): the next
+  // push starts a new timeline. The output holds until then.
+  void restart() { _synced = false; }
+
+  bool failsafe() const { return _inFailsafe; }
+  uint32_t periodUs() const { return _periodUs; }
+  const SmootherStats &stats() const { return _stats; }
+
+private:
+  struct Slot {
+    int32_t ext;            // unwrapped seq
+    ControlCommand cmd;
+  };
+
+  static int8_t lerp(int8_t a, int8_t b, int32_t frac) {
+    return (int8_t)(a + ((b - a) * frac + (b >= a ? 128 : -128)) / 256);
+  }
+
+  void resync(const ControlCommand &cmd, uint32_t nowUs) {
+    _stats.resyncs++;
+    _synced = true;
+    _played = false;
+    _count = 1;
+    _slots[0].ext = 0;
+    _slots[0].cmd = cmd;
+    _newestExt = 0;
+    _baseExt = 0;
+    _baseUs = nowUs;
+    _anchorExt = 0;
+    _anchorUs = nowUs;
+    _lastArrivalUs = nowUs;
+  }
+
+  // Keep base on the earliest arrivals: jump down at once, creep up slowly
+  // so clock drift and a lasting rise in delay are followed.
+  void trackClock(int32_t ext, uint32_t nowUs) {
+    uint32_t expect = _baseUs + (uint32_t)(ext - _baseExt) * _periodUs;
+    int32_t d = (int32_t)(nowUs - expect);
+    _baseUs += d < 0 ? d : d / 128;
+
+    // Re-estimate the period over at least 64 commands. Re-anchor base at
+    // the newest seq first so the change does not shift earlier playout.
+    if (ext - _anchorExt >= 64) {
+      uint32_t measured = (nowUs - _anchorUs) / (uint32_t)(ext - _anchorExt);
+      if (measured > _cfg.periodUs / 2 && measured < _cfg.periodUs * 2) {
+        _baseUs += (uint32_t)(ext - _baseExt) * _periodUs;
+        _baseExt = ext;
+        _periodUs += ((int32_t)measured - (int32_t)_periodUs) / 4;
+      }
+      _anchorExt = ext;
+      _anchorUs = nowUs;
+    }
+  }
+
+  ControlCommand rampDown(uint32_t intoRampUs) {
+    if (!_inFailsafe) {
+      _inFailsafe = true;
+      _stats.failsafes++;
+      _rampFrom = _out;
+    }
+    ControlCommand c = _rampFrom;
+    if (intoRampUs >= _cfg.rampUs) {
+      c.x = c.y = c.rot = 0;
+      c.buttons = 0;
+    } else {
+      int32_t keep = (int32_t)((uint64_t)(_cfg.rampUs - intoRampUs) * 256 / _cfg.rampUs);
+      c.x = (int8_t)(c.x * keep / 256);
+      c.y = (int8_t)(c.y * keep / 256);
+      c.rot = (int8_t)(c.rot * keep / 256);
+    }
+    _out = c;
+    return c;
+  }
+
+  SmootherConfig _cfg = {};
+  uint32_t _periodUs = 20000;
+  Slot _slots[SMOOTH_SLOTS];
+  int _count = 0;
+
+  bool _synced = false;
+  int32_t _newestExt = 0;
+  int32_t _baseExt = 0;
+  uint32_t _baseUs = 0;         // arrival time of seq _baseExt on the earliest-arrival timeline
+  int32_t _anchorExt = 0;       // period estimation window start
+  uint32_t _anchorUs = 0;
+  uint32_t _lastArrivalUs = 0;
+
+  bool _played = false;
+  int32_t _playedExt = 0;
+  ControlCommand _current = {};
+  ControlCommand _out = {};
+  bool _starved = false;        // playout point is past the newest command
+
+  bool _inFailsafe = false;
+  ControlCommand _rampFrom = {};
+  SmootherStats _stats = {};
+};
+
+#endif // COMMAND_SMOOTHER_H
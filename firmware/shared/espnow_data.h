@@ -1,14 +1,64 @@
 #ifndef ESPNOW_DATA_H
 #define ESPNOW_DATA_H
 
+#include <stdint.h>
+
 // MAC Addresses
 // Receiver (cu.usbmodem141201): 88:56:a6:64:a1:e8
 // Controller (cu.usbmodem141401): ec:da:3b:bd:cd:74
 
-// Joystick data structure - MUST be identical on both boards
-typedef struct {
-  int leftX, leftY, rightX, rightY;
-  bool leftButton, rightButton, auxSwitch;
-} JoystickData;
+// ============================================
+// ESP-NOW CONTROL PROTOCOL
+// ============================================
+// ControlCommand must stay byte-identical to the receiver firmware
+// (Mini Mecanum ESP32). Sent controller -> device at ~50 Hz.
+#define CONTROL_PROTOCOL_VERSION 1
+
+typedef struct __attribute__((packed)) {
+  uint8_t version;   // protocol version
+  uint8_t seq;       // rolling counter, for debug / loss detection
+  int8_t  x;         // strafe    -100..100 (left .. right)
+  int8_t  y;         // forward   -100..100 (back .. forward)
+  int8_t  rot;       // rotation  -100..100 (CCW .. CW)
+  uint8_t speed;     // master speed 0..255
+  uint8_t buttons;   // bit0=leftBtn, bit1=rightBtn, bit2=aux
+} ControlCommand;     // 7 bytes packed
+
+// buttons bit7: a zero-motion probe that only asks to be answered (channel
+// search, background probing, BENCH), numbered apart from the drive seq.
+// Receivers answer it but never drive, arbitrate or seq-track on it.
+#define CONTROL_BTN_PROBE 0x80
+
+// Redundancy mode: the current command plus the one before it, so a single
+// lost frame is rebuilt from the next. Receivers tell it apart from a plain
+// ControlCommand by its length and dedup by seq.
+typedef struct __attribute__((packed)) {
+  ControlCommand cur;
+  ControlCommand prev;
+} RedundantCommand;   // 14 bytes packed
+
+// Broadcast mode: frames go to FF:FF:FF:FF:FF:FF (no MAC ACK, no retries)
+// and start with the intended receiver's MAC, followed by a ControlCommand
+// or RedundantCommand. Receivers drop frames addressed to someone else.
+#define CONTROL_TARGET_LEN 6
+
+typedef struct __attribute__((packed)) {
+  uint8_t target[CONTROL_TARGET_LEN];
+  ControlCommand cmd;
+} AddressedCommand;   // 13 bytes packed (20 with a RedundantCommand)
+
+// Receiver -> controller for each new command and each probe, broadcast so
+// it is not retried either. Lets the controller see delivery and round-trip
+// time without relying on MAC ACKs. Every controller in range hears it, so
+// a probe's echo is flagged: its seq is not one of the drive stream's.
+#define ECHO_FLAG_PROBE 0x01
+
+typedef struct __attribute__((packed)) {
+  uint8_t  version;
+  uint8_t  seq;            // seq of the command being echoed
+  uint16_t lossPermille;   // receiver's effective loss so far
+  uint32_t received;       // distinct commands received
+  uint8_t  flags;          // ECHO_FLAG_*
+} LinkEcho;           // 9 bytes packed
 
 #endif
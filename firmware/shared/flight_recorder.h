@@ -0,0 +1,72 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "telemetry_frame.h"   // FlightEvent wire layout
+
+// ============================================
+// FLIGHT RECORDER RING BUFFER
+// ============================================
+// Fixed-size history of link events for post-mortem analysis. Any number of
+// producers (the loop and the WiFi task) claim a slot with one fetch_add and
+// publish it with a per-slot sequence stamp, so writers never lock, never
+// allocate and never wait. Readers copy a slot and re-check its stamp; a
+// slot overwritten mid-copy is skipped rather than returned torn.
+// Plain C++ so tools/flight_recorder_check runs the same code.
+
+template <size_t N>
+class FlightRecorder {
+  static_assert((N & (N - 1)) == 0, "FlightRecorder size must be a power of two");
+
+public:
+  void record(uint32_t tUs, uint8_t type, uint8_t a, uint16_t b) {
+    uint32_t idx = _head.fetch_add(1, std::memory_order_relaxed);
+    Slot &s = _slots[idx & (N - 1)];
+    s.stamp.store(0, std::memory_order_relaxed);          // mark in-progress
+    std::atomic_thread_fence(std::memory_order_release);
+    s.tUs.store(tUs, std::memory_order_relaxed);
+    s.word.store(type | (uint32_t)a << 8 | (uint32_t)b << 16, std::memory_order_relaxed);
+    s.stamp.store(idx + 1, std::memory_order_release);    // publish
+  }
+
+  // Total events ever recorded (the oldest N remain readable).
+  uint32_t written() const { return _head.load(std::memory_order_acquire); }
+
+  // Index range currently held: [first, written()).
+  uint32_t first() const {
+    uint32_t h = written();
+    return h > N ? h - N : 0;
+  }
+
+  // Copy event idx if it is still intact. False if it was overwritten or is
+  // still being written.
+  bool read(uint32_t idx, FlightEvent &out) const {
+    const Slot &s = _slots[idx & (N - 1)];
+    uint32_t st1 = s.stamp.load(std::memory_order_acquire);
+    uint32_t t = s.tUs.load(std::memory_order_relaxed);
+    uint32_t w = s.word.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint32_t st2 = s.stamp.load(std::memory_order_relaxed);
+    if (st1 != idx + 1 || st2 != st1) return false;
+    out.tUs = t;
+    out.type = w & 0xFF;
+    out.a = (w >> 8) & 0xFF;
+    out.b = w >> 16;
+    return true;
+  }
+
+  static constexpr size_t capacity() { return N; }
+
+private:
+  struct Slot {
+    std::atomic<uint32_t> stamp{0};   // idx + 1 once published
+    std::atomic<uint32_t> tUs{0};
+    std::atomic<uint32_t> word{0};    // type | a << 8 | b << 16
+  };
+  Slot _slots[N];
+  std::atomic<uint32_t> _head{0};
+};
+
+#endif // FLIGHT_RECORDER_H
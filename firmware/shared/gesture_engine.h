@@ -0,0 +1,189 @@
+#ifndef GESTURE_ENGINE_H
+#define GESTURE_ENGINE_H
+
+#include <stdint.h>
+#include <string.h>
+
+// ============================================
+// BUTTON GESTURE ENGINE
+// ============================================
+// Turns raw, timestamped button edges (from GPIO interrupts) into debounced
+// levels and the gestures listed in a caller-supplied table.
+//
+// Debounce is eager: the first edge that changes a button's level is taken
+// at once, then the button ignores edges for debounceUs. If the contacts
+// settled on the other level meanwhile, poll() takes it when the lock-out
+// ends. A press therefore costs no latency, and contact bounce cannot
+// produce extra presses.
+//
+// Gestures (one table entry each, result bit = table index):
+//   GESTURE_PRESS / _RELEASE   debounced edge of the button in `buttons`
+//   GESTURE_DOUBLE_TAP         second press within `ms` of the first
+//   GESTURE_HOLD / _CHORD_HOLD every button in `buttons` down and every
+//                              button in `forbid` up, continuously for `ms`;
+//                              fires once per hold
+//
+// Plain C++ with caller-supplied microsecond times (may wrap), so synthetic
+// edge sequences can be replayed on a host (tools/gesture_replay).
+
+#define GESTURE_MAX_BUTTONS   8
+#define GESTURE_MAX_SPECS     32
+
+enum GestureKind : uint8_t {
+  GESTURE_PRESS,
+  GESTURE_RELEASE,
+  GESTURE_DOUBLE_TAP,
+  GESTURE_HOLD,
+  GESTURE_CHORD_HOLD,
+};
+
+struct GestureSpec {
+  GestureKind kind;
+  uint8_t buttons;     // bit per button
+  uint8_t forbid;      // HOLD / CHORD_HOLD: buttons that must stay up
+  uint16_t ms;         // hold time or double-tap window
+};
+
+struct ButtonEdge {
+  uint32_t tUs;
+  uint8_t button;
+  uint8_t down;        // level after the edge, 1 = pressed
+};
+
+class GestureEngine {
+public:
+  void begin(const GestureSpec *specs, int count, uint32_t debounceUs) {
+    _specs = specs;
+    _count = count < GESTURE_MAX_SPECS ? count : GESTURE_MAX_SPECS;
+    _debounceUs = debounceUs;
+    _raw = _stable = 0;
+    _pending = 0;
+    _pressLatch = 0;
+    _bounces = 0;
+    memset(_acceptUs, 0, sizeof(_acceptUs));
+    memset(_lastPressUs, 0, sizeof(_lastPressUs));
+    memset(_holdSinceUs, 0, sizeof(_holdSinceUs));
+    _tapArmed = 0;
+    _holding = _holdFired = 0;
+    _locked = 0;
+  }
+
+  // Raw edge, in time order (levels that do not change are ignored).
+  void edge(const ButtonEdge &e) {
+    if (e.button >= GESTURE_MAX_BUTTONS) return;
+    uint8_t bit = 1u << e.button;
+    _raw = e.down ? (_raw | bit) : (_raw & ~bit);
+    if (((_stable ^ _raw) & bit) == 0) return;
+    if ((_locked & bit) && e.tUs - _acceptUs[e.button] < _debounceUs) {
+      _bounces++;
+      return;
+    }
+    accept(e.button, e.down != 0, e.tUs);
+  }
+
+  // Advance time: settle debounced levels and fire holds. Returns the
+  // gestures fired since the previous call (bit i = specs[i]).
+  uint32_t poll(uint32_t nowUs) {
+    for (uint8_t b = 0; b < GESTURE_MAX_BUTTONS; b++) {
+      uint8_t bit = 1u << b;
+      if (!(_locked & bit) || nowUs - _acceptUs[b] < _debounceUs) continue;
+      _locked &= ~bit;
+      if ((_raw ^ _stable) & bit) accept(b, (_raw & bit) != 0, nowUs);
+    }
+    checkHolds(nowUs);
+    uint32_t fired = _pending;
+    _pending = 0;
+    return fired;
+  }
+
+  uint8_t levels() const { return _stable; }
+
+  // Buttons pressed since the last call, even if already released again, so
+  // a tap shorter than the send interval still reaches a command.
+  uint8_t presses() const { return _pressLatch; }
+  uint8_t takePresses() {
+    uint8_t p = _pressLatch;
+    _pressLatch = 0;
+    return p;
+  }
+
+  uint32_t bounces() const { return _bounces; }
+
+private:
+  void accept(uint8_t b, bool down, uint32_t tUs) {
+    uint8_t bit = 1u << b;
+    _stable = down ? (_stable | bit) : (_stable & ~bit);
+    _acceptUs[b] = tUs;
+    _locked |= bit;
+    if (down) _pressLatch |= bit;
+
+    for (int i = 0; i < _count; i++) {
+      const GestureSpec &s = _specs[i];
+      if (!(s.buttons & bit)) continue;
+      switch (s.kind) {
+        case GESTURE_PRESS:
+          if (down) _pending |= 1u << i;
+          break;
+        case GESTURE_RELEASE:
+          if (!down) _pending |= 1u << i;
+          break;
+        case GESTURE_DOUBLE_TAP:
+          if (!down) break;
+          if ((_tapArmed & (1u << i)) && tUs - _lastPressUs[i] <= (uint32_t)s.ms * 1000) {
+            _pending |= 1u << i;
+            _tapArmed &= ~(1u << i);
+          } else {
+            _tapArmed |= 1u << i;
+            _lastPressUs[i] = tUs;
+          }
+          break;
+        default:
+          break;
+      }
+    }
+    checkHolds(tUs);
+  }
+
+  // A hold starts at the edge that completes its condition.
+  void checkHolds(uint32_t tUs) {
+    for (int i = 0; i < _count; i++) {
+      const GestureSpec &s = _specs[i];
+      if (s.kind != GESTURE_HOLD && s.kind != GESTURE_CHORD_HOLD) continue;
+      uint32_t bit = 1u << i;
+      bool met = (_stable & s.buttons) == s.buttons && (_stable & s.forbid) == 0;
+      if (!met) {
+        _holding &= ~bit;
+        _holdFired &= ~bit;
+        continue;
+      }
+      if (!(_holding & bit)) {
+        _holding |= bit;
+        _holdSinceUs[i] = tUs;
+      }
+      if (!(_holdFired & bit) && tUs - _holdSinceUs[i] >= (uint32_t)s.ms * 1000) {
+        _holdFired |= bit;
+        _pending |= bit;
+      }
+    }
+  }
+
+  const GestureSpec *_specs = nullptr;
+  int _count = 0;
+  uint32_t _debounceUs = 5000;
+
+  uint8_t _raw = 0;              // last raw level per button
+  uint8_t _stable = 0;           // debounced level
+  uint8_t _locked = 0;           // in the post-edge lock-out
+  uint8_t _pressLatch = 0;
+  uint32_t _acceptUs[GESTURE_MAX_BUTTONS];
+  uint32_t _bounces = 0;
+
+  uint32_t _pending = 0;
+  uint32_t _tapArmed = 0;
+  uint32_t _lastPressUs[GESTURE_MAX_SPECS];
+  uint32_t _holding = 0;
+  uint32_t _holdFired = 0;
+  uint32_t _holdSinceUs[GESTURE_MAX_SPECS];
+};
+
+#endif // GESTURE_ENGINE_H
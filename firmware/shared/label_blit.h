@@ -0,0 +1,56 @@
+#ifndef LABEL_BLIT_H
+#define LABEL_BLIT_H
+
+#include <stdint.h>
+
+// ============================================
+// LABEL COLUMN BLIT
+// ============================================
+// The pixel work behind the controller's label cache: a label rasterised
+// once into 8-pixel columns (bit n = row n) is ORed into an SSD1306 page
+// buffer, one byte per column, two when it straddles a page. Rotation 2
+// mirrors the panel on both axes, so its columns are stored bit-reversed
+// and drawn right to left. Plain C++ so tools/label_render_check can hold
+// it against print() on a host framebuffer.
+
+static inline uint8_t labelReverseBits(uint8_t b) {
+  b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
+  b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
+  b = (b & 0xAA) >> 1 | (b & 0x55) << 1;
+  return b;
+}
+
+// Column bytes of a w x 8 canvas (anything with getPixel(x, y)) into out.
+template <typename Canvas>
+static inline void labelColumns(const Canvas &canvas, int w, bool flip, uint8_t *out) {
+  for (int x = 0; x < w; x++) {
+    uint8_t col = 0;
+    for (int y = 0; y < 8; y++) {
+      if (canvas.getPixel(x, y)) col |= 1 << y;
+    }
+    out[x] = flip ? labelReverseBits(col) : col;
+  }
+}
+
+// OR width columns into the page buffer fb (fbWidth x fbHeight pixels) with
+// the label's top-left corner at logical (x, y); clipped at every edge.
+static inline void labelBlit(uint8_t *fb, int fbWidth, int fbHeight, const uint8_t *cols, int width,
+                             int x, int y, bool flip) {
+  int top = flip ? fbHeight - 8 - y : y;   // physical row of the label's first bit
+  if (top <= -8 || top >= fbHeight) return;
+
+  int page = (top + 8) / 8 - 1;            // floor(top / 8) for top >= -7
+  int shift = top - page * 8;
+  bool lo = page >= 0;
+  bool hi = shift && page + 1 < fbHeight / 8;
+
+  for (int i = 0; i < width; i++) {
+    int px = flip ? fbWidth - 1 - (x + i) : x + i;
+    if (px < 0 || px >= fbWidth) continue;
+    uint8_t col = cols[i];
+    if (lo) fb[page * fbWidth + px] |= col << shift;
+    if (hi) fb[(page + 1) * fbWidth + px] |= col >> (8 - shift);
+  }
+}
+
+#endif // LABEL_BLIT_H
@@ -0,0 +1,160 @@
+#ifndef LINK_STATS_H
+#define LINK_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// ============================================
+// SEQUENCE TRACKING
+// ============================================
+// Counts distinct commands, duplicates and commands that never arrived,
+// from the 8-bit rolling seq. Keeps a 32-seq window as a bitmask: a seq
+// that slides out of the window without having been seen counts as lost,
+// so loss is "effective" loss after any redundancy has had its chance.
+// Plain C++ so the same counter runs in firmware and host simulators.
+
+#define SEQ_WINDOW     32
+#define SEQ_MAX_JUMP   64     // larger jumps restart tracking (new stream)
+
+class SeqTracker {
+public:
+  // Returns true the first time a seq is seen.
+  bool mark(uint8_t seq) {
+    if (!_started) {
+      _started = true;
+      _newest = seq;
+      _seen = ~0u;         // nothing before the first seq is owed
+      unique++;
+      return true;
+    }
+    int8_t d = (int8_t)(seq - _newest);
+    if (d > 0) {
+      if (d > SEQ_MAX_JUMP) {
+        restarts++;
+        _seen = ~0u;
+      } else if (d >= SEQ_WINDOW) {
+        lost += SEQ_WINDOW - popcount(_seen) + (d - SEQ_WINDOW);
+        _seen = 0;
+      } else {
+        // Seqs pushed out of the window unseen are lost for good.
+        uint32_t out = _seen >> (SEQ_WINDOW - d);
+        lost += d - popcount(out);
+        _seen <<= d;
+      }
+      _seen |= 1;
+      _newest = seq;
+      unique++;
+      return true;
+    }
+    // Nothing stays in flight for a whole window, so a seq this far back
+    // is a sender that started counting again (a reboot), not a late copy.
+    int age = -d;
+    if (age >= SEQ_WINDOW) {
+      restarts++;
+      _seen = ~0u;
+      _newest = seq;
+      unique++;
+      return true;
+    }
+    uint32_t bit = 1u << age;
+    if (_seen & bit) {
+      duplicates++;
+      return false;
+    }
+    _seen |= bit;
+    unique++;
+    return true;
+  }
+
+  // Lost share of all commands that have left the window (0..1).
+  float lossRate() const {
+    uint32_t settled = unique + lost;
+    return settled ? (float)lost / settled : 0.0f;
+  }
+
+  uint32_t unique = 0;       // distinct seqs received
+  uint32_t duplicates = 0;
+  uint32_t lost = 0;         // left the window without arriving
+  uint32_t restarts = 0;     // jumps of more than SEQ_MAX_JUMP ahead or a window back
+
+private:
+  static int popcount(uint32_t v) {
+    int n = 0;
+    for (; v; v &= v - 1) n++;
+    return n;
+  }
+
+  bool _started = false;
+  uint8_t _newest = 0;
+  uint32_t _seen = 0;        // bit i = seq (_newest - i) received
+};
+
+// ============================================
+// LATENCY HISTOGRAM
+// ============================================
+// Fixed 250 us buckets up to 32 ms (the last bucket collects anything
+// slower), so percentiles cost no allocation and updates are O(1).
+
+#define LAT_BUCKET_US  250
+#define LAT_BUCKETS    128
+
+class LatencyHistogram {
+public:
+  void add(uint32_t us) {
+    uint32_t b = us / LAT_BUCKET_US;
+    _buckets[b < LAT_BUCKETS ? b : LAT_BUCKETS - 1]++;
+    count++;
+    sumUs += us;
+    if (us > maxUs) maxUs = us;
+  }
+
+  void reset() {
+    memset(_buckets, 0, sizeof(_buckets));
+    count = 0;
+    sumUs = 0;
+    maxUs = 0;
+  }
+
+  uint32_t avgUs() const { return count ? (uint32_t)(sumUs / count) : 0; }
+
+  // Upper edge of the bucket holding the p-th fraction (0..1) of samples.
+  uint32_t percentileUs(float p) const {
+    if (count == 0) return 0;
+    uint32_t want = (uint32_t)(p * count + 0.5f);
+    if (want == 0) want = 1;
+    uint32_t seen = 0;
+    for (int b = 0; b < LAT_BUCKETS; b++) {
+      seen += _buckets[b];
+      if (seen >= want) return b == LAT_BUCKETS - 1 ? maxUs : (b + 1) * LAT_BUCKET_US;
+    }
+    return maxUs;
+  }
+
+  uint32_t count = 0;
+  uint64_t sumUs = 0;
+  uint32_t maxUs = 0;
+
+private:
+  uint32_t _buckets[LAT_BUCKETS] = {};
+};
+
+// ============================================
+// AIRTIME ESTIMATE
+// ============================================
+// On-air time of one unicast ESP-NOW frame and its ACK at a DSSS/CCK rate:
+// long preamble + PLCP header, MAC header + ESP-NOW action/vendor header +
+// FCS, SIFS, then the 14-byte ACK at the same rate. Good enough to compare
+// frame formats; ignores contention and retries.
+#define ESPNOW_FRAME_OVERHEAD  43     // bytes around the payload
+#define ESPNOW_PREAMBLE_US     192
+#define ESPNOW_SIFS_US         10
+#define ESPNOW_ACK_BYTES       14
+
+static inline uint32_t espnowAirtimeUs(size_t payload, uint32_t rateKbps = 1000, bool acked = true) {
+  uint32_t t = ESPNOW_PREAMBLE_US + (ESPNOW_FRAME_OVERHEAD + payload) * 8000 / rateKbps;
+  if (acked) t += ESPNOW_SIFS_US + ESPNOW_PREAMBLE_US + ESPNOW_ACK_BYTES * 8000 / rateKbps;
+  return t;
+}
+
+#endif // LINK_STATS_H
@@ -0,0 +1,193 @@
+#ifndef LIST_VIEW_H
+#define LIST_VIEW_H
+
+#include <stdint.h>
+#include <string.h>
+
+// ============================================
+// SCROLLING LIST VIEW MODEL
+// ============================================
+// Model behind the device menu: a sorted order over the caller's items, a
+// highlight that follows its item when the order changes, and a window of
+// `rows` visible rows kept around the highlight. Only visible rows are ever
+// drawn, and each one remembers what it showed last (item, status word,
+// highlight), so a frame is only redrawn - and only the rows that changed -
+// when something on screen would differ.
+//
+//   view.update(items, n, nowMs);        every pass: new keys and status
+//   view.move(+1);                       stick tilt
+//   if (view.dirty()) { draw rows where rowDirty(r) (all if frameDirty());
+//                       view.drawn(); }
+//
+// Items are identified by their index in the caller's array, which must stay
+// stable. Plain C++ so the same model runs in tools/list_view_check.
+
+#define LIST_MAX_ITEMS 64
+#define LIST_MAX_ROWS  8
+
+enum ListSort : uint8_t {
+  LIST_SORT_TABLE,       // caller's order
+  LIST_SORT_QUALITY,     // best link first
+  LIST_SORT_LAST_SEEN,   // most recently heard first, never-heard last
+  LIST_SORT_COUNT
+};
+
+struct ListItem {
+  uint8_t quality;       // 0..100
+  uint32_t lastSeenMs;   // 0 = never
+  uint16_t status;       // whatever the row shows besides the name; a change redraws it
+};
+
+class ListView {
+public:
+  void begin(uint8_t rows) {
+    _rows = rows > LIST_MAX_ROWS ? LIST_MAX_ROWS : rows;
+    _count = 0;
+    _pos = 0;
+    _top = 0;
+    _sort = LIST_SORT_TABLE;
+    _needFrame = true;
+  }
+
+  void setSort(ListSort s) {
+    if (s == _sort) return;
+    _sort = s;
+    _needFrame = true;
+    reorder();
+  }
+  ListSort sort() const { return _sort; }
+
+  // New keys and status for every item; re-sorts and keeps the highlighted
+  // item highlighted.
+  void update(const ListItem *items, int count, uint32_t nowMs) {
+    if (count > LIST_MAX_ITEMS) count = LIST_MAX_ITEMS;
+    int item = highlighted();
+    if (count != _count) {
+      _needFrame = true;
+      _pos = 0;
+      for (int i = 0; i < count; i++) _order[i] = (uint8_t)i;
+    }
+    _count = count;
+    for (int i = 0; i < count; i++) {
+      _status[i] = items[i].status;
+      _quality[i] = items[i].quality;
+      // Age, so newer sorts first across a millis() wrap; never = oldest.
+      _age[i] = items[i].lastSeenMs ? nowMs - items[i].lastSeenMs : UINT32_MAX;
+    }
+    reorder();
+    if (item >= 0 && item < count) select(item);
+    else place(_pos < _count ? _pos : _count - 1);
+  }
+
+  // Move the highlight by delta rows, wrapping at either end.
+  void move(int delta) {
+    if (_count == 0) return;
+    int p = (_pos + delta) % _count;
+    place(p < 0 ? p + _count : p);
+  }
+
+  // Highlight an item by its caller index.
+  void select(int item) {
+    for (int p = 0; p < _count; p++) {
+      if (_order[p] == item) { place(p); return; }
+    }
+  }
+
+  int highlighted() const { return _count ? _order[_pos] : -1; }
+  int count() const { return _count; }
+  int top() const { return _top; }
+  int position() const { return _pos; }
+  int visibleRows() const { return _count < _rows ? _count : _rows; }
+  // Caller index on a visible row, -1 past the end of the list.
+  int itemAt(int row) const { return row < visibleRows() ? _order[_top + row] : -1; }
+
+  // Title, scroll bar or row count changed: redraw everything.
+  bool frameDirty() const { return _needFrame; }
+  bool rowDirty(int row) const { return _needFrame || signature(row) != _drawn[row]; }
+  bool dirty() const {
+    if (_needFrame) return true;
+    for (int r = 0; r < _rows; r++) {
+      if (signature(r) != _drawn[r]) return true;
+    }
+    return false;
+  }
+
+  // The caller has drawn every dirty row.
+  void drawn() {
+    for (int r = 0; r < _rows; r++) _drawn[r] = signature(r);
+    _needFrame = false;
+  }
+
+  // Forces a full redraw (screen was used for something else).
+  void invalidate() { _needFrame = true; }
+
+private:
+  // What row r shows: item, its status and whether it is highlighted.
+  uint32_t signature(int row) const {
+    int item = itemAt(row);
+    if (item < 0) return UINT32_MAX;
+    return (uint32_t)item | (uint32_t)_status[item] << 8 | (uint32_t)(_top + row == _pos) << 24;
+  }
+
+  // a before b in the current sort; ties keep the caller's order.
+  bool before(uint8_t a, uint8_t b) const {
+    switch (_sort) {
+      case LIST_SORT_QUALITY:
+        if (_quality[a] != _quality[b]) return _quality[a] > _quality[b];
+        break;
+      case LIST_SORT_LAST_SEEN:
+        if (_age[a] != _age[b]) return _age[a] < _age[b];
+        break;
+      default:
+        break;
+    }
+    return a < b;
+  }
+
+  // Insertion sort: keys change a little between passes, so the order is
+  // nearly sorted and this is close to one compare per item.
+  void reorder() {
+    int item = highlighted();
+    for (int i = 1; i < _count; i++) {
+      uint8_t v = _order[i];
+      int j = i;
+      while (j > 0 && before(v, _order[j - 1])) {
+        _order[j] = _order[j - 1];
+        j--;
+      }
+      _order[j] = v;
+    }
+    if (item >= 0) select(item);
+  }
+
+  // Highlight position p, scrolling the least needed to keep it visible.
+  void place(int p) {
+    if (_count == 0) {
+      _pos = 0;
+      _top = 0;
+      return;
+    }
+    _pos = p;
+    int top = _top;
+    if (_pos < top) top = _pos;
+    if (_pos >= top + _rows) top = _pos - _rows + 1;
+    int maxTop = _count > _rows ? _count - _rows : 0;
+    if (top > maxTop) top = maxTop;
+    if (top != _top) _needFrame = true;   // scroll bar moves, every row changes
+    _top = top;
+  }
+
+  uint8_t _rows = 0;
+  int _count = 0;
+  int _pos = 0;              // highlight, as a position in _order
+  int _top = 0;              // position shown on the first row
+  ListSort _sort = LIST_SORT_TABLE;
+  bool _needFrame = true;
+  uint8_t _order[LIST_MAX_ITEMS];
+  uint16_t _status[LIST_MAX_ITEMS];
+  uint8_t _quality[LIST_MAX_ITEMS];
+  uint32_t _age[LIST_MAX_ITEMS];
+  uint32_t _drawn[LIST_MAX_ROWS];
+};
+
+#endif // LIST_VIEW_H
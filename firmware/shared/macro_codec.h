@@ -0,0 +1,184 @@
+#ifndef MACRO_CODEC_H
+#define MACRO_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// ============================================
+// MACRO LOG CODEC
+// ============================================
+// Compact encoding for a recorded driving session: one sample per control
+// tick. Plain C++ (no Arduino) so tools/macro_codec_check runs the same code.
+//
+// Each sample is a header byte followed by its changed fields:
+//   0x80 | n          run: previous sample repeated n (1..127) times at the
+//                     nominal tick
+//   0b00dm_mmmm       m = changed-field mask (bit0 x, bit1 y, bit2 rot,
+//                     bit3 speed, bit4 buttons); d = dt differs from the tick,
+//                     followed by dt in ms as a LEB128 varint
+// Then one byte per changed field in mask order. x/y/rot are stored as the
+// 8-bit wrapping delta from the previous value, which is lossless for the
+// -100..100 range; speed and buttons are stored as-is.
+
+#define MACRO_MAGIC        0x3143414D   // "MAC1"
+#define MACRO_VERSION      1
+#define MACRO_MAX_ENCODED  10           // worst case bytes from one encode()
+#define MACRO_RUN_MAX      127
+
+#define MACRO_FIELD_X        0x01
+#define MACRO_FIELD_Y        0x02
+#define MACRO_FIELD_ROT      0x04
+#define MACRO_FIELD_SPEED    0x08
+#define MACRO_FIELD_BUTTONS  0x10
+#define MACRO_FLAG_DT        0x20
+#define MACRO_FLAG_RUN       0x80
+
+struct MacroSample {
+  uint16_t dtMs;      // time since the previous sample
+  int8_t   x, y, rot;
+  uint8_t  speed;
+  uint8_t  buttons;
+};
+
+struct __attribute__((packed)) MacroFileHeader {
+  uint32_t magic;
+  uint8_t  version;
+  uint8_t  tickMs;    // nominal sample interval at record time
+  uint16_t reserved;
+};
+
+// ============================================
+// ENCODER
+// ============================================
+class MacroEncoder {
+public:
+  void begin(uint8_t tickMs) {
+    memset(&_prev, 0, sizeof(_prev));
+    _tick = tickMs;
+    _run = 0;
+  }
+
+  // Append one sample; returns the number of bytes written to out (0 when
+  // the sample was folded into a pending run). out needs MACRO_MAX_ENCODED.
+  size_t encode(const MacroSample &s, uint8_t *out) {
+    uint8_t mask = 0;
+    if (s.x != _prev.x)             mask |= MACRO_FIELD_X;
+    if (s.y != _prev.y)             mask |= MACRO_FIELD_Y;
+    if (s.rot != _prev.rot)         mask |= MACRO_FIELD_ROT;
+    if (s.speed != _prev.speed)     mask |= MACRO_FIELD_SPEED;
+    if (s.buttons != _prev.buttons) mask |= MACRO_FIELD_BUTTONS;
+    bool nominal = s.dtMs == _tick;
+
+    if (mask == 0 && nominal) {
+      if (++_run == MACRO_RUN_MAX) return flush(out);
+      return 0;
+    }
+
+    size_t n = flush(out);
+    out[n++] = mask | (nominal ? 0 : MACRO_FLAG_DT);
+    if (!nominal) {
+      uint16_t dt = s.dtMs;
+      do {
+        uint8_t b = dt & 0x7F;
+        dt >>= 7;
+        out[n++] = b | (dt ? 0x80 : 0);
+      } while (dt);
+    }
+    if (mask & MACRO_FIELD_X)       out[n++] = (uint8_t)(s.x - _prev.x);
+    if (mask & MACRO_FIELD_Y)       out[n++] = (uint8_t)(s.y - _prev.y);
+    if (mask & MACRO_FIELD_ROT)     out[n++] = (uint8_t)(s.rot - _prev.rot);
+    if (mask & MACRO_FIELD_SPEED)   out[n++] = s.speed;
+    if (mask & MACRO_FIELD_BUTTONS) out[n++] = s.buttons;
+    _prev = s;
+    return n;
+  }
+
+  // Emit any pending run; call once at the end of a recording.
+  size_t flush(uint8_t *out) {
+    if (_run == 0) return 0;
+    out[0] = MACRO_FLAG_RUN | _run;
+    _run = 0;
+    return 1;
+  }
+
+private:
+  MacroSample _prev;
+  uint8_t _tick = 20;
+  uint8_t _run = 0;
+};
+
+// ============================================
+// DECODER
+// ============================================
+// Byte-at-a-time so it can be fed across buffer boundaries. push() returns
+// 0 while a sample is incomplete, N > 0 when sample() should be emitted N
+// times (N > 1 only for runs), or -1 on a malformed stream. A stream that
+// ends with idle() false was cut off mid-sample.
+class MacroDecoder {
+public:
+  void begin(uint8_t tickMs) {
+    memset(&_cur, 0, sizeof(_cur));
+    _tick = tickMs;
+    _mask = 0;
+    _needDt = false;
+    _inSample = false;
+  }
+
+  int push(uint8_t b) {
+    if (!_inSample) {
+      if (b & MACRO_FLAG_RUN) {
+        uint8_t n = b & 0x7F;
+        if (n == 0) return -1;
+        _cur.dtMs = _tick;
+        return n;
+      }
+      if (b & 0x40) return -1;   // reserved bit
+      _mask = b & 0x1F;
+      _needDt = b & MACRO_FLAG_DT;
+      _cur.dtMs = _needDt ? 0 : _tick;
+      _dtShift = 0;
+      _inSample = true;
+    } else if (_needDt) {
+      // The third varint byte holds dt bits 14..15 only.
+      if (_dtShift > 14 || (_dtShift == 14 && (b & 0x7C))) return -1;
+      _cur.dtMs |= (uint16_t)(b & 0x7F) << _dtShift;
+      _dtShift += 7;
+      if (!(b & 0x80)) _needDt = false;
+    } else if (_mask & MACRO_FIELD_X) {
+      _cur.x = (int8_t)(_cur.x + (int8_t)b);
+      _mask &= ~MACRO_FIELD_X;
+    } else if (_mask & MACRO_FIELD_Y) {
+      _cur.y = (int8_t)(_cur.y + (int8_t)b);
+      _mask &= ~MACRO_FIELD_Y;
+    } else if (_mask & MACRO_FIELD_ROT) {
+      _cur.rot = (int8_t)(_cur.rot + (int8_t)b);
+      _mask &= ~MACRO_FIELD_ROT;
+    } else if (_mask & MACRO_FIELD_SPEED) {
+      _cur.speed = b;
+      _mask &= ~MACRO_FIELD_SPEED;
+    } else if (_mask & MACRO_FIELD_BUTTONS) {
+      _cur.buttons = b;
+      _mask &= ~MACRO_FIELD_BUTTONS;
+    }
+
+    if (_inSample && !_needDt && _mask == 0) {
+      _inSample = false;
+      return 1;
+    }
+    return 0;
+  }
+
+  const MacroSample &sample() const { return _cur; }
+  bool idle() const { return !_inSample; }
+
+private:
+  MacroSample _cur;
+  uint8_t _tick = 20;
+  uint8_t _mask = 0;     // fields still to read for the current sample
+  bool _needDt = false;
+  uint8_t _dtShift = 0;
+  bool _inSample = false;
+};
+
+#endif // MACRO_CODEC_H
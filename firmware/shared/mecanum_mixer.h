@@ -0,0 +1,67 @@
+#ifndef MECANUM_MIXER_H
+#define MECANUM_MIXER_H
+
+#include <stdint.h>
+#include "espnow_data.h"
+
+// ============================================
+// MECANUM WHEEL MIXING
+// ============================================
+// The robot's calculateMotorSpeeds() in integer arithmetic:
+//
+//   FL = y + x + rot     FR = y - x - rot
+//   BL = y - x + rot     BR = y + x - rot
+//
+// with x, y, rot clamped to -100..100 (the robot's /100.0 and clamp to
+// [-1, 1]). When a wheel would exceed full scale, all four are divided by
+// the largest, so the direction of travel is kept and only the magnitude
+// saturates. Each wheel is then scaled by speed into a signed duty of
+// -255..255 (sign = direction, magnitude = 8-bit PWM).
+//
+// One integer division per command; the four wheels share a Q16 scale
+// factor. Results are within one duty step of the float formula (see
+// tools/mixer_check, which also times it). Plain C++ so the same mixer
+// runs on the bench receiver and on a host.
+
+#define MIX_AXIS_MAX  100     // |x|, |y|, |rot| after clamping
+#define MIX_DUTY_MAX  255
+
+struct WheelDuty {
+  int16_t fl, fr, bl, br;     // -MIX_DUTY_MAX..MIX_DUTY_MAX
+};
+
+static inline int32_t mixClampAxis(int8_t v) {
+  return v > MIX_AXIS_MAX ? MIX_AXIS_MAX : v < -MIX_AXIS_MAX ? -MIX_AXIS_MAX : v;
+}
+
+static inline int32_t mixAbs(int32_t v) { return v < 0 ? -v : v; }
+
+// s * k / 65536, rounded half away from zero.
+static inline int16_t mixScale(int32_t s, uint32_t k) {
+  uint32_t m = ((uint32_t)mixAbs(s) * k + 0x8000u) >> 16;
+  return (int16_t)(s < 0 ? -(int32_t)m : (int32_t)m);
+}
+
+static inline WheelDuty mecanumMix(const ControlCommand &cmd) {
+  int32_t x = mixClampAxis(cmd.x);
+  int32_t y = mixClampAxis(cmd.y);
+  int32_t r = mixClampAxis(cmd.rot);
+
+  int32_t fl = y + x + r;
+  int32_t fr = y - x - r;
+  int32_t bl = y - x + r;
+  int32_t br = y + x - r;
+
+  // Full scale is MIX_AXIS_MAX, or the largest wheel if that is beyond it.
+  int32_t peak = MIX_AXIS_MAX;
+  if (mixAbs(fl) > peak) peak = mixAbs(fl);
+  if (mixAbs(fr) > peak) peak = mixAbs(fr);
+  if (mixAbs(bl) > peak) peak = mixAbs(bl);
+  if (mixAbs(br) > peak) peak = mixAbs(br);
+
+  // |wheel| <= peak <= 300 and k <= 255 << 16 / 100, so the product fits.
+  uint32_t k = ((uint32_t)cmd.speed << 16) / (uint32_t)peak;
+  return {mixScale(fl, k), mixScale(fr, k), mixScale(bl, k), mixScale(br, k)};
+}
+
+#endif // MECANUM_MIXER_H
@@ -0,0 +1,334 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+
+// ============================================
+// METRICS REGISTRY
+// ============================================
+// Counters, gauges and fixed-bucket histograms declared at compile time with
+// an X-macro list:
+//
+//   #define MY_METRICS(COUNTER, GAUGE, HISTOGRAM)
+//     COUNTER(framesSent, "frames", "frames handed to the radio")
+//     GAUGE(channel, "", "radio channel")
+//     HISTOGRAM(ackUs, "us", "send -> ACK", ackEdgesUs)
+//   METRICS_REGISTRY(MyMetrics, MY_METRICS)
+//
+// Each metric is a plain member (metrics.framesSent.inc()), so an update is
+// one relaxed atomic op on a fixed address: no lookup, no lock, no
+// allocation, safe from any task. A histogram first finds its bucket (a
+// short scan of the edge table), then does one fetch_add.
+//
+// metricsTake() copies every value into a MetricsSnapshot. Relaxed updates
+// give no cross-metric ordering, so it reads everything twice and retries
+// until both passes agree; a snapshot from a quiet moment is exact. Formatting
+// (human table, CSV, JSON lines) works on the snapshot and writes through a
+// callback, so the same code prints to Serial and to stdout on a host.
+
+#define METRIC_HIST_BUCKETS  8     // METRIC_HIST_BUCKETS - 1 edges + overflow
+#define METRICS_MAX          32
+#define METRIC_SNAPSHOT_TRIES 4
+
+enum MetricKind : uint8_t {
+  METRIC_COUNTER,
+  METRIC_GAUGE,
+  METRIC_HISTOGRAM,
+};
+
+class MetricCounter {
+public:
+  void inc(uint32_t n = 1) { _v.fetch_add(n, std::memory_order_relaxed); }
+  uint32_t load() const { return _v.load(std::memory_order_relaxed); }
+  void reset() { _v.store(0, std::memory_order_relaxed); }
+
+private:
+  std::atomic<uint32_t> _v{0};
+};
+
+class MetricGauge {
+public:
+  void set(int32_t v) { _v.store(v, std::memory_order_relaxed); }
+  int32_t load() const { return _v.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<int32_t> _v{0};
+};
+
+// Bucket i counts values <= edges[i]; the last bucket counts the rest.
+// edges must hold METRIC_HIST_BUCKETS - 1 ascending values.
+class MetricHistogram {
+public:
+  explicit MetricHistogram(const uint32_t *edges) : _edges(edges) {}
+
+  void add(uint32_t v) {
+    int b = 0;
+    while (b < METRIC_HIST_BUCKETS - 1 && v > _edges[b]) b++;
+    _b[b].fetch_add(1, std::memory_order_relaxed);
+  }
+  uint32_t load(int b) const { return _b[b].load(std::memory_order_relaxed); }
+  const uint32_t *edges() const { return _edges; }
+  void reset() {
+    for (std::atomic<uint32_t> &b : _b) b.store(0, std::memory_order_relaxed);
+  }
+
+private:
+  const uint32_t *_edges;
+  std::atomic<uint32_t> _b[METRIC_HIST_BUCKETS] = {};
+};
+
+// ============================================
+// SNAPSHOT
+// ============================================
+
+struct MetricValue {
+  const char *name;
+  const char *unit;
+  const char *help;
+  MetricKind kind;
+  int32_t value;                         // counter (as uint32) or gauge
+  const uint32_t *edges;                 // histogram only
+  uint32_t buckets[METRIC_HIST_BUCKETS];
+
+  bool operator==(const MetricValue &o) const {
+    return value == o.value && memcmp(buckets, o.buckets, sizeof(buckets)) == 0;
+  }
+  bool operator!=(const MetricValue &o) const { return !(*this == o); }
+
+  uint32_t count() const {
+    uint32_t n = 0;
+    for (uint32_t b : buckets) n += b;
+    return n;
+  }
+  // Upper edge of the bucket holding percentile p (0..1); UINT32_MAX if it
+  // falls in the overflow bucket, 0 if empty.
+  uint32_t percentileEdge(float p) const {
+    uint32_t n = count();
+    if (!n) return 0;
+    uint32_t target = (uint32_t)(p * n);
+    if (target >= n) target = n - 1;
+    uint32_t seen = 0;
+    for (int b = 0; b < METRIC_HIST_BUCKETS - 1; b++) {
+      seen += buckets[b];
+      if (seen > target) return edges[b];
+    }
+    return UINT32_MAX;
+  }
+};
+
+struct MetricsSnapshot {
+  uint32_t tMs;
+  int count;
+  bool consistent;                       // two passes agreed
+  MetricValue m[METRICS_MAX];
+};
+
+// Fills a snapshot from a registry's visit().
+class MetricsCollector {
+public:
+  explicit MetricsCollector(MetricsSnapshot &s) : _s(s) { _s.count = 0; }
+
+  void counter(const char *name, const char *unit, const char *help, const MetricCounter &c) {
+    MetricValue *v = next(name, unit, help, METRIC_COUNTER);
+    if (v) v->value = (int32_t)c.load();
+  }
+  void gauge(const char *name, const char *unit, const char *help, const MetricGauge &g) {
+    MetricValue *v = next(name, unit, help, METRIC_GAUGE);
+    if (v) v->value = g.load();
+  }
+  void histogram(const char *name, const char *unit, const char *help, const MetricHistogram &h) {
+    MetricValue *v = next(name, unit, help, METRIC_HISTOGRAM);
+    if (!v) return;
+    v->edges = h.edges();
+    for (int b = 0; b < METRIC_HIST_BUCKETS; b++) v->buckets[b] = h.load(b);
+  }
+
+private:
+  MetricValue *next(const char *name, const char *unit, const char *help, MetricKind kind) {
+    if (_s.count >= METRICS_MAX) return nullptr;
+    MetricValue &v = _s.m[_s.count++];
+    v = MetricValue();
+    v.name = name;
+    v.unit = unit;
+    v.help = help;
+    v.kind = kind;
+    return &v;
+  }
+
+  MetricsSnapshot &_s;
+};
+
+// Resets counters and histograms; gauges keep their current value.
+class MetricsResetter {
+public:
+  void counter(const char *, const char *, const char *, MetricCounter &c) { c.reset(); }
+  void gauge(const char *, const char *, const char *, MetricGauge &) {}
+  void histogram(const char *, const char *, const char *, MetricHistogram &h) { h.reset(); }
+};
+
+template <class Registry>
+void metricsTake(const Registry &reg, uint32_t tMs, MetricsSnapshot &out) {
+  static MetricsSnapshot check;          // not on the (small) loop task stack
+  out.tMs = tMs;
+  out.consistent = false;
+  MetricsCollector first(out);
+  reg.visit(first);
+  for (int tries = 0; tries < METRIC_SNAPSHOT_TRIES && !out.consistent; tries++) {
+    MetricsCollector again(check);
+    reg.visit(again);
+    out.consistent = true;
+    for (int i = 0; i < out.count; i++) {
+      if (out.m[i] != check.m[i]) {
+        out.consistent = false;
+        out.m[i] = check.m[i];
+      }
+    }
+  }
+}
+
+// ============================================
+// REGISTRY GENERATION
+// ============================================
+
+#define METRIC_MEMBER_COUNTER(id, unit, help)          MetricCounter id;
+#define METRIC_MEMBER_GAUGE(id, unit, help)            MetricGauge id;
+#define METRIC_MEMBER_HISTOGRAM(id, unit, help, edges) MetricHistogram id{edges};
+#define METRIC_VISIT_COUNTER(id, unit, help)           v.counter(#id, unit, help, id);
+#define METRIC_VISIT_GAUGE(id, unit, help)             v.gauge(#id, unit, help, id);
+#define METRIC_VISIT_HISTOGRAM(id, unit, help, edges)  v.histogram(#id, unit, help, id);
+
+#define METRICS_REGISTRY(Name, LIST)                                          \
+  struct Name {                                                               \
+    LIST(METRIC_MEMBER_COUNTER, METRIC_MEMBER_GAUGE, METRIC_MEMBER_HISTOGRAM) \
+    template <class V> void visit(V &v) const {                               \
+      LIST(METRIC_VISIT_COUNTER, METRIC_VISIT_GAUGE, METRIC_VISIT_HISTOGRAM)  \
+    }                                                                         \
+    template <class V> void visit(V &v) {                                     \
+      LIST(METRIC_VISIT_COUNTER, METRIC_VISIT_GAUGE, METRIC_VISIT_HISTOGRAM)  \
+    }                                                                         \
+    void reset() {                                                            \
+      MetricsResetter r;                                                      \
+      visit(r);                                                               \
+    }                                                                         \
+  };
+
+// ============================================
+// FORMATTING
+// ============================================
+
+enum MetricsFormat : uint8_t {
+  METRICS_HUMAN,
+  METRICS_CSV,      // "t_ms,name,kind,unit,value" rows; histograms as name.le_N buckets
+  METRICS_JSON,     // one JSON object per snapshot, on one line
+};
+
+typedef void (*MetricsWriter)(const char *text, void *ctx);
+
+class MetricsPrinter {
+public:
+  MetricsPrinter(MetricsWriter w, void *ctx) : _w(w), _ctx(ctx) {}
+
+  void print(const MetricsSnapshot &s, MetricsFormat f) {
+    switch (f) {
+      case METRICS_HUMAN: human(s); break;
+      case METRICS_CSV:   csv(s);   break;
+      case METRICS_JSON:  json(s);  break;
+    }
+  }
+
+private:
+  void out(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+    char buf[96];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    _w(buf, _ctx);
+  }
+
+  void human(const MetricsSnapshot &s) {
+    out("Metrics at %lu ms%s\n", (unsigned long)s.tMs, s.consistent ? "" : " (updated while copying)");
+    for (int i = 0; i < s.count; i++) {
+      const MetricValue &m = s.m[i];
+      switch (m.kind) {
+        case METRIC_COUNTER:
+          out("  %-18s %10lu %-7s %s\n", m.name, (unsigned long)(uint32_t)m.value, m.unit, m.help);
+          break;
+        case METRIC_GAUGE:
+          out("  %-18s %10ld %-7s %s\n", m.name, (long)m.value, m.unit, m.help);
+          break;
+        case METRIC_HISTOGRAM: {
+          out("  %-18s %10lu %-7s %s\n", m.name, (unsigned long)m.count(), "samples", m.help);
+          out("  %-18s p50 ", "");
+          edge(m.percentileEdge(0.5f), m.unit);
+          out(" p95 ");
+          edge(m.percentileEdge(0.95f), m.unit);
+          out(" p99 ");
+          edge(m.percentileEdge(0.99f), m.unit);
+          out("\n  %-18s", "");
+          for (int b = 0; b < METRIC_HIST_BUCKETS; b++) {
+            if (b < METRIC_HIST_BUCKETS - 1) out(" <=%lu:%lu", (unsigned long)m.edges[b], (unsigned long)m.buckets[b]);
+            else out(" >:%lu", (unsigned long)m.buckets[b]);
+          }
+          out("\n");
+          break;
+        }
+      }
+    }
+  }
+
+  void edge(uint32_t e, const char *unit) {
+    if (e == UINT32_MAX) out(">max");
+    else out("<=%lu %s", (unsigned long)e, unit);
+  }
+
+  void csv(const MetricsSnapshot &s) {
+    out("t_ms,name,kind,unit,value\n");
+    for (int i = 0; i < s.count; i++) {
+      const MetricValue &m = s.m[i];
+      if (m.kind == METRIC_HISTOGRAM) {
+        for (int b = 0; b < METRIC_HIST_BUCKETS; b++) {
+          if (b < METRIC_HIST_BUCKETS - 1) {
+            out("%lu,%s.le_%lu,bucket,%s,%lu\n", (unsigned long)s.tMs, m.name,
+                (unsigned long)m.edges[b], m.unit, (unsigned long)m.buckets[b]);
+          } else {
+            out("%lu,%s.le_inf,bucket,%s,%lu\n", (unsigned long)s.tMs, m.name, m.unit,
+                (unsigned long)m.buckets[b]);
+          }
+        }
+      } else if (m.kind == METRIC_COUNTER) {
+        out("%lu,%s,counter,%s,%lu\n", (unsigned long)s.tMs, m.name, m.unit, (unsigned long)(uint32_t)m.value);
+      } else {
+        out("%lu,%s,gauge,%s,%ld\n", (unsigned long)s.tMs, m.name, m.unit, (long)m.value);
+      }
+    }
+  }
+
+  void json(const MetricsSnapshot &s) {
+    out("{\"t_ms\":%lu,\"consistent\":%s", (unsigned long)s.tMs, s.consistent ? "true" : "false");
+    for (int i = 0; i < s.count; i++) {
+      const MetricValue &m = s.m[i];
+      if (m.kind == METRIC_HISTOGRAM) {
+        out(",\"%s\":{\"le\":[", m.name);
+        for (int b = 0; b < METRIC_HIST_BUCKETS - 1; b++) out(b ? ",%lu" : "%lu", (unsigned long)m.edges[b]);
+        out("],\"counts\":[");
+        for (int b = 0; b < METRIC_HIST_BUCKETS; b++) out(b ? ",%lu" : "%lu", (unsigned long)m.buckets[b]);
+        out("]}");
+      } else if (m.kind == METRIC_COUNTER) {
+        out(",\"%s\":%lu", m.name, (unsigned long)(uint32_t)m.value);
+      } else {
+        out(",\"%s\":%ld", m.name, (long)m.value);
+      }
+    }
+    out("}\n");
+  }
+
+  MetricsWriter _w;
+  void *_ctx;
+};
+
+#endif // METRICS_H
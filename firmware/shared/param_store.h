@@ -0,0 +1,149 @@
+#ifndef PARAM_STORE_H
+#define PARAM_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+
+// ============================================
+// PARAMETER STORE
+// ============================================
+// Runtime-tunable integer parameters with bounds and defaults, declared once
+// in an X-macro list:
+//
+//   #define MY_PARAMS(P, T)
+//     P(T, sendIntervalMs, "send_ms", PARAM_INT, 20, 5, 200, "ms", "command period")
+//   PARAMS_STRUCT(MyParams, MY_PARAMS);
+//   const ParamInfo myParamDefs[] = PARAMS_TABLE(MyParams, MY_PARAMS);
+//
+// The struct holds plain int32_t members that hot-path code reads directly
+// (params.sendIntervalMs), so a tunable costs the same as a #define held in
+// RAM. ParamStore reaches the same members by index for GET/SET and for NVS.
+//
+// NVS access goes through a template parameter with the Preferences API
+// (isKey/getInt/putInt/getUShort/putUShort/clear), so the host check can
+// pass a fake. Every parameter is stored under its own key, next to a
+// schema version: bump the version when a parameter changes meaning, and
+// values stored under another version are ignored in favour of the defaults.
+// Stored values outside the current bounds are also replaced by defaults.
+
+enum ParamType : uint8_t {
+  PARAM_INT,     // any value in [min, max]
+  PARAM_SIGN,    // -1 or +1 (axis polarity)
+};
+
+struct ParamInfo {
+  const char *name;       // struct member name
+  const char *key;        // NVS key, at most 15 characters
+  ParamType type;
+  int32_t def;
+  int32_t min;
+  int32_t max;
+  const char *unit;
+  const char *help;
+  size_t offset;          // of the member in the params struct
+};
+
+enum ParamResult : uint8_t {
+  PARAM_OK,
+  PARAM_UNKNOWN,          // no parameter by that name
+  PARAM_OUT_OF_RANGE,
+};
+
+enum ParamLoadResult : uint8_t {
+  PARAM_LOADED,           // schema matched; bad values were defaulted
+  PARAM_NOTHING_STORED,   // first boot: defaults
+  PARAM_SCHEMA_MISMATCH,  // stored under another schema: defaults
+};
+
+#define PARAM_SCHEMA_KEY "schema"
+
+#define PARAM_MEMBER(T, id, key, type, def, mn, mx, unit, help) int32_t id = def;
+#define PARAM_INFO(T, id, key, type, def, mn, mx, unit, help) \
+  {#id, key, type, def, mn, mx, unit, help, offsetof(T, id)},
+
+#define PARAMS_STRUCT(Name, LIST) struct Name { LIST(PARAM_MEMBER, Name) }
+#define PARAMS_TABLE(Name, LIST)  { LIST(PARAM_INFO, Name) }
+
+class ParamStore {
+public:
+  ParamStore(const ParamInfo *defs, int count, void *values, uint16_t schema)
+    : _defs(defs), _count(count), _values((uint8_t *)values), _schema(schema) {}
+
+  int count() const { return _count; }
+  const ParamInfo &info(int i) const { return _defs[i]; }
+  uint16_t schema() const { return _schema; }
+
+  // By member name or NVS key, ignoring case (the CLI upper-cases lines).
+  int find(const char *name) const {
+    for (int i = 0; i < _count; i++) {
+      if (strcasecmp(name, _defs[i].name) == 0 || strcasecmp(name, _defs[i].key) == 0) return i;
+    }
+    return -1;
+  }
+
+  int32_t get(int i) const { return *slot(i); }
+
+  static bool valid(const ParamInfo &p, int32_t v) {
+    if (p.type == PARAM_SIGN) return v == 1 || v == -1;
+    return v >= p.min && v <= p.max;
+  }
+
+  ParamResult set(int i, int32_t v) {
+    if (i < 0 || i >= _count) return PARAM_UNKNOWN;
+    if (!valid(_defs[i], v)) return PARAM_OUT_OF_RANGE;
+    if (*slot(i) != v) _dirty = true;
+    *slot(i) = v;
+    return PARAM_OK;
+  }
+
+  void resetDefaults() {
+    for (int i = 0; i < _count; i++) {
+      if (*slot(i) != _defs[i].def) _dirty = true;
+      *slot(i) = _defs[i].def;
+    }
+  }
+
+  // Changed since the last load or save.
+  bool dirty() const { return _dirty; }
+  // Stored values that were out of bounds at the last load.
+  int rejected() const { return _rejected; }
+
+  // nvs must already be open on the parameter namespace.
+  template <class Nvs> ParamLoadResult load(Nvs &nvs) {
+    _rejected = 0;
+    for (int i = 0; i < _count; i++) *slot(i) = _defs[i].def;
+    _dirty = false;
+    if (!nvs.isKey(PARAM_SCHEMA_KEY)) return PARAM_NOTHING_STORED;
+    if (nvs.getUShort(PARAM_SCHEMA_KEY, 0) != _schema) return PARAM_SCHEMA_MISMATCH;
+    for (int i = 0; i < _count; i++) {
+      const ParamInfo &p = _defs[i];
+      if (!nvs.isKey(p.key)) continue;
+      int32_t v = nvs.getInt(p.key, p.def);
+      if (valid(p, v)) *slot(i) = v;
+      else _rejected++;
+    }
+    return PARAM_LOADED;
+  }
+
+  // Rewrites the namespace, so keys of removed parameters do not linger.
+  template <class Nvs> void save(Nvs &nvs) {
+    nvs.clear();
+    nvs.putUShort(PARAM_SCHEMA_KEY, _schema);
+    for (int i = 0; i < _count; i++) nvs.putInt(_defs[i].key, *slot(i));
+    _dirty = false;
+  }
+
+private:
+  int32_t *slot(int i) const { return (int32_t *)(_values + _defs[i].offset); }
+
+  const ParamInfo *_defs;
+  int _count;
+  uint8_t *_values;
+  uint16_t _schema;
+  bool _dirty = false;
+  int _rejected = 0;
+};
+
+#endif // PARAM_STORE_H
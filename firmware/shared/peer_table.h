@@ -0,0 +1,157 @@
+#ifndef PEER_TABLE_H
+#define PEER_TABLE_H
+
+#include <stdint.h>
+
+// ============================================
+// ESP-NOW PEER SLOTS
+// ============================================
+// The driver holds at most ESP_NOW_MAX_TOTAL_PEER_NUM peers, of which only
+// ESP_NOW_MAX_ENCRYPT_PEER_NUM (6 by default) may be encrypted. PeerTable
+// decides which devices hold which kind of slot; the controller applies
+// the changes it returns with esp_now_add_peer()/esp_now_del_peer().
+//
+// A device with a key (LMK) is only ever registered encrypted, never plain:
+// falling back would put its drive commands on the air unprotected. Keyed
+// devices beyond the encrypted limit stay unregistered until selected; the
+// selected device always gets its slot, taken from the keyed device that
+// was selected longest ago. Unkeyed devices get plain slots while the total
+// lasts. Plain C++ so tools/peer_table_check runs the same code.
+
+#define PEER_TABLE_MAX 20          // devices tracked (ESP_NOW_MAX_TOTAL_PEER_NUM)
+#define PEER_KEY_LEN 16            // PMK / LMK bytes (ESP_NOW_KEY_LEN)
+
+enum PeerSlot : uint8_t {
+  PEER_NONE,                       // not registered: sends fail
+  PEER_PLAIN,
+  PEER_ENCRYPTED,
+};
+
+struct PeerChange {
+  uint8_t device;
+  PeerSlot to;                     // PEER_NONE = remove
+};
+
+class PeerTable {
+public:
+  // slots: peers available to devices (the driver total minus any kept for
+  // broadcast); encryptedSlots: the driver's encrypted limit.
+  void begin(int devices, int slots, int encryptedSlots) {
+    _n = devices < PEER_TABLE_MAX ? devices : PEER_TABLE_MAX;
+    _slots = slots;
+    _encSlots = encryptedSlots < slots ? encryptedSlots : slots;
+    _clock = 0;
+    for (int i = 0; i < PEER_TABLE_MAX; i++) {
+      _keyed[i] = false;
+      _slot[i] = PEER_NONE;
+      _lastUse[i] = 0;
+    }
+  }
+
+  void setKeyed(int device, bool keyed) {
+    if (device >= 0 && device < _n) _keyed[device] = keyed;
+  }
+
+  // Brings the table in line with the keys and the selected device. Writes
+  // the changes to make, removals first so their slots are free for the
+  // additions, and returns how many. A device whose kind of slot changes
+  // appears twice (removed, then added). out needs room for 2 * devices.
+  int update(int selected, PeerChange *out) {
+    if (selected >= 0 && selected < _n) _lastUse[selected] = ++_clock;
+
+    PeerSlot want[PEER_TABLE_MAX];
+    for (int i = 0; i < _n; i++) want[i] = PEER_NONE;
+
+    // Encrypted slots: most recently selected keyed devices, selected first,
+    // leaving one slot for an unkeyed selected device.
+    bool plainSelected = selected >= 0 && selected < _n && !_keyed[selected];
+    int encLimit = plainSelected && _encSlots >= _slots ? _slots - 1 : _encSlots;
+    int enc = 0;
+    while (enc < encLimit) {
+      int best = -1;
+      for (int i = 0; i < _n; i++) {
+        if (!_keyed[i] || want[i] != PEER_NONE) continue;
+        if (best < 0 || rank(i, selected) > rank(best, selected)) best = i;
+      }
+      if (best < 0) break;
+      want[best] = PEER_ENCRYPTED;
+      enc++;
+    }
+
+    // Plain slots for the rest, selected first, then in device order.
+    int used = enc;
+    if (plainSelected && used < _slots) {
+      want[selected] = PEER_PLAIN;
+      used++;
+    }
+    for (int i = 0; i < _n && used < _slots; i++) {
+      if (_keyed[i] || want[i] != PEER_NONE) continue;
+      want[i] = PEER_PLAIN;
+      used++;
+    }
+
+    int m = 0;
+    for (int i = 0; i < _n; i++) {
+      if (_slot[i] != PEER_NONE && _slot[i] != want[i]) out[m++] = {(uint8_t)i, PEER_NONE};
+    }
+    for (int i = 0; i < _n; i++) {
+      if (want[i] != PEER_NONE && _slot[i] != want[i]) out[m++] = {(uint8_t)i, want[i]};
+      _slot[i] = want[i];
+    }
+    return m;
+  }
+
+  // The driver refused a change: the device holds no slot.
+  void failed(int device) {
+    if (device >= 0 && device < _n) _slot[device] = PEER_NONE;
+  }
+
+  PeerSlot slot(int device) const { return device >= 0 && device < _n ? _slot[device] : PEER_NONE; }
+  bool keyed(int device) const { return device >= 0 && device < _n && _keyed[device]; }
+  int count(PeerSlot s) const {
+    int c = 0;
+    for (int i = 0; i < _n; i++) c += _slot[i] == s;
+    return c;
+  }
+  int slots() const { return _slots; }
+  int encryptedSlots() const { return _encSlots; }
+
+private:
+  // Selected device first, then by last selection, then lower index.
+  uint32_t rank(int i, int selected) const {
+    if (i == selected) return UINT32_MAX;
+    return _lastUse[i];
+  }
+
+  int _n = 0;
+  int _slots = 0;
+  int _encSlots = 0;
+  uint32_t _clock = 0;
+  bool _keyed[PEER_TABLE_MAX];
+  PeerSlot _slot[PEER_TABLE_MAX];
+  uint32_t _lastUse[PEER_TABLE_MAX];
+};
+
+// ============================================
+// KEYS
+// ============================================
+
+// 32 hex digits (either case) -> 16 bytes. An all-zero key is refused: it
+// is what an erased or never-set key reads as.
+static inline bool parseKeyHex(const char *s, uint8_t key[PEER_KEY_LEN]) {
+  uint8_t any = 0;
+  for (int i = 0; i < 2 * PEER_KEY_LEN; i++) {
+    char c = s[i];
+    int v = c >= '0' && c <= '9' ? c - '0'
+          : c >= 'a' && c <= 'f' ? c - 'a' + 10
+          : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+    if (v < 0) return false;
+    if (i % 2 == 0) key[i / 2] = (uint8_t)(v << 4);
+    else key[i / 2] |= (uint8_t)v;
+  }
+  if (s[2 * PEER_KEY_LEN] != '\0' && s[2 * PEER_KEY_LEN] != ' ') return false;
+  for (int i = 0; i < PEER_KEY_LEN; i++) any |= key[i];
+  return any != 0;
+}
+
+#endif // PEER_TABLE_H
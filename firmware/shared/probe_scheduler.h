@@ -0,0 +1,138 @@
+#ifndef PROBE_SCHEDULER_H
+#define PROBE_SCHEDULER_H
+
+#include <stdint.h>
+
+// ============================================
+// BACKGROUND PROBE SCHEDULER
+// ============================================
+// Decides when and where to ping a non-selected device so its cached channel
+// and link state stay fresh. At most one probe is handed out per call (the
+// caller asks once per spare slot between drive commands) and each device is
+// probed at most once per period.
+//
+// A device on the radio's current channel is probed with a plain async send,
+// offered only when the slack before the next drive command covers one
+// frame's air time (retries included) plus a guard. One on another channel
+// needs a hop away and back; that is only offered when the slack covers the
+// recent worst hop plus the guard, and the caller must be back home within
+// the returned budget, so the drive stream is never knowingly delayed. After
+// PROBE_FAIL_LIMIT misses on its cached channel a device is hunted on
+// channels 1..13, one hop per attempt. Plain C++ so tools/probe_sim runs
+// the same code.
+
+#define PROBE_MAX_DEVICES   20     // ESP-NOW peer limit
+#define PROBE_FAIL_LIMIT    3      // misses on the cached channel before hunting
+#define PROBE_HOP_GUARD_US  1000   // kept free before the next drive command
+#define PROBE_HOP_INIT_US   4000   // assumed hop cost until one has been measured
+#define PROBE_TX_US         2000   // air time reserved for a same-channel probe
+
+struct ProbeDecision {
+  int      device;
+  uint8_t  channel;      // channel to probe on
+  bool     hop;          // channel differs from the radio's current one
+  uint32_t budgetUs;     // hop: must be back on the home channel within this
+};
+
+class ProbeScheduler {
+public:
+  void begin(uint32_t periodMs, uint32_t maxHopUs) {
+    _periodMs = periodMs;
+    _maxHopUs = maxHopUs;
+    _cursor = 0;
+    for (int i = 0; i < PROBE_MAX_DEVICES; i++) _peers[i] = Peer();
+    probes = hops = deferred = found = 0;
+    hopCostMaxUs = 0;
+    _hopEstUs = PROBE_HOP_INIT_US;
+  }
+
+  // slackUs: time until the next drive command is due. channels[i] is the
+  // cached channel of device i, 0 = unknown.
+  bool next(uint32_t nowMs, uint32_t slackUs, int selected, uint8_t radioCh,
+            const uint8_t *channels, int n, ProbeDecision &out) {
+    if (n > PROBE_MAX_DEVICES) n = PROBE_MAX_DEVICES;
+    bool txFits = slackUs >= PROBE_TX_US + PROBE_HOP_GUARD_US;
+    bool hopFits = slackUs >= _hopEstUs + PROBE_HOP_GUARD_US;
+
+    // Round-robin from the cursor so one unreachable device cannot starve the rest.
+    for (int k = 0; k < n; k++) {
+      int i = (_cursor + k) % n;
+      if (i == selected) continue;
+      Peer &p = _peers[i];
+      if (p.lastProbeMs != 0 && nowMs - p.lastProbeMs < _periodMs) continue;
+
+      if (p.huntCh == 0 && (channels[i] == 0 || p.fails >= PROBE_FAIL_LIMIT)) p.huntCh = 1;
+      uint8_t ch = p.huntCh ? p.huntCh : channels[i];
+      bool hop = ch != radioCh;
+      if (!(hop ? hopFits : txFits)) {
+        deferred++;
+        continue;
+      }
+
+      out.device = i;
+      out.channel = ch;
+      out.hop = hop;
+      uint32_t budget = slackUs > PROBE_HOP_GUARD_US ? slackUs - PROBE_HOP_GUARD_US : 0;
+      out.budgetUs = budget < _maxHopUs ? budget : _maxHopUs;
+      p.lastProbeMs = nowMs ? nowMs : 1;
+      _cursor = (i + 1) % n;
+      probes++;
+      if (hop) hops++;
+      return true;
+    }
+    return false;
+  }
+
+  // Report how a probe went. costUs is the time spent off the home channel
+  // for a hop (ignored otherwise).
+  void result(const ProbeDecision &d, bool ok, uint32_t costUs) {
+    if (d.device < 0 || d.device >= PROBE_MAX_DEVICES) return;
+    Peer &p = _peers[d.device];
+    if (d.hop) {
+      if (costUs > hopCostMaxUs) hopCostMaxUs = costUs;
+      // Follow a slow hop at once, relax only gradually after it.
+      uint32_t decayed = _hopEstUs - _hopEstUs / 16;
+      _hopEstUs = costUs > decayed ? costUs : decayed;
+      if (_hopEstUs > _maxHopUs) _hopEstUs = _maxHopUs;   // the budget aborts a slow hop anyway
+    }
+
+    if (ok) {
+      if (p.huntCh) found++;
+      p.fails = 0;
+      p.huntCh = 0;
+    } else if (p.huntCh) {
+      p.huntCh = p.huntCh >= 13 ? 1 : p.huntCh + 1;
+    } else if (p.fails < PROBE_FAIL_LIMIT) {
+      p.fails++;
+    }
+  }
+
+  // The selected device is probed by the drive stream itself; forget any
+  // hunt state so it starts clean when it becomes a background device again.
+  void reset(int device) {
+    if (device < 0 || device >= PROBE_MAX_DEVICES) return;
+    _peers[device].fails = 0;
+    _peers[device].huntCh = 0;
+  }
+
+  uint32_t probes = 0;         // probes handed out
+  uint32_t hops = 0;           // of which needed a channel hop
+  uint32_t deferred = 0;       // due probes passed over because the slack was too short
+  uint32_t found = 0;          // hunts that located a device on a new channel
+  uint32_t hopCostMaxUs = 0;   // worst measured time off the home channel (stat)
+
+private:
+  struct Peer {
+    uint32_t lastProbeMs;
+    uint8_t  fails;
+    uint8_t  huntCh;           // next channel to try while hunting, 0 = not hunting
+  };
+
+  Peer _peers[PROBE_MAX_DEVICES] = {};
+  uint32_t _periodMs = 1000;
+  uint32_t _maxHopUs = 6000;
+  uint32_t _hopEstUs = PROBE_HOP_INIT_US;   // decaying max of measured hop cost
+  int _cursor = 0;
+};
+
+#endif // PROBE_SCHEDULER_H
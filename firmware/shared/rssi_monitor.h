@@ -0,0 +1,220 @@
+#ifndef RSSI_MONITOR_H
+#define RSSI_MONITOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+
+// ============================================
+// PROMISCUOUS RSSI MONITOR
+// ============================================
+// Signal strength of frames heard from known devices. The radio's
+// promiscuous callback copies the rx_ctrl fields and the first bytes of the
+// frame into a SniffRecord and pushes it onto a SniffRing. That is all it
+// does. The loop pops the records, parses the 802.11 header
+// (parseSniffHeader), matches the sender against the device list and adds
+// the sample to that device's RssiStats.
+//
+// Plain C++ so the parser, the ring and the statistics run in
+// tools/rssi_check against captured frame headers.
+
+#define SNIFF_HDR_BYTES   40     // 24-byte MAC header + ESP-NOW action/vendor header
+#define RSSI_WINDOW       32     // samples per device in the rolling statistics
+
+// What the callback keeps of one received frame.
+struct SniffRecord {
+  uint32_t tUs;
+  int8_t rssi;                  // dBm
+  int8_t noiseFloor;            // dBm
+  uint8_t rate;                 // legacy (11b/g) rate code, see sniffRateKbps()
+  uint8_t sigMode;              // 0 = 11b/g, 1 = 11n
+  uint8_t mcs;                  // 11n only
+  uint8_t channel;
+  uint16_t len;                 // bytes valid in hdr
+  uint8_t hdr[SNIFF_HDR_BYTES];
+};
+
+// ============================================
+// CALLBACK -> LOOP HANDOFF
+// ============================================
+// Single producer (WiFi task), single consumer (loop): two atomic indices,
+// no lock, no allocation. A full ring drops the new record and counts it,
+// so the callback never waits.
+
+template <size_t N>
+class SniffRing {
+  static_assert((N & (N - 1)) == 0, "SniffRing size must be a power of two");
+
+public:
+  bool push(const SniffRecord &r) {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    if (head - _tail.load(std::memory_order_acquire) >= N) {
+      _dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    _slots[head & (N - 1)] = r;
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(SniffRecord &r) {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire)) return false;
+    r = _slots[tail & (N - 1)];
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+  SniffRecord _slots[N];
+  std::atomic<uint32_t> _head{0};
+  std::atomic<uint32_t> _tail{0};
+  std::atomic<uint32_t> _dropped{0};
+};
+
+// ============================================
+// FRAME HEADER PARSING
+// ============================================
+
+enum SniffKind : uint8_t {
+  SNIFF_OTHER,          // management or data frame with a transmitter address
+  SNIFF_ESPNOW,         // Espressif vendor action frame (ESP-NOW)
+};
+
+struct SniffedFrame {
+  uint8_t src[6];       // transmitter (addr2)
+  SniffKind kind;
+  uint16_t seqNum;      // 802.11 sequence number, 0..4095
+  bool retry;           // MAC-layer retransmission
+};
+
+// Cheap pre-filter for the callback: management and data frames only, and
+// no beacons, which make up most of what a channel carries and never come
+// from a controlled device.
+static inline bool sniffWanted(const uint8_t *frame, uint16_t len) {
+  if (len < 24) return false;
+  uint8_t type = (frame[0] >> 2) & 3;
+  uint8_t subtype = frame[0] >> 4;
+  if (type == 0) return subtype != 8;
+  return type == 2;
+}
+
+// Transmitter, kind and sequence number of a captured frame. False for
+// control frames (no transmitter address) and frames too short to carry
+// a MAC header.
+static inline bool parseSniffHeader(const uint8_t *frame, uint16_t len, SniffedFrame &out) {
+  static const uint8_t espressif[3] = {0x18, 0xFE, 0x34};
+  if (len < 24) return false;
+  uint8_t type = (frame[0] >> 2) & 3;
+  uint8_t subtype = frame[0] >> 4;
+  if (type != 0 && type != 2) return false;
+  memcpy(out.src, frame + 10, 6);
+  out.retry = (frame[1] & 0x08) != 0;
+  out.seqNum = (uint16_t)(frame[22] | frame[23] << 8) >> 4;
+  // Action frame, vendor-specific category, Espressif OUI, 4 random bytes,
+  // then a vendor element with the Espressif OUI and type 4 (ESP-NOW).
+  out.kind = SNIFF_OTHER;
+  if (type == 0 && subtype == 13 && len >= 38 && frame[24] == 127 &&
+      memcmp(frame + 25, espressif, 3) == 0 && frame[32] == 0xDD &&
+      memcmp(frame + 34, espressif, 3) == 0 && frame[37] == 4) {
+    out.kind = SNIFF_ESPNOW;
+  }
+  return true;
+}
+
+// PHY rate of a received frame in kbps, 0 if unknown. Legacy codes as in
+// wifi_phy_rate_t; 11n MCS 0..7 at 20 MHz, long guard interval.
+static inline uint32_t sniffRateKbps(uint8_t sigMode, uint8_t rate, uint8_t mcs) {
+  static const uint16_t legacy[16] = {
+    1000, 2000, 5500, 11000, 0, 2000, 5500, 11000,
+    48000, 24000, 12000, 6000, 54000, 36000, 18000, 9000,
+  };
+  static const uint16_t ht[8] = {6500, 13000, 19500, 26000, 39000, 52000, 58500, 65000};
+  if (sigMode == 0) return rate < 16 ? legacy[rate] : 0;
+  if (sigMode == 1) return mcs < 8 ? ht[mcs] : 0;
+  return 0;
+}
+
+// ============================================
+// ROLLING STATISTICS
+// ============================================
+
+// What a device's recent samples suggest about a bad link.
+enum LinkDiag : uint8_t {
+  DIAG_NO_DATA,         // nothing heard recently
+  DIAG_OK,
+  DIAG_WEAK,            // low signal over a quiet floor: range or obstruction
+  DIAG_NOISY,           // raised noise floor: interference
+};
+
+// Last RSSI_WINDOW samples of one device. add() is O(1); min/max scan the
+// window.
+class RssiStats {
+public:
+  void add(int8_t rssi, int8_t noise, uint32_t rateKbps, uint32_t tUs) {
+    if (_n == RSSI_WINDOW) {
+      _rssiSum -= _rssi[_next];
+      _noiseSum -= _noise[_next];
+    } else {
+      _n++;
+    }
+    _rssi[_next] = rssi;
+    _noise[_next] = noise;
+    _rssiSum += rssi;
+    _noiseSum += noise;
+    _next = (_next + 1) % RSSI_WINDOW;
+    last = rssi;
+    lastRateKbps = rateKbps;
+    lastUs = tUs;
+    total++;
+  }
+
+  void reset() { *this = RssiStats(); }
+
+  int samples() const { return _n; }
+  // Window means, rounded to the nearest dB.
+  int mean() const { return _n ? divRound(_rssiSum, _n) : 0; }
+  int noiseMean() const { return _n ? divRound(_noiseSum, _n) : 0; }
+  int snr() const { return mean() - noiseMean(); }
+  int min() const {
+    int m = 127;
+    for (int i = 0; i < _n; i++) if (_rssi[i] < m) m = _rssi[i];
+    return _n ? m : 0;
+  }
+  int max() const {
+    int m = -128;
+    for (int i = 0; i < _n; i++) if (_rssi[i] > m) m = _rssi[i];
+    return _n ? m : 0;
+  }
+
+  // A raised noise floor points at interference whatever the signal;
+  // a weak signal over a normal floor points at range.
+  LinkDiag diagnose(int weakDbm, int noisyFloorDbm) const {
+    if (_n == 0) return DIAG_NO_DATA;
+    if (noiseMean() > noisyFloorDbm) return DIAG_NOISY;
+    if (mean() < weakDbm) return DIAG_WEAK;
+    return DIAG_OK;
+  }
+
+  int8_t last = 0;
+  uint32_t lastRateKbps = 0;
+  uint32_t lastUs = 0;
+  uint32_t total = 0;          // samples since reset
+
+private:
+  static int divRound(int32_t sum, int n) {
+    return (int)(sum >= 0 ? (sum + n / 2) / n : -((-sum + n / 2) / n));
+  }
+
+  int8_t _rssi[RSSI_WINDOW] = {};
+  int8_t _noise[RSSI_WINDOW] = {};
+  int32_t _rssiSum = 0;
+  int32_t _noiseSum = 0;
+  uint8_t _n = 0;
+  uint8_t _next = 0;
+};
+
+#endif // RSSI_MONITOR_H
@@ -0,0 +1,236 @@
+#ifndef TELEMETRY_FRAME_H
+#define TELEMETRY_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// ============================================
+// BINARY TELEMETRY FRAMING
+// ============================================
+// Shared by the controller firmware (encoder) and the host tools in tools/
+// (decoder). Plain C++ with no Arduino dependency so both sides build it.
+//
+// On the wire every frame is COBS( type | payload | crc16 ) followed by a
+// 0x00 delimiter. COBS guarantees the body contains no zero byte, so a reader
+// can join the stream at any point and resync on the next delimiter. Human
+// text printed while streaming simply fails the CRC and is dropped.
+
+#define TLM_MAX_PAYLOAD   32
+#define TLM_MAX_RAW       (1 + TLM_MAX_PAYLOAD + 2)         // type + payload + crc
+#define TLM_MAX_ENCODED   (TLM_MAX_RAW + TLM_MAX_RAW / 254 + 2) // + COBS overhead + 0x00
+
+enum TelemetryType : uint8_t {
+  TLM_SAMPLE  = 1,   // raw stick sample, once per control tick
+  TLM_COMMAND = 2,   // ControlCommand handed to esp_now_send()
+  TLM_ACK     = 3,   // OnDataSent() result
+  TLM_TIMING  = 4,   // loop timing for the tick
+  TLM_EVENTS  = 5,   // up to TLM_EVENTS_PER_FRAME FlightEvent records (DUMP)
+  TLM_TRACE   = 6,   // up to TLM_EVENTS_PER_FRAME trace records (TRACE DUMP)
+};
+
+// All timestamps are micros() on the controller (wraps every ~71 min).
+struct __attribute__((packed)) TlmSample {
+  uint32_t tUs;
+  uint16_t lx, ly, rx, ry;   // raw ADC
+  uint8_t  buttons;          // bit0=leftBtn, bit1=rightBtn, bit2=aux
+};
+
+struct __attribute__((packed)) TlmCommand {
+  uint32_t tUs;
+  uint8_t  device;           // index into the controller's device list
+  uint8_t  seq;
+  int8_t   x, y, rot;
+  uint8_t  speed;
+  uint8_t  buttons;
+};
+
+struct __attribute__((packed)) TlmAck {
+  uint32_t tUs;
+  uint8_t  device;
+  uint8_t  seq;              // seq of the frame this result belongs to
+  uint8_t  ok;               // 1 = MAC ACK received
+};
+
+struct __attribute__((packed)) TlmTiming {
+  uint32_t tUs;
+  uint16_t loopUs;           // period of the previous loop() pass
+  uint16_t sendUs;           // time spent inside esp_now_send()
+};
+
+// Flight recorder events, as kept in the controller's RAM ring and streamed
+// by the DUMP command.
+enum FlightEventType : uint8_t {
+  FE_CMD_SENT    = 1,   // a = device, b = seq
+  FE_ACK         = 2,   // a = device, b = seq
+  FE_NACK        = 3,   // a = device, b = seq
+  FE_CHANNEL     = 4,   // a = channel, b = device
+  FE_REACQ_START = 5,   // a = device
+  FE_REACQ_END   = 6,   // a = device, b = channel found (0 = none)
+  FE_MODE        = 7,   // a = new controller mode
+  FE_SELECT      = 8,   // a = device, b = 0 no link, 1 found by probe, 2 same channel (no probe)
+  FE_PROBE       = 9,   // a = device, b = channel | ok << 8 | hop << 9 (background probe)
+};
+
+struct __attribute__((packed)) FlightEvent {
+  uint32_t tUs;
+  uint8_t  type;
+  uint8_t  a;
+  uint16_t b;
+};
+
+#define TLM_EVENTS_PER_FRAME (TLM_MAX_PAYLOAD / sizeof(FlightEvent))
+
+// Trace records (TRACE_* macros, TRACE DUMP) use the FlightEvent layout with
+// type = TracePoint, a = TracePhase, b = argument. tools/trace_export turns
+// them into Chrome trace JSON.
+enum TracePhase : uint8_t {
+  TRACE_PH_BEGIN   = 0,
+  TRACE_PH_END     = 1,
+  TRACE_PH_INSTANT = 2,
+};
+
+enum TracePoint : uint8_t {
+  // loop task
+  TP_LOOP        = 1,   // one loop() pass
+  TP_CLI         = 2,   // handleSerialCommands()
+  TP_INPUT       = 3,   // readJoystickInputs(): ADC + button drain
+  TP_BUTTON      = 4,   // instant, b = button | down << 8
+  TP_MENU        = 5,   // updateDeviceSelection()
+  TP_CMD         = 6,   // sendControlCommand()
+  TP_ESPNOW_SEND = 7,   // esp_now_send() call, b = seq
+  TP_HELD        = 8,   // instant, frame held back, b = seq
+  TP_CHANNEL     = 9,   // channel switch + settle, b = channel
+  TP_PROBE       = 10,  // background probe, b = device | hop << 8
+  TP_DISPLAY     = 11,  // OLED render into the frame buffer
+  TP_I2C_FLUSH   = 12,  // display.display(): frame buffer over I2C
+  // WiFi task
+  TP_SEND_CB     = 32,  // instant, OnDataSent, b = seq | ok << 8
+  TP_ECHO        = 33,  // instant, LinkEcho received, b = seq
+};
+
+// ============================================
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+// ============================================
+static inline uint16_t tlmCrc16(const uint8_t *data, size_t len) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (int b = 0; b < 8; b++) {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+// ============================================
+// COBS
+// ============================================
+// Encode len bytes into out (no trailing delimiter). out must hold
+// len + len/254 + 1 bytes. Returns the encoded length.
+static inline size_t cobsEncode(const uint8_t *in, size_t len, uint8_t *out) {
+  size_t codeIdx = 0;
+  size_t o = 1;
+  uint8_t code = 1;
+  for (size_t i = 0; i < len; i++) {
+    if (in[i] == 0) {
+      out[codeIdx] = code;
+      codeIdx = o++;
+      code = 1;
+    } else {
+      out[o++] = in[i];
+      if (++code == 0xFF) {
+        out[codeIdx] = code;
+        codeIdx = o++;
+        code = 1;
+      }
+    }
+  }
+  out[codeIdx] = code;
+  return o;
+}
+
+// Decode len COBS bytes (delimiter already stripped) into out, which holds
+// outCap bytes. Returns the decoded length, or 0 if the input is malformed.
+static inline size_t cobsDecode(const uint8_t *in, size_t len, uint8_t *out, size_t outCap) {
+  size_t i = 0, o = 0;
+  while (i < len) {
+    uint8_t code = in[i++];
+    if (code == 0 || i + code - 1 > len || o + code > outCap) return 0;
+    memcpy(out + o, in + i, code - 1);
+    o += code - 1;
+    i += code - 1;
+    if (code != 0xFF && i < len) out[o++] = 0;
+  }
+  return o;
+}
+
+// Build a complete wire frame (including the 0x00 delimiter) into out, which
+// must hold TLM_MAX_ENCODED bytes. Returns the number of bytes to transmit.
+static inline size_t tlmEncodeFrame(uint8_t type, const void *payload, size_t len, uint8_t *out) {
+  if (len > TLM_MAX_PAYLOAD) return 0;
+  uint8_t raw[TLM_MAX_RAW];
+  raw[0] = type;
+  memcpy(raw + 1, payload, len);
+  uint16_t crc = tlmCrc16(raw, len + 1);
+  raw[len + 1] = (uint8_t)(crc >> 8);
+  raw[len + 2] = (uint8_t)(crc & 0xFF);
+  size_t n = cobsEncode(raw, len + 3, out);
+  out[n++] = 0;
+  return n;
+}
+
+// ============================================
+// STREAM DECODER
+// ============================================
+// Feed raw bytes one at a time; push() returns true when a frame with a valid
+// CRC has been completed, after which type()/payload()/length() describe it.
+// Allocation-free; oversized or corrupt frames are counted and skipped.
+class TelemetryDecoder {
+public:
+  bool push(uint8_t byte) {
+    if (byte != 0) {
+      if (_n < sizeof(_enc)) _enc[_n++] = byte;
+      else _overflow = true;
+      return false;
+    }
+    // Delimiter: try to decode what we have collected.
+    size_t n = _n;
+    bool overflow = _overflow;
+    _n = 0;
+    _overflow = false;
+    if (n == 0) return false;          // back-to-back delimiters
+    if (overflow) { badFrames++; return false; }
+    size_t raw = cobsDecode(_enc, n, _raw, sizeof(_raw));
+    if (raw < 3) { badFrames++; return false; }
+    uint16_t crc = ((uint16_t)_raw[raw - 2] << 8) | _raw[raw - 1];
+    if (tlmCrc16(_raw, raw - 2) != crc) { crcErrors++; return false; }
+    _len = raw - 3;
+    frames++;
+    return true;
+  }
+
+  uint8_t type() const { return _raw[0]; }
+  const uint8_t *payload() const { return _raw + 1; }
+  size_t length() const { return _len; }
+
+  // Copy the payload into a typed record if the size matches.
+  template <typename T> bool as(T &out) const {
+    if (_len != sizeof(T)) return false;
+    memcpy(&out, _raw + 1, sizeof(T));
+    return true;
+  }
+
+  uint32_t frames = 0;
+  uint32_t crcErrors = 0;
+  uint32_t badFrames = 0;
+
+private:
+  uint8_t _enc[TLM_MAX_ENCODED];
+  uint8_t _raw[TLM_MAX_ENCODED];
+  size_t _n = 0;
+  size_t _len = 0;
+  bool _overflow = false;
+};
+
+#endif // TELEMETRY_FRAME_H
@@ -0,0 +1,123 @@
+#ifndef TX_TRACKER_H
+#define TX_TRACKER_H
+
+#include <stdint.h>
+#include <atomic>
+
+// ============================================
+// IN-FLIGHT TRACKER
+// ============================================
+// Pairs each frame handed to esp_now_send() with its send callback. ESP-NOW
+// reports frames in the order they were queued, so the oldest outstanding
+// entry is always the one a callback belongs to; that gives the seq and the
+// send -> callback time of every drive frame without guessing.
+//
+// The sender asks hasRoom() before queueing: with at most maxInFlight frames
+// outstanding, a new command never waits behind one the MAC layer is still
+// retrying. The caller holds the freshest command until a slot frees up and
+// counts the ones it replaced (superseded).
+//
+// Lock-free for one sending task and one callback context: the sender only
+// writes _sent, the callback only writes _done. An entry whose callback is
+// overdue stops counting towards the limit (timeouts) but stays in the ring,
+// so a late callback still pops the right one. Plain C++ so the host
+// simulator runs the same code.
+
+#define TX_RING_SIZE        16    // power of two
+#define TX_MAX_IN_FLIGHT_CAP 4
+
+struct TxTrackerStats {
+  uint32_t sent;         // frames accepted by esp_now_send
+  uint32_t acked;        // callbacks with success
+  uint32_t failed;       // callbacks with failure (retries exhausted)
+  uint32_t superseded;   // held commands replaced by a fresher one
+  uint32_t queueFull;    // esp_now_send returned ESP_ERR_ESPNOW_NO_MEM
+  uint32_t sendErrors;   // any other esp_now_send error
+  uint32_t timeouts;     // callbacks overdue when the slot was needed
+  uint32_t depthAtSend[TX_MAX_IN_FLIGHT_CAP];   // frames already out when sending
+  uint8_t maxDepth;
+};
+
+class TxTracker {
+public:
+  void begin(uint8_t maxInFlight, uint32_t timeoutUs) {
+    _max = maxInFlight < 1 ? 1 : maxInFlight > TX_MAX_IN_FLIGHT_CAP ? TX_MAX_IN_FLIGHT_CAP : maxInFlight;
+    _timeoutUs = timeoutUs;
+    _sent.store(0);
+    _done.store(0);
+    _stats = TxTrackerStats();
+  }
+
+  // Outstanding frames whose callback is not overdue (sender side).
+  uint8_t depth(uint32_t nowUs) {
+    uint32_t done = _done.load(std::memory_order_acquire);
+    uint32_t sent = _sent.load(std::memory_order_relaxed);
+    uint8_t n = 0;
+    for (uint32_t i = done; i != sent; i++) {
+      if (nowUs - _ring[i % TX_RING_SIZE].tUs < _timeoutUs) n++;
+      else if (!_ring[i % TX_RING_SIZE].expired) {
+        _ring[i % TX_RING_SIZE].expired = true;
+        _stats.timeouts++;
+      }
+    }
+    return n;
+  }
+
+  bool hasRoom(uint32_t nowUs) {
+    uint32_t outstanding = _sent.load(std::memory_order_relaxed) - _done.load(std::memory_order_acquire);
+    return outstanding < TX_RING_SIZE && depth(nowUs) < _max;
+  }
+
+  // esp_now_send accepted the frame (sender side, after hasRoom()).
+  void sent(uint8_t seq, uint32_t nowUs) {
+    uint8_t d = depth(nowUs);
+    _stats.depthAtSend[d < TX_MAX_IN_FLIGHT_CAP ? d : TX_MAX_IN_FLIGHT_CAP - 1]++;
+    if (d + 1 > _stats.maxDepth) _stats.maxDepth = d + 1;
+    _stats.sent++;
+    uint32_t s = _sent.load(std::memory_order_relaxed);
+    _ring[s % TX_RING_SIZE] = {nowUs, seq, false};
+    _sent.store(s + 1, std::memory_order_release);
+  }
+
+  // Send callback for a tracked frame (callback side). False if nothing was
+  // outstanding, i.e. the callback belongs to an untracked frame.
+  bool completed(bool ok, uint32_t nowUs, uint8_t &seq, uint32_t &latencyUs) {
+    uint32_t d = _done.load(std::memory_order_relaxed);
+    if (d == _sent.load(std::memory_order_acquire)) return false;
+    const Entry &e = _ring[d % TX_RING_SIZE];
+    seq = e.seq;
+    latencyUs = nowUs - e.tUs;
+    if (ok) _stats.acked++;
+    else _stats.failed++;
+    _done.store(d + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool idle() const {
+    return _sent.load(std::memory_order_relaxed) == _done.load(std::memory_order_acquire);
+  }
+
+  void superseded() { _stats.superseded++; }
+  void queueFull() { _stats.queueFull++; }
+  void sendError() { _stats.sendErrors++; }
+
+  uint8_t maxInFlight() const { return _max; }
+  const TxTrackerStats &stats() const { return _stats; }
+  void resetStats() { _stats = TxTrackerStats(); }
+
+private:
+  struct Entry {
+    uint32_t tUs;
+    uint8_t seq;
+    bool expired;      // already counted as a timeout
+  };
+
+  uint8_t _max = 1;
+  uint32_t _timeoutUs = 100000;
+  Entry _ring[TX_RING_SIZE] = {};
+  std::atomic<uint32_t> _sent{0};
+  std::atomic<uint32_t> _done{0};
+  TxTrackerStats _stats = {};
+};
+
+#endif // TX_TRACKER_H
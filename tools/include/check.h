@@ -0,0 +1,26 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+// ============================================
+// HOST CHECK HELPERS
+// ============================================
+// Shared by the *_check tools and the simulators that assert their results.
+// CHECK() reports the failing line and keeps going, so one run lists every
+// broken check; checkSummary() prints the closing "ok" / "FAILED" line and
+// returns the exit status (ctest only looks at that). Each tool is a single
+// translation unit, so the counter lives here.
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { printf("  FAIL line %d: %s\n", __LINE__, #cond); failures++; } \
+  } while (0)
+
+static inline int checkSummary() {
+  printf("\n%s (%d failure%s)\n", failures ? "FAILED" : "ok", failures, failures == 1 ? "" : "s");
+  return failures ? 1 : 0;
+}
+
+#endif // CHECK_H
@@ -0,0 +1,14 @@
+#ifndef SERIAL_PORT_H
+#define SERIAL_PORT_H
+
+// ============================================
+// BYTE SOURCE: TTY OR RECORDED FILE
+// ============================================
+// Opens either a serial device (configured raw 8N1 at the given baud) or a
+// plain file holding a captured byte stream. Returns an fd, or -1 with errno
+// set. isTty reports which one it was so callers can pick live vs. batch
+// behaviour.
+
+int openByteSource(const char *path, int baud, bool &isTty);
+
+#endif // SERIAL_PORT_H
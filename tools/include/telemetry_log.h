@@ -0,0 +1,127 @@
+#ifndef TELEMETRY_LOG_H
+#define TELEMETRY_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// ============================================
+// ON-DISK TELEMETRY LOG
+// ============================================
+// Append-only file of fixed 32-byte records behind a 64-byte header, written
+// and read through mmap so multi-hour captures are never loaded into RAM. A
+// sidecar "<log>.idx" holds one summary per block of LOG_BLOCK_RECORDS
+// records (time span, device mask, ACK failures) so range and per-device
+// queries can skip whole blocks. The idx file only ever contains complete
+// blocks; readers scan the partial tail block directly.
+
+#define LOG_MAGIC          0x474F4C544E505345ULL   // "ESPNTLOG"
+#define LOG_VERSION        1
+#define LOG_BLOCK_RECORDS  4096
+#define LOG_GROW_BYTES     (4u << 20)               // mapping grows in 4 MiB steps
+
+struct __attribute__((packed)) LogHeader {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t recordSize;
+  uint64_t count;          // committed records; updated after each append
+  uint64_t firstTUs;       // tUs of record 0
+  uint8_t  reserved[32];
+};
+
+// tUs is the recorder's monotonic timeline: wall-clock at session start plus
+// the unwrapped controller micros(), clamped so it never goes backwards
+// across sessions appended to the same log.
+struct __attribute__((packed)) LogRecord {
+  uint64_t tUs;
+  uint32_t devUs;          // raw controller micros()
+  uint8_t  type;           // TelemetryType
+  uint8_t  device;
+  uint8_t  seq;
+  uint8_t  ok;             // ACK result (TLM_ACK only)
+  uint8_t  buttons;
+  uint8_t  reserved[3];
+  uint32_t latencyUs;      // TLM_ACK: send -> callback, 0 if unmatched
+  union {
+    struct __attribute__((packed)) {
+      int8_t x, y, rot;
+      uint8_t speed;
+    } cmd;                 // TLM_COMMAND
+    uint16_t v[4];         // TLM_SAMPLE: lx,ly,rx,ry  TLM_TIMING: loopUs,sendUs
+  };
+};
+
+struct __attribute__((packed)) LogIndexEntry {
+  uint64_t firstTUs;
+  uint64_t lastTUs;
+  uint32_t deviceMask;     // bit n set if device n appears in the block
+  uint32_t ackFails;
+};
+
+static_assert(sizeof(LogHeader) == 64, "LogHeader layout");
+static_assert(sizeof(LogRecord) == 32, "LogRecord layout");
+static_assert(sizeof(LogIndexEntry) == 24, "LogIndexEntry layout");
+
+// ============================================
+// WRITER
+// ============================================
+class LogWriter {
+public:
+  ~LogWriter() { close(); }
+
+  // Create the log, or reopen an existing one for appending.
+  bool open(const char *path);
+  bool append(const LogRecord &rec);
+  void close();
+
+  uint64_t count() const { return _hdr ? _hdr->count : 0; }
+  uint64_t lastTUs() const { return _lastTUs; }
+
+private:
+  bool remap(size_t bytes);
+  void foldIntoBlock(const LogRecord &rec);
+
+  int _fd = -1;
+  int _idxFd = -1;
+  uint8_t *_map = nullptr;
+  size_t _mapLen = 0;
+  LogHeader *_hdr = nullptr;
+  LogIndexEntry _block = {};
+  uint64_t _lastTUs = 0;
+};
+
+// ============================================
+// READER
+// ============================================
+class LogReader {
+public:
+  ~LogReader() { close(); }
+
+  bool open(const char *path);
+  void close();
+
+  uint64_t count() const { return _count; }
+  uint64_t firstTUs() const { return _count ? _recs[0].tUs : 0; }
+  uint64_t lastTUs() const { return _count ? _recs[_count - 1].tUs : 0; }
+  const LogRecord &at(uint64_t i) const { return _recs[i]; }
+
+  // Block summaries, covering every record (tail block included).
+  size_t blocks() const { return _index.size(); }
+  const LogIndexEntry &block(size_t b) const { return _index[b]; }
+
+  // First record with tUs >= t (count() if none).
+  uint64_t lowerBound(uint64_t t) const;
+
+private:
+  int _fd = -1;
+  uint8_t *_map = nullptr;
+  size_t _mapLen = 0;
+  const LogRecord *_recs = nullptr;
+  uint64_t _count = 0;
+  std::vector<LogIndexEntry> _index;
+};
+
+// Summary of n consecutive records, as stored in the idx file.
+LogIndexEntry summarizeRecords(const LogRecord *recs, uint64_t n);
+
+#endif // TELEMETRY_LOG_H
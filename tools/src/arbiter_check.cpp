@@ -0,0 +1,304 @@
+// arbiter_check - interleaved command streams from several controllers
+// through the receiver's CommandArbiter, checked against who must own the
+// robot and when.
+//
+//   arbiter_check             run every scenario, exit 1 on a mismatch
+//   arbiter_check -v          also print the owner changes of passing ones
+//
+// Each simulated controller sends at its own period (down to 1 ms, well
+// above the real 20 ms), optionally as RedundantCommands (every seq offered
+// twice), between a start and stop time. Frames from all controllers are
+// merged in time order, as the receiver's RX queue sees them. A controller
+// may also send background probes for the whole run, numbered from their own
+// counter; they start half the seq space away from the drive seqs, the worst
+// case for a tracker that mixes the two. Ends with the host cost of one
+// offer().
+
+#include "command_arbiter.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define LOCK_US 500000
+
+struct Controller {
+  uint8_t id;              // last MAC byte, names the controller in output
+  uint32_t periodUs;
+  uint32_t startUs;
+  uint32_t stopUs;         // exclusive
+  bool redundant;
+  uint8_t priority;        // rule table entry; 255 = not listed
+  uint32_t probePeriodUs = 0;   // background probes from time 0; 0 = none
+};
+
+struct Expect {
+  uint32_t tUs;            // owner checked just before this time
+  int owner;               // controller index, -1 = none
+};
+
+struct Scenario {
+  const char *name;
+  ArbPolicy policy;
+  uint8_t defaultPriority;
+  uint32_t t0;             // clock offset (wrap tests)
+  uint32_t durationUs;
+  std::vector<Controller> ctls;
+  std::vector<Expect> expects;
+  std::vector<uint32_t> minDriven;   // per controller, commands applied at least
+  std::vector<uint32_t> maxDriven;   // per controller, at most
+};
+
+static void macOf(const Controller &c, uint8_t *mac) {
+  static const uint8_t base[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x00};
+  memcpy(mac, base, 6);
+  mac[5] = c.id;
+}
+
+// ============================================
+// SIMULATION
+// ============================================
+
+static bool run(const Scenario &sc, bool verbose) {
+  std::vector<ArbRule> rules;
+  for (const Controller &c : sc.ctls) {
+    if (c.priority == 255) continue;
+    ArbRule r;
+    macOf(c, r.mac);
+    r.priority = c.priority;
+    rules.push_back(r);
+  }
+  CommandArbiter arb;
+  arb.begin({sc.policy, LOCK_US, sc.defaultPriority, rules.data(), (uint8_t)rules.size()});
+
+  size_t n = sc.ctls.size();
+  std::vector<uint32_t> next(n), driven(n, 0), duplicates(n, 0);
+  std::vector<uint8_t> seq(n, 0), probeSeq(n, 0x80);
+  std::vector<uint32_t> sent(n, 0), nextProbe(n, UINT32_MAX);
+  for (size_t i = 0; i < n; i++) {
+    next[i] = sc.ctls[i].startUs;
+    if (sc.ctls[i].probePeriodUs) nextProbe[i] = 0;
+  }
+  std::vector<std::string> log;
+  size_t expectIdx = 0;
+  bool ok = true;
+  char line[160];
+
+  auto ctlOf = [&](int src) -> int {
+    if (src < 0) return -1;
+    for (size_t i = 0; i < n; i++) {
+      uint8_t mac[6];
+      macOf(sc.ctls[i], mac);
+      if (memcmp(mac, arb.source(src).mac, 6) == 0) return (int)i;
+    }
+    return -2;
+  };
+  auto check = [&](uint32_t t) {
+    while (expectIdx < sc.expects.size() && sc.expects[expectIdx].tUs <= t) {
+      const Expect &e = sc.expects[expectIdx++];
+      int got = ctlOf(arb.owner());
+      if (got != e.owner) {
+        snprintf(line, sizeof(line), "  FAIL at %.3f s: owner %d, expected %d", e.tUs / 1e6, got, e.owner);
+        log.push_back(line);
+        ok = false;
+      }
+    }
+  };
+
+  for (;;) {
+    int pick = -1;
+    bool probe = false;
+    for (size_t i = 0; i < n; i++) {
+      if (nextProbe[i] < sc.durationUs && (pick < 0 || nextProbe[i] < (probe ? nextProbe[pick] : next[pick]))) {
+        pick = (int)i;
+        probe = true;
+      }
+      if (next[i] >= sc.ctls[i].stopUs || next[i] >= sc.durationUs) continue;
+      if (pick < 0 || next[i] < (probe ? nextProbe[pick] : next[pick])) {
+        pick = (int)i;
+        probe = false;
+      }
+    }
+    uint32_t t = pick < 0 ? sc.durationUs : probe ? nextProbe[pick] : next[pick];
+    check(t);
+    // The receiver's control tick releases a silent owner.
+    arb.expire(sc.t0 + t);
+    if (pick < 0) break;
+
+    const Controller &c = sc.ctls[pick];
+    uint8_t mac[6];
+    macOf(c, mac);
+    if (probe) {
+      if (arb.offer(mac, probeSeq[pick]++, sc.t0 + t, true) != ARB_PROBE) {
+        snprintf(line, sizeof(line), "  FAIL at %.3f s: %d's probe was arbitrated", t / 1e6, pick);
+        log.push_back(line);
+        ok = false;
+      }
+      nextProbe[pick] += c.probePeriodUs;
+      continue;
+    }
+    int copies = c.redundant && sent[pick] ? 2 : 1;   // no "prev" before the first
+    for (int k = copies - 1; k >= 0; k--) {
+      // Redundant frames carry the previous seq first.
+      ArbVerdict v = arb.offer(mac, (uint8_t)(seq[pick] - k), sc.t0 + t);
+      if (v == ARB_DRIVE) {
+        driven[pick]++;
+        if (arb.owner() < 0 || memcmp(arb.source(arb.owner()).mac, mac, 6) != 0) {
+          snprintf(line, sizeof(line), "  FAIL at %.3f s: %d drove without owning", t / 1e6, pick);
+          log.push_back(line);
+          ok = false;
+        }
+      }
+      if (v == ARB_DUPLICATE) duplicates[pick]++;
+    }
+    seq[pick]++;
+    sent[pick]++;
+    next[pick] += c.periodUs;
+
+    ArbChange ch;
+    static const char *const reasons[] = {"claim", "takeover", "expired"};
+    while (arb.takeChange(ch)) {
+      snprintf(line, sizeof(line), "  %8.3f s  %2d -> %2d  %s", (uint32_t)(ch.tUs - sc.t0) / 1e6,
+               ctlOf(ch.from), ctlOf(ch.to), reasons[ch.reason]);
+      log.push_back(line);
+    }
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    if (i < sc.minDriven.size() && driven[i] < sc.minDriven[i]) {
+      snprintf(line, sizeof(line), "  FAIL: %zu drove %u, expected at least %u", i, driven[i], sc.minDriven[i]);
+      log.push_back(line);
+      ok = false;
+    }
+    if (i < sc.maxDriven.size() && driven[i] > sc.maxDriven[i]) {
+      snprintf(line, sizeof(line), "  FAIL: %zu drove %u, expected at most %u", i, driven[i], sc.maxDriven[i]);
+      log.push_back(line);
+      ok = false;
+    }
+  }
+
+  printf("%-4s %s\n", ok ? "ok" : "FAIL", sc.name);
+  if (!ok || verbose) {
+    for (const std::string &l : log) printf("%s\n", l.c_str());
+    for (size_t i = 0; i < n; i++) {
+      printf("  controller %zu: driven %u, duplicates %u\n", i, driven[i], duplicates[i]);
+    }
+  }
+  return ok;
+}
+
+// ============================================
+// SCENARIOS
+// ============================================
+
+static std::vector<Scenario> scenarios() {
+  const uint32_t S = 1000000;
+  std::vector<Scenario> all;
+
+  // 1 kHz, every frame redundant: each seq drives once.
+  all.push_back({"single controller, redundant 1 kHz", ARB_FIRST_OWNER, 1, 0, 2 * S,
+                 {{1, 1000, 0, 2 * S, true, 255}},
+                 {{1000, 0}, {2 * S - 1, 0}},
+                 {2000}, {2000}});
+
+  // Two equal controllers interleaved at 1 kHz each: the first one keeps
+  // the robot while it sends; the second only after the lock runs out.
+  all.push_back({"first owner holds against an interleaved stream", ARB_FIRST_OWNER, 1, 0, 3 * S,
+                 {{1, 1000, 0, 1 * S, false, 255}, {2, 1000, 500, 3 * S, true, 255}},
+                 {{10000, 0}, {S - 1, 0}, {S + LOCK_US - 2000, 0}, {S + LOCK_US + 2000, 1}, {3 * S - 1, 1}},
+                 {1000, 1500}, {1000, 1501}});
+
+  // The old owner coming back (same MAC, fresh seqs) is locked out while
+  // the new one keeps sending.
+  all.push_back({"returning owner locked out", ARB_FIRST_OWNER, 1, 0, 4 * S,
+                 {{1, 500, 0, 1 * S, true, 255}, {2, 700, 300, 4 * S, false, 255}, {1, 500, 2 * S, 3 * S, true, 255}},
+                 {{S / 2, 0}, {2 * S, 1}, {3 * S, 1}, {4 * S - 1, 1}},
+                 {2000, 3000, 0}, {2000, 4000, 0}});
+
+  // ARB_PRIORITY: the listed controller takes over at once and hands back
+  // after its lock expires.
+  all.push_back({"priority takeover and hand-back", ARB_PRIORITY, 1, 0, 3 * S,
+                 {{1, 1000, 0, 3 * S, false, 255}, {2, 1000, S / 2, S + S / 2, true, 5}},
+                 {{S / 2 - 1, 0}, {S / 2 + 1, 1}, {S + S / 2 - 1, 1},
+                  {S + S / 2 + LOCK_US - 2000, 1}, {S + S / 2 + LOCK_US + 2000, 0}},
+                 {501 + 1001, 1000}, {501 + 1001, 1000}});
+
+  // Same streams under ARB_FIRST_OWNER: priority does not matter.
+  all.push_back({"first owner ignores priority", ARB_FIRST_OWNER, 1, 0, 2 * S,
+                 {{1, 1000, 0, 2 * S, false, 255}, {2, 1000, S / 2, 2 * S, false, 5}},
+                 {{2 * S - 1, 0}},
+                 {2000, 0}, {2000, 0}});
+
+  // A spectator never drives, even when nobody else does; with default
+  // priority 0 only listed controllers may.
+  all.push_back({"spectators never drive", ARB_PRIORITY, 0, 0, 2 * S,
+                 {{1, 1000, 0, 2 * S, false, 255}, {2, 1000, 0, 2 * S, false, 0}, {3, 2000, S, 2 * S, false, 1}},
+                 {{S - 1, -1}, {S + 1000, 2}},
+                 {0, 0, 500}, {0, 0, 500}});
+
+  // More controllers than slots: the quiet ones are recycled, never the
+  // owner, and the owner's stream is untouched.
+  all.push_back({"six controllers, four slots", ARB_FIRST_OWNER, 1, 0, 2 * S,
+                 {{1, 1000, 0, 2 * S, false, 255}, {2, 1100, 100, 2 * S, false, 255},
+                  {3, 1300, 200, 2 * S, false, 255}, {4, 1700, 300, 2 * S, false, 255},
+                  {5, 1900, 400, 2 * S, false, 255}, {6, 2300, 500, 2 * S, false, 255}},
+                 {{2 * S - 1, 0}},
+                 {2000, 0, 0, 0, 0, 0}, {2000, 0, 0, 0, 0, 0}});
+
+  // micros() wraps half-way through a handover.
+  all.push_back({"handover across a micros() wrap", ARB_FIRST_OWNER, 1, UINT32_MAX - S, 3 * S,
+                 {{1, 1000, 0, S - 200000, false, 255}, {2, 1000, 1000, 3 * S, false, 255}},
+                 {{S / 2, 0}, {S - 200000 + LOCK_US + 2000, 1}, {3 * S - 1, 1}},
+                 {800, 1600}, {800, 1800}});
+
+  // A higher-priority controller probing at 1 Hz, driving nothing: its
+  // probes neither claim the idle robot nor take it from the operator.
+  all.push_back({"probes neither claim nor take over", ARB_PRIORITY, 1, 0, 3 * S,
+                 {{1, 20000, 10000, 3 * S, false, 255}, {2, 20000, 0, 0, false, 5, S}},
+                 {{5000, -1}, {20000, 0}, {S + 1000, 0}, {2 * S + 1000, 0}, {3 * S - 1, 0}},
+                 {150, 0}, {150, 0}});
+
+  // The operator probed this robot for two seconds before selecting it: the
+  // probe seqs, 128 ahead of the drive seqs, must not make those stale.
+  all.push_back({"driving after probing", ARB_PRIORITY, 1, 0, 4 * S,
+                 {{1, 20000, 2 * S, 4 * S, false, 255, S}},
+                 {{2 * S - 1, -1}, {2 * S + 1000, 0}, {4 * S - 1, 0}},
+                 {100}, {100}});
+
+  // The owner reboots and counts again from 0, 99 seqs behind its last one,
+  // before its lock runs out: a restarted stream, not 68 duplicates.
+  all.push_back({"owner restarts its seq", ARB_FIRST_OWNER, 1, 0, 2 * S,
+                 {{1, 10000, 0, S, false, 255}, {1, 10000, S + S / 10, 2 * S, false, 255}},
+                 {{S + S / 20, 0}, {S + S / 2, 0}, {2 * S - 1, 0}},
+                 {100, 90}, {100, 90}});
+  return all;
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+int main(int argc, char **argv) {
+  bool verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+  std::vector<Scenario> all = scenarios();
+  int failed = 0;
+  for (const Scenario &s : all) {
+    if (!run(s, verbose)) failed++;
+  }
+  printf("\n%d/%zu scenarios passed\n", (int)all.size() - failed, all.size());
+
+  // Cost per offer with four sources interleaved and a redundant owner.
+  CommandArbiter arb;
+  arb.begin({ARB_PRIORITY, LOCK_US, 1, nullptr, 0});
+  uint8_t macs[4][6] = {{2, 0, 0, 0, 0, 1}, {2, 0, 0, 0, 0, 2}, {2, 0, 0, 0, 0, 3}, {2, 0, 0, 0, 0, 4}};
+  const uint32_t ops = 20000000;
+  volatile uint32_t sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < ops; i++) sink += arb.offer(macs[i & 3], (uint8_t)(i >> 3), i * 50);
+  auto t1 = std::chrono::steady_clock::now();
+  printf("offer(): %.1f ns on this host (%u offers, 4 sources)\n",
+         std::chrono::duration<double, std::nano>(t1 - t0).count() / ops, ops);
+  return failed ? 1 : 0;
+}
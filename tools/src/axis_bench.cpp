@@ -0,0 +1,258 @@
+// axis_bench - the controller's table-driven axis mapping (axis_model.h)
+// against the per-axis code it replaced: same outputs, and the cost of the
+// display bars and of the command fields for each.
+//
+//   axis_bench                  equivalence sweep + benchmark, exit 1 on a mismatch
+//   axis_bench --ops 20000000   passes per timed run (best of five runs)
+//
+// The legacy functions are the old mapJoystickValues() and the three
+// mapAxisSigned() calls of buildCommandFromSticks(), with Arduino's map()
+// and constrain() spelled out. The sweep covers random calibrations with
+// travel on both halves (the old code divides by zero otherwise).
+
+#include "axis_model.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ADC_MAX 4095
+#define ADC_MAP_MIN 0
+#define ADC_MAP_MAX 58
+#define ADC_MAP_CENTER 29
+
+enum AxisId { AXIS_LX, AXIS_LY, AXIS_RX, AXIS_RY, AXIS_COUNT };
+
+// Same rows as the controller's AXES, pins aside.
+constexpr AxisDesc AXES[AXIS_COUNT] = {
+  {4, AXIS_ROLE_X,    AXIS_LX, STICK_LEFT,  "leftX",  "LX", "LEFT", "RIGHT"},
+  {3, AXIS_ROLE_Y,    AXIS_LY, STICK_LEFT,  "leftY",  "LY", "DOWN", "UP"},
+  {2, AXIS_ROLE_ROT,  AXIS_RX, STICK_RIGHT, "rightX", "RX", "LEFT", "RIGHT"},
+  {1, AXIS_ROLE_NONE, AXIS_RY, STICK_RIGHT, "rightY", "RY", "DOWN", "UP"},
+};
+
+// ============================================
+// LEGACY PER-AXIS CODE
+// ============================================
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+static long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+struct LegacyCalibration {
+  int leftXMin, leftXMax, leftXCenter;
+  int leftYMin, leftYMax, leftYCenter;
+  int rightXMin, rightXMax, rightXCenter;
+  int rightYMin, rightYMax, rightYCenter;
+};
+
+struct Inputs {
+  int raw[AXIS_COUNT];   // LX, LY, RX, RY
+};
+
+struct Outputs {
+  int bars[AXIS_COUNT];
+  int8_t x, y, rot;
+  bool operator==(const Outputs &o) const {
+    return memcmp(bars, o.bars, sizeof(bars)) == 0 && x == o.x && y == o.y && rot == o.rot;
+  }
+};
+
+static int deadzone = 50;
+
+static int8_t legacyMapAxisSigned(int raw, int mn, int ctr, int mx) {
+  if (abs(raw - ctr) < deadzone) return 0;
+  long v;
+  if (raw < ctr) {
+    v = map(constrain(raw, mn, ctr), mn, ctr, -100, 0);
+  } else {
+    v = map(constrain(raw, ctr, mx), ctr, mx, 0, 100);
+  }
+  return (int8_t)constrain(v, -100, 100);
+}
+
+// mapJoystickValues(): display bars.
+__attribute__((noinline))
+static void legacyBars(const LegacyCalibration &calibration, const Inputs &in, Outputs &out) {
+  int leftX = in.raw[0], leftY = in.raw[1], rightX = in.raw[2], rightY = in.raw[3];
+  int &leftXBar = out.bars[0], &leftYBar = out.bars[1], &rightXBar = out.bars[2], &rightYBar = out.bars[3];
+
+  if (abs(leftX - calibration.leftXCenter) < deadzone) {
+    leftXBar = ADC_MAP_CENTER;
+  } else if (leftX < calibration.leftXCenter) {
+    leftXBar = map(constrain(leftX, calibration.leftXMin, calibration.leftXCenter),
+                   calibration.leftXMin, calibration.leftXCenter, ADC_MAP_MIN, ADC_MAP_CENTER);
+  } else {
+    leftXBar = map(constrain(leftX, calibration.leftXCenter, calibration.leftXMax),
+                   calibration.leftXCenter, calibration.leftXMax, ADC_MAP_CENTER, ADC_MAP_MAX);
+  }
+  if (abs(leftY - calibration.leftYCenter) < deadzone) {
+    leftYBar = ADC_MAP_CENTER;
+  } else if (leftY < calibration.leftYCenter) {
+    leftYBar = map(constrain(leftY, calibration.leftYMin, calibration.leftYCenter),
+                   calibration.leftYMin, calibration.leftYCenter, ADC_MAP_MIN, ADC_MAP_CENTER);
+  } else {
+    leftYBar = map(constrain(leftY, calibration.leftYCenter, calibration.leftYMax),
+                   calibration.leftYCenter, calibration.leftYMax, ADC_MAP_CENTER, ADC_MAP_MAX);
+  }
+  if (abs(rightX - calibration.rightXCenter) < deadzone) {
+    rightXBar = ADC_MAP_CENTER;
+  } else if (rightX < calibration.rightXCenter) {
+    rightXBar = map(constrain(rightX, calibration.rightXMin, calibration.rightXCenter),
+                    calibration.rightXMin, calibration.rightXCenter, ADC_MAP_MIN, ADC_MAP_CENTER);
+  } else {
+    rightXBar = map(constrain(rightX, calibration.rightXCenter, calibration.rightXMax),
+                    calibration.rightXCenter, calibration.rightXMax, ADC_MAP_CENTER, ADC_MAP_MAX);
+  }
+  if (abs(rightY - calibration.rightYCenter) < deadzone) {
+    rightYBar = ADC_MAP_CENTER;
+  } else if (rightY < calibration.rightYCenter) {
+    rightYBar = map(constrain(rightY, calibration.rightYMin, calibration.rightYCenter),
+                    calibration.rightYMin, calibration.rightYCenter, ADC_MAP_MIN, ADC_MAP_CENTER);
+  } else {
+    rightYBar = map(constrain(rightY, calibration.rightYCenter, calibration.rightYMax),
+                    calibration.rightYCenter, calibration.rightYMax, ADC_MAP_CENTER, ADC_MAP_MAX);
+  }
+  leftXBar = constrain(leftXBar, ADC_MAP_MIN, ADC_MAP_MAX);
+  leftYBar = constrain(leftYBar, ADC_MAP_MIN, ADC_MAP_MAX);
+  rightXBar = constrain(rightXBar, ADC_MAP_MIN, ADC_MAP_MAX);
+  rightYBar = constrain(rightYBar, ADC_MAP_MIN, ADC_MAP_MAX);
+}
+
+// buildCommandFromSticks(): command fields.
+__attribute__((noinline))
+static void legacyCommand(const LegacyCalibration &calibration, const Inputs &in, Outputs &out) {
+  int leftX = in.raw[0], leftY = in.raw[1], rightX = in.raw[2];
+  out.x   = legacyMapAxisSigned(leftX,  calibration.leftXMin,  calibration.leftXCenter,  calibration.leftXMax);
+  out.y   = legacyMapAxisSigned(leftY,  calibration.leftYMin,  calibration.leftYCenter,  calibration.leftYMax);
+  out.rot = legacyMapAxisSigned(rightX, calibration.rightXMin, calibration.rightXCenter, calibration.rightXMax);
+}
+
+// ============================================
+// TABLE-DRIVEN CODE
+// ============================================
+
+__attribute__((noinline))
+static void tableBars(const AxisCal *cal, const Inputs &in, Outputs &out) {
+  axisScaleAll(AXES, in.raw, cal, deadzone, ADC_MAP_MIN, ADC_MAP_CENTER, ADC_MAP_MAX, out.bars);
+}
+
+__attribute__((noinline))
+static void tableCommand(const AxisCal *cal, const Inputs &in, Outputs &out) {
+  int8_t v[AXIS_ROLE_COUNT];
+  axisRoles(AXES, in.raw, cal, deadzone, v);
+  out.x = v[AXIS_ROLE_X];
+  out.y = v[AXIS_ROLE_Y];
+  out.rot = v[AXIS_ROLE_ROT];
+}
+
+// ============================================
+// INPUTS
+// ============================================
+
+static void randomCal(AxisCal cal[AXIS_COUNT], LegacyCalibration &legacy) {
+  for (int a = 0; a < AXIS_COUNT; a++) {
+    int mn = rand() % 1200;
+    int mx = ADC_MAX - rand() % 1200;
+    int ctr = mn + 1 + rand() % (mx - mn - 1);
+    cal[a] = {mn, ctr, mx};
+  }
+  legacy = {cal[0].min, cal[0].max, cal[0].center, cal[1].min, cal[1].max, cal[1].center,
+            cal[2].min, cal[2].max, cal[2].center, cal[3].min, cal[3].max, cal[3].center};
+}
+
+static int randomRaw(const AxisCal &c) {
+  switch (rand() % 6) {
+    case 0: return c.center + rand() % 101 - 50;    // around the deadzone edge
+    case 1: return c.min + rand() % 21 - 10;        // around the ends
+    case 2: return c.max + rand() % 21 - 10;
+    default: return rand() % (ADC_MAX + 1);
+  }
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+int main(int argc, char **argv) {
+  uint64_t ops = 5000000;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--ops") == 0 && i + 1 < argc) ops = strtoull(argv[++i], nullptr, 10);
+    else {
+      fprintf(stderr, "usage: %s [--ops N]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  // Equivalence: random calibrations, deadzones and readings.
+  srand(1);
+  uint64_t checked = 0, mismatches = 0;
+  AxisCal cal[AXIS_COUNT];
+  LegacyCalibration legacy;
+  for (int round = 0; round < 20000; round++) {
+    randomCal(cal, legacy);
+    deadzone = rand() % 201;
+    for (int k = 0; k < 100; k++) {
+      Inputs in;
+      for (int a = 0; a < AXIS_COUNT; a++) in.raw[a] = randomRaw(cal[a]);
+      Outputs want, got;
+      legacyBars(legacy, in, want);
+      legacyCommand(legacy, in, want);
+      tableBars(cal, in, got);
+      tableCommand(cal, in, got);
+      checked++;
+      if (!(got == want)) {
+        if (mismatches < 5) {
+          printf("  MISMATCH raw %d %d %d %d dz %d: bars %d/%d %d/%d %d/%d %d/%d  cmd %d/%d %d/%d %d/%d\n",
+                 in.raw[0], in.raw[1], in.raw[2], in.raw[3], deadzone,
+                 got.bars[0], want.bars[0], got.bars[1], want.bars[1], got.bars[2], want.bars[2],
+                 got.bars[3], want.bars[3], got.x, want.x, got.y, want.y, got.rot, want.rot);
+        }
+        mismatches++;
+      }
+    }
+  }
+  printf("Equivalence: %llu passes, %llu mismatches\n",
+         (unsigned long long)checked, (unsigned long long)mismatches);
+
+  // Cost per pass over a fixed set of readings.
+  static Inputs inputs[1024];
+  for (Inputs &in : inputs) {
+    for (int a = 0; a < AXIS_COUNT; a++) in.raw[a] = randomRaw(cal[a]);
+  }
+  deadzone = 50;
+  Outputs out;
+  volatile int sink = 0;
+
+  // Best of seven alternating runs, so a busy host does not favour either.
+  auto time = [&](void (*pass)(const void *, const Inputs &, Outputs &), const void *c) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < ops; i++) {
+      pass(c, inputs[i & 1023], out);
+      sink += out.bars[0] + out.x;
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / ops;
+  };
+  typedef void (*Pass)(const void *, const Inputs &, Outputs &);
+  Pass passes[4] = {
+    [](const void *c, const Inputs &in, Outputs &o) { legacyBars(*(const LegacyCalibration *)c, in, o); },
+    [](const void *c, const Inputs &in, Outputs &o) { tableBars((const AxisCal *)c, in, o); },
+    [](const void *c, const Inputs &in, Outputs &o) { legacyCommand(*(const LegacyCalibration *)c, in, o); },
+    [](const void *c, const Inputs &in, Outputs &o) { tableCommand((const AxisCal *)c, in, o); },
+  };
+  const void *cals[4] = {&legacy, cal, &legacy, cal};
+  double best[4] = {1e9, 1e9, 1e9, 1e9};
+  for (int rep = 0; rep < 7; rep++) {
+    for (int p = 0; p < 4; p++) {
+      double ns = time(passes[p], cals[p]);
+      if (ns < best[p]) best[p] = ns;
+    }
+  }
+  printf("                 bars (4 axes)   command (3 fields)\n");
+  printf("Per-axis code:   %6.2f ns        %6.2f ns\n", best[0], best[2]);
+  printf("Axis table:      %6.2f ns        %6.2f ns\n", best[1], best[3]);
+  return mismatches ? 1 : 0;
+}
@@ -0,0 +1,283 @@
+// axis_curve_check - the controller's multi-point stick calibration
+// (axis_curve.h): point averaging, curve fitting, monotonicity enforcement
+// and lookup-table accuracy, then the cost of one lookup against the
+// three-point mapping.
+//
+//   axis_curve_check            run every check, exit 1 on a failure
+//
+// Sticks are simulated as a non-linear pot (S-shaped near centre, flattened
+// near the ends) with ADC noise; the checks compare the fitted curve with
+// the stick's true position.
+
+#include "axis_curve.h"
+#include "axis_model.h"
+#include "check.h"
+
+#include <chrono>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+
+static std::mt19937 rng(49);
+
+// ============================================
+// SIMULATED STICK
+// ============================================
+
+// Raw reading at stick position pos (-1..1). bend > 0 makes the pot steep
+// around centre and shallow near the ends (negative: the other way round).
+struct Stick {
+  double center, halfLow, halfHigh, bend;
+
+  double raw(double pos) const {
+    double shaped = pos + bend * (pos - pos * fabs(pos));
+    return center + (shaped < 0 ? shaped * halfLow : shaped * halfHigh);
+  }
+};
+
+static const Stick sticks[] = {
+  {2048, 2000, 2000, 0.0},     // linear, full range
+  {1900, 1700, 2100, 0.5},     // off-centre, steep in the middle
+  {2200, 1500, 1750, 0.8},     // strong S-curve, short travel
+  {2050, 1950, 1980, -0.4},    // flat in the middle, steep near the ends
+};
+
+static uint16_t noisyRead(double v, double sigma, double spikeRate) {
+  std::normal_distribution<double> noise(0.0, sigma);
+  std::uniform_real_distribution<double> u(0.0, 1.0);
+  double r = v + noise(rng);
+  if (u(rng) < spikeRate) r += u(rng) < 0.5 ? -400 : 400;
+  if (r < 0) r = 0;
+  if (r > AXIS_CURVE_RAW_MAX) r = AXIS_CURVE_RAW_MAX;
+  return (uint16_t)lround(r);
+}
+
+// What CURVE CAL captures: 64 reads per knot position, averaged.
+static void capture(const Stick &s, int points[AXIS_CURVE_KNOTS], double sigma, double spikeRate) {
+  for (int k = 0; k < AXIS_CURVE_KNOTS; k++) {
+    double pos = axisCurveOut(k) / 100.0;
+    uint16_t reads[64];
+    for (uint16_t &r : reads) r = noisyRead(s.raw(pos), sigma, spikeRate);
+    points[k] = axisPointAverage(reads, 64);
+  }
+}
+
+static bool strictlyIncreasing(const AxisCurve &c, int gap) {
+  for (int k = 1; k < AXIS_CURVE_KNOTS; k++) {
+    if (c.knot[k] < c.knot[k - 1] + gap) return false;
+  }
+  return true;
+}
+
+// ============================================
+// CHECKS
+// ============================================
+
+static void checkAverage() {
+  printf("point averaging\n");
+  double worstTrimmed = 0, worstMean = 0;
+  for (int t = 0; t < 2000; t++) {
+    double truth = 200 + t;
+    uint16_t reads[64];
+    long sum = 0;
+    for (uint16_t &r : reads) {
+      r = noisyRead(truth, 12.0, 0.05);
+      sum += r;
+    }
+    double mean = sum / 64.0;
+    int trimmed = axisPointAverage(reads, 64);
+    worstTrimmed = fmax(worstTrimmed, fabs(trimmed - truth));
+    worstMean = fmax(worstMean, fabs(mean - truth));
+    for (int i = 1; i < 64; i++) CHECK(reads[i - 1] <= reads[i]);
+  }
+  printf("  worst error, 64 reads, sigma 12, 5%% spikes: trimmed %.1f, plain mean %.1f counts\n",
+         worstTrimmed, worstMean);
+  CHECK(worstTrimmed < 8);
+  CHECK(worstTrimmed < worstMean);
+
+  uint16_t one[1] = {1234};
+  CHECK(axisPointAverage(one, 1) == 1234);
+  uint16_t same[8] = {500, 500, 500, 500, 500, 500, 500, 500};
+  CHECK(axisPointAverage(same, 8) == 500);
+}
+
+static void checkFit() {
+  printf("fitting and accuracy\n");
+  for (const Stick &s : sticks) {
+    int points[AXIS_CURVE_KNOTS];
+    capture(s, points, 8.0, 0.02);
+    AxisCurve c = {};
+    int moved = axisCurveFit(points, c);
+    CHECK(moved == 0);
+    CHECK(axisCurveValid(c));
+
+    // Three-point calibration of the same stick, for comparison.
+    AxisCal lin = {points[0], points[AXIS_CURVE_HALF], points[AXIS_CURVE_KNOTS - 1]};
+
+    // Error against the true position over the whole travel.
+    double worstCurve = 0, worstLinear = 0;
+    for (int i = -1000; i <= 1000; i++) {
+      double pos = i / 1000.0;
+      int raw = (int)lround(s.raw(pos));
+      worstCurve = fmax(worstCurve, fabs(axisCurveEval(c, raw) - pos * 100));
+      worstLinear = fmax(worstLinear, fabs(axisSigned(raw, lin, 0) - pos * 100));
+    }
+    printf("  bend %+.1f: worst error %4.1f with the curve, %4.1f three-point\n",
+           s.bend, worstCurve, worstLinear);
+    CHECK(worstCurve <= 3.0 + 7.0 * fabs(s.bend));
+    if (s.bend != 0) CHECK(worstCurve < worstLinear / 2);
+
+    // Every knot lands on its output, the centre on zero.
+    for (int k = 0; k < AXIS_CURVE_KNOTS; k++) CHECK(axisCurveEval(c, c.knot[k]) == axisCurveOut(k));
+    CHECK(axisCurveEval(c, 0) == -100 && axisCurveEval(c, AXIS_CURVE_RAW_MAX) == 100);
+  }
+}
+
+static void checkMonotone() {
+  printf("monotonicity enforcement\n");
+  AxisCurve c, ref;
+  int good[AXIS_CURVE_KNOTS] = {100, 500, 900, 1400, 2000, 2500, 3000, 3500, 4000};
+  CHECK(axisCurveFit(good, ref) == 0);
+
+  // Two points captured in the wrong order pool to their mean.
+  int swapped[AXIS_CURVE_KNOTS] = {100, 500, 1400, 900, 2000, 2500, 3000, 3500, 4000};
+  CHECK(axisCurveFit(swapped, c) == 2);
+  CHECK(strictlyIncreasing(c, AXIS_CURVE_MIN_GAP));
+  CHECK(c.knot[2] == 1150 && c.knot[3] == 1158);
+  CHECK(c.knot[0] == 100 && c.knot[4] == 2000 && c.knot[8] == 4000);
+
+  // A point far out of place drags its neighbours only as far as needed.
+  int spike[AXIS_CURVE_KNOTS] = {100, 500, 900, 1400, 2000, 3600, 3000, 3500, 4000};
+  CHECK(axisCurveFit(spike, c) > 0);
+  CHECK(strictlyIncreasing(c, AXIS_CURVE_MIN_GAP));
+  CHECK(c.knot[4] == 2000 && c.knot[8] == 4000);
+
+  // Ties (a point captured twice) are spread to the minimum gap.
+  int ties[AXIS_CURVE_KNOTS] = {0, 0, 900, 1400, 2000, 2500, 4095, 4095, 4095};
+  CHECK(axisCurveFit(ties, c) > 0);
+  CHECK(strictlyIncreasing(c, AXIS_CURVE_MIN_GAP));
+  CHECK(c.knot[0] == 0 && c.knot[AXIS_CURVE_KNOTS - 1] == AXIS_CURVE_RAW_MAX);
+
+  // A pot mounted the other way round fits to the same curve.
+  int reversed[AXIS_CURVE_KNOTS];
+  for (int k = 0; k < AXIS_CURVE_KNOTS; k++) reversed[k] = good[AXIS_CURVE_KNOTS - 1 - k];
+  CHECK(axisCurveFit(reversed, c) == 0);
+  bool same = true;
+  for (int k = 0; k < AXIS_CURVE_KNOTS; k++) same = same && c.knot[k] == ref.knot[k];
+  CHECK(same);
+
+  // No travel: rejected, the axis stays three-point.
+  int flat[AXIS_CURVE_KNOTS] = {2000, 2001, 2003, 2002, 2000, 2004, 2001, 2003, 2002};
+  CHECK(axisCurveFit(flat, c) == -1);
+
+  // Random captures: always strictly increasing or rejected.
+  std::uniform_int_distribution<int> any(0, AXIS_CURVE_RAW_MAX);
+  int rejected = 0;
+  for (int t = 0; t < 100000; t++) {
+    int p[AXIS_CURVE_KNOTS];
+    for (int &v : p) v = any(rng);
+    int moved = axisCurveFit(p, c);
+    if (moved < 0) {
+      rejected++;
+      continue;
+    }
+    CHECK(axisCurveValid(c) && strictlyIncreasing(c, AXIS_CURVE_MIN_GAP));
+    if (failures) break;
+  }
+  printf("  100000 random captures: %d rejected, the rest strictly increasing\n", rejected);
+
+  // Stored curves that are not increasing are refused on load.
+  AxisCurve bad = ref;
+  bad.knot[5] = bad.knot[4];
+  CHECK(!axisCurveValid(bad));
+  bad = ref;
+  bad.knot[AXIS_CURVE_KNOTS - 1] = 5000;
+  CHECK(!axisCurveValid(bad));
+}
+
+static void checkLut() {
+  printf("lookup table\n");
+  static int8_t lut[AXIS_LUT_LEN];
+  for (const Stick &s : sticks) {
+    int points[AXIS_CURVE_KNOTS];
+    capture(s, points, 8.0, 0.02);
+    AxisCurve c = {};
+    axisCurveFit(points, c);
+    axisCurveLut(c, lut);
+
+    // Steepest segment, output per raw count: the table can be off by up
+    // to half a bucket of it.
+    double steep = 0;
+    for (int k = 0; k + 1 < AXIS_CURVE_KNOTS; k++) {
+      steep = fmax(steep, (double)(axisCurveOut(k + 1) - axisCurveOut(k)) / (c.knot[k + 1] - c.knot[k]));
+    }
+    int bound = 1 + (int)ceil(steep * (1 << AXIS_LUT_SHIFT) / 2);
+
+    int worst = 0;
+    for (int raw = 0; raw <= AXIS_CURVE_RAW_MAX; raw++) {
+      int err = abs(axisCurveSigned(lut, raw, c.knot[AXIS_CURVE_HALF], 0) - axisCurveEval(c, raw));
+      if (err > worst) worst = err;
+    }
+    bool monotone = true;
+    for (int i = 1; i < AXIS_LUT_LEN; i++) monotone = monotone && lut[i] >= lut[i - 1];
+    printf("  bend %+.1f: worst table error %d (bound %d)\n", s.bend, worst, bound);
+    CHECK(worst <= bound && worst <= 1);
+    CHECK(monotone);
+    CHECK(lut[0] == -100 && lut[AXIS_LUT_LEN - 1] == 100);
+
+    // Deadzone around the centre knot, as the three-point mapping has.
+    int ctr = c.knot[AXIS_CURVE_HALF];
+    CHECK(axisCurveSigned(lut, ctr + 49, ctr, 50) == 0 && axisCurveSigned(lut, ctr - 49, ctr, 50) == 0);
+    CHECK(axisCurveSigned(lut, ctr + 50, ctr, 50) == lut[(ctr + 50) >> AXIS_LUT_SHIFT]);
+  }
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+int main() {
+  checkAverage();
+  checkFit();
+  checkMonotone();
+  checkLut();
+  int status = checkSummary();
+
+  // Cost per axis: three-point mapping, exact curve, curve table.
+  const Stick &s = sticks[2];
+  int points[AXIS_CURVE_KNOTS];
+  capture(s, points, 8.0, 0.0);
+  AxisCurve c = {};
+  axisCurveFit(points, c);
+  static int8_t lut[AXIS_LUT_LEN];
+  axisCurveLut(c, lut);
+  AxisCal lin = {points[0], points[AXIS_CURVE_HALF], points[AXIS_CURVE_KNOTS - 1]};
+  int raws[1024];
+  for (int &r : raws) r = (int)lround(s.raw(std::uniform_real_distribution<double>(-1, 1)(rng)));
+
+  const int ops = 20000000;
+  volatile int sink = 0;
+  auto time = [&](const char *name, int (*f)(const AxisCal &, const AxisCurve &, const int8_t *, int)) {
+    double best = 1e9;
+    for (int rep = 0; rep < 5; rep++) {
+      int acc = 0;
+      auto t0 = std::chrono::steady_clock::now();
+      for (int i = 0; i < ops; i++) acc += f(lin, c, lut, raws[i & 1023]);
+      auto t1 = std::chrono::steady_clock::now();
+      sink += acc;
+      best = fmin(best, std::chrono::duration<double, std::nano>(t1 - t0).count() / ops);
+    }
+    printf("%-22s %5.2f ns per axis on this host\n", name, best);
+  };
+  time("three-point:", [](const AxisCal &l, const AxisCurve &, const int8_t *, int raw) {
+    return (int)axisSigned(raw, l, 40);
+  });
+  time("curve, exact:", [](const AxisCal &, const AxisCurve &cv, const int8_t *, int raw) {
+    return axisCurveEval(cv, raw);
+  });
+  time("curve, table:", [](const AxisCal &l, const AxisCurve &, const int8_t *t, int raw) {
+    return (int)axisCurveSigned(t, raw, l.center, 40);
+  });
+  return status;
+}
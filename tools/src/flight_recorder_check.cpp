@@ -0,0 +1,189 @@
+// flight_recorder_check - the controller's flight recorder ring
+// (FlightRecorder) with several producer threads against a live reader
+// doing what DUMP does: no slot comes back torn or out of order, and every
+// slot the dump skips is one that was really overwritten.
+//
+//   flight_recorder_check       run every check, exit 1 on a failure
+//
+// The ring is kept small so the producers lap the reader all the time, as
+// the loop and the WiFi task would on a ring a dump cannot keep up with.
+
+#include "check.h"
+#include "flight_recorder.h"
+
+#include <atomic>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+#define RING 64
+#define PRODUCERS 4
+#define EVENTS 400000              // per producer, fits the 24-bit counter
+
+// ============================================
+// EVENT ENCODING
+// ============================================
+// Producer p's n-th event: type p + 1, the producer in the top bits of tUs
+// and n in the rest, n again split over a and b. A copy mixing two events
+// disagrees with itself.
+
+static void encode(int p, uint32_t n, uint32_t &tUs, uint8_t &type, uint8_t &a, uint16_t &b) {
+  tUs = (uint32_t)p << 28 | n;
+  type = (uint8_t)(p + 1);
+  a = (uint8_t)n;
+  b = (uint16_t)(n >> 8);
+}
+
+// Producer of an intact event, or -1.
+static int decode(const FlightEvent &e, uint32_t &n) {
+  int p = e.type - 1;
+  n = e.tUs & 0x0FFFFFFF;
+  if (p < 0 || p >= PRODUCERS || (e.tUs >> 28) != (uint32_t)p) return -1;
+  if (e.a != (uint8_t)n || e.b != (uint16_t)(n >> 8)) return -1;
+  return p;
+}
+
+// ============================================
+// CHECKS
+// ============================================
+
+static FlightRecorder<RING> recorder;
+
+// One DUMP pass over [first, written) as flightlog.cpp does it.
+struct Pass {
+  uint32_t returned = 0, skipped = 0, unexplained = 0, torn = 0, outOfOrder = 0;
+};
+
+// live: give the producers the CPU now and then, as the real dump does
+// while it waits on the serial port.
+static Pass dumpPass(bool live) {
+  Pass r;
+  uint32_t from = recorder.first();
+  uint32_t to = recorder.written();
+  std::vector<uint32_t> skippedIdx;
+  int64_t last[PRODUCERS];
+  for (int64_t &l : last) l = -1;
+  for (uint32_t i = from; i < to; i++) {
+    if (live && i % 8 == 7) std::this_thread::yield();
+    FlightEvent e;
+    if (!recorder.read(i, e)) {
+      r.skipped++;
+      skippedIdx.push_back(i);
+      continue;
+    }
+    r.returned++;
+    uint32_t n;
+    int p = decode(e, n);
+    if (p < 0) {
+      r.torn++;
+      continue;
+    }
+    // Each producer claims its slots in order, so its events rise with the index.
+    if ((int64_t)n <= last[p]) r.outOfOrder++;
+    last[p] = n;
+  }
+  // A skipped slot was overwritten (claimed again by now) or is one of the
+  // at most PRODUCERS writes still in flight.
+  uint32_t now = recorder.written();
+  for (uint32_t i : skippedIdx) {
+    if (now - i <= RING) r.unexplained++;
+  }
+  if (r.unexplained > PRODUCERS) r.unexplained -= PRODUCERS;
+  else r.unexplained = 0;
+  return r;
+}
+
+static void checkConcurrent() {
+  printf("%d producers against a live dump, ring of %d\n", PRODUCERS, RING);
+  std::atomic<int> running(PRODUCERS);
+  std::vector<std::thread> producers;
+  for (int p = 0; p < PRODUCERS; p++) {
+    producers.emplace_back([p, &running] {
+      for (uint32_t n = 0; n < EVENTS; n++) {
+        uint32_t tUs;
+        uint8_t type, a;
+        uint16_t b;
+        encode(p, n, tUs, type, a, b);
+        recorder.record(tUs, type, a, b);
+        if (n % 100 == 99) std::this_thread::yield();
+      }
+      running.fetch_sub(1);
+    });
+  }
+
+  Pass total;
+  uint32_t passes = 0;
+  while (running.load() > 0) {
+    Pass r = dumpPass(true);
+    total.returned += r.returned;
+    total.skipped += r.skipped;
+    total.unexplained += r.unexplained;
+    total.torn += r.torn;
+    total.outOfOrder += r.outOfOrder;
+    passes++;
+    std::this_thread::yield();
+  }
+  for (std::thread &t : producers) t.join();
+
+  printf("  %u passes: %u events read, %u skipped as overwritten\n", passes, total.returned, total.skipped);
+  CHECK(total.torn == 0 && total.outOfOrder == 0);
+  CHECK(total.unexplained == 0);
+  CHECK(passes > 0 && total.returned > 0);
+}
+
+// With the producers stopped: the counters add up and the ring holds
+// exactly the newest RING claims, each producer's as an unbroken run up to
+// its last event.
+static void checkQuiescent() {
+  printf("after the producers stop\n");
+  uint32_t total = (uint32_t)PRODUCERS * EVENTS;
+  CHECK(recorder.written() == total);
+  CHECK(recorder.first() == total - RING);
+  printf("  %u recorded, %u overwritten, %u held\n", total, recorder.first(), total - recorder.first());
+
+  Pass r = dumpPass(false);
+  CHECK(r.returned == RING && r.skipped == 0 && r.torn == 0 && r.outOfOrder == 0);
+
+  uint32_t lo[PRODUCERS], hi[PRODUCERS], count[PRODUCERS] = {};
+  for (uint32_t i = recorder.first(); i < recorder.written(); i++) {
+    FlightEvent e;
+    uint32_t n;
+    if (!recorder.read(i, e)) continue;
+    int p = decode(e, n);
+    if (p < 0) continue;
+    if (!count[p]++) lo[p] = n;
+    hi[p] = n;
+  }
+  for (int p = 0; p < PRODUCERS; p++) {
+    if (!count[p]) continue;
+    CHECK(hi[p] == EVENTS - 1 && hi[p] - lo[p] + 1 == count[p]);
+  }
+}
+
+// Single producer, no concurrency: wraparound bookkeeping.
+static void checkSequential() {
+  printf("sequential wraparound\n");
+  FlightRecorder<8> r;
+  FlightEvent e;
+  CHECK(r.written() == 0 && r.first() == 0 && !r.read(0, e));
+  for (uint32_t i = 0; i < 5; i++) r.record(i, FE_CMD_SENT, 1, (uint16_t)i);
+  CHECK(r.written() == 5 && r.first() == 0);
+  CHECK(r.read(4, e) && e.tUs == 4 && e.type == FE_CMD_SENT && e.a == 1 && e.b == 4);
+  for (uint32_t i = 5; i < 20; i++) r.record(i, FE_ACK, 2, (uint16_t)i);
+  CHECK(r.written() == 20 && r.first() == 12);
+  CHECK(!r.read(11, e) && !r.read(4, e));   // overwritten
+  CHECK(r.read(12, e) && e.tUs == 12 && e.type == FE_ACK);
+  CHECK(r.read(19, e) && e.tUs == 19 && e.b == 19);
+  CHECK(!r.read(20, e));                    // not written yet
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+int main() {
+  checkSequential();
+  checkConcurrent();
+  checkQuiescent();
+  return checkSummary();
+}
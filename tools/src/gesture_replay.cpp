@@ -0,0 +1,163 @@
+// gesture_replay - synthetic button edge sequences through the controller's
+// GestureEngine, checked against the gestures they must (and must not) fire.
+//
+//   gesture_replay             run every scenario, exit 1 on a mismatch
+//   gesture_replay -v          also print the fired gestures of passing ones
+//
+// The table mirrors firmware/controller/src/buttons.cpp (plus a double-tap
+// entry the firmware does not use yet). Edges carry microsecond times as the
+// GPIO ISRs stamp them; the engine is polled once per 1 ms "loop pass", and a
+// gesture is reported at the pass that saw it.
+
+#include "gesture_engine.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define LOOP_US        1000
+#define DEBOUNCE_US    5000     // controller BUTTON_DEBOUNCE_US
+#define HOLD_TO_MENU   600      // controller HOLD_TO_MENU_MS
+#define CALIB_HOLD     5000     // controller CALIBRATION_TRIGGER_TIME
+
+enum { L, R, A };
+
+enum {
+  MENU_HOLD, MENU_PICK, CALIBRATE, L_PRESS, R_PRESS, A_PRESS, R_DOUBLE,
+};
+
+static const GestureSpec table[] = {
+  {GESTURE_HOLD,       1u << R, 1u << L, HOLD_TO_MENU},
+  {GESTURE_RELEASE,    1u << R, 0, 0},
+  {GESTURE_CHORD_HOLD, (1u << L) | (1u << R), 0, CALIB_HOLD},
+  {GESTURE_PRESS,      1u << L, 0, 0},
+  {GESTURE_PRESS,      1u << R, 0, 0},
+  {GESTURE_PRESS,      1u << A, 0, 0},
+  {GESTURE_DOUBLE_TAP, 1u << R, 0, 300},
+};
+
+static const char *names[] = {
+  "MENU_HOLD", "MENU_PICK", "CALIBRATE", "L_PRESS", "R_PRESS", "A_PRESS", "R_DOUBLE",
+};
+
+// ============================================
+// SCENARIOS
+// ============================================
+
+struct Edge {
+  double ms;
+  uint8_t button;
+  uint8_t down;
+};
+
+struct Scenario {
+  const char *name;
+  std::vector<Edge> edges;
+  double runMs;
+  std::vector<std::string> expect;   // "GESTURE@pass_ms", in firing order
+  uint8_t endLevels;
+};
+
+static std::vector<Scenario> scenarios() {
+  return {
+    {"bouncy press and release",
+     {{10.0, R, 1}, {10.3, R, 0}, {10.6, R, 1}, {10.9, R, 0}, {11.2, R, 1},
+      {200.0, R, 0}, {200.2, R, 1}, {200.5, R, 0}},
+     300, {"R_PRESS@10", "MENU_PICK@200"}, 0},
+
+    {"tap shorter than the debounce",
+     {{10.0, R, 1}, {13.0, R, 0}},
+     100, {"R_PRESS@10", "MENU_PICK@15"}, 0},
+
+    {"100 us spike counts as a tap",
+     {{50.0, L, 1}, {50.1, L, 0}},
+     100, {"L_PRESS@50"}, 0},
+
+    {"hold right to open the menu",
+     {{100.0, R, 1}, {900.0, R, 0}},
+     1000, {"R_PRESS@100", "MENU_HOLD@700", "MENU_PICK@900"}, 0},
+
+    {"left joins before the menu hold fires",
+     {{100.0, R, 1}, {400.0, L, 1}, {450.0, L, 0}, {1200.0, R, 0}},
+     1300, {"R_PRESS@100", "L_PRESS@400", "MENU_HOLD@1050", "MENU_PICK@1200"}, 0},
+
+    {"both buttons held for calibration",
+     {{100.0, L, 1}, {300.0, R, 1}, {5400.0, L, 0}, {5410.0, R, 0}},
+     5500, {"L_PRESS@100", "R_PRESS@300", "CALIBRATE@5300", "MENU_PICK@5410"}, 0},
+
+    {"chord broken and restarted",
+     {{100.0, L, 1}, {300.0, R, 1}, {2000.0, L, 0}, {2100.0, L, 1},
+      {3000.0, R, 0}, {3000.0, L, 0}},
+     6000, {"L_PRESS@100", "R_PRESS@300", "L_PRESS@2100", "MENU_PICK@3000"}, 0},
+
+    {"chord held past the calibration fires once",
+     {{100.0, L, 1}, {100.5, R, 1}},
+     15000, {"L_PRESS@100", "R_PRESS@101", "CALIBRATE@5101"}, (1u << L) | (1u << R)},
+
+    {"double tap, then a third tap",
+     {{10.0, R, 1}, {60.0, R, 0}, {200.0, R, 1}, {250.0, R, 0}, {400.0, R, 1}, {450.0, R, 0}},
+     600, {"R_PRESS@10", "MENU_PICK@60", "R_PRESS@200", "R_DOUBLE@200", "MENU_PICK@250",
+           "R_PRESS@400", "MENU_PICK@450"}, 0},
+
+    {"two taps too far apart",
+     {{10.0, R, 1}, {60.0, R, 0}, {400.0, R, 1}, {450.0, R, 0}},
+     600, {"R_PRESS@10", "MENU_PICK@60", "R_PRESS@400", "MENU_PICK@450"}, 0},
+
+    {"AUX switch left on",
+     {{50.0, A, 1}, {50.2, A, 0}, {50.4, A, 1}},
+     200, {"A_PRESS@50"}, 1u << A},
+  };
+}
+
+// ============================================
+// REPLAY
+// ============================================
+
+static bool run(const Scenario &s, bool verbose) {
+  GestureEngine engine;
+  engine.begin(table, sizeof(table) / sizeof(table[0]), DEBOUNCE_US);
+
+  // Start the clock near the 32-bit wrap, as micros() will be after 71 min.
+  const uint32_t base = 0xFFFFFFFFu - 2000000u;
+  std::vector<std::string> fired;
+  size_t next = 0;
+  uint32_t passes = (uint32_t)(s.runMs * 1000 / LOOP_US);
+  for (uint32_t p = 0; p <= passes; p++) {
+    uint32_t nowUs = p * LOOP_US;
+    while (next < s.edges.size() && (uint32_t)(s.edges[next].ms * 1000 + 0.5) <= nowUs) {
+      const Edge &e = s.edges[next++];
+      engine.edge({base + (uint32_t)(e.ms * 1000 + 0.5), e.button, e.down});
+    }
+    uint32_t mask = engine.poll(base + nowUs);
+    for (unsigned g = 0; g < sizeof(table) / sizeof(table[0]); g++) {
+      if (mask & (1u << g)) fired.push_back(std::string(names[g]) + "@" + std::to_string(nowUs / 1000));
+    }
+  }
+
+  bool ok = fired == s.expect && engine.levels() == s.endLevels;
+  printf("%s  %s (bounces %u)\n", ok ? "PASS" : "FAIL", s.name, engine.bounces());
+  if (!ok || verbose) {
+    printf("      expected:");
+    for (const std::string &f : s.expect) printf(" %s", f.c_str());
+    printf("  levels 0x%02x\n      observed:", s.endLevels);
+    for (const std::string &f : fired) printf(" %s", f.c_str());
+    printf("  levels 0x%02x\n", engine.levels());
+  }
+  return ok;
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+int main(int argc, char **argv) {
+  bool verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+  int failed = 0;
+  std::vector<Scenario> all = scenarios();
+  for (const Scenario &s : all) {
+    if (!run(s, verbose)) failed++;
+  }
+  printf("\n%d/%zu scenarios passed\n", (int)all.size() - failed, all.size());
+  return failed ? 1 : 0;
+}
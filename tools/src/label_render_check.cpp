@@ -0,0 +1,301 @@
+// label_render_check - the controller's cached label blit (label_blit.h)
+// against print() on a host model of the SSD1306 page buffer: the frames
+// the display code draws, and every label at every row and many columns,
+// must come out pixel-identical in both rotations. Times both paths.
+//
+//   label_render_check          run every check, exit 1 on a failure
+//
+// print() is modelled on Adafruit GFX with the classic font at size 1:
+// write() wraps at the right edge, drawChar() draws 5 columns of 8 pixels
+// and skips clear ones, and the SSD1306 drawPixel() clips, applies the
+// rotation and sets one bit in the page buffer. The glyph bitmaps are
+// generated, not the real font: both paths draw from the same table, and
+// using all 8 rows of every column checks the page straddling harder than
+// the real glyphs would.
+
+#include "check.h"
+#include "label_blit.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define SCREEN_WIDTH 128
+#define SCREEN_HEIGHT 64
+#define MENU_FIRST_ROW_Y 14        // controller config.h
+#define MENU_ROW_HEIGHT 10
+
+// ============================================
+// GFX MODEL
+// ============================================
+
+static uint8_t font[256 * 5];
+
+static void makeFont() {
+  uint32_t s = 0x2545F491;
+  for (int i = 0; i < 256 * 5; i++) {
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    font[i] = (uint8_t)s;
+  }
+  memset(font + ' ' * 5, 0, 5);
+}
+
+class HostGfx {
+public:
+  HostGfx(int w, int h) : WIDTH(w), HEIGHT(h), _width(w), _height(h) {}
+  virtual ~HostGfx() {}
+  virtual void drawPixel(int x, int y) = 0;
+
+  void setCursor(int x, int y) { _cx = x; _cy = y; }
+  void setTextWrap(bool w) { _wrap = w; }
+  void print(const char *s) { while (*s) write((uint8_t)*s++); }
+
+protected:
+  void write(uint8_t c) {
+    if (_wrap && _cx + 6 > _width) {
+      _cx = 0;
+      _cy += 8;
+    }
+    drawChar(_cx, _cy, c);
+    _cx += 6;
+  }
+
+  void drawChar(int x, int y, uint8_t c) {
+    if (x >= _width || y >= _height || x + 6 - 1 < 0 || y + 8 - 1 < 0) return;
+    for (int i = 0; i < 5; i++) {
+      uint8_t line = font[c * 5 + i];
+      for (int j = 0; j < 8; j++, line >>= 1) {
+        if (line & 1) drawPixel(x + i, y + j);
+      }
+    }
+  }
+
+  const int WIDTH, HEIGHT;   // physical
+  int _width, _height;       // after rotation
+  int _cx = 0, _cy = 0;
+  bool _wrap = true;
+};
+
+// GFXcanvas1 as renderLabel() uses it: unrotated, one bit per pixel.
+class HostCanvas : public HostGfx {
+public:
+  HostCanvas(int w, int h) : HostGfx(w, h), _bits((w + 7) / 8 * h, 0) {}
+  void drawPixel(int x, int y) override {
+    if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) return;
+    _bits[y * ((WIDTH + 7) / 8) + x / 8] |= 0x80 >> (x & 7);
+  }
+  bool getPixel(int x, int y) const {
+    return _bits[y * ((WIDTH + 7) / 8) + x / 8] & (0x80 >> (x & 7));
+  }
+
+private:
+  std::vector<uint8_t> _bits;
+};
+
+class HostSsd1306 : public HostGfx {
+public:
+  HostSsd1306() : HostGfx(SCREEN_WIDTH, SCREEN_HEIGHT) {}
+  void setRotation(int r) {
+    _rotation = r;
+    bool swap = r & 1;
+    _width = swap ? HEIGHT : WIDTH;
+    _height = swap ? WIDTH : HEIGHT;
+  }
+  int getRotation() const { return _rotation; }
+  void clearDisplay() { memset(buffer, 0, sizeof(buffer)); }
+  uint8_t *getBuffer() { return buffer; }
+
+  void drawPixel(int x, int y) override {
+    if (x < 0 || x >= _width || y < 0 || y >= _height) return;
+    if (_rotation == 2) {
+      x = WIDTH - x - 1;
+      y = HEIGHT - y - 1;
+    }
+    buffer[x + (y / 8) * WIDTH] |= 1 << (y & 7);
+  }
+
+  uint8_t buffer[SCREEN_WIDTH * SCREEN_HEIGHT / 8];
+
+private:
+  int _rotation = 0;
+};
+
+// ============================================
+// LABELS
+// ============================================
+// The controller's label texts and a set of device names, rasterised the
+// way buildCache() does for the current rotation.
+
+static const char *const texts[] = {
+  "MOVE", "TURN", "L", "R", "A", "REC", "PLAY",
+  "SELECT DEVICE", "release = pick", ">", "*", "OK",
+  "list", "qual", "seen",
+  "Mecanum-1", "Rover 42", "Arm_B", "Test RX", "Crawler",
+};
+#define NUM_TEXTS (int)(sizeof(texts) / sizeof(texts[0]))
+enum { T_MOVE, T_TURN, T_L, T_R, T_A, T_REC, T_PLAY, T_TITLE, T_HINT, T_CURSOR, T_STAR, T_OK,
+       T_LIST, T_QUAL, T_SEEN, T_NAME0 };
+
+struct Cached {
+  std::vector<uint8_t> cols;
+};
+
+static std::vector<Cached> buildLabels(bool flip) {
+  std::vector<Cached> out(NUM_TEXTS);
+  for (int i = 0; i < NUM_TEXTS; i++) {
+    int w = strlen(texts[i]) * 6;
+    HostCanvas canvas(w, 8);
+    canvas.setTextWrap(false);
+    canvas.print(texts[i]);
+    out[i].cols.resize(w);
+    labelColumns(canvas, w, flip, out[i].cols.data());
+  }
+  return out;
+}
+
+static int width(int t) { return strlen(texts[t]) * 6; }
+
+struct Placement {
+  int text, x, y;
+};
+
+// drawJoystickBars(), drawButtonStatus() and drawESPNowStatus() while
+// recording, with the name of the selected device.
+static std::vector<Placement> driveFrame() {
+  return {
+    {T_NAME0, 0, 0}, {T_REC, 92, 0},
+    {T_MOVE, 4 + (38 - width(T_MOVE)) / 2, 13 + 38 + 2},
+    {T_TURN, 86 + (38 - width(T_TURN)) / 2, 13 + 38 + 2},
+    {T_L, 50, 17}, {T_R, 50, 30}, {T_A, 50, 43},
+  };
+}
+
+// displayDeviceMenu() with four rows, the second highlighted and selected.
+static std::vector<Placement> menuFrame() {
+  std::vector<Placement> v = {
+    {T_TITLE, 0, 0}, {T_QUAL, 128 - width(T_QUAL), 0}, {T_HINT, 0, 56},
+  };
+  for (int row = 0; row < 4; row++) {
+    int y = MENU_FIRST_ROW_Y + row * MENU_ROW_HEIGHT;
+    int name = T_NAME0 + 1 + row;
+    if (row == 1) {
+      v.push_back({T_CURSOR, 0, y});
+      v.push_back({T_STAR, 18 + width(name), y});
+    }
+    v.push_back({name, 12, y});
+    v.push_back({T_OK, 110, y});
+  }
+  return v;
+}
+
+static void drawBlit(HostSsd1306 &d, const std::vector<Cached> &labels, const std::vector<Placement> &f) {
+  for (const Placement &p : f) {
+    const Cached &c = labels[p.text];
+    labelBlit(d.getBuffer(), SCREEN_WIDTH, SCREEN_HEIGHT, c.cols.data(), (int)c.cols.size(), p.x, p.y,
+              d.getRotation() == 2);
+  }
+}
+
+static void drawPrint(HostSsd1306 &d, const std::vector<Placement> &f) {
+  for (const Placement &p : f) {
+    d.setCursor(p.x, p.y);
+    d.print(texts[p.text]);
+  }
+}
+
+static bool identical(int rotation, const std::vector<Cached> &labels, const std::vector<Placement> &f) {
+  static HostSsd1306 a, b;
+  a.setRotation(rotation);
+  b.setRotation(rotation);
+  a.clearDisplay();
+  b.clearDisplay();
+  drawBlit(a, labels, f);
+  drawPrint(b, f);
+  return memcmp(a.buffer, b.buffer, sizeof(a.buffer)) == 0;
+}
+
+// ============================================
+// CHECKS
+// ============================================
+
+static void checkFrames() {
+  printf("display frames\n");
+  for (int rotation : {0, 2}) {
+    std::vector<Cached> labels = buildLabels(rotation == 2);
+    CHECK(identical(rotation, labels, driveFrame()));
+    CHECK(identical(rotation, labels, menuFrame()));
+  }
+}
+
+// Every label alone at every row from fully above to fully below the panel,
+// and at columns from partly off the left edge to flush with the right one
+// (print() wraps where the blit clips, so nothing is placed past it).
+static void checkPlacements() {
+  printf("every label, row and page offset\n");
+  int placements = 0, differ = 0;
+  for (int rotation : {0, 2}) {
+    std::vector<Cached> labels = buildLabels(rotation == 2);
+    for (int t = 0; t < NUM_TEXTS; t++) {
+      for (int y = -9; y <= SCREEN_HEIGHT + 1; y++) {
+        for (int x = -13; x <= SCREEN_WIDTH - width(t); x += 5) {
+          placements++;
+          if (!identical(rotation, labels, {{t, x, y}})) differ++;
+        }
+        placements++;
+        if (!identical(rotation, labels, {{t, SCREEN_WIDTH - width(t), y}})) differ++;
+      }
+    }
+  }
+  printf("  %d placements, %d differ\n", placements, differ);
+  CHECK(differ == 0);
+
+  // Overlapping labels OR together the same way.
+  std::vector<Cached> labels = buildLabels(true);
+  CHECK(identical(2, labels, {{T_TITLE, 0, 3}, {T_HINT, 4, 6}, {T_MOVE, 2, 9}}));
+}
+
+static void bench() {
+  printf("frame timing\n");
+  const int frames = 20000;
+  HostSsd1306 d;
+  d.setRotation(2);
+  std::vector<Cached> labels = buildLabels(true);
+  using clock = std::chrono::steady_clock;
+  struct { const char *name; std::vector<Placement> f; } cases[] = {
+    {"drive", driveFrame()}, {"menu", menuFrame()},
+  };
+  for (auto &c : cases) {
+    uint32_t sink = 0;
+    auto t0 = clock::now();
+    for (int i = 0; i < frames; i++) {
+      d.clearDisplay();
+      drawBlit(d, labels, c.f);
+      sink += d.buffer[i % sizeof(d.buffer)];
+    }
+    double blitUs = std::chrono::duration<double, std::micro>(clock::now() - t0).count() / frames;
+    t0 = clock::now();
+    for (int i = 0; i < frames; i++) {
+      d.clearDisplay();
+      drawPrint(d, c.f);
+      sink += d.buffer[i % sizeof(d.buffer)];
+    }
+    double printUs = std::chrono::duration<double, std::micro>(clock::now() - t0).count() / frames;
+    printf("  %-5s labels: blit %6.3f us, print() %6.3f us per frame (%.1fx)  [%u]\n",
+           c.name, blitUs, printUs, printUs / blitUs, sink & 0xFF);
+  }
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+int main() {
+  makeFont();
+  checkFrames();
+  checkPlacements();
+  bench();
+  return checkSummary();
+}
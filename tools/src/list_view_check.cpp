@@ -0,0 +1,211 @@
+// list_view_check - the controller's device menu model (ListView) with long
+// lists: scrolling, sorting, highlight tracking and redraw tracking, then
+// the cost of one update() pass.
+//
+//   list_view_check             run every check, exit 1 on a failure
+//
+// The device menu shows 4 rows; the checks use the same window over lists
+// of up to LIST_MAX_ITEMS devices.
+
+#include "check.h"
+#include "list_view.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ROWS 4
+
+static ListItem items[LIST_MAX_ITEMS];
+
+static void makeItems(int n) {
+  for (int i = 0; i < n; i++) {
+    items[i].quality = (uint8_t)((i * 37) % 101);
+    items[i].lastSeenMs = i % 5 == 0 ? 0 : 1000 + (uint32_t)((i * 53) % 97) * 10;
+    items[i].status = 0;
+  }
+}
+
+// The highlight is on a visible row and the window is inside the list.
+static bool inView(const ListView &v) {
+  int rows = v.visibleRows();
+  return v.position() >= v.top() && v.position() < v.top() + rows &&
+         v.top() >= 0 && v.top() + rows <= v.count();
+}
+
+// ============================================
+// CHECKS
+// ============================================
+
+static void checkScrolling() {
+  printf("scrolling\n");
+  ListView v;
+  v.begin(ROWS);
+  makeItems(40);
+  v.update(items, 40, 2000);
+  CHECK(v.count() == 40 && v.highlighted() == 0 && v.top() == 0);
+
+  // Every item is reachable, one step at a time, with the highlight in view.
+  bool seen[40] = {};
+  for (int i = 0; i < 40; i++) {
+    CHECK(inView(v));
+    int h = v.highlighted();
+    if (h >= 0) seen[h] = true;
+    v.move(+1);
+  }
+  for (bool s : seen) CHECK(s);
+  CHECK(v.highlighted() == 0 && v.top() == 0);   // wrapped to the top
+
+  v.move(-1);                                    // wraps to the bottom
+  CHECK(v.highlighted() == 39 && v.top() == 40 - ROWS && inView(v));
+  v.move(-2);
+  CHECK(v.top() == 40 - ROWS);                   // still in the window: no scroll
+  v.move(-3);
+  CHECK(v.position() == 34 && v.top() == 34 && inView(v));
+
+  v.select(20);
+  CHECK(v.highlighted() == 20 && inView(v));
+
+  // Fewer items than rows, and an empty list.
+  v.update(items, 2, 2000);
+  CHECK(v.count() == 2 && v.visibleRows() == 2 && v.top() == 0 && inView(v));
+  CHECK(v.itemAt(2) == -1);
+  v.move(+1);
+  v.move(+1);
+  CHECK(v.highlighted() == 0);
+  v.update(items, 0, 2000);
+  CHECK(v.highlighted() == -1 && v.visibleRows() == 0);
+  v.move(+1);
+  CHECK(v.highlighted() == -1);
+}
+
+static void checkSorting() {
+  printf("sorting\n");
+  ListView v;
+  v.begin(ROWS);
+  makeItems(30);
+  v.update(items, 30, 2000);
+  v.select(17);
+
+  v.setSort(LIST_SORT_QUALITY);
+  CHECK(v.highlighted() == 17 && inView(v));     // highlight follows its item
+  // Walk the order from the top and check it is by quality, ties by index.
+  v.move(-v.position());
+  int prev = v.highlighted();
+  for (int p = 1; p < 30; p++) {
+    v.move(+1);
+    int cur = v.highlighted();
+    if (prev < 0 || cur < 0) { CHECK(false); break; }
+    CHECK(items[prev].quality > items[cur].quality ||
+          (items[prev].quality == items[cur].quality && prev < cur));
+    prev = cur;
+  }
+
+  v.setSort(LIST_SORT_LAST_SEEN);
+  v.move(-v.position());
+  prev = v.highlighted();
+  bool neverSeen = false;
+  for (int p = 1; p < 30; p++) {
+    v.move(+1);
+    int cur = v.highlighted();
+    if (prev < 0 || cur < 0) { CHECK(false); break; }
+    if (items[cur].lastSeenMs == 0) neverSeen = true;
+    else CHECK(!neverSeen && items[prev].lastSeenMs >= items[cur].lastSeenMs);   // never-heard last
+    prev = cur;
+  }
+
+  // Newer across a millis() wrap: seen 5 ms before the wrap is older than
+  // seen 5 ms after it.
+  ListItem wrap[2] = {{50, 0xFFFFFFFBu, 0}, {50, 5, 0}};
+  v.update(wrap, 2, 10);
+  v.move(-v.position());
+  CHECK(v.highlighted() == 1);
+
+  // Keys change while a highlighted item moves down the order.
+  v.setSort(LIST_SORT_QUALITY);
+  makeItems(30);
+  v.update(items, 30, 2000);
+  v.select(5);
+  items[5].quality = 0;
+  v.update(items, 30, 2000);
+  CHECK(v.highlighted() == 5 && inView(v));
+  items[5].quality = 100;
+  v.update(items, 30, 2000);
+  CHECK(v.highlighted() == 5 && v.position() == 0 && v.top() == 0);
+}
+
+static void checkRedraw() {
+  printf("redraw tracking\n");
+  ListView v;
+  v.begin(ROWS);
+  makeItems(20);
+  v.update(items, 20, 2000);
+  CHECK(v.dirty() && v.frameDirty());
+  v.drawn();
+  CHECK(!v.dirty());
+
+  // Same data again: nothing to draw.
+  v.update(items, 20, 2000);
+  CHECK(!v.dirty());
+
+  // A status change off screen draws nothing; on screen only that row.
+  items[15].status = 3;
+  v.update(items, 20, 2000);
+  CHECK(!v.dirty());
+  items[2].status = 1;
+  v.update(items, 20, 2000);
+  CHECK(v.dirty() && !v.frameDirty());
+  CHECK(!v.rowDirty(0) && !v.rowDirty(1) && v.rowDirty(2) && !v.rowDirty(3));
+  v.drawn();
+
+  // Moving inside the window redraws the two rows the cursor left/entered.
+  v.move(+1);
+  CHECK(!v.frameDirty() && v.rowDirty(0) && v.rowDirty(1) && !v.rowDirty(2) && !v.rowDirty(3));
+  v.drawn();
+
+  // Scrolling redraws the whole frame (scroll bar moves).
+  v.move(+3);
+  CHECK(v.frameDirty());
+  v.drawn();
+  CHECK(!v.dirty());
+
+  // A new sort order, or a different device count, redraws everything.
+  v.setSort(LIST_SORT_LAST_SEEN);
+  CHECK(v.frameDirty());
+  v.drawn();
+  v.update(items, 19, 2000);
+  CHECK(v.frameDirty());
+  v.drawn();
+  v.invalidate();
+  CHECK(v.frameDirty());
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+int main() {
+  checkScrolling();
+  checkSorting();
+  checkRedraw();
+  int status = checkSummary();
+
+  // One menu pass with a full list: refresh keys, re-sort, check dirty.
+  ListView v;
+  v.begin(ROWS);
+  v.setSort(LIST_SORT_QUALITY);
+  makeItems(LIST_MAX_ITEMS);
+  const int passes = 200000;
+  volatile int sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int p = 0; p < passes; p++) {
+    items[p % LIST_MAX_ITEMS].quality = (uint8_t)(rand() % 101);   // one link changes per pass
+    v.update(items, LIST_MAX_ITEMS, 2000 + p);
+    sink += v.dirty();
+    v.drawn();
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  printf("update + dirty, %d items: %.0f ns per pass on this host\n", LIST_MAX_ITEMS,
+         std::chrono::duration<double, std::nano>(t1 - t0).count() / passes);
+  return status;
+}
@@ -0,0 +1,273 @@
+// macro_codec_check - the controller's macro log codec (MacroEncoder /
+// MacroDecoder): synthetic sessions round-trip exactly, edge cases (empty
+// macro, longest run, largest sample, extreme values and dt) decode back,
+// corrupt or truncated input is refused, and encode/decode throughput.
+//
+//   macro_codec_check           run every check, exit 1 on a failure
+//
+// Encoded streams are decoded one byte at a time, as the replay does from
+// its flash buffers.
+
+#include "check.h"
+#include "macro_codec.h"
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define TICK_MS 20
+
+// ============================================
+// HELPERS
+// ============================================
+
+static bool same(const MacroSample &a, const MacroSample &b) {
+  return a.dtMs == b.dtMs && a.x == b.x && a.y == b.y && a.rot == b.rot &&
+         a.speed == b.speed && a.buttons == b.buttons;
+}
+
+// Whole session through the encoder, flush included. Fails the check if a
+// single encode() writes more than MACRO_MAX_ENCODED bytes.
+static std::vector<uint8_t> encodeAll(const std::vector<MacroSample> &in) {
+  MacroEncoder enc;
+  enc.begin(TICK_MS);
+  std::vector<uint8_t> out;
+  uint8_t buf[MACRO_MAX_ENCODED + 8];
+  size_t worst = 0;
+  for (const MacroSample &s : in) {
+    memset(buf, 0xEE, sizeof(buf));
+    size_t n = enc.encode(s, buf);
+    if (n > worst) worst = n;
+    out.insert(out.end(), buf, buf + n);
+  }
+  size_t n = enc.flush(buf);
+  out.insert(out.end(), buf, buf + n);
+  CHECK(worst <= MACRO_MAX_ENCODED);
+  return out;
+}
+
+// Samples decoded, runs expanded. -1 on a malformed stream, -2 when the
+// stream ends mid-sample.
+static int decodeAll(const std::vector<uint8_t> &in, std::vector<MacroSample> &out) {
+  MacroDecoder dec;
+  dec.begin(TICK_MS);
+  out.clear();
+  for (uint8_t b : in) {
+    int r = dec.push(b);
+    if (r < 0) return -1;
+    for (int i = 0; i < r; i++) out.push_back(dec.sample());
+  }
+  return dec.idle() ? 0 : -2;
+}
+
+static bool roundTrips(const std::vector<MacroSample> &in, size_t *bytes = nullptr) {
+  std::vector<uint8_t> enc = encodeAll(in);
+  if (bytes) *bytes = enc.size();
+  std::vector<MacroSample> dec;
+  if (decodeAll(enc, dec) != 0 || dec.size() != in.size()) return false;
+  for (size_t i = 0; i < in.size(); i++) {
+    if (!same(in[i], dec[i])) return false;
+  }
+  return true;
+}
+
+static MacroSample sample(uint16_t dt, int x, int y, int rot, int speed, int buttons) {
+  MacroSample s;
+  s.dtMs = dt;
+  s.x = (int8_t)x;
+  s.y = (int8_t)y;
+  s.rot = (int8_t)rot;
+  s.speed = (uint8_t)speed;
+  s.buttons = (uint8_t)buttons;
+  return s;
+}
+
+// Driving as recorded: sticks held for a while then moved, the tick mostly
+// on time with the odd late loop, buttons rarely.
+static std::vector<MacroSample> session(size_t n, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::vector<MacroSample> v;
+  MacroSample s = sample(TICK_MS, 0, 0, 0, 50, 0);
+  for (size_t i = 0; i < n; i++) {
+    if (rng() % 8 == 0) {
+      s.x = (int8_t)(rng() % 201 - 100);
+      s.y = (int8_t)(rng() % 201 - 100);
+    }
+    if (rng() % 20 == 0) s.rot = (int8_t)(rng() % 201 - 100);
+    if (rng() % 500 == 0) s.speed = (uint8_t)(rng() % 101);
+    if (rng() % 300 == 0) s.buttons = (uint8_t)(rng() % 8);
+    s.dtMs = rng() % 30 == 0 ? (uint16_t)(TICK_MS + rng() % 40) : TICK_MS;
+    v.push_back(s);
+  }
+  return v;
+}
+
+// ============================================
+// CHECKS
+// ============================================
+
+static void checkSessions() {
+  printf("synthetic sessions\n");
+  for (uint32_t seed = 1; seed <= 20; seed++) {
+    size_t bytes;
+    std::vector<MacroSample> v = session(5000, seed);
+    CHECK(roundTrips(v, &bytes));
+    if (seed == 1) printf("  5000 samples -> %zu bytes (%.2f per sample)\n", bytes, (double)bytes / 5000);
+  }
+
+  // Every field changing every sample, with random dt, from the full int8 range.
+  std::mt19937 rng(7);
+  std::vector<MacroSample> v;
+  for (int i = 0; i < 20000; i++) {
+    v.push_back(sample((uint16_t)rng(), (int)(rng() % 256) - 128, (int)(rng() % 256) - 128,
+                       (int)(rng() % 256) - 128, rng() % 256, rng() % 256));
+  }
+  CHECK(roundTrips(v));
+}
+
+static void checkEdges() {
+  printf("edge cases\n");
+  std::vector<MacroSample> v;
+  std::vector<uint8_t> enc = encodeAll(v);
+  std::vector<MacroSample> dec;
+  CHECK(enc.empty() && decodeAll(enc, dec) == 0 && dec.empty());   // empty macro
+
+  // A sample equal to the initial state is a run of one.
+  v = {sample(TICK_MS, 0, 0, 0, 0, 0)};
+  enc = encodeAll(v);
+  CHECK(enc.size() == 1 && enc[0] == (MACRO_FLAG_RUN | 1) && roundTrips(v));
+
+  // Runs at and around the longest a run byte holds.
+  for (size_t n : {(size_t)MACRO_RUN_MAX - 1, (size_t)MACRO_RUN_MAX, (size_t)MACRO_RUN_MAX + 1,
+                   (size_t)2 * MACRO_RUN_MAX, (size_t)100000}) {
+    v.assign(n, sample(TICK_MS, 0, 0, 0, 0, 0));
+    enc = encodeAll(v);
+    CHECK(enc.size() == (n + MACRO_RUN_MAX - 1) / MACRO_RUN_MAX && roundTrips(v));
+  }
+
+  // Largest single sample: pending run, header, three dt bytes, every field.
+  MacroEncoder e;
+  e.begin(TICK_MS);
+  uint8_t buf[MACRO_MAX_ENCODED];
+  MacroSample still = sample(TICK_MS, 0, 0, 0, 0, 0);
+  CHECK(e.encode(still, buf) == 0);
+  CHECK(e.encode(sample(65535, 127, -128, 127, 255, 255), buf) == MACRO_MAX_ENCODED);
+
+  // dt extremes, and swings across the whole int8 range.
+  v = {sample(0, 0, 0, 0, 0, 0), sample(1, 0, 0, 0, 0, 0), sample(127, 0, 0, 0, 0, 0),
+       sample(128, 0, 0, 0, 0, 0), sample(16383, 0, 0, 0, 0, 0), sample(16384, 0, 0, 0, 0, 0),
+       sample(65535, 0, 0, 0, 0, 0), sample(TICK_MS, 127, -128, 127, 0, 0),
+       sample(TICK_MS, -128, 127, -128, 0, 0), sample(TICK_MS, 127, 127, 127, 0, 0)};
+  CHECK(roundTrips(v));
+
+  // A stream decoded across buffer boundaries of every size.
+  v = session(2000, 3);
+  enc = encodeAll(v);
+  for (size_t chunk = 1; chunk <= 7; chunk++) {
+    MacroDecoder d;
+    d.begin(TICK_MS);
+    size_t got = 0, bad = 0;
+    for (size_t at = 0; at < enc.size(); at += chunk) {
+      uint8_t part[8];
+      size_t n = enc.size() - at < chunk ? enc.size() - at : chunk;
+      memcpy(part, &enc[at], n);
+      for (size_t i = 0; i < n; i++) {
+        int r = d.push(part[i]);
+        for (int k = 0; k < r; k++) bad += !same(d.sample(), v[got++]);
+      }
+    }
+    CHECK(got == v.size() && bad == 0 && d.idle());
+  }
+}
+
+static void checkCorrupt() {
+  printf("corrupt input\n");
+  std::vector<MacroSample> dec;
+  CHECK(decodeAll({MACRO_FLAG_RUN}, dec) == -1);                    // run of zero
+  CHECK(decodeAll({0x40}, dec) == -1);                              // reserved bit
+  CHECK(decodeAll({MACRO_FLAG_DT, 0xFF, 0xFF, 0x04}, dec) == -1);   // dt over 16 bits
+  CHECK(decodeAll({MACRO_FLAG_DT, 0xFF, 0xFF, 0x83, 0x00}, dec) == -1);   // varint too long
+  CHECK(decodeAll({MACRO_FLAG_DT, 0xFF, 0xFF, 0x03}, dec) == 0 && dec.size() == 1 && dec[0].dtMs == 65535);
+
+  // Every cut through a session stops either on a sample boundary or
+  // mid-sample, and decodes the samples before the cut unchanged.
+  std::vector<MacroSample> v = session(300, 5);
+  std::vector<uint8_t> enc = encodeAll(v);
+  int wrong = 0, midSample = 0;
+  for (size_t cut = 0; cut < enc.size(); cut++) {
+    std::vector<uint8_t> part(enc.begin(), enc.begin() + cut);
+    int r = decodeAll(part, dec);
+    midSample += r == -2;
+    if (r == -1 || dec.size() > v.size()) { wrong++; continue; }
+    for (size_t i = 0; i < dec.size(); i++) wrong += !same(dec[i], v[i]);
+  }
+  printf("  %zu cuts, %d mid-sample\n", enc.size(), midSample);
+  CHECK(wrong == 0 && midSample > 0);
+
+  // Random bytes: the decoder never reads out of bounds and either refuses
+  // the stream or yields samples; nothing else to hold it to.
+  std::mt19937 rng(11);
+  int refused = 0;
+  for (int run = 0; run < 2000; run++) {
+    std::vector<uint8_t> junk(1 + rng() % 64);
+    for (uint8_t &b : junk) b = (uint8_t)rng();
+    refused += decodeAll(junk, dec) == -1;
+  }
+  printf("  2000 random streams, %d refused\n", refused);
+  CHECK(refused > 0);
+}
+
+static void bench() {
+  printf("throughput\n");
+  // An hour of driving at the 20 ms tick.
+  std::vector<MacroSample> v = session(3600 * 1000 / TICK_MS, 9);
+  using clock = std::chrono::steady_clock;
+
+  std::vector<uint8_t> enc;
+  enc.reserve(v.size() * 2);
+  MacroEncoder e;
+  uint8_t buf[MACRO_MAX_ENCODED];
+  auto t0 = clock::now();
+  e.begin(TICK_MS);
+  for (const MacroSample &s : v) {
+    size_t n = e.encode(s, buf);
+    enc.insert(enc.end(), buf, buf + n);
+  }
+  size_t n = e.flush(buf);
+  enc.insert(enc.end(), buf, buf + n);
+  double encS = std::chrono::duration<double>(clock::now() - t0).count();
+
+  MacroDecoder d;
+  uint64_t samples = 0, check = 0;
+  t0 = clock::now();
+  d.begin(TICK_MS);
+  for (uint8_t b : enc) {
+    int r = d.push(b);
+    if (r > 0) {
+      samples += r;
+      check += (uint8_t)d.sample().x;
+    }
+  }
+  double decS = std::chrono::duration<double>(clock::now() - t0).count();
+
+  printf("  %zu samples -> %zu bytes (%.1f KiB/h, %.2f bytes/sample)\n",
+         v.size(), enc.size(), enc.size() / 1024.0, (double)enc.size() / v.size());
+  printf("  encode %6.1f MB/s out, %6.1f M samples/s\n", enc.size() / encS / 1e6, v.size() / encS / 1e6);
+  printf("  decode %6.1f MB/s in,  %6.1f M samples/s  (check %llu)\n",
+         enc.size() / decS / 1e6, samples / decS / 1e6, (unsigned long long)check);
+  CHECK(samples == v.size());
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+int main() {
+  checkSessions();
+  checkEdges();
+  checkCorrupt();
+  bench();
+  return checkSummary();
+}
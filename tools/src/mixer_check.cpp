@@ -0,0 +1,145 @@
+// mixer_check - the receiver's fixed-point mecanum mixer against the
+// robot's float formula, over every x/y/rot input, then its throughput.
+//
+//   mixer_check                 full sweep + benchmark, exit 1 on a mismatch
+//   mixer_check --ops 50000000  benchmark length
+//
+// The sweep covers all 256^3 x/y/rot values (beyond +-100 they must clamp)
+// at a spread of speeds. Each wheel must be within one duty step of the
+// float result, never exceed speed, keep the float's sign, and the wheel
+// ratios must hold when one wheel saturates.
+
+#include "mecanum_mixer.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// The robot's calculateMotorSpeeds(), in float, with the same
+// normalisation and speed scaling.
+static void floatMix(const ControlCommand &cmd, double out[4]) {
+  double x = fmax(-1.0, fmin(1.0, cmd.x / 100.0));
+  double y = fmax(-1.0, fmin(1.0, cmd.y / 100.0));
+  double r = fmax(-1.0, fmin(1.0, cmd.rot / 100.0));
+  double w[4] = {y + x + r, y - x - r, y - x + r, y + x - r};
+  double peak = 1.0;
+  for (double v : w) peak = fmax(peak, fabs(v));
+  for (int i = 0; i < 4; i++) out[i] = w[i] / peak * cmd.speed;
+}
+
+// ============================================
+// SWEEP
+// ============================================
+
+struct SweepResult {
+  uint64_t commands = 0;
+  uint64_t offByOne = 0;   // wheels one step from the rounded float value
+  uint64_t failures = 0;
+  double maxErr = 0;
+};
+
+static void report(const ControlCommand &c, const char *what, int wheel, int got, double want) {
+  printf("  FAIL x=%d y=%d rot=%d speed=%u wheel %d: %s (got %d, float %.3f)\n",
+         c.x, c.y, c.rot, c.speed, wheel, what, got, want);
+}
+
+static void sweep(uint8_t speed, SweepResult &res) {
+  ControlCommand c = {};
+  c.version = CONTROL_PROTOCOL_VERSION;
+  c.speed = speed;
+  for (int x = -128; x <= 127; x++) {
+    for (int y = -128; y <= 127; y++) {
+      for (int r = -128; r <= 127; r++) {
+        c.x = (int8_t)x;
+        c.y = (int8_t)y;
+        c.rot = (int8_t)r;
+        WheelDuty d = mecanumMix(c);
+        int got[4] = {d.fl, d.fr, d.bl, d.br};
+        double want[4];
+        floatMix(c, want);
+        res.commands++;
+        for (int i = 0; i < 4; i++) {
+          double err = fabs(got[i] - want[i]);
+          if (err > res.maxErr) res.maxErr = err;
+          if (got[i] != (int)lround(want[i])) res.offByOne++;
+          const char *bad = nullptr;
+          if (err > 1.0) bad = "more than one step off";
+          else if (abs(got[i]) > speed) bad = "beyond speed";
+          else if (got[i] != 0 && (got[i] < 0) != (want[i] < 0)) bad = "wrong direction";
+          if (bad) {
+            if (res.failures < 10) report(c, bad, i, got[i], want[i]);
+            res.failures++;
+          }
+        }
+        // Saturated: the largest wheel is at full speed.
+        double peak = 0;
+        int peakGot = 0;
+        for (int i = 0; i < 4; i++) {
+          if (fabs(want[i]) > peak) peak = fabs(want[i]);
+          if (abs(got[i]) > peakGot) peakGot = abs(got[i]);
+        }
+        if (abs(x) + abs(y) + abs(r) > 0 && fabs(peak - speed) < 1e-9 && peakGot != speed) {
+          if (res.failures < 10) report(c, "saturated peak below speed", -1, peakGot, peak);
+          res.failures++;
+        }
+      }
+    }
+  }
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+int main(int argc, char **argv) {
+  uint64_t ops = 50000000;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--ops") == 0 && i + 1 < argc) ops = strtoull(argv[++i], nullptr, 10);
+    else {
+      fprintf(stderr, "usage: %s [--ops N]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  static const uint8_t speeds[] = {0, 1, 37, 100, 128, 200, 254, 255};
+  SweepResult res;
+  for (uint8_t s : speeds) sweep(s, res);
+  printf("Sweep: %llu commands x 4 wheels, max error %.3f steps, %.3f%% not the rounded float value, %llu failures\n",
+         (unsigned long long)res.commands, res.maxErr,
+         100.0 * res.offByOne / (res.commands * 4), (unsigned long long)res.failures);
+
+  // Throughput over a fixed mix of commands, so the compiler cannot fold them.
+  std::vector<ControlCommand> cmds(4096);
+  srand(1);
+  for (ControlCommand &c : cmds) {
+    c.version = CONTROL_PROTOCOL_VERSION;
+    c.x = (int8_t)(rand() % 201 - 100);
+    c.y = (int8_t)(rand() % 201 - 100);
+    c.rot = (int8_t)(rand() % 201 - 100);
+    c.speed = (uint8_t)(rand() % 256);
+  }
+  volatile int32_t sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < ops; i++) {
+    WheelDuty d = mecanumMix(cmds[i & 4095]);
+    sink += d.fl + d.fr + d.bl + d.br;
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  double fixedNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / ops;
+
+  t0 = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < ops; i++) {
+    double w[4];
+    floatMix(cmds[i & 4095], w);
+    sink += (int32_t)(w[0] + w[1] + w[2] + w[3]);
+  }
+  t1 = std::chrono::steady_clock::now();
+  double floatNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / ops;
+
+  printf("Fixed point: %6.2f ns/command  %6.1f M commands/s\n", fixedNs, 1000.0 / fixedNs);
+  printf("Float (ref): %6.2f ns/command  %6.1f M commands/s\n", floatNs, 1000.0 / floatNs);
+  return res.failures ? 1 : 0;
+}
@@ -0,0 +1,150 @@
+// param_check - the controller's parameter table and ParamStore against a
+// fake NVS (a map with the Preferences calls ParamStore uses).
+//
+//   param_check             run every check, exit 1 on a failure
+//
+// Covers the table itself (defaults inside their bounds, NVS keys short
+// enough, no duplicate names) and the store: first boot, SET bounds, dirty
+// tracking, SAVE/load roundtrip, a schema bump, and out-of-range values
+// left in NVS by older firmware.
+
+#include "check.h"
+#include "params.h"
+
+#include <map>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+class FakePreferences {
+public:
+  bool isKey(const char *key) { return _ints.count(key) || _ushorts.count(key); }
+  int32_t getInt(const char *key, int32_t def) {
+    auto it = _ints.find(key);
+    return it == _ints.end() ? def : it->second;
+  }
+  size_t putInt(const char *key, int32_t v) { _ints[key] = v; writes++; return 4; }
+  uint16_t getUShort(const char *key, uint16_t def) {
+    auto it = _ushorts.find(key);
+    return it == _ushorts.end() ? def : it->second;
+  }
+  size_t putUShort(const char *key, uint16_t v) { _ushorts[key] = v; writes++; return 2; }
+  bool clear() { _ints.clear(); _ushorts.clear(); return true; }
+
+  int writes = 0;
+
+private:
+  std::map<std::string, int32_t> _ints;
+  std::map<std::string, uint16_t> _ushorts;
+};
+
+static const ParamInfo defs[] = PARAMS_TABLE(ControllerParams, CONTROLLER_PARAMS);
+static const int numDefs = sizeof(defs) / sizeof(defs[0]);
+
+// ============================================
+// CHECKS
+// ============================================
+
+static void checkTable() {
+  printf("table\n");
+  for (int i = 0; i < numDefs; i++) {
+    const ParamInfo &p = defs[i];
+    CHECK(ParamStore::valid(p, p.def));
+    CHECK(p.min <= p.max);
+    CHECK(strlen(p.key) <= 15);                    // NVS key limit
+    CHECK(strcmp(p.key, PARAM_SCHEMA_KEY) != 0);
+    for (int j = 0; j < i; j++) {
+      CHECK(strcasecmp(p.key, defs[j].key) != 0);
+      CHECK(strcasecmp(p.name, defs[j].name) != 0);
+    }
+  }
+  // The struct initialisers and the table agree.
+  ControllerParams v;
+  ParamStore store(defs, numDefs, &v, PARAMS_SCHEMA);
+  for (int i = 0; i < numDefs; i++) CHECK(store.get(i) == defs[i].def);
+}
+
+static void checkSet() {
+  printf("set\n");
+  ControllerParams v;
+  ParamStore store(defs, numDefs, &v, PARAMS_SCHEMA);
+  int send = store.find("SEND_MS");
+  CHECK(send >= 0 && store.find("sendIntervalMs") == send);
+  CHECK(store.find("nope") == -1);
+  CHECK(store.set(-1, 0) == PARAM_UNKNOWN);
+  CHECK(!store.dirty());
+
+  const ParamInfo &p = store.info(send);
+  CHECK(store.set(send, p.min - 1) == PARAM_OUT_OF_RANGE);
+  CHECK(store.set(send, p.max + 1) == PARAM_OUT_OF_RANGE);
+  CHECK(!store.dirty());
+  CHECK(store.set(send, p.def) == PARAM_OK);
+  CHECK(!store.dirty());                           // same value: nothing to save
+  CHECK(store.set(send, p.max) == PARAM_OK);
+  CHECK(store.dirty() && v.sendIntervalMs == p.max);
+
+  int sign = store.find("sign_y");
+  CHECK(store.set(sign, 0) == PARAM_OUT_OF_RANGE);
+  CHECK(store.set(sign, 2) == PARAM_OUT_OF_RANGE);
+  CHECK(store.set(sign, 1) == PARAM_OK && v.signY == 1);
+
+  store.resetDefaults();
+  CHECK(v.sendIntervalMs == p.def && v.signY == defs[sign].def);
+}
+
+static void checkPersistence() {
+  printf("persistence\n");
+  FakePreferences nvs;
+  ControllerParams v;
+  ParamStore store(defs, numDefs, &v, PARAMS_SCHEMA);
+
+  CHECK(store.load(nvs) == PARAM_NOTHING_STORED);
+  CHECK(v.deadzone == defs[store.find("deadzone")].def);
+
+  store.set(store.find("deadzone"), 120);
+  store.set(store.find("sign_x"), -1);
+  store.save(nvs);
+  CHECK(!store.dirty());
+  CHECK(nvs.writes == numDefs + 1);
+
+  // Fresh boot: values come back, dirty is clear.
+  ControllerParams w;
+  ParamStore again(defs, numDefs, &w, PARAMS_SCHEMA);
+  CHECK(again.load(nvs) == PARAM_LOADED);
+  CHECK(w.deadzone == 120 && w.signX == -1 && w.linkOkMs == v.linkOkMs);
+  CHECK(!again.dirty() && again.rejected() == 0);
+
+  // A value out of the current bounds (saved when they were wider) and a
+  // key that was never written both fall back to their defaults.
+  nvs.putInt("speed", 9999);
+  FakePreferences partial = nvs;
+  ControllerParams x;
+  ParamStore third(defs, numDefs, &x, PARAMS_SCHEMA);
+  CHECK(third.load(partial) == PARAM_LOADED);
+  CHECK(third.rejected() == 1);
+  CHECK(x.defaultSpeed == defs[third.find("speed")].def && x.deadzone == 120);
+
+  // Another schema: everything stored is ignored.
+  ControllerParams y;
+  ParamStore bumped(defs, numDefs, &y, PARAMS_SCHEMA + 1);
+  CHECK(bumped.load(nvs) == PARAM_SCHEMA_MISMATCH);
+  CHECK(y.deadzone == defs[bumped.find("deadzone")].def && y.signX == defs[bumped.find("sign_x")].def);
+
+  // Load overwrites unsaved changes and clears dirty.
+  bumped.set(bumped.find("deadzone"), 300);
+  CHECK(bumped.dirty());
+  bumped.load(nvs);
+  CHECK(!bumped.dirty() && y.deadzone == defs[bumped.find("deadzone")].def);
+
+  // Save under the new schema rewrites the namespace.
+  bumped.save(nvs);
+  CHECK(third.load(nvs) == PARAM_SCHEMA_MISMATCH);
+  CHECK(bumped.load(nvs) == PARAM_LOADED && bumped.rejected() == 0);
+}
+
+int main() {
+  checkTable();
+  checkSet();
+  checkPersistence();
+  return checkSummary();
+}
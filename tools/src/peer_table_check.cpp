@@ -0,0 +1,188 @@
+// peer_table_check - the controller's ESP-NOW peer slot planner
+// (PeerTable) against a model of the driver's peer limits: keyed devices
+// only ever encrypted, the encrypted limit never exceeded, the selected
+// device always registered; plus key parsing.
+//
+//   peer_table_check            run every check, exit 1 on a failure
+//
+// The driver model applies each change in the order given and fails the
+// check if a step would go over either limit, as esp_now_add_peer() would.
+
+#include "check.h"
+#include "peer_table.h"
+
+#include <random>
+#include <stdio.h>
+#include <string.h>
+
+// The ESP-NOW defaults: 20 peers (one kept for broadcast), 6 encrypted.
+#define TOTAL_SLOTS 19
+#define ENCRYPTED_SLOTS 6
+
+// ============================================
+// DRIVER MODEL
+// ============================================
+
+struct Driver {
+  PeerSlot slot[PEER_TABLE_MAX];
+  int total, encrypted;
+  bool overLimit;
+
+  void reset() {
+    for (PeerSlot &s : slot) s = PEER_NONE;
+    total = encrypted = 0;
+    overLimit = false;
+  }
+
+  // Apply changes in order; returns how many.
+  int apply(const PeerChange *c, int m) {
+    for (int i = 0; i < m; i++) {
+      PeerSlot &s = slot[c[i].device];
+      if (c[i].to == PEER_NONE) {
+        if (s == PEER_NONE) overLimit = true;   // removing a peer that is not there
+        total -= s != PEER_NONE;
+        encrypted -= s == PEER_ENCRYPTED;
+      } else {
+        if (s != PEER_NONE) overLimit = true;   // add_peer on an existing peer
+        total++;
+        encrypted += c[i].to == PEER_ENCRYPTED;
+      }
+      s = c[i].to;
+      if (total > TOTAL_SLOTS || encrypted > ENCRYPTED_SLOTS) overLimit = true;
+    }
+    return m;
+  }
+};
+
+static bool matches(const PeerTable &t, const Driver &d, int n) {
+  for (int i = 0; i < n; i++) {
+    if (t.slot(i) != d.slot[i]) return false;
+  }
+  return true;
+}
+
+// ============================================
+// CHECKS
+// ============================================
+
+static void checkFits() {
+  printf("everything fits\n");
+  PeerTable t;
+  Driver d;
+  d.reset();
+  PeerChange c[2 * PEER_TABLE_MAX];
+  t.begin(3, TOTAL_SLOTS, ENCRYPTED_SLOTS);
+  t.setKeyed(1, true);
+  CHECK(d.apply(c, t.update(0, c)) == 3);
+  CHECK(t.slot(0) == PEER_PLAIN && t.slot(1) == PEER_ENCRYPTED && t.slot(2) == PEER_PLAIN);
+  CHECK(matches(t, d, 3) && !d.overLimit);
+
+  // Switching between registered devices touches nothing.
+  for (int s = 0; s < 30; s++) CHECK(t.update(s % 3, c) == 0);
+
+  // Keying a plain device: removed, then added encrypted.
+  t.setKeyed(2, true);
+  int m = t.update(0, c);
+  CHECK(m == 2 && c[0].device == 2 && c[0].to == PEER_NONE && c[1].device == 2 && c[1].to == PEER_ENCRYPTED);
+  d.apply(c, m);
+  t.setKeyed(1, false);
+  d.apply(c, t.update(0, c));
+  CHECK(t.slot(1) == PEER_PLAIN && matches(t, d, 3) && !d.overLimit);
+
+  // A refused add is retried on the next update.
+  t.failed(2);
+  d.slot[2] = PEER_NONE;
+  d.total--;
+  d.encrypted--;
+  m = t.update(0, c);
+  CHECK(m == 1 && c[0].device == 2 && c[0].to == PEER_ENCRYPTED);
+  d.apply(c, m);
+  CHECK(matches(t, d, 3) && !d.overLimit);
+}
+
+static void checkEncryptedLimit() {
+  printf("encrypted limit\n");
+  PeerTable t;
+  Driver d;
+  d.reset();
+  PeerChange c[2 * PEER_TABLE_MAX];
+  t.begin(10, TOTAL_SLOTS, ENCRYPTED_SLOTS);
+  for (int i = 0; i < 10; i++) t.setKeyed(i, true);
+  d.apply(c, t.update(0, c));
+  CHECK(t.count(PEER_ENCRYPTED) == ENCRYPTED_SLOTS && t.count(PEER_PLAIN) == 0);
+  for (int i = 0; i < 10; i++) CHECK(t.slot(i) == (i < ENCRYPTED_SLOTS ? PEER_ENCRYPTED : PEER_NONE));
+
+  // Selecting a keyed device that was left out evicts the one selected
+  // longest ago (never selected, highest index first), removal first.
+  int m = t.update(8, c);
+  CHECK(m == 2 && c[0].device == 5 && c[0].to == PEER_NONE && c[1].device == 8 && c[1].to == PEER_ENCRYPTED);
+  d.apply(c, m);
+  CHECK(matches(t, d, 10) && !d.overLimit);
+
+  // Recently selected devices keep their slots.
+  d.apply(c, t.update(9, c));
+  d.apply(c, t.update(7, c));
+  CHECK(t.slot(8) == PEER_ENCRYPTED && t.slot(9) == PEER_ENCRYPTED && t.slot(7) == PEER_ENCRYPTED);
+  CHECK(t.slot(0) == PEER_ENCRYPTED);   // selected before them
+  CHECK(t.update(8, c) == 0 && t.update(0, c) == 0);
+  CHECK(matches(t, d, 10) && !d.overLimit);
+
+  // Keyed devices never fall back to plain, even with plain slots free.
+  for (int i = 0; i < 10; i++) CHECK(t.slot(i) != PEER_PLAIN);
+}
+
+static void checkRandom() {
+  printf("random keys and selections\n");
+  std::mt19937 rng(50);
+  PeerChange c[2 * PEER_TABLE_MAX];
+  long changes = 0, updates = 0;
+  for (int run = 0; run < 200; run++) {
+    int n = 1 + rng() % PEER_TABLE_MAX;
+    int slots = 1 + rng() % TOTAL_SLOTS;
+    int enc = rng() % (ENCRYPTED_SLOTS + 1);
+    PeerTable t;
+    Driver d;
+    d.reset();
+    t.begin(n, slots, enc);
+    for (int step = 0; step < 500; step++) {
+      if (rng() % 4 == 0) t.setKeyed(rng() % n, rng() % 2);
+      int sel = rng() % n;
+      int m = t.update(sel, c);
+      updates++;
+      changes += m;
+      d.apply(c, m);
+      CHECK(!d.overLimit && d.total <= slots && d.encrypted <= enc);
+      CHECK(matches(t, d, n));
+      CHECK(t.slot(sel) == (t.keyed(sel) ? (enc ? PEER_ENCRYPTED : PEER_NONE) : PEER_PLAIN));
+      for (int i = 0; i < n; i++) CHECK(!(t.keyed(i) && t.slot(i) == PEER_PLAIN));
+      if (failures) return;
+    }
+  }
+  printf("  %ld updates, %.2f peer changes per update\n", updates, (double)changes / updates);
+}
+
+static void checkKeys() {
+  printf("key parsing\n");
+  uint8_t k[PEER_KEY_LEN];
+  CHECK(parseKeyHex("00112233445566778899AABBCCDDEEFF", k));
+  CHECK(k[0] == 0x00 && k[1] == 0x11 && k[10] == 0xAA && k[15] == 0xFF);
+  CHECK(parseKeyHex("00112233445566778899aabbccddeeff", k) && k[15] == 0xFF);
+  CHECK(parseKeyHex("0123456789ABCDEF0123456789ABCDEF extra", k));
+  CHECK(!parseKeyHex("0123456789ABCDEF0123456789ABCDE", k));     // 31 digits
+  CHECK(!parseKeyHex("0123456789ABCDEF0123456789ABCDEF0", k));   // 33 digits
+  CHECK(!parseKeyHex("0123456789ABCDEF0123456789ABCDEG", k));
+  CHECK(!parseKeyHex("00000000000000000000000000000000", k));    // never-set key
+  CHECK(!parseKeyHex("", k));
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+int main() {
+  checkFits();
+  checkEncryptedLimit();
+  checkRandom();
+  checkKeys();
+  return checkSummary();
+}
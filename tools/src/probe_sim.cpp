@@ -0,0 +1,249 @@
+// probe_sim - the controller's background probe scheduler (ProbeScheduler)
+// between drive commands, against a radio whose channel hops take a
+// variable time and devices that sit on other channels, move, or are gone.
+//
+//   probe_sim                   every scenario, exit 1 if a bound is broken
+//   probe_sim --seconds 600 --seed 7
+//
+// The loop below is probeBackground() from espnow.cpp: a loop pass every
+// LOOP_US, a drive command every send_ms whose callback comes back
+// DRIVE_TX_US later, and at most one probe per pass in the slack before the
+// next command. A hop probe blocks the loop: retune (cut off at the budget),
+// probe and wait for the ACK until the budget runs out, then retune home.
+//
+// Checked per scenario:
+//   - a hop's budget never exceeds PROBE_MAX_HOP_US or the slack minus
+//     PROBE_HOP_GUARD_US, so the time off the drive channel is at most
+//     PROBE_MAX_HOP_US plus the retune home;
+//   - a drive command is late only by what the retune home takes beyond the
+//     guard, never by PROBE_MAX_HOP_US or more;
+//   - no device is probed more often than PROBE_PERIOD_MS, and every
+//     device is probed at least every PROBE_PERIOD_MS + PERIOD_SLACK_MS;
+//   - a device that moved channel is found again by the hunt.
+
+#include "check.h"
+#include "probe_scheduler.h"
+
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PROBE_PERIOD_MS  1000     // controller config.h
+#define PROBE_MAX_HOP_US 6000     // controller config.h
+#define LOOP_US          500      // controller loop pass
+#define DRIVE_TX_US      900      // drive frame send -> callback
+#define PENDING_MAX_US   50000    // probeBackground() gives up on a same-channel probe
+#define HOME_CHANNEL     1
+#define DEVICES          8
+#define SELECTED         0
+// Each due device waits at most one round of the others for a slot that
+// fits, and the unreachable device's hunt hops take the longest slots.
+#define PERIOD_SLACK_MS  (DEVICES * 20 + 60)
+
+struct Scenario {
+  const char *name;
+  uint32_t sendUs;                     // send_ms; 0 = not driving
+  uint32_t retuneMinUs, retuneMaxUs;   // one channel switch
+  double slowPct;                      // share of switches that take slowUs
+  uint32_t slowUs;
+};
+
+// ============================================
+// RADIO AND DEVICES
+// ============================================
+// Devices 1 and 2 share the drive channel, 3 and 4 are on 6, 5 on 11.
+// Device 6 is switched off. Device 7 starts on 6 and moves to 11 a third
+// of the way in, with the controller's cached channel still saying 6.
+
+struct World {
+  std::mt19937 rng;
+  uint8_t trueCh[PROBE_MAX_DEVICES] = {1, 1, 1, 6, 6, 11, 0, 6};
+  uint8_t cachedCh[PROBE_MAX_DEVICES] = {1, 1, 1, 6, 6, 11, 3, 6};
+  const Scenario &sc;
+
+  World(const Scenario &s, unsigned seed) : rng(seed), sc(s) {}
+
+  uint32_t uniform(uint32_t lo, uint32_t hi) { return lo + rng() % (hi - lo + 1); }
+
+  uint32_t retuneUs() {
+    if (rng() % 10000 < sc.slowPct * 100) return sc.slowUs;
+    return uniform(sc.retuneMinUs, sc.retuneMaxUs);
+  }
+
+  // Send -> ACK time of a probe on channel ch, 0 if it is not answered.
+  uint32_t ackUs(int device, uint8_t ch) {
+    if (trueCh[device] == 0 || trueCh[device] != ch) return 0;
+    if (rng() % 100 < 5) return 0;   // plain loss
+    return uniform(300, 1500);
+  }
+};
+
+// ============================================
+// SIMULATION
+// ============================================
+
+struct Result {
+  uint32_t drives = 0, late = 0;
+  uint32_t lateMaxUs = 0;
+  uint32_t offHomeMaxUs = 0;
+  uint32_t budgetMaxUs = 0;
+  uint32_t budgetOverSlack = 0;        // budget beyond slack - guard
+  uint32_t intervalMinMs = UINT32_MAX, intervalMaxMs = 0;
+  int64_t movedAtUs = -1, foundAtUs = -1;
+  ProbeScheduler sched;
+};
+
+static void simulate(const Scenario &sc, double seconds, unsigned seed, Result &r) {
+  World w(sc, seed);
+  ProbeScheduler &s = r.sched;
+  s.begin(PROBE_PERIOD_MS, PROBE_MAX_HOP_US);
+
+  uint64_t totalUs = (uint64_t)(seconds * 1e6);
+  uint64_t moveUs = totalUs / 3;
+  uint64_t t = 0;
+  uint64_t nextTxDue = 0, callbackAt = 0;
+  bool pending = false;
+  ProbeDecision pendingD = {};
+  uint64_t pendingSince = 0, pendingAckAt = 0;
+  uint64_t lastProbeUs[DEVICES] = {};
+  bool probed[DEVICES] = {};
+
+  auto finish = [&](const ProbeDecision &d, bool ok, uint32_t costUs) {
+    s.result(d, ok, costUs);
+    if (d.device < 0 || d.device >= DEVICES) return;
+    if (ok && w.cachedCh[d.device] != d.channel) {
+      w.cachedCh[d.device] = d.channel;
+      if (d.device == 7 && r.movedAtUs >= 0 && r.foundAtUs < 0) r.foundAtUs = t;
+    }
+  };
+
+  while (t < totalUs) {
+    if (t >= moveUs && r.movedAtUs < 0) {
+      w.trueCh[7] = 11;
+      r.movedAtUs = t;
+    }
+
+    // Drive command, late if a hop held the loop past its due time.
+    if (sc.sendUs && t >= nextTxDue) {
+      uint32_t late = (uint32_t)(t - nextTxDue);
+      r.drives++;
+      if (late > LOOP_US) r.late++;
+      if (late > r.lateMaxUs) r.lateMaxUs = late;
+      callbackAt = t + DRIVE_TX_US;
+      nextTxDue = t + sc.sendUs;
+    }
+
+    // probeBackground()
+    bool skip = false;
+    if (pending) {
+      bool done = pendingAckAt && t >= pendingAckAt;
+      if (!done && t - pendingSince < PENDING_MAX_US) skip = true;
+      else {
+        pending = false;
+        finish(pendingD, done, 0);
+      }
+    }
+    uint32_t slackUs = PROBE_MAX_HOP_US + PROBE_HOP_GUARD_US;
+    if (!skip && sc.sendUs) {
+      if (t < callbackAt) skip = true;
+      else slackUs = nextTxDue > t ? (uint32_t)(nextTxDue - t) : 0;
+    }
+
+    ProbeDecision d;
+    if (!skip && s.next((uint32_t)(t / 1000), slackUs, SELECTED, HOME_CHANNEL, w.cachedCh, DEVICES, d)) {
+      if (probed[d.device]) {
+        uint32_t ms = (uint32_t)(t / 1000 - lastProbeUs[d.device] / 1000);
+        if (ms < r.intervalMinMs) r.intervalMinMs = ms;
+        if (ms > r.intervalMaxMs) r.intervalMaxMs = ms;
+      }
+      probed[d.device] = true;
+      lastProbeUs[d.device] = t;
+
+      if (d.hop) {
+        if (d.budgetUs > r.budgetMaxUs) r.budgetMaxUs = d.budgetUs;
+        if (d.budgetUs + PROBE_HOP_GUARD_US > slackUs) r.budgetOverSlack++;
+        // hopProbe(): away, probe until the deadline, back.
+        uint64_t start = t, deadline = t + d.budgetUs;
+        bool ok = false;
+        uint64_t at = start + w.retuneUs();
+        if (at >= deadline) {
+          at = deadline;
+        } else {
+          uint32_t ack = w.ackUs(d.device, d.channel);
+          ok = ack && at + ack < deadline;
+          at = ok ? at + ack : deadline;
+        }
+        at += w.retuneUs();
+        uint32_t off = (uint32_t)(at - start);
+        if (off > r.offHomeMaxUs) r.offHomeMaxUs = off;
+        t = at;
+        finish(d, ok, off);
+        continue;   // the loop pass ends with the hop
+      }
+      uint32_t ack = w.ackUs(d.device, d.channel);
+      pending = true;
+      pendingD = d;
+      pendingSince = t;
+      pendingAckAt = ack ? t + ack : 0;
+    }
+    t += LOOP_US;
+  }
+}
+
+static void runScenario(const Scenario &sc, double seconds, unsigned seed) {
+  Result r;
+  simulate(sc, seconds, seed, r);
+  const ProbeScheduler &s = r.sched;
+  uint32_t retuneWorst = sc.slowPct > 0 && sc.slowUs > sc.retuneMaxUs ? sc.slowUs : sc.retuneMaxUs;
+  uint32_t lateBound = retuneWorst > PROBE_HOP_GUARD_US ? retuneWorst - PROBE_HOP_GUARD_US : 0;
+
+  printf("%s\n", sc.name);
+  printf("  probes %u (hops %u, deferred %u), hunts found %u\n", s.probes, s.hops, s.deferred, s.found);
+  printf("  budget max %u us, off channel max %u us, hop cost max %u us\n",
+         r.budgetMaxUs, r.offHomeMaxUs, s.hopCostMaxUs);
+  if (sc.sendUs) {
+    printf("  drive commands %u, late %u (%.3f%%), late max %u us (bound %u + one loop pass)\n",
+           r.drives, r.late, 100.0 * r.late / r.drives, r.lateMaxUs, lateBound);
+  }
+  printf("  probe interval %u..%u ms per device", r.intervalMinMs, r.intervalMaxMs);
+  if (r.foundAtUs >= 0) printf(", moved device found after %.2f s", (r.foundAtUs - r.movedAtUs) / 1e6);
+  printf("\n");
+
+  CHECK(r.budgetMaxUs <= PROBE_MAX_HOP_US && r.budgetOverSlack == 0);
+  CHECK(r.offHomeMaxUs <= PROBE_MAX_HOP_US + retuneWorst);
+  CHECK(r.lateMaxUs <= lateBound + LOOP_US && r.lateMaxUs < PROBE_MAX_HOP_US);
+  CHECK(r.intervalMinMs >= PROBE_PERIOD_MS);
+  CHECK(r.intervalMaxMs <= PROBE_PERIOD_MS + PERIOD_SLACK_MS);
+  // Three misses on the old channel, then at most one sweep of 13 channels.
+  CHECK(r.foundAtUs >= 0);
+  CHECK(r.foundAtUs - r.movedAtUs <= (int64_t)(PROBE_FAIL_LIMIT + 13 + 1) * (PROBE_PERIOD_MS + PERIOD_SLACK_MS) * 1000);
+  printf("\n");
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+int main(int argc, char **argv) {
+  double seconds = 120;
+  unsigned seed = 1;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) seconds = atof(argv[++i]);
+    else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = atoi(argv[++i]);
+    else {
+      fprintf(stderr, "usage: %s [--seconds S] [--seed N]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  static const Scenario scenarios[] = {
+    {"driving, quick retunes",                  20000, 200,  600, 0,   0},
+    {"driving, retunes up to the guard",        20000, 400, 1000, 0,   0},
+    {"driving, 2% slow retunes",                20000, 200,  600, 2, 1800},
+    {"driving at send_ms 8, 2% slow retunes",    8000, 200,  600, 2, 1800},
+    {"menu (not driving)",                          0, 200,  600, 2, 1800},
+  };
+  for (const Scenario &sc : scenarios) runScenario(sc, seconds, seed);
+  return checkSummary();
+}
@@ -0,0 +1,198 @@
+// redundancy_sim - compare the controller's redundancy modes over a lossy
+// channel: effective command loss at the receiver and airtime per command.
+//
+//   redundancy_sim                       default channels, exit 1 if a check fails
+//   redundancy_sim --loss 10             one i.i.d. channel (percent)
+//   redundancy_sim --loss 10 --burst 30  Gilbert-Elliott, mean burst in ms
+//   redundancy_sim --seconds 600 --seed 7
+//
+// Modes mirror the REDUNDANCY command: OFF (one ControlCommand per tick),
+// PREV (RedundantCommand carrying the previous command) and DOUBLE (the
+// same ControlCommand twice, half an interval apart). No MAC retries are
+// modelled, i.e. the loss figures are per transmission attempt.
+//
+// "in time" counts commands that reached the receiver within the playout
+// delay of the jitter buffer (20 ms by default): PREV recovers a command one
+// interval late, which is exactly the default delay.
+//
+// Checked per channel:
+//   - under i.i.d. loss p, PREV loses about p^2 of the commands (within four
+//     standard deviations) where OFF loses p;
+//   - DOUBLE sends exactly 2.00 frames per command;
+//   - PREV's extra airtime is exactly the extra payload bytes at 1 Mbps.
+
+#include "check.h"
+#include "espnow_data.h"
+#include "link_stats.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+#include <vector>
+
+#define SEND_PERIOD_MS   20
+#define PLAYOUT_MS       20
+
+// ============================================
+// CHANNEL MODEL
+// ============================================
+// Two-state Gilbert-Elliott channel stepped every millisecond: frames are
+// lost with lossGood in the good state and lossBad in the bad state. With
+// burstMs == 0 it degenerates to i.i.d. loss.
+
+struct Channel {
+  const char *name;
+  double lossPct;       // long-run average loss
+  double burstMs;       // mean bad-state duration, 0 = i.i.d.
+};
+
+class LossModel {
+public:
+  LossModel(const Channel &c, unsigned seed) : _rng(seed), _uni(0, 1) {
+    double p = c.lossPct / 100;
+    if (c.burstMs <= 0) {
+      _lossGood = _lossBad = p;
+      _toBad = 0;
+      _toGood = 1;
+    } else {
+      // Bad state drops everything; choose its share so the average is p.
+      _lossGood = 0;
+      _lossBad = 1;
+      _toGood = 1 / c.burstMs;
+      _toBad = p * _toGood / (1 - p);
+    }
+  }
+
+  void stepMs() {
+    if (_bad) { if (_uni(_rng) < _toGood) _bad = false; }
+    else if (_uni(_rng) < _toBad) _bad = true;
+  }
+
+  bool lost() { return _uni(_rng) < (_bad ? _lossBad : _lossGood); }
+
+private:
+  std::mt19937 _rng;
+  std::uniform_real_distribution<double> _uni;
+  double _lossGood, _lossBad, _toBad, _toGood;
+  bool _bad = false;
+};
+
+// ============================================
+// SIMULATION
+// ============================================
+
+enum Mode { MODE_OFF, MODE_PREV, MODE_DOUBLE };
+static const char *const modeNames[] = {"OFF", "PREV", "DOUBLE"};
+
+struct Result {
+  uint32_t commands = 0;
+  uint32_t frames = 0;
+  uint64_t airUs = 0;
+  uint32_t inTime = 0;
+  SeqTracker seq;
+};
+
+static Result simulate(const Channel &c, Mode mode, double seconds, unsigned seed) {
+  LossModel ch(c, seed);
+  Result r;
+  int totalMs = (int)(seconds * 1000);
+  std::vector<int> firstSeenMs(totalMs / SEND_PERIOD_MS + 2, -1);
+  size_t plainLen = sizeof(ControlCommand);
+  size_t frameLen = mode == MODE_PREV ? sizeof(RedundantCommand) : plainLen;
+
+  auto deliver = [&](int cmd, int tMs) {
+    r.seq.mark((uint8_t)cmd);
+    if (firstSeenMs[cmd] < 0) firstSeenMs[cmd] = tMs;
+  };
+
+  for (int t = 0; t < totalMs; t++) {
+    ch.stepMs();
+    int phase = t % SEND_PERIOD_MS;
+    int cmd = t / SEND_PERIOD_MS;
+    if (phase == 0) {
+      r.commands++;
+      r.frames++;
+      r.airUs += espnowAirtimeUs(cmd > 0 ? frameLen : plainLen);
+      if (!ch.lost()) {
+        if (mode == MODE_PREV && cmd > 0) deliver(cmd - 1, t);
+        deliver(cmd, t);
+      }
+    } else if (mode == MODE_DOUBLE && phase == SEND_PERIOD_MS / 2) {
+      r.frames++;
+      r.airUs += espnowAirtimeUs(plainLen);
+      if (!ch.lost()) deliver(cmd, t);
+    }
+  }
+
+  for (int cmd = 0; cmd < (int)r.commands; cmd++) {
+    int seen = firstSeenMs[cmd];
+    if (seen >= 0 && seen - cmd * SEND_PERIOD_MS <= PLAYOUT_MS) r.inTime++;
+  }
+  return r;
+}
+
+static void runChannel(const Channel &c, double seconds, unsigned seed) {
+  if (c.burstMs > 0) printf("%s: %.1f%% loss in bursts of ~%.0f ms\n", c.name, c.lossPct, c.burstMs);
+  else printf("%s: %.1f%% i.i.d. loss\n", c.name, c.lossPct);
+
+  Result off;
+  for (int m = MODE_OFF; m <= MODE_DOUBLE; m++) {
+    Result r = simulate(c, (Mode)m, seconds, seed);
+    if (m == MODE_OFF) off = r;
+    double air = (double)r.airUs / r.commands;
+    double baseAir = (double)off.airUs / off.commands;
+    printf("  %-7s loss %6.2f%%  late-or-lost %6.2f%%  frames/cmd %.2f  airtime %4.0f us/cmd (%+.0f%%)\n",
+           modeNames[m], r.seq.lossRate() * 100,
+           100.0 * (r.commands - r.inTime) / r.commands,
+           (double)r.frames / r.commands, air, (air / baseAir - 1) * 100);
+
+    if (m == MODE_PREV) {
+      // Every command but the first carries the previous one along.
+      uint64_t extraBytes = sizeof(RedundantCommand) - sizeof(ControlCommand);
+      CHECK(r.airUs - off.airUs == (r.commands - 1) * extraBytes * 8);
+      if (c.burstMs <= 0 && c.lossPct > 0) {
+        // A command is lost only if both of its frames are.
+        double p2 = c.lossPct / 100 * c.lossPct / 100;
+        double sigma = sqrt(p2 * (1 - p2) / r.commands);
+        CHECK(fabs(r.seq.lossRate() - p2) <= 4 * sigma + 1.0 / r.commands);
+      }
+    }
+    if (m == MODE_DOUBLE) CHECK(r.frames == 2 * r.commands);
+  }
+  printf("\n");
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+int main(int argc, char **argv) {
+  double seconds = 300;
+  unsigned seed = 1;
+  Channel custom = {"custom", -1, 0};
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) seconds = atof(argv[++i]);
+    else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--loss") == 0 && i + 1 < argc) custom.lossPct = atof(argv[++i]);
+    else if (strcmp(argv[i], "--burst") == 0 && i + 1 < argc) custom.burstMs = atof(argv[++i]);
+    else {
+      fprintf(stderr, "usage: %s [--seconds S] [--seed N] [--loss PCT [--burst MS]]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (custom.lossPct >= 0 && custom.lossPct < 100) {
+    runChannel(custom, seconds, seed);
+  } else {
+    static const Channel channels[] = {
+      {"light",  2,  0},
+      {"heavy", 10,  0},
+      {"bursty", 5, 15},
+      {"fades",  5, 60},
+    };
+    for (const Channel &c : channels) runChannel(c, seconds, seed);
+  }
+  return checkSummary();
+}
@@ -0,0 +1,263 @@
+// rssi_check - the controller's RSSI sniffer pieces on the host: header
+// parsing against captured frame headers, the rolling statistics and link
+// diagnosis, and the callback -> loop ring under a concurrent producer.
+//
+//   rssi_check                  run every check, exit 1 on a failure
+//
+// The frames below are the first bytes of real captures (MAC addresses of
+// unrelated stations replaced), as the promiscuous callback hands them over:
+// 802.11 header first, no radiotap, no FCS.
+
+#include "check.h"
+#include "rssi_monitor.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+
+static const uint8_t testRx[6] = {0x88, 0x56, 0xA6, 0x64, 0xA1, 0xE8};
+
+// ============================================
+// CAPTURED FRAMES
+// ============================================
+
+// LinkEcho from the test receiver: ESP-NOW action frame to the controller.
+static const uint8_t espnowEcho[] = {
+  0xD0, 0x00, 0x3A, 0x01,                         // action, duration
+  0x34, 0x85, 0x18, 0x7B, 0x22, 0x10,             // addr1: controller
+  0x88, 0x56, 0xA6, 0x64, 0xA1, 0xE8,             // addr2: test receiver
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,             // addr3
+  0x70, 0xA2,                                     // seq 2599, frag 0
+  0x7F, 0x18, 0xFE, 0x34,                         // vendor action, Espressif
+  0x5C, 0x1D, 0x93, 0x0A,                         // random
+  0xDD, 0x0B, 0x18, 0xFE, 0x34, 0x04, 0x01,       // vendor element, ESP-NOW v1
+  0x01,                                           // first payload byte
+};
+
+// The same echo retransmitted (retry bit set, same sequence number).
+static const uint8_t espnowRetry[] = {
+  0xD0, 0x08, 0x3A, 0x01,
+  0x34, 0x85, 0x18, 0x7B, 0x22, 0x10,
+  0x88, 0x56, 0xA6, 0x64, 0xA1, 0xE8,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0x70, 0xA2,
+  0x7F, 0x18, 0xFE, 0x34, 0x5C, 0x1D, 0x93, 0x0A,
+  0xDD, 0x0B, 0x18, 0xFE, 0x34, 0x04, 0x01, 0x01,
+};
+
+// Beacon from a nearby access point.
+static const uint8_t beacon[] = {
+  0x80, 0x00, 0x00, 0x00,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0x02, 0x1A, 0x11, 0xF0, 0x3C, 0x51,
+  0x02, 0x1A, 0x11, 0xF0, 0x3C, 0x51,
+  0x40, 0x3E,
+  0x8B, 0x4F, 0x2A, 0x19, 0x06, 0x00, 0x00, 0x00, 0x64, 0x00, 0x11, 0x04,
+};
+
+// Probe request from a phone.
+static const uint8_t probeReq[] = {
+  0x40, 0x00, 0x00, 0x00,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xDA, 0x31, 0x7C, 0x05, 0x9E, 0x42,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0x10, 0x05,
+  0x00, 0x00, 0x01, 0x08, 0x82, 0x84, 0x8B, 0x96,
+};
+
+// QoS data frame between two other stations.
+static const uint8_t qosData[] = {
+  0x88, 0x41, 0x2C, 0x00,
+  0x02, 0x1A, 0x11, 0xF0, 0x3C, 0x51,
+  0xDA, 0x31, 0x7C, 0x05, 0x9E, 0x42,
+  0x02, 0x1A, 0x11, 0xF0, 0x3C, 0x51,
+  0xB0, 0x7C,
+  0x00, 0x00,
+};
+
+// Vendor action frame with a non-Espressif OUI (Wi-Fi Alliance).
+static const uint8_t otherAction[] = {
+  0xD0, 0x00, 0x3A, 0x01,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xDA, 0x31, 0x7C, 0x05, 0x9E, 0x42,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0x20, 0x00,
+  0x7F, 0x50, 0x6F, 0x9A, 0x09, 0x02, 0x10, 0x00,
+  0xDD, 0x0B, 0x50, 0x6F, 0x9A, 0x04, 0x01, 0x01,
+};
+
+// ACK: control frame, receiver address only.
+static const uint8_t ack[] = {
+  0xD4, 0x00, 0x00, 0x00,
+  0x88, 0x56, 0xA6, 0x64, 0xA1, 0xE8,
+};
+
+// ============================================
+// CHECKS
+// ============================================
+
+static void checkParsing() {
+  printf("header parsing\n");
+  SniffedFrame f;
+
+  CHECK(sniffWanted(espnowEcho, sizeof(espnowEcho)));
+  CHECK(parseSniffHeader(espnowEcho, sizeof(espnowEcho), f));
+  CHECK(memcmp(f.src, testRx, 6) == 0);
+  CHECK(f.kind == SNIFF_ESPNOW && !f.retry && f.seqNum == 2599);
+
+  CHECK(parseSniffHeader(espnowRetry, sizeof(espnowRetry), f));
+  CHECK(f.kind == SNIFF_ESPNOW && f.retry && f.seqNum == 2599);
+
+  // Cut before the vendor element: still a frame from the device, but not
+  // recognisable as ESP-NOW.
+  CHECK(parseSniffHeader(espnowEcho, 30, f));
+  CHECK(memcmp(f.src, testRx, 6) == 0 && f.kind == SNIFF_OTHER);
+
+  CHECK(!sniffWanted(beacon, sizeof(beacon)));
+  CHECK(parseSniffHeader(beacon, sizeof(beacon), f) && f.kind == SNIFF_OTHER);
+
+  CHECK(sniffWanted(probeReq, sizeof(probeReq)));
+  CHECK(parseSniffHeader(probeReq, sizeof(probeReq), f));
+  CHECK(f.kind == SNIFF_OTHER && f.src[0] == 0xDA && f.seqNum == 81);
+
+  CHECK(sniffWanted(qosData, sizeof(qosData)));
+  CHECK(parseSniffHeader(qosData, sizeof(qosData), f));
+  CHECK(f.kind == SNIFF_OTHER && f.src[5] == 0x42 && f.seqNum == 1995);
+
+  CHECK(parseSniffHeader(otherAction, sizeof(otherAction), f) && f.kind == SNIFF_OTHER);
+
+  CHECK(!sniffWanted(ack, sizeof(ack)));
+  CHECK(!parseSniffHeader(ack, sizeof(ack), f));
+  CHECK(!parseSniffHeader(espnowEcho, 23, f));
+
+  // Rate codes: 1M long preamble (ESP-NOW default), 54M, MCS7, unknown.
+  CHECK(sniffRateKbps(0, 0x00, 0) == 1000);
+  CHECK(sniffRateKbps(0, 0x05, 0) == 2000);
+  CHECK(sniffRateKbps(0, 0x0C, 0) == 54000);
+  CHECK(sniffRateKbps(1, 0, 7) == 65000);
+  CHECK(sniffRateKbps(0, 0x04, 0) == 0 && sniffRateKbps(3, 0, 0) == 0);
+}
+
+static void checkStatistics() {
+  printf("rolling statistics\n");
+  RssiStats s;
+  CHECK(s.samples() == 0 && s.mean() == 0 && s.min() == 0 && s.max() == 0);
+  CHECK(s.diagnose(-80, -85) == DIAG_NO_DATA);
+
+  s.add(-60, -95, 1000, 10);
+  s.add(-61, -95, 1000, 20);
+  CHECK(s.samples() == 2 && s.mean() == -61 && s.min() == -61 && s.max() == -60);   // -60.5 rounds away
+  CHECK(s.snr() == 34 && s.last == -61 && s.lastUs == 20);
+  CHECK(s.diagnose(-80, -85) == DIAG_OK);
+
+  // The window forgets: after RSSI_WINDOW weak samples the strong ones are gone.
+  for (int i = 0; i < RSSI_WINDOW; i++) s.add(-88, -96, 1000, 100 + i);
+  CHECK(s.samples() == RSSI_WINDOW && s.total == RSSI_WINDOW + 2);
+  CHECK(s.mean() == -88 && s.max() == -88 && s.min() == -88);
+  CHECK(s.diagnose(-80, -85) == DIAG_WEAK);
+
+  // Good signal, but the floor comes up: interference.
+  for (int i = 0; i < RSSI_WINDOW; i++) s.add(-55, (int8_t)(i & 1 ? -78 : -80), 1000, 200 + i);
+  CHECK(s.noiseMean() == -79 && s.snr() == 24);
+  CHECK(s.diagnose(-80, -85) == DIAG_NOISY);
+
+  // Weak and noisy together: the floor wins, range is not the cause.
+  for (int i = 0; i < RSSI_WINDOW; i++) s.add(-86, -80, 1000, 300 + i);
+  CHECK(s.diagnose(-80, -85) == DIAG_NOISY);
+
+  // Extremes do not overflow the sums.
+  s.reset();
+  for (int i = 0; i < 1000; i++) s.add(-128, -128, 0, i);
+  CHECK(s.mean() == -128 && s.min() == -128 && s.total == 1000);
+  s.reset();
+  CHECK(s.total == 0 && s.samples() == 0);
+}
+
+// Producer thread stands in for the WiFi task, the main thread for the
+// loop. Every record carries its index in tUs and in every header byte, so
+// a torn copy or a reordering shows up. The producer's bursts are longer
+// than the ring, so it runs both full and empty.
+static void checkHandoff() {
+  printf("callback -> loop handoff\n");
+  static SniffRing<32> ring;
+  const uint32_t total = 1000000;
+  std::atomic<bool> done(false);
+  std::thread producer([&] {
+    SniffRecord r = {};
+    for (uint32_t i = 0; i < total; i++) {
+      r.tUs = i;
+      r.rssi = (int8_t)-(int)(i % 90);
+      r.len = SNIFF_HDR_BYTES;
+      memset(r.hdr, (uint8_t)i, sizeof(r.hdr));
+      ring.push(r);
+      if (i % 40 == 39) std::this_thread::yield();   // bursts longer than the ring
+    }
+    done.store(true);
+  });
+
+  uint32_t received = 0, torn = 0, outOfOrder = 0;
+  int64_t prev = -1;
+  SniffRecord r;
+  auto drain = [&] {
+    while (ring.pop(r)) {
+      received++;
+      if ((int64_t)r.tUs <= prev) outOfOrder++;
+      prev = r.tUs;
+      bool ok = r.rssi == (int8_t)-(int)(r.tUs % 90);
+      for (uint8_t b : r.hdr) ok = ok && b == (uint8_t)r.tUs;
+      if (!ok) torn++;
+    }
+  };
+  while (!done.load()) {
+    drain();
+    std::this_thread::yield();
+  }
+  producer.join();
+  drain();
+
+  printf("  %u records: %u handed over, %u dropped on a full ring\n", total, received, ring.dropped());
+  CHECK(received + ring.dropped() == total);
+  CHECK(torn == 0 && outOfOrder == 0);
+  CHECK(received > 0);
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+int main() {
+  checkParsing();
+  checkStatistics();
+  checkHandoff();
+  int status = checkSummary();
+
+  // What the callback does per frame, and what the loop does per record.
+  static SniffRing<32> ring;
+  SniffRecord rec = {};
+  memcpy(rec.hdr, espnowEcho, sizeof(espnowEcho));
+  rec.len = sizeof(espnowEcho);
+  RssiStats stats;
+  SniffedFrame f;
+  const uint32_t ops = 20000000;
+  volatile uint32_t sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < ops; i++) {
+    rec.rssi = (int8_t)-(int)(i & 63);
+    if (sniffWanted(rec.hdr, rec.len)) ring.push(rec);
+    ring.pop(rec);
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < ops; i++) {
+    if (parseSniffHeader(rec.hdr, rec.len, f) && memcmp(f.src, testRx, 6) == 0) {
+      stats.add((int8_t)-(int)(i & 63), -95, sniffRateKbps(0, rec.rate, 0), i);
+    }
+  }
+  sink += stats.mean();
+  auto t2 = std::chrono::steady_clock::now();
+  printf("callback filter + push/pop: %.1f ns, parse + match + add: %.1f ns on this host\n",
+         std::chrono::duration<double, std::nano>(t1 - t0).count() / ops,
+         std::chrono::duration<double, std::nano>(t2 - t1).count() / ops);
+  return status;
+}
@@ -0,0 +1,43 @@
+#include "serial_port.h"
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+static speed_t baudToSpeed(int baud) {
+  switch (baud) {
+    case 9600:    return B9600;
+    case 57600:   return B57600;
+    case 115200:  return B115200;
+    case 230400:  return B230400;
+    case 460800:  return B460800;
+    case 921600:  return B921600;
+    default:      return B115200;
+  }
+}
+
+int openByteSource(const char *path, int baud, bool &isTty) {
+  int fd = open(path, O_RDONLY | O_NOCTTY);
+  if (fd < 0) return -1;
+
+  isTty = isatty(fd);
+  if (!isTty) return fd;
+
+  struct termios tio;
+  if (tcgetattr(fd, &tio) != 0) {
+    close(fd);
+    return -1;
+  }
+  cfmakeraw(&tio);
+  cfsetispeed(&tio, baudToSpeed(baud));
+  cfsetospeed(&tio, baudToSpeed(baud));
+  tio.c_cflag |= CLOCAL | CREAD;
+  tio.c_cc[VMIN] = 0;
+  tio.c_cc[VTIME] = 1;   // read() returns after 100 ms with whatever arrived
+  if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+    close(fd);
+    return -1;
+  }
+  tcflush(fd, TCIFLUSH);
+  return fd;
+}
@@ -0,0 +1,268 @@
+// smoother_sim - feed the receiver's CommandSmoother with synthetic lossy,
+// jittery command traces and report added latency versus smoothness.
+//
+//   smoother_sim                         default scenarios, exit 1 if a check fails
+//   smoother_sim --loss 10 --jitter 8    one custom scenario (percent, ms)
+//   smoother_sim --seconds 120 --seed 7
+//
+// For every scenario the same trace is replayed through "apply on arrival"
+// (what the receiver did before) and the smoother with each policy and a
+// range of playout delays. Latency is the lag that best aligns the output
+// with the stick signal; roughness is the mean absolute second difference
+// of the output per control tick (lower = smoother).
+//
+// Checked for every smoother run:
+//   - the output never steps back to an older seq;
+//   - the lag added over "apply on arrival" stays within the playout delay
+//     plus one send period.
+// And separately, on a clean stream: duplicates and frames older than the
+// one playing are dropped and counted, and after the last frame the output
+// ramps down and is zero FAILSAFE_US + FAILSAFE_RAMP_US later.
+
+#include "check.h"
+#include "command_smoother.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// ============================================
+// TRACE GENERATION
+// ============================================
+
+#define SEND_PERIOD_US   20000    // controller SEND_INTERVAL
+#define TICK_US          10000    // receiver control rate (100 Hz)
+#define FAILSAFE_US      250000   // receiver main.cpp
+#define FAILSAFE_RAMP_US 250000
+
+struct Arrival {
+  uint32_t tUs;
+  ControlCommand cmd;
+};
+
+struct Scenario {
+  const char *name;
+  double lossPct;
+  double jitterMs;      // mean of the exponential extra delay
+  double burstPct;      // chance of a 10..40 ms retry burst (reorders)
+};
+
+// Stick signal: slow sweeps with an occasional flick.
+static double stickAt(double tS) {
+  double v = 70 * sin(2 * M_PI * tS / 2.3) + 25 * sin(2 * M_PI * tS / 0.7);
+  if (fmod(tS, 5.0) > 4.5) v = 100;
+  return std::max(-100.0, std::min(100.0, v));
+}
+
+static std::vector<Arrival> makeTrace(const Scenario &sc, double seconds, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> uni(0, 1);
+  std::exponential_distribution<double> expo(1.0 / std::max(sc.jitterMs, 0.001));
+
+  std::vector<Arrival> out;
+  uint32_t sendUs = 0;
+  uint8_t seq = 0;
+  while (sendUs < seconds * 1e6) {
+    // Controller loop granularity: sends land 0..5 ms after they are due.
+    sendUs += SEND_PERIOD_US + (uint32_t)(uni(rng) * 5000);
+    ControlCommand c = {};
+    c.version = CONTROL_PROTOCOL_VERSION;
+    c.seq = seq++;
+    c.x = (int8_t)lround(stickAt(sendUs / 1e6));
+    c.speed = 200;
+    if (uni(rng) * 100 < sc.lossPct) continue;
+    double delayMs = 1.0 + (sc.jitterMs > 0 ? expo(rng) : 0);
+    if (uni(rng) * 100 < sc.burstPct) delayMs += 10 + uni(rng) * 30;
+    out.push_back({sendUs + (uint32_t)(delayMs * 1000), c});
+  }
+  std::stable_sort(out.begin(), out.end(),
+                   [](const Arrival &a, const Arrival &b) { return a.tUs < b.tUs; });
+  return out;
+}
+
+// ============================================
+// EVALUATION
+// ============================================
+
+struct Result {
+  double lagMs;
+  double errAtLag;
+  double roughness;
+};
+
+// Output x sampled every TICK_US; smoother == nullptr means apply on arrival.
+// backwards counts ticks whose output seq is older than the tick before.
+static std::vector<int> run(const std::vector<Arrival> &trace, CommandSmoother *sm,
+                            double seconds, uint32_t *backwards = nullptr) {
+  std::vector<int> xs;
+  size_t next = 0;
+  int applied = 0;
+  bool started = false;
+  uint8_t lastSeq = 0;
+  if (backwards) *backwards = 0;
+  for (uint32_t t = 0; t < seconds * 1e6; t += TICK_US) {
+    while (next < trace.size() && trace[next].tUs <= t) {
+      if (sm) sm->push(trace[next].cmd, trace[next].tUs);
+      else applied = trace[next].cmd.x;
+      next++;
+    }
+    if (!sm) {
+      xs.push_back(applied);
+      continue;
+    }
+    ControlCommand out = sm->tick(t);
+    xs.push_back(out.x);
+    if (started && backwards && (int8_t)(out.seq - lastSeq) < 0) (*backwards)++;
+    started = started || out.speed;   // the first command has played
+    lastSeq = out.seq;
+  }
+  return xs;
+}
+
+static Result evaluate(const std::vector<int> &xs) {
+  Result r = {};
+  r.errAtLag = 1e9;
+  // Skip the first second so start-up does not dominate.
+  size_t skip = 1000000 / TICK_US;
+  for (int lagMs = 0; lagMs <= 250; lagMs++) {
+    double err = 0;
+    size_t n = 0;
+    for (size_t k = skip; k < xs.size(); k++) {
+      double t = (double)k * TICK_US / 1e6 - lagMs / 1000.0;
+      err += fabs(xs[k] - stickAt(t));
+      n++;
+    }
+    err /= n ? n : 1;
+    if (err < r.errAtLag) {
+      r.errAtLag = err;
+      r.lagMs = lagMs;
+    }
+  }
+  double rough = 0;
+  for (size_t k = skip + 2; k < xs.size(); k++) rough += abs(xs[k] - 2 * xs[k - 1] + xs[k - 2]);
+  r.roughness = rough / (xs.size() > skip + 2 ? xs.size() - skip - 2 : 1);
+  return r;
+}
+
+static void report(const char *label, const Result &r, const SmootherStats *s) {
+  printf("  %-16s lag %5.0f ms  err %5.2f  rough %6.2f", label, r.lagMs, r.errAtLag, r.roughness);
+  if (s) printf("  | late %u reord %u lost %u underrun %u", s->late, s->reordered, s->lost, s->underruns);
+  printf("\n");
+}
+
+static void runScenario(const Scenario &sc, double seconds, unsigned seed) {
+  std::vector<Arrival> trace = makeTrace(sc, seconds, seed);
+  printf("%s: loss %.0f%%  jitter %.1f ms  bursts %.0f%%  (%zu packets)\n",
+         sc.name, sc.lossPct, sc.jitterMs, sc.burstPct, trace.size());
+
+  Result arrival = evaluate(run(trace, nullptr, seconds));
+  report("on arrival", arrival, nullptr);
+
+  static const uint32_t delaysMs[] = {0, 10, 20, 40};
+  for (int policy = SMOOTH_HOLD; policy <= SMOOTH_LINEAR; policy++) {
+    for (uint32_t d : delaysMs) {
+      CommandSmoother sm;
+      sm.begin({SEND_PERIOD_US, d * 1000, FAILSAFE_US, FAILSAFE_RAMP_US, (SmoothPolicy)policy});
+      uint32_t backwards;
+      Result r = evaluate(run(trace, &sm, seconds, &backwards));
+      char label[32];
+      snprintf(label, sizeof(label), "%s +%ums", policy == SMOOTH_HOLD ? "hold" : "linear", d);
+      report(label, r, &sm.stats());
+      CHECK(backwards == 0);
+      CHECK(r.lagMs - arrival.lagMs <= d + SEND_PERIOD_US / 1000);
+    }
+  }
+  printf("\n");
+}
+
+// ============================================
+// CHECKS
+// ============================================
+
+static ControlCommand command(uint8_t seq, int x) {
+  ControlCommand c = {};
+  c.version = CONTROL_PROTOCOL_VERSION;
+  c.seq = seq;
+  c.x = (int8_t)x;
+  c.speed = 200;
+  return c;
+}
+
+// A clean 50 Hz stream with every frame pushed twice, an old frame pushed
+// again long after it played, and then silence.
+static void checkDropsAndFailsafe() {
+  printf("duplicates, late frames and the failsafe ramp\n");
+  for (int policy = SMOOTH_HOLD; policy <= SMOOTH_LINEAR; policy++) {
+    CommandSmoother sm;
+    sm.begin({SEND_PERIOD_US, 20000, FAILSAFE_US, FAILSAFE_RAMP_US, (SmoothPolicy)policy});
+    const int frames = 100;
+    uint32_t t = 0, lastUs = 0;
+    int wrongX = 0;
+    for (int i = 0; i < frames; i++) {
+      uint32_t at = i * SEND_PERIOD_US;
+      for (; t < at; t += TICK_US) sm.tick(t);
+      sm.push(command(i, 50), at);
+      sm.push(command(i, 50), at + 300);          // redundant copy
+      if (i == 60) sm.push(command(40, -90), at + 300); // 20 frames behind
+      lastUs = at;
+    }
+    for (uint32_t end = lastUs + 60000; t < end; t += TICK_US) wrongX += sm.tick(t).x != 50;
+    const SmootherStats &s = sm.stats();
+    printf("  %-6s received %u  duplicates %u  late %u  resyncs %u\n",
+           policy == SMOOTH_HOLD ? "hold" : "linear", s.received, s.duplicates, s.late, s.resyncs);
+    CHECK(s.resyncs == 1 && s.duplicates == frames && s.late == 1 && s.lost == 0);
+    CHECK(wrongX == 0);
+
+    // Silence: full output until FAILSAFE_US, then a ramp that never grows,
+    // and zero from FAILSAFE_US + FAILSAFE_RAMP_US on.
+    int prev = 50, grew = 0, earlyRamp = 0, lateZero = 0;
+    for (; t < lastUs + FAILSAFE_US + FAILSAFE_RAMP_US + 200000; t += TICK_US) {
+      ControlCommand out = sm.tick(t);
+      uint32_t quiet = t - lastUs;
+      if (quiet <= FAILSAFE_US && (out.x != 50 || sm.failsafe())) earlyRamp++;
+      if (abs(out.x) > abs(prev)) grew++;
+      if (quiet >= FAILSAFE_US + FAILSAFE_RAMP_US && (out.x || out.y || out.rot || out.buttons)) lateZero++;
+      prev = out.x;
+    }
+    CHECK(earlyRamp == 0 && grew == 0 && lateZero == 0 && sm.failsafe());
+  }
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+int main(int argc, char **argv) {
+  double seconds = 60;
+  unsigned seed = 1;
+  Scenario custom = {"custom", -1, 0, 0};
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) seconds = atof(argv[++i]);
+    else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--loss") == 0 && i + 1 < argc) custom.lossPct = atof(argv[++i]);
+    else if (strcmp(argv[i], "--jitter") == 0 && i + 1 < argc) custom.jitterMs = atof(argv[++i]);
+    else if (strcmp(argv[i], "--bursts") == 0 && i + 1 < argc) custom.burstPct = atof(argv[++i]);
+    else {
+      fprintf(stderr, "usage: %s [--seconds S] [--seed N] [--loss PCT --jitter MS --bursts PCT]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (custom.lossPct >= 0) {
+    runScenario(custom, seconds, seed);
+  } else {
+    static const Scenario scenarios[] = {
+      {"clean",          0, 0.5, 0},
+      {"jittery",        2, 4,   2},
+      {"lossy+jittery", 10, 8,   5},
+    };
+    for (const Scenario &sc : scenarios) runScenario(sc, seconds, seed);
+  }
+  checkDropsAndFailsafe();
+  return checkSummary();
+}
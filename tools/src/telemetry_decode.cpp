@@ -0,0 +1,203 @@
+// telemetry_decode - decode the controller's binary telemetry stream.
+//
+//   telemetry_decode /dev/ttyACM0            live stats once per second
+//   telemetry_decode capture.bin             decode a recorded byte stream
+//   telemetry_decode capture.bin --dump      print every frame
+//
+// Send "STREAM ON" to the controller first (e.g. from a serial monitor), or
+// capture with: cat /dev/ttyACM0 > capture.bin
+// A capture of the DUMP command decodes the same way (--dump lists events).
+
+#include "serial_port.h"
+#include "telemetry_frame.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// ============================================
+// STATISTICS
+// ============================================
+
+struct Stats {
+  uint32_t samples = 0;
+  uint32_t commands = 0;
+  uint32_t acksOk = 0;
+  uint32_t acksFail = 0;
+  uint32_t timings = 0;
+  uint32_t events = 0;           // flight recorder events from DUMP
+  uint32_t unknown = 0;
+  uint32_t seqGaps = 0;          // commands missing between consecutive seqs
+
+  uint64_t ackLatSumUs = 0;      // send -> OnDataSent, matched by seq
+  uint32_t ackLatN = 0;
+  uint32_t ackLatMaxUs = 0;
+
+  uint64_t sendSumUs = 0;        // time inside esp_now_send()
+  uint32_t sendMaxUs = 0;
+  uint32_t loopMaxUs = 0;
+
+  uint32_t firstCmdUs = 0;
+  uint32_t lastCmdUs = 0;
+};
+
+static Stats stats;
+static uint32_t sentAtUs[256];     // command timestamp by seq, for ACK latency
+static bool sentValid[256];
+static int lastSeq = -1;
+
+static const char *eventName(uint8_t type) {
+  switch (type) {
+    case FE_CMD_SENT:    return "CMD_SENT";
+    case FE_ACK:         return "ACK";
+    case FE_NACK:        return "NACK";
+    case FE_CHANNEL:     return "CHANNEL";
+    case FE_REACQ_START: return "REACQ_START";
+    case FE_REACQ_END:   return "REACQ_END";
+    case FE_MODE:        return "MODE";
+    case FE_SELECT:      return "SELECT";
+    case FE_PROBE:       return "PROBE";
+    default:             return "?";
+  }
+}
+
+static void onFrame(const TelemetryDecoder &dec, bool dump) {
+  switch (dec.type()) {
+    case TLM_SAMPLE: {
+      TlmSample s;
+      if (!dec.as(s)) break;
+      stats.samples++;
+      if (dump) printf("%10u SAMPLE  L(%4u,%4u) R(%4u,%4u) btn=%u\n",
+                       s.tUs, s.lx, s.ly, s.rx, s.ry, s.buttons);
+      break;
+    }
+    case TLM_COMMAND: {
+      TlmCommand c;
+      if (!dec.as(c)) break;
+      if (stats.commands == 0) stats.firstCmdUs = c.tUs;
+      stats.lastCmdUs = c.tUs;
+      stats.commands++;
+      if (lastSeq >= 0) stats.seqGaps += (uint8_t)(c.seq - lastSeq - 1);
+      lastSeq = c.seq;
+      sentAtUs[c.seq] = c.tUs;
+      sentValid[c.seq] = true;
+      if (dump) printf("%10u COMMAND dev=%u seq=%3u x=%4d y=%4d rot=%4d spd=%3u btn=%u\n",
+                       c.tUs, c.device, c.seq, c.x, c.y, c.rot, c.speed, c.buttons);
+      break;
+    }
+    case TLM_ACK: {
+      TlmAck a;
+      if (!dec.as(a)) break;
+      if (a.ok) stats.acksOk++;
+      else stats.acksFail++;
+      if (sentValid[a.seq]) {
+        uint32_t lat = a.tUs - sentAtUs[a.seq];
+        stats.ackLatSumUs += lat;
+        stats.ackLatN++;
+        if (lat > stats.ackLatMaxUs) stats.ackLatMaxUs = lat;
+        sentValid[a.seq] = false;
+      }
+      if (dump) printf("%10u ACK     dev=%u seq=%3u %s\n",
+                       a.tUs, a.device, a.seq, a.ok ? "OK" : "FAIL");
+      break;
+    }
+    case TLM_TIMING: {
+      TlmTiming t;
+      if (!dec.as(t)) break;
+      stats.timings++;
+      stats.sendSumUs += t.sendUs;
+      if (t.sendUs > stats.sendMaxUs) stats.sendMaxUs = t.sendUs;
+      if (t.loopUs > stats.loopMaxUs) stats.loopMaxUs = t.loopUs;
+      if (dump) printf("%10u TIMING  loop=%uus send=%uus\n", t.tUs, t.loopUs, t.sendUs);
+      break;
+    }
+    case TLM_EVENTS: {
+      size_t n = dec.length() / sizeof(FlightEvent);
+      for (size_t i = 0; i < n; i++) {
+        FlightEvent e;
+        memcpy(&e, dec.payload() + i * sizeof(e), sizeof(e));
+        stats.events++;
+        if (dump) printf("%10u EVENT   %-11s a=%u b=%u\n", e.tUs, eventName(e.type), e.a, e.b);
+      }
+      break;
+    }
+    default:
+      stats.unknown++;
+      break;
+  }
+}
+
+static void printStats(const TelemetryDecoder &dec, const char *prefix) {
+  double spanS = (stats.lastCmdUs - stats.firstCmdUs) / 1e6;
+  double rate = spanS > 0 ? (stats.commands - 1) / spanS : 0.0;
+  uint32_t acks = stats.acksOk + stats.acksFail;
+  printf("%sframes=%u crc_err=%u bad=%u | cmd=%u (%.1f Hz) gaps=%u | "
+         "ack ok=%u fail=%u (%.1f%%) lat avg=%.0fus max=%uus | "
+         "send avg=%.0fus max=%uus loop max=%uus | events=%u\n",
+         prefix, dec.frames, dec.crcErrors, dec.badFrames,
+         stats.commands, rate, stats.seqGaps,
+         stats.acksOk, stats.acksFail, acks ? 100.0 * stats.acksOk / acks : 0.0,
+         stats.ackLatN ? (double)stats.ackLatSumUs / stats.ackLatN : 0.0, stats.ackLatMaxUs,
+         stats.timings ? (double)stats.sendSumUs / stats.timings : 0.0, stats.sendMaxUs,
+         stats.loopMaxUs, stats.events);
+  fflush(stdout);
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+static void usage(const char *argv0) {
+  fprintf(stderr, "usage: %s <tty|capture-file> [--baud N] [--dump]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+  const char *path = nullptr;
+  int baud = 115200;
+  bool dump = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--dump") == 0) dump = true;
+    else if (strcmp(argv[i], "--baud") == 0 && i + 1 < argc) baud = atoi(argv[++i]);
+    else if (argv[i][0] != '-' && !path) path = argv[i];
+    else { usage(argv[0]); return 2; }
+  }
+  if (!path) { usage(argv[0]); return 2; }
+
+  bool isTty = false;
+  int fd = openByteSource(path, baud, isTty);
+  if (fd < 0) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return 1;
+  }
+
+  TelemetryDecoder dec;
+  uint8_t buf[4096];
+  time_t lastReport = time(nullptr);
+
+  for (;;) {
+    ssize_t n = read(fd, buf, sizeof(buf));
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      fprintf(stderr, "read: %s\n", strerror(errno));
+      break;
+    }
+    if (n == 0 && !isTty) break;   // end of capture file
+
+    for (ssize_t i = 0; i < n; i++) {
+      if (dec.push(buf[i])) onFrame(dec, dump);
+    }
+
+    if (isTty && !dump && time(nullptr) != lastReport) {
+      lastReport = time(nullptr);
+      printStats(dec, "");
+    }
+  }
+
+  close(fd);
+  printStats(dec, "total: ");
+  return 0;
+}
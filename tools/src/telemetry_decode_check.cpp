@@ -0,0 +1,364 @@
+// telemetry_decode_check - the telemetry stream decoder (TelemetryDecoder)
+// and telemetry_decode on a captured byte stream with the faults a real
+// capture has: joined mid-frame, text printed while streaming, a corrupted
+// byte, a frame cut short, line noise and a DUMP with its text header.
+//
+//   telemetry_decode_check                   check tools/fixtures/telemetry_capture.bin
+//   telemetry_decode_check <capture>         check another copy of it
+//   telemetry_decode_check --write <path>    write the fixture from the plan below
+//
+// The fixture is kept in the tree so a change to the framing or the record
+// layouts shows up as a mismatch here; rewrite it with --write only when
+// the wire format is meant to change.
+//
+// Plan of the capture, in control ticks of 20 ms (S sample, C command,
+// T timing, A ack, E events; every frame ends in 0x00 unless noted):
+//   tick 0   only the last 6 bytes of C: the capture started mid-frame
+//   tick 1   "Binary telemetry stream ON ..." glued to S, then C T A
+//   tick 2   S C T A
+//   tick 3   S with one bit flipped in its CRC, then C T A
+//   tick 4   S, C cut after 7 bytes and glued to T, then A
+//   tick 5   "Selected device 1" glued to S, then C T A (NACK)
+//   tick 6   three bare 0x00, 50 bytes of noise and a 0x00, then S C T A
+//   tick 7   "DUMP 3 events" and its 0x00, E, "DUMP end ..." glued to S,
+//            then C T A
+//   tick 8   S, then C cut off by the end of the capture
+
+#include "check.h"
+#include "telemetry_frame.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+static const char *decoder = TELEMETRY_DECODE;
+
+// ============================================
+// RECORDS
+// ============================================
+// What the controller sent on tick n; the expectations below use the same
+// values, so only the bytes in the fixture pin the wire format.
+
+#define TICKS 9
+
+static TlmSample sampleAt(int n) {
+  TlmSample s;
+  s.tUs = 20000 * n + 40;
+  s.lx = 2047 + 13 * n;
+  s.ly = 2051 - 7 * n;
+  s.rx = 1990 + n;
+  s.ry = 2103;
+  s.buttons = n == 6 ? 0x01 : 0;
+  return s;
+}
+
+static TlmCommand commandAt(int n) {
+  TlmCommand c;
+  c.tUs = 20000 * n + 150;
+  c.device = 1;
+  c.seq = (uint8_t)(100 + n);
+  c.x = (int8_t)(10 * n - 40);
+  c.y = 35;
+  c.rot = (int8_t)(-n);
+  c.speed = 60;
+  c.buttons = n == 6 ? 0x01 : 0;
+  return c;
+}
+
+static TlmTiming timingAt(int n) {
+  TlmTiming t;
+  t.tUs = 20000 * n + 160;
+  t.loopUs = (uint16_t)(19990 + 3 * n);
+  t.sendUs = (uint16_t)(110 + n);
+  return t;
+}
+
+static TlmAck ackAt(int n) {
+  TlmAck a;
+  a.tUs = 20000 * n + 1100;
+  a.device = 1;
+  a.seq = (uint8_t)(100 + n);
+  a.ok = n != 5;
+  return a;
+}
+
+static FlightEvent eventAt(int i) {
+  FlightEvent e;
+  e.tUs = 140000 + 20 * i;
+  e.type = i == 2 ? FE_ACK : FE_CMD_SENT;
+  e.a = 1;
+  e.b = (uint16_t)(106 + (i == 2));
+  return e;
+}
+
+#define DUMP_EVENTS 3
+
+// ============================================
+// CAPTURE
+// ============================================
+
+typedef std::vector<uint8_t> Bytes;
+
+template <typename T> static Bytes frame(uint8_t type, const T &rec) {
+  uint8_t buf[TLM_MAX_ENCODED];
+  size_t n = tlmEncodeFrame(type, &rec, sizeof(rec), buf);
+  return Bytes(buf, buf + n);
+}
+
+static void add(Bytes &out, const Bytes &b) { out.insert(out.end(), b.begin(), b.end()); }
+static void text(Bytes &out, const char *s) { out.insert(out.end(), s, s + strlen(s)); }
+
+static Bytes buildCapture() {
+  Bytes out;
+  Bytes c0 = frame(TLM_COMMAND, commandAt(0));
+  out.insert(out.end(), c0.end() - 6, c0.end());
+
+  for (int n = 1; n < TICKS; n++) {
+    if (n == 1) text(out, "Binary telemetry stream ON (send STREAM OFF to stop)\r\n");
+    if (n == 5) text(out, "Selected device 1\r\n");
+    if (n == 6) {
+      out.insert(out.end(), 3, 0);
+      for (int i = 0; i < 50; i++) out.push_back((uint8_t)(0x80 | (i * 37)));
+      out.push_back(0);
+    }
+    if (n == 7) {
+      FlightEvent ev[DUMP_EVENTS];
+      for (int i = 0; i < DUMP_EVENTS; i++) ev[i] = eventAt(i);
+      text(out, "DUMP 3 events\n");
+      out.push_back(0);
+      add(out, frame(TLM_EVENTS, ev));
+      text(out, "\nDUMP end (0 overwritten during dump)\n");
+    }
+
+    Bytes s = frame(TLM_SAMPLE, sampleAt(n));
+    if (n == 3) s[s.size() - 2] ^= 0x01;   // low CRC byte
+    add(out, s);
+
+    Bytes c = frame(TLM_COMMAND, commandAt(n));
+    if (n == 4 || n == 8) c.resize(7);
+    add(out, c);
+    if (n == 8) break;
+
+    add(out, frame(TLM_TIMING, timingAt(n)));
+    add(out, frame(TLM_ACK, ackAt(n)));
+  }
+  return out;
+}
+
+// One letter per non-empty delimiter, in order: the type of a good frame
+// (S C A T E), c for a CRC error, b for a frame that does not decode.
+static const char expectedOutcomes[] =
+  "c"         // tick 0: the tail decodes as COBS, the CRC catches it
+  "bCTA"      // 1
+  "SCTA"      // 2
+  "cCTA"      // 3
+  "ScA"       // 4
+  "bCTA"      // 5
+  "bSCTA"     // 6
+  "bEbCTA"    // 7
+  "S";        // 8
+
+static char letter(uint8_t type) {
+  switch (type) {
+    case TLM_SAMPLE:  return 'S';
+    case TLM_COMMAND: return 'C';
+    case TLM_ACK:     return 'A';
+    case TLM_TIMING:  return 'T';
+    case TLM_EVENTS:  return 'E';
+    default:          return '?';
+  }
+}
+
+// ============================================
+// DECODING
+// ============================================
+
+struct Decoded {
+  std::string outcomes;
+  std::vector<size_t> endsAt;        // capture offset of each outcome's 0x00
+  std::vector<Bytes> frames;         // type + payload of each good frame
+  uint32_t frameCount = 0, crcErrors = 0, badFrames = 0;
+};
+
+static Decoded decode(const Bytes &in, size_t from = 0) {
+  Decoded d;
+  TelemetryDecoder dec;
+  for (size_t i = from; i < in.size(); i++) {
+    uint32_t crc = dec.crcErrors, bad = dec.badFrames;
+    if (dec.push(in[i])) {
+      d.outcomes += letter(dec.type());
+      Bytes f(1 + dec.length());
+      f[0] = dec.type();
+      memcpy(&f[1], dec.payload(), dec.length());
+      d.frames.push_back(f);
+    } else if (dec.crcErrors != crc) {
+      d.outcomes += 'c';
+    } else if (dec.badFrames != bad) {
+      d.outcomes += 'b';
+    } else {
+      continue;
+    }
+    d.endsAt.push_back(i);
+  }
+  d.frameCount = dec.frames;
+  d.crcErrors = dec.crcErrors;
+  d.badFrames = dec.badFrames;
+  return d;
+}
+
+template <typename T> static bool is(const Bytes &f, uint8_t type, const T &rec) {
+  return f.size() == 1 + sizeof(T) && f[0] == type && memcmp(f.data() + 1, &rec, sizeof(T)) == 0;
+}
+
+// ============================================
+// CHECKS
+// ============================================
+
+static void checkFixture(const Bytes &capture) {
+  printf("fixture against the plan\n");
+  Bytes planned = buildCapture();
+  printf("  %zu bytes\n", capture.size());
+  CHECK(capture == planned);
+  if (capture != planned) printf("  the encoder no longer writes the fixture's bytes\n");
+}
+
+static void checkOutcomes(const Bytes &capture) {
+  printf("frames, errors and resync points\n");
+  Decoded d = decode(capture);
+  printf("  %s\n", d.outcomes.c_str());
+  CHECK(d.outcomes == expectedOutcomes);
+  CHECK(d.frameCount == 24 && d.crcErrors == 3 && d.badFrames == 5);
+
+  // Every good frame carries exactly what was sent, in order; the frames
+  // right after each fault are the ones the decoder resynced on.
+  std::vector<Bytes> want;
+  auto put = [&](uint8_t type, const void *p, size_t len) {
+    Bytes f(1 + len);
+    f[0] = type;
+    memcpy(&f[1], p, len);
+    want.push_back(f);
+  };
+  for (int n = 1; n < TICKS; n++) {
+    TlmSample s = sampleAt(n);
+    TlmCommand c = commandAt(n);
+    TlmTiming t = timingAt(n);
+    TlmAck a = ackAt(n);
+    if (n == 7) {
+      FlightEvent ev[DUMP_EVENTS];
+      for (int i = 0; i < DUMP_EVENTS; i++) ev[i] = eventAt(i);
+      put(TLM_EVENTS, ev, sizeof(ev));
+    }
+    if (n == 2 || n == 4 || n == 6 || n == 8) put(TLM_SAMPLE, &s, sizeof(s));
+    if (n == 8) break;
+    if (n != 4) put(TLM_COMMAND, &c, sizeof(c));
+    if (n != 4) put(TLM_TIMING, &t, sizeof(t));
+    put(TLM_ACK, &a, sizeof(a));
+  }
+  CHECK(d.frames == want);
+
+  // Spot checks through the typed views the tools use.
+  CHECK(d.frames.size() > 2 && is(d.frames[0], TLM_COMMAND, commandAt(1)));
+  TelemetryDecoder one;
+  Bytes s2 = frame(TLM_SAMPLE, sampleAt(2));
+  bool got = false;
+  for (uint8_t b : s2) got = one.push(b);
+  TlmSample back;
+  TlmCommand wrongSize;
+  CHECK(got && one.as(back) && back.tUs == sampleAt(2).tUs && back.lx == sampleAt(2).lx);
+  CHECK(!one.as(wrongSize));
+}
+
+// Joining the stream at any byte loses at most the frame in progress: from
+// the first 0x00 on, the outcomes are those of the whole capture.
+static void checkJoinAnywhere(const Bytes &capture) {
+  printf("joining at every offset\n");
+  Decoded whole = decode(capture);
+  int wrong = 0;
+  for (size_t from = 0; from < capture.size(); from++) {
+    size_t z = from;
+    while (z < capture.size() && capture[z] != 0) z++;
+    Decoded part = decode(capture, from);
+    size_t skip = part.endsAt.size() && part.endsAt[0] == z ? 1 : 0;
+    size_t k = 0;
+    while (k < whole.endsAt.size() && whole.endsAt[k] <= z) k++;
+    if (part.outcomes.compare(skip, std::string::npos, whole.outcomes, k, std::string::npos) != 0) wrong++;
+  }
+  printf("  %zu offsets, %d resync wrong\n", capture.size(), wrong);
+  CHECK(wrong == 0);
+}
+
+static std::string run(const std::string &args) {
+  std::string cmd = std::string(decoder) + " " + args + " 2>&1";
+  std::string out;
+  FILE *f = popen(cmd.c_str(), "r");
+  if (!f) return out;
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+  if (pclose(f) != 0) out += "\n(exit status)";
+  return out;
+}
+
+// telemetry_decode on the same file: totals, command stats and the dump.
+static void checkTool(const char *fixture) {
+  printf("telemetry_decode\n");
+  std::string out = run(fixture);
+  printf("  %s", out.c_str());
+  CHECK(out.find("total: frames=24 crc_err=3 bad=5 | cmd=6 ") != std::string::npos);
+  CHECK(out.find("gaps=1 ") != std::string::npos);          // seq 104 lost with tick 4's C
+  CHECK(out.find("ack ok=6 fail=1 ") != std::string::npos);
+  CHECK(out.find("events=3\n") != std::string::npos);
+
+  std::string dump = run(std::string(fixture) + " --dump");
+  size_t lines = 0;
+  for (char ch : dump) lines += ch == '\n';
+  CHECK(lines == 24 - 1 + DUMP_EVENTS + 1);                 // E expands, plus the total line
+  CHECK(dump.find("   60160 TIMING  loop=19999us send=113us\n") != std::string::npos);
+  CHECK(dump.find("  140040 EVENT   ACK         a=1 b=107\n") != std::string::npos);
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+static bool readFile(const char *path, Bytes &out) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+  fclose(f);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  const char *fixture = TELEMETRY_FIXTURE;
+  if (argc == 3 && strcmp(argv[1], "--write") == 0) {
+    Bytes b = buildCapture();
+    FILE *f = fopen(argv[2], "wb");
+    if (!f || fwrite(b.data(), 1, b.size(), f) != b.size() || fclose(f) != 0) {
+      perror(argv[2]);
+      return 1;
+    }
+    printf("wrote %zu bytes to %s\n", b.size(), argv[2]);
+    return 0;
+  }
+  if (argc == 2 && argv[1][0] != '-') fixture = argv[1];
+  else if (argc != 1) {
+    fprintf(stderr, "usage: telemetry_decode_check [capture] | --write <path>\n");
+    return 2;
+  }
+
+  Bytes capture;
+  if (!readFile(fixture, capture)) {
+    perror(fixture);
+    return 1;
+  }
+  checkFixture(capture);
+  checkOutcomes(capture);
+  checkJoinAnywhere(capture);
+  checkTool(fixture);
+  return checkSummary();
+}
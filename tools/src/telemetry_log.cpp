@@ -0,0 +1,224 @@
+#include "telemetry_log.h"
+#include "telemetry_frame.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ============================================
+// HELPERS
+// ============================================
+
+// Only commands and ACKs are addressed to a device.
+static bool hasDevice(const LogRecord &r) {
+  return (r.type == TLM_COMMAND || r.type == TLM_ACK) && r.device < 32;
+}
+
+LogIndexEntry summarizeRecords(const LogRecord *recs, uint64_t n) {
+  LogIndexEntry e = {};
+  if (n == 0) return e;
+  e.firstTUs = recs[0].tUs;
+  e.lastTUs = recs[n - 1].tUs;
+  for (uint64_t i = 0; i < n; i++) {
+    if (hasDevice(recs[i])) e.deviceMask |= 1u << recs[i].device;
+    if (recs[i].type == TLM_ACK && !recs[i].ok) e.ackFails++;
+  }
+  return e;
+}
+
+static std::string indexPath(const char *path) {
+  return std::string(path) + ".idx";
+}
+
+static size_t bytesFor(uint64_t records) {
+  return sizeof(LogHeader) + records * sizeof(LogRecord);
+}
+
+// ============================================
+// WRITER
+// ============================================
+
+bool LogWriter::open(const char *path) {
+  close();
+  _fd = ::open(path, O_RDWR | O_CREAT, 0644);
+  if (_fd < 0) return false;
+
+  struct stat st;
+  if (fstat(_fd, &st) != 0) { close(); return false; }
+  bool fresh = st.st_size == 0;
+  if (!fresh && (size_t)st.st_size < sizeof(LogHeader)) { close(); return false; }
+
+  if (!remap(fresh ? LOG_GROW_BYTES : (size_t)st.st_size)) { close(); return false; }
+  _hdr = (LogHeader *)_map;
+  if (fresh) {
+    memset(_hdr, 0, sizeof(LogHeader));
+    _hdr->magic = LOG_MAGIC;
+    _hdr->version = LOG_VERSION;
+    _hdr->recordSize = sizeof(LogRecord);
+  } else if (_hdr->magic != LOG_MAGIC || _hdr->recordSize != sizeof(LogRecord)) {
+    close();
+    return false;
+  }
+
+  // Trust the header count only as far as the file actually reaches.
+  uint64_t fits = (_mapLen - sizeof(LogHeader)) / sizeof(LogRecord);
+  if (_hdr->count > fits) _hdr->count = fits;
+  const LogRecord *recs = (const LogRecord *)(_map + sizeof(LogHeader));
+  _lastTUs = _hdr->count ? recs[_hdr->count - 1].tUs : 0;
+
+  // The idx file must hold exactly one entry per complete block; rebuild it
+  // from the data if a previous session died before writing it out.
+  _idxFd = ::open(indexPath(path).c_str(), O_RDWR | O_CREAT, 0644);
+  if (_idxFd < 0) { close(); return false; }
+  uint64_t complete = _hdr->count / LOG_BLOCK_RECORDS;
+  if (fstat(_idxFd, &st) != 0) { close(); return false; }
+  if ((uint64_t)st.st_size != complete * sizeof(LogIndexEntry)) {
+    if (ftruncate(_idxFd, 0) != 0) { close(); return false; }
+    for (uint64_t b = 0; b < complete; b++) {
+      LogIndexEntry e = summarizeRecords(recs + b * LOG_BLOCK_RECORDS, LOG_BLOCK_RECORDS);
+      if (pwrite(_idxFd, &e, sizeof(e), b * sizeof(e)) != (ssize_t)sizeof(e)) { close(); return false; }
+    }
+  }
+  lseek(_idxFd, 0, SEEK_END);
+
+  uint64_t tail = _hdr->count % LOG_BLOCK_RECORDS;
+  _block = summarizeRecords(recs + complete * LOG_BLOCK_RECORDS, tail);
+  return true;
+}
+
+bool LogWriter::remap(size_t bytes) {
+  if (_map) munmap(_map, _mapLen);
+  _map = nullptr;
+  _hdr = nullptr;
+  if (ftruncate(_fd, bytes) != 0) return false;
+  void *m = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+  if (m == MAP_FAILED) return false;
+  _map = (uint8_t *)m;
+  _mapLen = bytes;
+  _hdr = (LogHeader *)_map;
+  return true;
+}
+
+void LogWriter::foldIntoBlock(const LogRecord &rec) {
+  if (_hdr->count % LOG_BLOCK_RECORDS == 0) {
+    _block = {};
+    _block.firstTUs = rec.tUs;
+  }
+  _block.lastTUs = rec.tUs;
+  if (hasDevice(rec)) _block.deviceMask |= 1u << rec.device;
+  if (rec.type == TLM_ACK && !rec.ok) _block.ackFails++;
+}
+
+bool LogWriter::append(const LogRecord &rec) {
+  if (!_hdr) return false;
+  if (bytesFor(_hdr->count + 1) > _mapLen) {
+    if (!remap(_mapLen + LOG_GROW_BYTES)) return false;
+  }
+
+  LogRecord *recs = (LogRecord *)(_map + sizeof(LogHeader));
+  recs[_hdr->count] = rec;
+  if (_hdr->count == 0) _hdr->firstTUs = rec.tUs;
+  foldIntoBlock(rec);
+  _hdr->count++;   // commit only after the record is in place
+  _lastTUs = rec.tUs;
+
+  if (_hdr->count % LOG_BLOCK_RECORDS == 0) {
+    if (write(_idxFd, &_block, sizeof(_block)) != (ssize_t)sizeof(_block)) return false;
+  }
+  return true;
+}
+
+void LogWriter::close() {
+  if (_map) {
+    size_t used = bytesFor(_hdr->count);
+    msync(_map, _mapLen, MS_SYNC);
+    munmap(_map, _mapLen);
+    if (ftruncate(_fd, used) != 0) {
+      // Leaves trailing slack; readers bound themselves by the header count.
+    }
+  }
+  _map = nullptr;
+  _hdr = nullptr;
+  _mapLen = 0;
+  if (_fd >= 0) ::close(_fd);
+  if (_idxFd >= 0) ::close(_idxFd);
+  _fd = _idxFd = -1;
+}
+
+// ============================================
+// READER
+// ============================================
+
+bool LogReader::open(const char *path) {
+  close();
+  _fd = ::open(path, O_RDONLY);
+  if (_fd < 0) return false;
+
+  struct stat st;
+  if (fstat(_fd, &st) != 0 || (size_t)st.st_size < sizeof(LogHeader)) { close(); return false; }
+  void *m = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, _fd, 0);
+  if (m == MAP_FAILED) { close(); return false; }
+  _map = (uint8_t *)m;
+  _mapLen = st.st_size;
+
+  const LogHeader *hdr = (const LogHeader *)_map;
+  if (hdr->magic != LOG_MAGIC || hdr->recordSize != sizeof(LogRecord)) { close(); return false; }
+  uint64_t fits = (_mapLen - sizeof(LogHeader)) / sizeof(LogRecord);
+  _count = hdr->count < fits ? hdr->count : fits;
+  _recs = (const LogRecord *)(_map + sizeof(LogHeader));
+
+  // Complete blocks come from the idx file where present; anything it does
+  // not cover (stale idx, tail block) is summarised from the records.
+  uint64_t complete = _count / LOG_BLOCK_RECORDS;
+  _index.clear();
+  _index.reserve(complete + 1);
+  int idxFd = ::open(indexPath(path).c_str(), O_RDONLY);
+  if (idxFd >= 0) {
+    LogIndexEntry e;
+    while (_index.size() < complete && read(idxFd, &e, sizeof(e)) == (ssize_t)sizeof(e)) {
+      _index.push_back(e);
+    }
+    ::close(idxFd);
+  }
+  for (uint64_t b = _index.size(); b * LOG_BLOCK_RECORDS < _count; b++) {
+    uint64_t n = _count - b * LOG_BLOCK_RECORDS;
+    if (n > LOG_BLOCK_RECORDS) n = LOG_BLOCK_RECORDS;
+    _index.push_back(summarizeRecords(_recs + b * LOG_BLOCK_RECORDS, n));
+  }
+  return true;
+}
+
+void LogReader::close() {
+  if (_map) munmap(_map, _mapLen);
+  if (_fd >= 0) ::close(_fd);
+  _map = nullptr;
+  _mapLen = 0;
+  _fd = -1;
+  _recs = nullptr;
+  _count = 0;
+  _index.clear();
+}
+
+uint64_t LogReader::lowerBound(uint64_t t) const {
+  // Find the first block that can contain t, then search inside it.
+  size_t lo = 0, hi = _index.size();
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (_index[mid].lastTUs < t) lo = mid + 1;
+    else hi = mid;
+  }
+  if (lo == _index.size()) return _count;
+
+  uint64_t a = (uint64_t)lo * LOG_BLOCK_RECORDS;
+  uint64_t b = a + LOG_BLOCK_RECORDS;
+  if (b > _count) b = _count;
+  while (a < b) {
+    uint64_t mid = (a + b) / 2;
+    if (_recs[mid].tUs < t) a = mid + 1;
+    else b = mid;
+  }
+  return a;
+}
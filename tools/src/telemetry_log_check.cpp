@@ -0,0 +1,497 @@
+// telemetry_log_check - the mmap'd telemetry log (telemetry_log.cpp) and
+// telemetry_recorder's queries on a synthetic log: append and reopen, the
+// idx rebuild after a truncated idx or log, lowerBound, and the range,
+// device, loss and latency answers against a plain scan of the records.
+//
+//   telemetry_log_check                   run every check, exit 1 on a failure
+//   telemetry_log_check <recorder>        use another telemetry_recorder build
+//
+// The queries are checked through the telemetry_recorder binary, the way
+// they are used; the "record" path is fed an encoded capture built here.
+// Logs go to a fresh directory under /tmp that is removed afterwards.
+
+#include "check.h"
+#include "telemetry_frame.h"
+#include "telemetry_log.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <algorithm>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#define RECORDS 18500              // four full blocks and a partial tail
+#define BASE_US 1700000000000000ULL
+
+static std::string dir;
+static const char *recorder = TELEMETRY_RECORDER;
+
+static std::string path(const char *name) { return dir + "/" + name; }
+
+// ============================================
+// SYNTHETIC LOG
+// ============================================
+// Four records per 1 ms tick: command, its ACK (same tUs, as the recorder
+// pins a late ACK), a stick sample and a timing record (same tUs again), so
+// lowerBound meets runs of equal times. The commands go to device 0, 1 or 2
+// in 3000-tick stretches, and to device 5 for ticks 1500..1599 only. ACKs
+// fail in bursts of 0..4 every 97 ticks; every 50th ACK is unmatched.
+
+static LogRecord synth(uint64_t i) {
+  static const uint8_t types[4] = {TLM_COMMAND, TLM_ACK, TLM_SAMPLE, TLM_TIMING};
+  uint64_t tick = i / 4;
+  LogRecord r = {};
+  r.type = types[i % 4];
+  r.tUs = BASE_US + tick * 1000 + (i % 4 >= 2 ? 500 : 0);
+  r.devUs = (uint32_t)r.tUs;
+  r.device = tick >= 1500 && tick < 1600 ? 5 : (tick / 3000) % 3;
+  r.seq = (uint8_t)tick;
+  if (r.type == TLM_COMMAND) {
+    r.cmd.x = (int8_t)(tick % 200 - 100);
+    r.cmd.speed = 50;
+  } else if (r.type == TLM_ACK) {
+    r.ok = tick % 97 >= (tick / 97) % 5;
+    r.latencyUs = tick % 50 == 0 ? 0 : 800 + (uint32_t)(tick * 37 % 3000);
+  } else {
+    r.device = 0;
+    for (int k = 0; k < 4; k++) r.v[k] = (uint16_t)(tick + k);
+  }
+  return r;
+}
+
+static bool writeLog(const std::string &p, uint64_t from, uint64_t to) {
+  LogWriter w;
+  if (!w.open(p.c_str())) return false;
+  for (uint64_t i = from; i < to; i++) {
+    if (!w.append(synth(i))) return false;
+  }
+  return true;
+}
+
+// The index entries a correct log has, worked out from the records alone.
+static LogIndexEntry expectBlock(const LogReader &r, size_t b) {
+  LogIndexEntry e = {};
+  uint64_t a = (uint64_t)b * LOG_BLOCK_RECORDS;
+  uint64_t z = std::min<uint64_t>(a + LOG_BLOCK_RECORDS, r.count());
+  e.firstTUs = r.at(a).tUs;
+  e.lastTUs = r.at(z - 1).tUs;
+  for (uint64_t i = a; i < z; i++) {
+    const LogRecord &x = r.at(i);
+    if (x.type == TLM_COMMAND || x.type == TLM_ACK) e.deviceMask |= 1u << x.device;
+    if (x.type == TLM_ACK && !x.ok) e.ackFails++;
+  }
+  return e;
+}
+
+static bool blocksMatch(const LogReader &r) {
+  if (r.blocks() != (r.count() + LOG_BLOCK_RECORDS - 1) / LOG_BLOCK_RECORDS) return false;
+  for (size_t b = 0; b < r.blocks(); b++) {
+    LogIndexEntry e = expectBlock(r, b);
+    if (memcmp(&e, &r.block(b), sizeof(e)) != 0) return false;
+  }
+  return true;
+}
+
+// The idx file on disk: exactly the complete blocks, each correct.
+static bool idxFileMatches(const std::string &p, const LogReader &r) {
+  FILE *f = fopen((p + ".idx").c_str(), "rb");
+  if (!f) return false;
+  std::vector<LogIndexEntry> idx;
+  LogIndexEntry e;
+  while (fread(&e, sizeof(e), 1, f) == 1) idx.push_back(e);
+  bool partial = fgetc(f) != EOF;
+  fclose(f);
+  if (partial || idx.size() != r.count() / LOG_BLOCK_RECORDS) return false;
+  for (size_t b = 0; b < idx.size(); b++) {
+    LogIndexEntry x = expectBlock(r, b);
+    if (memcmp(&x, &idx[b], sizeof(x)) != 0) return false;
+  }
+  return true;
+}
+
+static bool recordsMatch(const LogReader &r, uint64_t n) {
+  if (r.count() != n) return false;
+  for (uint64_t i = 0; i < n; i++) {
+    LogRecord x = synth(i);
+    if (memcmp(&x, &r.at(i), sizeof(x)) != 0) return false;
+  }
+  return true;
+}
+
+static off_t fileSize(const std::string &p) {
+  struct stat st;
+  return stat(p.c_str(), &st) == 0 ? st.st_size : -1;
+}
+
+// ============================================
+// LOG FILE CHECKS
+// ============================================
+
+static void checkAppendReopen() {
+  printf("append and reopen\n");
+  std::string p = path("append.log");
+  CHECK(writeLog(p, 0, 10000));
+  CHECK(fileSize(p) == (off_t)(sizeof(LogHeader) + 10000 * sizeof(LogRecord)));   // slack trimmed
+  CHECK(fileSize(p + ".idx") == (off_t)(2 * sizeof(LogIndexEntry)));
+
+  // Reopening picks up the count, last time and the partial block.
+  {
+    LogWriter w;
+    CHECK(w.open(p.c_str()));
+    CHECK(w.count() == 10000 && w.lastTUs() == synth(9999).tUs);
+    for (uint64_t i = 10000; i < RECORDS; i++) w.append(synth(i));
+  }
+  LogReader r;
+  CHECK(r.open(p.c_str()));
+  CHECK(recordsMatch(r, RECORDS));
+  CHECK(r.firstTUs() == BASE_US && r.lastTUs() == synth(RECORDS - 1).tUs);
+  CHECK(blocksMatch(r) && r.blocks() == 5);
+  CHECK(idxFileMatches(p, r));
+
+  // An empty log reopens empty; a file that is not a log is refused.
+  std::string e = path("empty.log");
+  CHECK(writeLog(e, 0, 0));
+  LogReader er;
+  CHECK(er.open(e.c_str()) && er.count() == 0 && er.blocks() == 0 && er.lowerBound(0) == 0);
+  FILE *f = fopen(path("junk.log").c_str(), "wb");
+  for (int i = 0; i < 200; i++) fputc('x', f);
+  fclose(f);
+  LogReader jr;
+  LogWriter jw;
+  CHECK(!jr.open(path("junk.log").c_str()) && !jw.open(path("junk.log").c_str()));
+}
+
+static void checkTruncation() {
+  printf("idx rebuild after truncation\n");
+  std::string p = path("append.log");
+
+  // idx cut mid-entry: the reader summarises what it lacks, the writer
+  // rewrites the file.
+  CHECK(truncate((p + ".idx").c_str(), sizeof(LogIndexEntry) + 10) == 0);
+  {
+    LogReader r;
+    CHECK(r.open(p.c_str()) && blocksMatch(r));
+  }
+  {
+    LogWriter w;
+    CHECK(w.open(p.c_str()) && w.count() == RECORDS);
+  }
+  {
+    LogReader r;
+    CHECK(r.open(p.c_str()) && idxFileMatches(p, r));
+  }
+
+  // idx gone entirely.
+  CHECK(unlink((p + ".idx").c_str()) == 0);
+  {
+    LogReader r;
+    CHECK(r.open(p.c_str()) && blocksMatch(r) && recordsMatch(r, RECORDS));
+  }
+  {
+    LogWriter w;
+    CHECK(w.open(p.c_str()));
+  }
+  CHECK(fileSize(p + ".idx") == (off_t)(4 * sizeof(LogIndexEntry)));
+
+  // Log cut mid-record, header count still claiming everything (a capture
+  // that died before the final trim). Both sides trust only whole records;
+  // the writer rebuilds the now too long idx and carries on appending.
+  const uint64_t kept = 9000;
+  CHECK(truncate(p.c_str(), sizeof(LogHeader) + kept * sizeof(LogRecord) + 10) == 0);
+  {
+    LogReader r;
+    CHECK(r.open(p.c_str()) && recordsMatch(r, kept) && blocksMatch(r));
+    CHECK(r.lowerBound(synth(RECORDS - 1).tUs) == kept);
+  }
+  {
+    LogWriter w;
+    CHECK(w.open(p.c_str()) && w.count() == kept && w.lastTUs() == synth(kept - 1).tUs);
+    for (uint64_t i = kept; i < RECORDS; i++) w.append(synth(i));
+  }
+  LogReader r;
+  CHECK(r.open(p.c_str()) && recordsMatch(r, RECORDS));
+  CHECK(blocksMatch(r) && idxFileMatches(p, r));
+}
+
+static void checkLowerBound() {
+  printf("lowerBound\n");
+  LogReader r;
+  CHECK(r.open(path("append.log").c_str()));
+  if (!r.count()) return;
+  auto linear = [&](uint64_t t) {
+    uint64_t i = 0;
+    while (i < r.count() && r.at(i).tUs < t) i++;
+    return i;
+  };
+  uint64_t last = r.lastTUs();
+  int wrong = 0, probes = 0;
+  // Every distinct time, the gaps on both sides of it, and the ends.
+  for (uint64_t t = BASE_US - 1000; t <= last + 1000; t += 250) {
+    probes++;
+    if (r.lowerBound(t) != linear(t)) wrong++;
+  }
+  const uint64_t ends[] = {0, BASE_US, last, last + 1, UINT64_MAX};
+  for (uint64_t t : ends) {
+    probes++;
+    if (r.lowerBound(t) != linear(t)) wrong++;
+  }
+  // Block edges: the record at the edge and its neighbours.
+  for (uint64_t b = LOG_BLOCK_RECORDS; b < r.count(); b += LOG_BLOCK_RECORDS) {
+    for (uint64_t i = b - 1; i <= b + 1; i++) {
+      probes++;
+      if (r.lowerBound(r.at(i).tUs) != linear(r.at(i).tUs)) wrong++;
+    }
+  }
+  printf("  %d probes\n", probes);
+  CHECK(wrong == 0);
+  CHECK(r.lowerBound(BASE_US) == 0 && r.lowerBound(last + 1) == r.count());
+  CHECK(r.lowerBound(BASE_US + 500) == 2);          // first of a run of equal times
+}
+
+// ============================================
+// QUERY CHECKS
+// ============================================
+
+static std::string run(const std::string &args) {
+  std::string cmd = std::string(recorder) + " " + args + " 2>&1";
+  std::string out;
+  FILE *f = popen(cmd.c_str(), "r");
+  if (!f) return out;
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+  if (pclose(f) != 0) out += "\n(exit status)";
+  return out;
+}
+
+static const char *after(const std::string &out, const char *key) {
+  size_t at = out.find(key);
+  return at == std::string::npos ? "" : out.c_str() + at;
+}
+
+// Records in [fromS, toS] seconds from the start, optionally one device's.
+template <typename Fn>
+static void brute(const LogReader &r, double fromS, double toS, int device, Fn fn) {
+  for (uint64_t i = 0; i < r.count(); i++) {
+    const LogRecord &x = r.at(i);
+    double s = (x.tUs - r.firstTUs()) / 1e6;
+    if ((fromS >= 0 && s < fromS) || (toS >= 0 && s > toS)) continue;
+    if (device >= 0 && ((x.type != TLM_COMMAND && x.type != TLM_ACK) || x.device != device)) continue;
+    fn(x);
+  }
+}
+
+struct Counts {
+  unsigned long long samples = 0, commands = 0, timing = 0, ok = 0, fail = 0;
+};
+
+static Counts expectCounts(const LogReader &r, double fromS, double toS, int device) {
+  Counts c;
+  brute(r, fromS, toS, device, [&](const LogRecord &x) {
+    c.samples += x.type == TLM_SAMPLE;
+    c.commands += x.type == TLM_COMMAND;
+    c.timing += x.type == TLM_TIMING;
+    c.ok += x.type == TLM_ACK && x.ok;
+    c.fail += x.type == TLM_ACK && !x.ok;
+  });
+  return c;
+}
+
+static bool countsMatch(const std::string &out, const Counts &e) {
+  Counts c;
+  double hz;
+  if (sscanf(after(out, "samples="), "samples=%llu commands=%llu (%lf Hz) timing=%llu",
+             &c.samples, &c.commands, &hz, &c.timing) != 4) return false;
+  if (sscanf(after(out, "acks ok="), "acks ok=%llu fail=%llu", &c.ok, &c.fail) != 2) return false;
+  return c.samples == e.samples && c.commands == e.commands && c.timing == e.timing &&
+         c.ok == e.ok && c.fail == e.fail;
+}
+
+static void checkRangeQueries() {
+  printf("range and device queries\n");
+  std::string p = path("append.log");
+  LogReader r;
+  CHECK(r.open(p.c_str()));
+  struct { double from, to; int device; } q[] = {
+    {-1, -1, -1},             // everything
+    {0.5, 1.0, -1},
+    {1.2346, 3.9998, -1},     // across block edges, between records
+    {4.0004, 4.0006, -1},     // one tick's sample and timing only
+    {9, 20, -1},              // running off the end
+    {-1, -1, 1},
+    {-1, -1, 5},              // one block out of five has device 5
+    {1.5501, 1.5799, 5},
+    {2, 4, 2},                // device 2 does not appear before 6 s
+  };
+  for (auto &x : q) {
+    std::string args = x.device >= 0 ? "device " + p + " " + std::to_string(x.device) : "range " + p;
+    if (x.from >= 0) args += " --from " + std::to_string(x.from) + " --to " + std::to_string(x.to);
+    std::string out = run(args);
+    Counts e = expectCounts(r, x.from, x.to, x.device);
+    bool ok = countsMatch(out, e);
+    if (!ok) printf("  %s:\n%s", args.c_str(), out.c_str());
+    CHECK(ok);
+  }
+
+  // Blocks holding only samples and timing have an empty device mask; only
+  // a device query may skip them.
+  std::string sp = path("samples.log");
+  {
+    LogWriter w;
+    CHECK(w.open(sp.c_str()));
+    for (uint64_t i = 0; i < 2 * LOG_BLOCK_RECORDS; i++) w.append(synth(i / 2 * 4 + 2 + i % 2));
+  }
+  LogReader sr;
+  CHECK(sr.open(sp.c_str()) && sr.blocks() == 2 && sr.block(0).deviceMask == 0);
+  CHECK(countsMatch(run("range " + sp), expectCounts(sr, -1, -1, -1)));
+  CHECK(countsMatch(run("device " + sp + " 0"), Counts()));
+}
+
+static void checkLossQuery() {
+  printf("loss query\n");
+  std::string p = path("append.log");
+  LogReader r;
+  CHECK(r.open(p.c_str()));
+  for (int device : {-1, 0, 1, 5}) {
+    for (unsigned minLen : {1u, 2u, 4u}) {
+      // Runs of failed ACKs per device, closed by an OK or the end.
+      unsigned len[32] = {}, bursts = 0, longest = 0;
+      auto close = [&](int d) {
+        if (len[d] >= minLen) { bursts++; longest = std::max(longest, len[d]); }
+        len[d] = 0;
+      };
+      brute(r, -1, -1, device, [&](const LogRecord &x) {
+        if (x.type != TLM_ACK) return;
+        if (x.ok) close(x.device);
+        else len[x.device]++;
+      });
+      for (int d = 0; d < 32; d++) close(d);
+
+      std::string args = "loss " + p + " --min " + std::to_string(minLen);
+      if (device >= 0) args += " --device " + std::to_string(device);
+      std::string out = run(args);
+      unsigned gotBursts, gotMin, gotLongest;
+      bool ok = sscanf(after(out, "bursts of"), "bursts of >= %u lost frames, longest %u",
+                       &gotMin, &gotLongest) == 2;
+      const char *line = after(out, "bursts of");
+      while (line > out.c_str() && line[-1] != '\n') line--;
+      ok = ok && sscanf(line, "%u bursts", &gotBursts) == 1;
+      ok = ok && gotBursts == bursts && gotMin == minLen && gotLongest == longest;
+      if (!ok) printf("  %s: want %u bursts, longest %u\n%s", args.c_str(), bursts, longest, out.c_str());
+      CHECK(ok);
+    }
+  }
+}
+
+static void checkLatencyQuery() {
+  printf("latency query\n");
+  std::string p = path("append.log");
+  LogReader r;
+  CHECK(r.open(p.c_str()));
+  struct { double from, to; int device; } q[] = {{-1, -1, -1}, {-1, -1, 0}, {1, 2.5, -1}, {1.5001, 1.6001, 5}};
+  for (auto &x : q) {
+    std::vector<uint32_t> lat;
+    brute(r, x.from, x.to, x.device, [&](const LogRecord &y) {
+      if (y.type == TLM_ACK && y.latencyUs) lat.push_back(y.latencyUs);
+    });
+    std::sort(lat.begin(), lat.end());
+
+    std::string args = "latency " + p;
+    if (x.device >= 0) args += " --device " + std::to_string(x.device);
+    if (x.from >= 0) args += " --from " + std::to_string(x.from) + " --to " + std::to_string(x.to);
+    std::string out = run(args);
+    unsigned long long n = 0;
+    unsigned maxUs = 0;
+    bool ok = sscanf(after(out, "over"), "over %llu frames", &n) == 1 && n == lat.size();
+    ok = ok && sscanf(after(out, "max"), "max = %u us", &maxUs) == 1 && maxUs == lat.back();
+    // Each percentile is the upper edge of the 10 us bin holding the
+    // floor(p * (n - 1)) + 1-th smallest value.
+    for (double pct : {50.0, 90.0, 99.0, 99.9}) {
+      char key[16];
+      snprintf(key, sizeof(key), "p%g ", pct);
+      unsigned bound = 0;
+      uint32_t want = lat[(size_t)(pct / 100.0 * (lat.size() - 1))];
+      ok = ok && sscanf(after(out, key) + strlen(key), " <= %u us", &bound) == 1;
+      ok = ok && bound == (want / 10 + 1) * 10;
+    }
+    if (!ok) printf("  %s: want %zu frames, max %u\n%s", args.c_str(), lat.size(), lat.back(), out.c_str());
+    CHECK(ok);
+  }
+}
+
+// The record command on an encoded capture: micros() unwrapped across its
+// 32-bit wrap, ACK latency matched to its command, and a second session
+// (controller rebooted, micros() from zero) appended after the first.
+static void checkRecord() {
+  printf("record and append a session\n");
+  std::string cap = path("capture.bin"), p = path("recorded.log");
+  auto capture = [&](uint32_t startUs, int ticks) {
+    FILE *f = fopen(cap.c_str(), "wb");
+    uint8_t buf[TLM_MAX_ENCODED];
+    for (int t = 0; t < ticks; t++) {
+      uint32_t us = startUs + (uint32_t)t * 20000;
+      TlmCommand c = {us, (uint8_t)(t % 2), (uint8_t)t, 10, -10, 0, 80, 0};
+      TlmAck a = {us + 1500 + (uint32_t)(t % 7) * 100, c.device, c.seq, (uint8_t)(t % 10 != 0)};
+      fwrite(buf, 1, tlmEncodeFrame(TLM_COMMAND, &c, sizeof(c), buf), f);
+      fwrite(buf, 1, tlmEncodeFrame(TLM_ACK, &a, sizeof(a), buf), f);
+    }
+    fclose(f);
+  };
+  capture(0xFFFFFFFFu - 500000, 100);               // wraps after 25 ticks
+  std::string out1 = run("record " + cap + " " + p);
+  capture(1000, 50);
+  std::string out2 = run("record " + cap + " " + p);
+  CHECK(out1.find("appended 200 records (200 total)") != std::string::npos);
+  CHECK(out2.find("appended 100 records (300 total)") != std::string::npos);
+
+  LogReader r;
+  CHECK(r.open(p.c_str()) && r.count() == 300);
+  if (r.count() != 300) return;
+  int backwards = 0, badStep = 0, badLatency = 0;
+  for (uint64_t i = 1; i < r.count(); i++) {
+    if (r.at(i).tUs < r.at(i - 1).tUs) backwards++;
+    // Within a session, timeline steps equal micros() steps, wrap included.
+    if (i != 200 && r.at(i).tUs - r.at(i - 1).tUs != (uint32_t)(r.at(i).devUs - r.at(i - 1).devUs)) badStep++;
+  }
+  for (uint64_t i = 1; i < r.count(); i += 2) {
+    const LogRecord &a = r.at(i);
+    if (a.type != TLM_ACK || a.latencyUs != 1500 + (a.seq % 7) * 100u) badLatency++;
+  }
+  CHECK(backwards == 0 && badStep == 0 && badLatency == 0);
+  CHECK(r.at(200).tUs > r.at(199).tUs);
+  CHECK(blocksMatch(r));
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+int main(int argc, char **argv) {
+  if (argc > 2) {
+    fprintf(stderr, "usage: telemetry_log_check [telemetry_recorder]\n");
+    return 2;
+  }
+  if (argc == 2) recorder = argv[1];
+  char tmpl[] = "/tmp/telemetry_log_check.XXXXXX";
+  if (!mkdtemp(tmpl)) {
+    perror("mkdtemp");
+    return 1;
+  }
+  dir = tmpl;
+
+  checkAppendReopen();
+  checkTruncation();
+  checkLowerBound();
+  checkRangeQueries();
+  checkLossQuery();
+  checkLatencyQuery();
+  checkRecord();
+
+  std::string rm = "rm -rf " + dir;
+  if (system(rm.c_str()) != 0) printf("could not remove %s\n", dir.c_str());
+  return checkSummary();
+}
@@ -0,0 +1,414 @@
+// telemetry_recorder - record the controller's telemetry stream into an
+// mmap'd fixed-record log and query it afterwards.
+//
+//   telemetry_recorder record  <tty|capture> <log>     append until EOF / Ctrl-C
+//   telemetry_recorder info    <log>
+//   telemetry_recorder range   <log> --from S --to S [--print]
+//   telemetry_recorder device  <log> <n> [--from S --to S]
+//   telemetry_recorder loss    <log> [--device n] [--min N]
+//   telemetry_recorder latency <log> [--device n] [--from S --to S]
+//
+// Times given with --from/--to are seconds relative to the start of the log.
+
+#include "serial_port.h"
+#include "telemetry_frame.h"
+#include "telemetry_log.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <vector>
+
+// ============================================
+// RECORD
+// ============================================
+
+static volatile sig_atomic_t stopRequested = 0;
+static void onSignal(int) { stopRequested = 1; }
+
+static uint64_t wallClockUs() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return (uint64_t)tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+// Turns decoded frames into log records on a monotonic timeline. Controller
+// micros() is unwrapped by its 32-bit delta. A small backwards step is a
+// frame emitted out of order (e.g. a queued ACK) and is pinned to the current
+// time; a large one is a controller reboot and rebases the session.
+struct Recorder {
+  LogWriter &log;
+  uint64_t tUs = 0;
+  uint32_t lastDevUs = 0;
+  bool started = false;
+  uint32_t sentAtUs[256] = {};
+  bool sentValid[256] = {};
+
+  explicit Recorder(LogWriter &w) : log(w) {}
+
+  uint64_t timeline(uint32_t devUs) {
+    if (!started) {
+      uint64_t now = wallClockUs();
+      tUs = now > log.lastTUs() ? now : log.lastTUs() + 1;
+      started = true;
+      lastDevUs = devUs;
+      return tUs;
+    }
+    uint32_t delta = devUs - lastDevUs;
+    if (delta < 0x80000000u) {
+      tUs += delta;
+      lastDevUs = devUs;
+    } else if (lastDevUs - devUs > 1000000u) {
+      lastDevUs = devUs;
+    }
+    return tUs;
+  }
+
+  bool onFrame(const TelemetryDecoder &dec) {
+    LogRecord r = {};
+    r.type = dec.type();
+    switch (r.type) {
+      case TLM_SAMPLE: {
+        TlmSample s;
+        if (!dec.as(s)) return false;
+        r.devUs = s.tUs;
+        r.buttons = s.buttons;
+        r.v[0] = s.lx; r.v[1] = s.ly; r.v[2] = s.rx; r.v[3] = s.ry;
+        break;
+      }
+      case TLM_COMMAND: {
+        TlmCommand c;
+        if (!dec.as(c)) return false;
+        r.devUs = c.tUs;
+        r.device = c.device;
+        r.seq = c.seq;
+        r.cmd.x = c.x; r.cmd.y = c.y; r.cmd.rot = c.rot;
+        r.cmd.speed = c.speed;
+        r.buttons = c.buttons;
+        sentAtUs[c.seq] = c.tUs;
+        sentValid[c.seq] = true;
+        break;
+      }
+      case TLM_ACK: {
+        TlmAck a;
+        if (!dec.as(a)) return false;
+        r.devUs = a.tUs;
+        r.device = a.device;
+        r.seq = a.seq;
+        r.ok = a.ok;
+        if (sentValid[a.seq]) {
+          r.latencyUs = a.tUs - sentAtUs[a.seq];
+          sentValid[a.seq] = false;
+        }
+        break;
+      }
+      case TLM_TIMING: {
+        TlmTiming t;
+        if (!dec.as(t)) return false;
+        r.devUs = t.tUs;
+        r.v[0] = t.loopUs;
+        r.v[1] = t.sendUs;
+        break;
+      }
+      default:
+        return false;
+    }
+    r.tUs = timeline(r.devUs);
+    return log.append(r);
+  }
+};
+
+static int cmdRecord(const char *src, const char *path) {
+  LogWriter log;
+  if (!log.open(path)) {
+    fprintf(stderr, "%s: cannot open log: %s\n", path, strerror(errno));
+    return 1;
+  }
+  bool isTty = false;
+  int fd = openByteSource(src, 115200, isTty);
+  if (fd < 0) {
+    fprintf(stderr, "%s: %s\n", src, strerror(errno));
+    return 1;
+  }
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  TelemetryDecoder dec;
+  Recorder rec(log);
+  uint64_t startCount = log.count();
+  uint8_t buf[4096];
+  uint64_t lastReport = wallClockUs();
+
+  while (!stopRequested) {
+    ssize_t n = read(fd, buf, sizeof(buf));
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      fprintf(stderr, "read: %s\n", strerror(errno));
+      break;
+    }
+    if (n == 0 && !isTty) break;
+    for (ssize_t i = 0; i < n; i++) {
+      if (dec.push(buf[i]) && !rec.onFrame(dec)) {
+        fprintf(stderr, "append failed: %s\n", strerror(errno));
+        stopRequested = 1;
+        break;
+      }
+    }
+    if (isTty && wallClockUs() - lastReport > 1000000) {
+      lastReport = wallClockUs();
+      fprintf(stderr, "\rrecords=%llu crc_err=%u bad=%u",
+              (unsigned long long)log.count(), dec.crcErrors, dec.badFrames);
+    }
+  }
+  close(fd);
+  printf("%sappended %llu records (%llu total), crc_err=%u bad=%u\n",
+         isTty ? "\n" : "",
+         (unsigned long long)(log.count() - startCount),
+         (unsigned long long)log.count(), dec.crcErrors, dec.badFrames);
+  log.close();
+  return 0;
+}
+
+// ============================================
+// QUERIES
+// ============================================
+
+struct Filter {
+  int device = -1;
+  double fromS = -1;
+  double toS = -1;
+};
+
+// Visit every record matching the filter, skipping whole blocks by time span
+// and device mask before touching their records.
+template <typename Fn>
+static void scan(const LogReader &log, const Filter &f, Fn fn) {
+  if (log.count() == 0) return;
+  uint64_t t0 = log.firstTUs();
+  uint64_t from = f.fromS >= 0 ? t0 + (uint64_t)(f.fromS * 1e6) : 0;
+  uint64_t to = f.toS >= 0 ? t0 + (uint64_t)(f.toS * 1e6) : UINT64_MAX;
+
+  uint64_t i = from ? log.lowerBound(from) : 0;
+  while (i < log.count()) {
+    size_t b = i / LOG_BLOCK_RECORDS;
+    uint64_t blockEnd = (uint64_t)(b + 1) * LOG_BLOCK_RECORDS;
+    if (blockEnd > log.count()) blockEnd = log.count();
+    const LogIndexEntry &e = log.block(b);
+    if (e.firstTUs > to) return;
+    if (f.device >= 0 && !(e.deviceMask & 1u << f.device)) { i = blockEnd; continue; }
+    for (; i < blockEnd; i++) {
+      const LogRecord &r = log.at(i);
+      if (r.tUs > to) return;
+      if (f.device >= 0 && ((r.type != TLM_COMMAND && r.type != TLM_ACK) || r.device != f.device)) continue;
+      fn(r);
+    }
+  }
+}
+
+static double relS(const LogReader &log, uint64_t tUs) {
+  return (tUs - log.firstTUs()) / 1e6;
+}
+
+static int cmdInfo(const LogReader &log) {
+  uint32_t mask = 0;
+  uint64_t fails = 0;
+  for (size_t b = 0; b < log.blocks(); b++) {
+    mask |= log.block(b).deviceMask;
+    fails += log.block(b).ackFails;
+  }
+  printf("records:  %llu\n", (unsigned long long)log.count());
+  printf("span:     %.3f s\n", log.count() ? relS(log, log.lastTUs()) : 0.0);
+  printf("blocks:   %zu x %d records\n", log.blocks(), LOG_BLOCK_RECORDS);
+  printf("devices: ");
+  for (int d = 0; d < 32; d++) if (mask & (1u << d)) printf(" %d", d);
+  printf("\nack fails: %llu\n", (unsigned long long)fails);
+  return 0;
+}
+
+struct Summary {
+  uint64_t byType[5] = {};
+  uint64_t acksOk = 0, acksFail = 0;
+  uint64_t latSum = 0, latN = 0;
+  uint64_t firstCmd = 0, lastCmd = 0;
+
+  void add(const LogRecord &r) {
+    if (r.type < 5) byType[r.type]++;
+    if (r.type == TLM_COMMAND) {
+      if (!firstCmd) firstCmd = r.tUs;
+      lastCmd = r.tUs;
+    }
+    if (r.type == TLM_ACK) {
+      if (r.ok) acksOk++;
+      else acksFail++;
+      if (r.latencyUs) { latSum += r.latencyUs; latN++; }
+    }
+  }
+
+  void print() const {
+    double span = (lastCmd - firstCmd) / 1e6;
+    uint64_t acks = acksOk + acksFail;
+    printf("samples=%llu commands=%llu (%.1f Hz) timing=%llu\n",
+           (unsigned long long)byType[TLM_SAMPLE], (unsigned long long)byType[TLM_COMMAND],
+           span > 0 ? (byType[TLM_COMMAND] - 1) / span : 0.0,
+           (unsigned long long)byType[TLM_TIMING]);
+    printf("acks ok=%llu fail=%llu (%.2f%% delivered) latency avg=%.0f us\n",
+           (unsigned long long)acksOk, (unsigned long long)acksFail,
+           acks ? 100.0 * acksOk / acks : 0.0, latN ? (double)latSum / latN : 0.0);
+  }
+};
+
+static void printRecord(const LogReader &log, const LogRecord &r) {
+  printf("%12.6f ", relS(log, r.tUs));
+  switch (r.type) {
+    case TLM_SAMPLE:
+      printf("SAMPLE  L(%4u,%4u) R(%4u,%4u) btn=%u\n", r.v[0], r.v[1], r.v[2], r.v[3], r.buttons);
+      break;
+    case TLM_COMMAND:
+      printf("COMMAND dev=%u seq=%3u x=%4d y=%4d rot=%4d spd=%3u btn=%u\n",
+             r.device, r.seq, r.cmd.x, r.cmd.y, r.cmd.rot, r.cmd.speed, r.buttons);
+      break;
+    case TLM_ACK:
+      printf("ACK     dev=%u seq=%3u %s lat=%uus\n", r.device, r.seq, r.ok ? "OK  " : "FAIL", r.latencyUs);
+      break;
+    case TLM_TIMING:
+      printf("TIMING  loop=%uus send=%uus\n", r.v[0], r.v[1]);
+      break;
+    default:
+      printf("type %u\n", r.type);
+  }
+}
+
+static int cmdRange(const LogReader &log, const Filter &f, bool print) {
+  Summary s;
+  scan(log, f, [&](const LogRecord &r) {
+    s.add(r);
+    if (print) printRecord(log, r);
+  });
+  s.print();
+  return 0;
+}
+
+// A loss burst is a run of consecutive failed ACKs for one device.
+static int cmdLoss(const LogReader &log, const Filter &f, unsigned minLen) {
+  struct Burst { uint64_t start = 0, end = 0; unsigned len = 0; };
+  Burst open[32];
+  unsigned bursts = 0, longest = 0;
+
+  auto close = [&](int dev) {
+    Burst &b = open[dev];
+    if (b.len >= minLen) {
+      printf("dev=%d  t=%.3f s  lost=%u  for %.1f ms\n",
+             dev, relS(log, b.start), b.len, (b.end - b.start) / 1e3);
+      bursts++;
+      if (b.len > longest) longest = b.len;
+    }
+    b = Burst();
+  };
+
+  scan(log, f, [&](const LogRecord &r) {
+    if (r.type != TLM_ACK || r.device >= 32) return;
+    Burst &b = open[r.device];
+    if (r.ok) {
+      if (b.len) close(r.device);
+    } else {
+      if (!b.len) b.start = r.tUs;
+      b.end = r.tUs;
+      b.len++;
+    }
+  });
+  for (int d = 0; d < 32; d++) if (open[d].len) close(d);
+  printf("%u bursts of >= %u lost frames, longest %u\n", bursts, minLen, longest);
+  return 0;
+}
+
+// Percentiles as the upper bound of their 10 us histogram bucket, up to 1 s
+// (overflow bucket above).
+static int cmdLatency(const LogReader &log, const Filter &f) {
+  const uint32_t binUs = 10, bins = 100000;
+  std::vector<uint32_t> hist(bins + 1, 0);
+  uint64_t n = 0;
+  uint32_t maxUs = 0;
+  scan(log, f, [&](const LogRecord &r) {
+    if (r.type != TLM_ACK || !r.latencyUs) return;
+    uint32_t bin = r.latencyUs / binUs;
+    hist[bin < bins ? bin : bins]++;
+    if (r.latencyUs > maxUs) maxUs = r.latencyUs;
+    n++;
+  });
+  if (!n) {
+    printf("no matched ACK latencies\n");
+    return 0;
+  }
+  const double pct[] = {50, 90, 99, 99.9};
+  printf("ACK latency over %llu frames:\n", (unsigned long long)n);
+  for (double p : pct) {
+    uint64_t target = (uint64_t)(p / 100.0 * (n - 1)) + 1, acc = 0;
+    uint32_t bin = 0;
+    for (; bin <= bins; bin++) {
+      acc += hist[bin];
+      if (acc >= target) break;
+    }
+    printf("  p%-5g <= %u us\n", p, (bin + 1) * binUs);
+  }
+  printf("  max    = %u us\n", maxUs);
+  return 0;
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+static void usage() {
+  fprintf(stderr,
+    "usage: telemetry_recorder record  <tty|capture> <log>\n"
+    "       telemetry_recorder info    <log>\n"
+    "       telemetry_recorder range   <log> [--from S] [--to S] [--print]\n"
+    "       telemetry_recorder device  <log> <n> [--from S] [--to S]\n"
+    "       telemetry_recorder loss    <log> [--device n] [--min N]\n"
+    "       telemetry_recorder latency <log> [--device n] [--from S] [--to S]\n");
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) { usage(); return 2; }
+  const char *cmd = argv[1];
+
+  if (strcmp(cmd, "record") == 0) {
+    if (argc != 4) { usage(); return 2; }
+    return cmdRecord(argv[2], argv[3]);
+  }
+
+  LogReader log;
+  if (!log.open(argv[2])) {
+    fprintf(stderr, "%s: not a telemetry log\n", argv[2]);
+    return 1;
+  }
+
+  Filter f;
+  bool print = false;
+  unsigned minLen = 2;
+  int argi = 3;
+  if (strcmp(cmd, "device") == 0) {
+    if (argc < 4) { usage(); return 2; }
+    f.device = atoi(argv[argi++]);
+  }
+  for (; argi < argc; argi++) {
+    if (strcmp(argv[argi], "--from") == 0 && argi + 1 < argc) f.fromS = atof(argv[++argi]);
+    else if (strcmp(argv[argi], "--to") == 0 && argi + 1 < argc) f.toS = atof(argv[++argi]);
+    else if (strcmp(argv[argi], "--device") == 0 && argi + 1 < argc) f.device = atoi(argv[++argi]);
+    else if (strcmp(argv[argi], "--min") == 0 && argi + 1 < argc) minLen = atoi(argv[++argi]);
+    else if (strcmp(argv[argi], "--print") == 0) print = true;
+    else { usage(); return 2; }
+  }
+  if (f.device >= 32) { fprintf(stderr, "device must be 0..31\n"); return 2; }
+
+  if (strcmp(cmd, "info") == 0) return cmdInfo(log);
+  if (strcmp(cmd, "range") == 0 || strcmp(cmd, "device") == 0) return cmdRange(log, f, print);
+  if (strcmp(cmd, "loss") == 0) return cmdLoss(log, f, minLen ? minLen : 1);
+  if (strcmp(cmd, "latency") == 0) return cmdLatency(log, f);
+  usage();
+  return 2;
+}
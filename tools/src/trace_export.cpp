@@ -0,0 +1,257 @@
+// trace_export - convert the controller's TRACE DUMP into Chrome trace JSON,
+// for chrome://tracing or https://ui.perfetto.dev.
+//
+//   trace_export /dev/ttyACM0 -o trace.json   send TRACE DUMP and convert
+//   trace_export capture.bin -o trace.json    convert a recorded dump
+//
+// Capture by hand with: cat /dev/ttyACM0 > capture.bin, then type TRACE DUMP
+// in another terminal. Loop-task trace points go on one track and the WiFi
+// task callbacks on another. Begin/end pairs whose begin was overwritten in
+// the ring are dropped; spans still open at the end are closed at the last
+// event. A per-point summary goes to stderr.
+
+#include "serial_port.h"
+#include "telemetry_frame.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#define TID_LOOP  1
+#define TID_WIFI  2
+
+static const char *pointName(uint8_t p) {
+  switch (p) {
+    case TP_LOOP:        return "loop";
+    case TP_CLI:         return "cli";
+    case TP_INPUT:       return "input";
+    case TP_BUTTON:      return "button";
+    case TP_MENU:        return "menu";
+    case TP_CMD:         return "command";
+    case TP_ESPNOW_SEND: return "esp_now_send";
+    case TP_HELD:        return "held";
+    case TP_CHANNEL:     return "channel switch";
+    case TP_PROBE:       return "probe";
+    case TP_DISPLAY:     return "display render";
+    case TP_I2C_FLUSH:   return "i2c flush";
+    case TP_SEND_CB:     return "send callback";
+    case TP_ECHO:        return "echo";
+    default:             return nullptr;
+  }
+}
+
+static int threadOf(uint8_t p) {
+  return p >= TP_SEND_CB ? TID_WIFI : TID_LOOP;
+}
+
+// ============================================
+// JSON OUTPUT
+// ============================================
+
+struct Span {
+  uint8_t point;
+  uint64_t ts;
+};
+
+struct PointStats {
+  uint32_t spans = 0;
+  uint32_t instants = 0;
+  uint64_t totalUs = 0;
+  uint64_t maxUs = 0;
+};
+
+class Exporter {
+public:
+  explicit Exporter(FILE *out) : _out(out) {
+    fprintf(_out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(_out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"controller\"}}");
+    fprintf(_out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"loop\"}}", TID_LOOP);
+    fprintf(_out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"wifi callbacks\"}}", TID_WIFI);
+  }
+
+  void add(const FlightEvent &e) {
+    const char *name = pointName(e.type);
+    if (!name) { unknown++; return; }
+    if (events == 0) _lastUs = e.tUs;
+    _ts += (int32_t)(e.tUs - _lastUs);   // unwrap micros(); tasks may interleave slightly
+    _lastUs = e.tUs;
+    events++;
+
+    int tid = threadOf(e.type);
+    std::vector<Span> &stack = _stack[tid];
+    switch (e.a) {
+      case TRACE_PH_BEGIN:
+        stack.push_back({e.type, _ts});
+        emit(name, "B", tid, _ts, e.type, e.b);
+        break;
+      case TRACE_PH_END: {
+        size_t i = stack.size();
+        while (i > 0 && stack[i - 1].point != e.type) i--;
+        if (i == 0) { orphans++; break; }   // begin lost to the ring
+        while (stack.size() >= i) close(tid, _ts);
+        break;
+      }
+      case TRACE_PH_INSTANT:
+        emit(name, "i", tid, _ts, e.type, e.b);
+        _stats[e.type].instants++;
+        break;
+      default:
+        unknown++;
+        break;
+    }
+  }
+
+  void finish() {
+    for (int tid = TID_LOOP; tid <= TID_WIFI; tid++) {
+      while (!_stack[tid].empty()) close(tid, _ts);
+    }
+    fprintf(_out, "\n]}\n");
+  }
+
+  void printSummary(FILE *f) const {
+    fprintf(f, "%u events over %.1f ms (%u unmatched ends, %u unknown)\n",
+            events, _ts / 1000.0, orphans, unknown);
+    for (int p = 0; p < 256; p++) {
+      const PointStats &s = _stats[p];
+      const char *name = pointName(p);
+      if (!name) continue;
+      if (s.spans) {
+        fprintf(f, "  %-15s %6u spans     avg %8.1f us  max %8llu us\n", name, s.spans,
+                (double)s.totalUs / s.spans, (unsigned long long)s.maxUs);
+      }
+      if (s.instants) fprintf(f, "  %-15s %6u instants\n", name, s.instants);
+    }
+  }
+
+  uint32_t events = 0;
+  uint32_t orphans = 0;
+  uint32_t unknown = 0;
+
+private:
+  void close(int tid, uint64_t ts) {
+    Span s = _stack[tid].back();
+    _stack[tid].pop_back();
+    emit(pointName(s.point), "E", tid, ts, s.point, 0);
+    PointStats &st = _stats[s.point];
+    st.spans++;
+    st.totalUs += ts - s.ts;
+    if (ts - s.ts > st.maxUs) st.maxUs = ts - s.ts;
+  }
+
+  void emit(const char *name, const char *ph, int tid, uint64_t ts, uint8_t point, uint16_t arg) {
+    fprintf(_out, ",\n{\"name\":\"%s\",\"ph\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%llu",
+            name, ph, tid, (unsigned long long)ts);
+    if (ph[0] == 'i') fprintf(_out, ",\"s\":\"t\"");
+    if (ph[0] != 'E') {
+      switch (point) {
+        case TP_BUTTON:
+          fprintf(_out, ",\"args\":{\"button\":%u,\"down\":%u}", arg & 0xFF, arg >> 8);
+          break;
+        case TP_SEND_CB:
+          fprintf(_out, ",\"args\":{\"seq\":%u,\"ok\":%u}", arg & 0xFF, arg >> 8);
+          break;
+        case TP_PROBE:
+          fprintf(_out, ",\"args\":{\"device\":%u,\"hop\":%u}", arg & 0xFF, arg >> 8);
+          break;
+        case TP_ESPNOW_SEND: case TP_HELD: case TP_ECHO:
+          fprintf(_out, ",\"args\":{\"seq\":%u}", arg);
+          break;
+        case TP_CHANNEL:
+          fprintf(_out, ",\"args\":{\"channel\":%u}", arg);
+          break;
+        default:
+          if (arg) fprintf(_out, ",\"args\":{\"arg\":%u}", arg);
+          break;
+      }
+    }
+    fprintf(_out, "}");
+  }
+
+  FILE *_out;
+  uint64_t _ts = 0;
+  uint32_t _lastUs = 0;
+  std::vector<Span> _stack[TID_WIFI + 1];
+  PointStats _stats[256];
+};
+
+// ============================================
+// MAIN
+// ============================================
+
+static void usage(const char *argv0) {
+  fprintf(stderr, "usage: %s <tty|capture-file> [-o out.json] [--baud N]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+  const char *path = nullptr;
+  const char *outPath = nullptr;
+  int baud = 115200;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) outPath = argv[++i];
+    else if (strcmp(argv[i], "--baud") == 0 && i + 1 < argc) baud = atoi(argv[++i]);
+    else if (argv[i][0] != '-' && !path) path = argv[i];
+    else { usage(argv[0]); return 2; }
+  }
+  if (!path) { usage(argv[0]); return 2; }
+
+  bool isTty = false;
+  int fd = openByteSource(path, baud, isTty);
+  if (fd < 0) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return 1;
+  }
+  FILE *out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out) {
+    fprintf(stderr, "%s: %s\n", outPath, strerror(errno));
+    return 1;
+  }
+
+  if (isTty) {
+    static const char cmd[] = "TRACE DUMP\n";
+    if (write(fd, cmd, sizeof(cmd) - 1) < 0) {
+      fprintf(stderr, "write: %s\n", strerror(errno));
+      return 1;
+    }
+  }
+
+  Exporter ex(out);
+  TelemetryDecoder dec;
+  uint8_t buf[4096];
+  for (;;) {
+    if (isTty) {
+      // The dump is done once the port has been quiet for a second.
+      struct pollfd p = {fd, POLLIN, 0};
+      int r = poll(&p, 1, 1000);
+      if (r == 0) break;
+      if (r < 0 && errno != EINTR) break;
+    }
+    ssize_t n = read(fd, buf, sizeof(buf));
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      fprintf(stderr, "read: %s\n", strerror(errno));
+      break;
+    }
+    if (n == 0 && !isTty) break;
+
+    for (ssize_t i = 0; i < n; i++) {
+      if (!dec.push(buf[i]) || dec.type() != TLM_TRACE) continue;
+      size_t count = dec.length() / sizeof(FlightEvent);
+      for (size_t k = 0; k < count; k++) {
+        FlightEvent e;
+        memcpy(&e, dec.payload() + k * sizeof(e), sizeof(e));
+        ex.add(e);
+      }
+    }
+  }
+
+  ex.finish();
+  if (out != stdout) fclose(out);
+  close(fd);
+  ex.printSummary(stderr);
+  return ex.events ? 0 : 1;
+}
@@ -0,0 +1,268 @@
+// txqueue_sim - the controller's TX back-pressure policy against a radio that
+// sometimes spends tens of milliseconds retrying one frame.
+//
+//   txqueue_sim                          default channels, exit 1 if a bound is broken
+//   txqueue_sim --loss 5 --burst 30      one channel: bad-state share (percent)
+//                                        and mean burst length (ms)
+//   txqueue_sim --seconds 600 --seed 7
+//
+// The radio is a FIFO of QUEUE_CAP frames (esp_now_send returns NO_MEM when
+// it is full). The head frame is retried up to RETRY_LIMIT times. The
+// channel is a two-state model. In the good state an attempt takes
+// ATTEMPT_US and rarely fails. In the bad state a busy medium (a neighbour
+// network, a microwave) stretches each attempt to ATTEMPT_BAD_US of
+// deferral and backoff, and most attempts fail. The send callback fires
+// when the head frame is done.
+//
+// Policies:
+//   queue-all   what sendControlCommand() used to do: send every command and
+//               ignore the result, so commands queue behind retried ones or
+//               are lost on NO_MEM
+//   in-flight N the firmware policy (TxTracker): at most N frames awaiting a
+//               callback. The freshest command is held until a slot frees up,
+//               and older held ones are superseded.
+//
+// "age" is generation -> delivery of delivered commands. "output age" is the
+// age of the newest command the receiver holds, sampled every millisecond:
+// how far behind the stick the robot is driving.
+//
+// Checked per channel, for the in-flight policies:
+//   - output age no worse than queue-all's (in-flight 1, to 0.1 ms);
+//   - no delivered command older than CALLBACK_TIMEOUT_US;
+//   - NO_MEM never hit, since the radio queue never fills;
+//   - held commands superseded during fades, rather than queued.
+
+#include "check.h"
+#include "tx_tracker.h"
+#include "link_stats.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <deque>
+#include <random>
+
+#define SEND_PERIOD_US   20000    // controller SEND_INTERVAL
+#define LOOP_US          500      // controller loop pass
+#define STEP_US          100
+#define ATTEMPT_US       900      // airtime + ACK timeout + backoff, 1 Mbps
+#define ATTEMPT_BAD_US   5000     // same with the medium mostly busy
+#define RETRY_LIMIT      7
+#define QUEUE_CAP        8
+#define CALLBACK_TIMEOUT_US 100000   // controller TX_CALLBACK_TIMEOUT_US
+
+// Without long fades both policies send almost the same frames, and their
+// output ages differ by sampling noise of a few hundredths of a millisecond.
+#define OUTPUT_AGE_SLACK_MS 0.1
+
+struct Channel {
+  const char *name;
+  double badPct;       // share of time in the bad state
+  double burstMs;      // mean bad-state duration
+  bool fades;          // bursts long enough that in-flight must supersede
+};
+
+// ============================================
+// RADIO MODEL
+// ============================================
+
+struct Frame {
+  uint8_t seq;
+  uint32_t genUs;
+};
+
+class Radio {
+public:
+  Radio(const Channel &c, unsigned seed) : _rng(seed), _uni(0, 1) {
+    double p = c.badPct / 100;
+    _toGood = STEP_US / (c.burstMs * 1000);
+    _toBad = p * _toGood / (1 - p);
+  }
+
+  bool send(const Frame &f) {
+    if (_queue.size() >= QUEUE_CAP) return false;
+    _queue.push_back(f);
+    return true;
+  }
+
+  // Advance one step; true when the head frame finished (callback).
+  bool step(Frame &done, bool &ok) {
+    if (_bad) { if (_uni(_rng) < _toGood) _bad = false; }
+    else if (_uni(_rng) < _toBad) _bad = true;
+
+    if (_queue.empty()) return false;
+    _attemptUs += STEP_US;
+    if (_attemptUs < (_bad ? ATTEMPT_BAD_US : ATTEMPT_US)) return false;
+    _attemptUs = 0;
+    ok = _uni(_rng) >= (_bad ? 0.9 : 0.03);
+    if (!ok && ++_tries < RETRY_LIMIT) return false;
+    done = _queue.front();
+    _queue.pop_front();
+    _tries = 0;
+    return true;
+  }
+
+private:
+  std::mt19937 _rng;
+  std::uniform_real_distribution<double> _uni;
+  double _toBad, _toGood;
+  bool _bad = false;
+  std::deque<Frame> _queue;
+  uint32_t _attemptUs = 0;
+  int _tries = 0;
+};
+
+// ============================================
+// SIMULATION
+// ============================================
+
+struct Result {
+  uint32_t commands = 0;
+  uint32_t delivered = 0;
+  uint32_t lostNoMem = 0;
+  LatencyHistogram age;
+  double outputAgeMs = 0;
+  TxTrackerStats tx = {};
+};
+
+// maxInFlight == 0: queue-all
+static Result simulate(const Channel &c, int maxInFlight, double seconds, unsigned seed) {
+  Radio radio(c, seed);
+  TxTracker tracker;
+  tracker.begin(maxInFlight ? maxInFlight : TX_MAX_IN_FLIGHT_CAP, CALLBACK_TIMEOUT_US);
+  Result r;
+
+  bool held = false;
+  Frame heldFrame = {};
+  uint32_t heldSinceUs = 0;
+  uint8_t seq = 0;
+  uint32_t newestGenUs = 0;
+  bool anyDelivered = false;
+  double outputAgeSum = 0;
+  uint32_t outputSamples = 0;
+
+  auto transmit = [&](const Frame &f, uint32_t nowUs) {
+    if (held) {
+      if (heldFrame.seq != f.seq) tracker.superseded();
+      held = false;
+    }
+    if (maxInFlight && !tracker.hasRoom(nowUs)) {
+      held = true;
+      heldFrame = f;
+      heldSinceUs = nowUs;
+      return;
+    }
+    if (radio.send(f)) {
+      tracker.sent(f.seq, nowUs);
+    } else {
+      tracker.queueFull();
+      if (maxInFlight) {
+        held = true;
+        heldFrame = f;
+        heldSinceUs = nowUs;
+      } else {
+        r.lostNoMem++;
+      }
+    }
+  };
+
+  uint64_t totalUs = (uint64_t)(seconds * 1e6);
+  for (uint32_t t = 0; t < totalUs; t += STEP_US) {
+    Frame done;
+    bool ok;
+    if (radio.step(done, ok)) {
+      uint8_t s;
+      uint32_t us;
+      tracker.completed(ok, t, s, us);
+      if (ok) {
+        r.delivered++;
+        r.age.add(t - done.genUs);
+        if (!anyDelivered || (int32_t)(done.genUs - newestGenUs) > 0) newestGenUs = done.genUs;
+        anyDelivered = true;
+      }
+    }
+
+    if (t % LOOP_US == 0) {
+      if (held) {
+        if (t - heldSinceUs >= SEND_PERIOD_US) {
+          tracker.superseded();
+          held = false;
+        } else if (tracker.hasRoom(t)) {
+          Frame f = heldFrame;
+          held = false;
+          transmit(f, t);
+        }
+      }
+      if (t % SEND_PERIOD_US == 0) {
+        r.commands++;
+        transmit({seq++, t}, t);
+      }
+    }
+
+    if (t % 1000 == 0 && anyDelivered && t > 1000000) {
+      outputAgeSum += (t - newestGenUs) / 1000.0;
+      outputSamples++;
+    }
+  }
+  r.outputAgeMs = outputSamples ? outputAgeSum / outputSamples : 0;
+  r.tx = tracker.stats();
+  return r;
+}
+
+static void runChannel(const Channel &c, double seconds, unsigned seed) {
+  printf("%s: bad state %.1f%% of the time, bursts of ~%.0f ms\n", c.name, c.badPct, c.burstMs);
+  static const int policies[] = {0, 1, 2};
+  double queueAllAgeMs = 0;
+  for (int n : policies) {
+    Result r = simulate(c, n, seconds, seed);
+    char label[16];
+    if (n) snprintf(label, sizeof(label), "in-flight %d", n);
+    else snprintf(label, sizeof(label), "queue-all");
+    printf("  %-11s delivered %6.2f%%  age avg %5.1f p95 %5.1f max %5.1f ms  output age %5.1f ms"
+           "  | superseded %u no-mem %u\n",
+           label, 100.0 * r.delivered / r.commands,
+           r.age.avgUs() / 1000.0, r.age.percentileUs(0.95f) / 1000.0, r.age.maxUs / 1000.0,
+           r.outputAgeMs, r.tx.superseded, r.tx.queueFull);
+    if (!n) {
+      queueAllAgeMs = r.outputAgeMs;
+      continue;
+    }
+    if (n == 1) CHECK(r.outputAgeMs <= queueAllAgeMs + OUTPUT_AGE_SLACK_MS);
+    CHECK(r.age.maxUs <= CALLBACK_TIMEOUT_US);
+    CHECK(r.tx.queueFull == 0);
+    if (c.fades) CHECK(r.tx.superseded > 0);
+  }
+  printf("\n");
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+int main(int argc, char **argv) {
+  double seconds = 300;
+  unsigned seed = 1;
+  Channel custom = {"custom", -1, 30, false};
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) seconds = atof(argv[++i]);
+    else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--loss") == 0 && i + 1 < argc) custom.badPct = atof(argv[++i]);
+    else if (strcmp(argv[i], "--burst") == 0 && i + 1 < argc) custom.burstMs = atof(argv[++i]);
+    else {
+      fprintf(stderr, "usage: %s [--seconds S] [--seed N] [--loss PCT [--burst MS]]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (custom.badPct >= 0 && custom.badPct < 100 && custom.burstMs > 0) {
+    runChannel(custom, seconds, seed);
+  } else {
+    static const Channel channels[] = {
+      {"clean",     0.5,  5, false},
+      {"bursty",    5,   30, false},
+      {"fades",    10,  120, true},
+    };
+    for (const Channel &c : channels) runChannel(c, seconds, seed);
+  }
+  return checkSummary();
+}